@@ -56,7 +56,7 @@ struct CFG_BasicBlockImpl : public CFG_BasicBlock
 {
   CFG_BasicBlockImpl () : nodes (), in (), out () { }
   virtual ~CFG_BasicBlockImpl () {
-    for (list<CFG_EdgeImpl *>::iterator ei = in.begin(); ei != in.end (); ei++)
+    for (vector<CFG_EdgeImpl *>::iterator ei = in.begin(); ei != in.end (); ei++)
       delete *ei;
   }
   
@@ -68,7 +68,7 @@ struct CFG_BasicBlockImpl : public CFG_BasicBlock
 
   vector<MicrocodeNode *> nodes;
   vector<bool> visible;
-  list<CFG_EdgeImpl *> in;
+  vector<CFG_EdgeImpl *> in;
   list<CFG_EdgeImpl *> out;
 };
 
@@ -331,6 +331,20 @@ CFG::get_next_successor (CFG::node_type *n, CFG::edge_type *e) const
   return result;
 }
 
+int
+CFG::get_nb_predecessors (CFG::node_type *n) const
+{
+  return ((CFG_BasicBlockImpl *) n)->in.size ();
+}
+
+std::pair<CFG::edge_type *, CFG::node_type *>
+CFG::get_predecessor (CFG::node_type *n, int i) const
+{
+  CFG_EdgeImpl *e = ((CFG_BasicBlockImpl *) n)->in[i];
+
+  return std::pair<CFG::edge_type *, CFG::node_type *> (e, e->src);
+}
+
 CFG::node_type *
 CFG::get_source (CFG::edge_type *e) const
 {
@@ -88,6 +88,9 @@ public:
   get_first_successor (node_type *n) const;
   virtual std::pair<edge_type *, node_type *>
   get_next_successor (node_type *n, edge_type *e) const;
+  virtual int get_nb_predecessors (node_type *n) const;
+  virtual std::pair<edge_type *, node_type *>
+  get_predecessor (node_type *n, int i) const;
   virtual node_type *get_source (edge_type *e) const;
   virtual node_type *get_target (edge_type *e) const;
   virtual void output_text(std::ostream & out) const;
@@ -0,0 +1,854 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "GraphStructure.hh"
+
+#include <cassert>
+#include <utility>
+
+using namespace std;
+
+const size_t GraphStructure::NONE = (size_t) -1;
+
+/* Lengauer-Tarjan algorithm, with the balanced link and eval of the
+ * original paper. The vertices of the depth-first tree are handled by
+ * their preorder number, from 1; 0 stands for no vertex. */
+class LengauerTarjan
+{
+public:
+  LengauerTarjan (size_t nb, size_t root,
+		  const vector<size_t> &successors_begin,
+		  const vector<size_t> &successors,
+		  const vector<size_t> &predecessors_begin,
+		  const vector<size_t> &predecessors);
+
+  /* Immediate dominators (NONE for the root and the unreachable
+   * vertices) and numbers of the vertices in the dominator tree */
+  void get_dominators (vector<size_t> &idom, vector<size_t> &pre,
+		       vector<size_t> &post) const;
+
+private:
+  void compress (size_t v);
+  size_t eval (size_t v);
+  void link (size_t v, size_t w);
+
+  size_t nb;
+  /* Indexed by vertex */
+  vector<size_t> dfnum;
+  /* Indexed by preorder number */
+  vector<size_t> vertex;
+  vector<size_t> parent;
+  vector<size_t> semi;
+  vector<size_t> label;
+  vector<size_t> ancestor;
+  vector<size_t> child;
+  vector<size_t> size;
+  vector<size_t> dom;
+  vector<size_t> stack;
+};
+
+LengauerTarjan::LengauerTarjan (size_t nb, size_t root,
+				const vector<size_t> &successors_begin,
+				const vector<size_t> &successors,
+				const vector<size_t> &predecessors_begin,
+				const vector<size_t> &predecessors)
+  : nb (nb), dfnum (nb, 0), vertex (1, 0), parent (1, 0), semi (), label (),
+    ancestor (), child (), size (), dom (), stack ()
+{
+  /* Depth-first numbering from the root */
+  vector< pair<size_t, size_t> > todo;
+
+  dfnum[root] = 1;
+  vertex.push_back (root);
+  parent.push_back (0);
+  todo.push_back (make_pair (root, successors_begin[root]));
+  while (! todo.empty ())
+    {
+      size_t v = todo.back ().first;
+      size_t a = todo.back ().second;
+
+      if (a == successors_begin[v + 1])
+	{
+	  todo.pop_back ();
+	  continue;
+	}
+      todo.back ().second++;
+
+      size_t w = successors[a];
+      if (dfnum[w] == 0)
+	{
+	  dfnum[w] = vertex.size ();
+	  vertex.push_back (w);
+	  parent.push_back (dfnum[v]);
+	  todo.push_back (make_pair (w, successors_begin[w]));
+	}
+    }
+
+  size_t N = vertex.size () - 1;
+  vector<size_t> bucket_head (N + 1, 0);
+  vector<size_t> bucket_next (N + 1, 0);
+
+  semi.resize (N + 1);
+  label.resize (N + 1);
+  for (size_t i = 0; i <= N; i++)
+    semi[i] = label[i] = i;
+  ancestor.assign (N + 1, 0);
+  child.assign (N + 1, 0);
+  size.assign (N + 1, 1);
+  size[0] = 0;
+  dom.assign (N + 1, 0);
+
+  for (size_t w = N; w >= 2; w--)
+    {
+      size_t x = vertex[w];
+
+      for (size_t p = predecessors_begin[x]; p < predecessors_begin[x + 1];
+	   p++)
+	{
+	  size_t v = dfnum[predecessors[p]];
+	  if (v == 0)
+	    continue;
+
+	  size_t u = eval (v);
+	  if (semi[u] < semi[w])
+	    semi[w] = semi[u];
+	}
+      bucket_next[w] = bucket_head[semi[w]];
+      bucket_head[semi[w]] = w;
+      link (parent[w], w);
+
+      for (size_t v = bucket_head[parent[w]]; v != 0; v = bucket_next[v])
+	{
+	  size_t u = eval (v);
+	  dom[v] = semi[u] < semi[v] ? u : parent[w];
+	}
+      bucket_head[parent[w]] = 0;
+    }
+
+  for (size_t w = 2; w <= N; w++)
+    if (dom[w] != semi[w])
+      dom[w] = dom[dom[w]];
+}
+
+void
+LengauerTarjan::compress (size_t v)
+{
+  stack.clear ();
+  for (size_t x = v; ancestor[ancestor[x]] != 0; x = ancestor[x])
+    stack.push_back (x);
+
+  while (! stack.empty ())
+    {
+      size_t x = stack.back ();
+      size_t a = ancestor[x];
+
+      stack.pop_back ();
+      if (semi[label[a]] < semi[label[x]])
+	label[x] = label[a];
+      ancestor[x] = ancestor[a];
+    }
+}
+
+size_t
+LengauerTarjan::eval (size_t v)
+{
+  if (ancestor[v] == 0)
+    return label[v];
+  compress (v);
+  if (semi[label[ancestor[v]]] >= semi[label[v]])
+    return label[v];
+  return label[ancestor[v]];
+}
+
+void
+LengauerTarjan::link (size_t v, size_t w)
+{
+  size_t s = w;
+
+  while (semi[label[w]] < semi[label[child[s]]])
+    {
+      if (size[s] + size[child[child[s]]] >= 2 * size[child[s]])
+	{
+	  ancestor[child[s]] = s;
+	  child[s] = child[child[s]];
+	}
+      else
+	{
+	  size[child[s]] = size[s];
+	  s = ancestor[s] = child[s];
+	}
+    }
+  label[s] = label[w];
+  size[v] += size[w];
+  if (size[v] < 2 * size[w])
+    swap (s, child[v]);
+  for (; s != 0; s = child[s])
+    ancestor[s] = v;
+}
+
+void
+LengauerTarjan::get_dominators (vector<size_t> &idom, vector<size_t> &pre,
+				vector<size_t> &post) const
+{
+  size_t N = vertex.size () - 1;
+
+  idom.assign (nb, GraphStructure::NONE);
+  pre.assign (nb, GraphStructure::NONE);
+  post.assign (nb, GraphStructure::NONE);
+  for (size_t w = 2; w <= N; w++)
+    idom[vertex[w]] = vertex[dom[w]];
+
+  /* Children in the dominator tree, sorted by parent */
+  vector<size_t> children_begin (N + 2, 0);
+  vector<size_t> children (N > 0 ? N - 1 : 0);
+
+  for (size_t w = 2; w <= N; w++)
+    children_begin[dom[w] + 1]++;
+  for (size_t w = 0; w <= N; w++)
+    children_begin[w + 1] += children_begin[w];
+
+  vector<size_t> next (children_begin.begin (), children_begin.end () - 1);
+  for (size_t w = 2; w <= N; w++)
+    children[next[dom[w]]++] = w;
+
+  vector< pair<size_t, size_t> > todo;
+  size_t pre_count = 0;
+  size_t post_count = 0;
+
+  pre[vertex[1]] = pre_count++;
+  todo.push_back (make_pair (1, children_begin[1]));
+  while (! todo.empty ())
+    {
+      size_t v = todo.back ().first;
+      size_t c = todo.back ().second;
+
+      if (c == children_begin[v + 1])
+	{
+	  post[vertex[v]] = post_count++;
+	  todo.pop_back ();
+	  continue;
+	}
+      todo.back ().second++;
+      pre[vertex[children[c]]] = pre_count++;
+      todo.push_back (make_pair (children[c], children_begin[children[c]]));
+    }
+}
+
+GraphStructure::GraphStructure (size_t nb_vertices, size_t entry,
+				const vector<size_t> &successors_begin,
+				const vector<size_t> &successors)
+  : nb_vertices (nb_vertices), entry (entry),
+    successors_begin (successors_begin), predecessors_begin (),
+    successors (successors), predecessors (),
+    idom (), dom_pre (), dom_post (), ipdom (), pdom_pre (), pdom_post (),
+    nb_sccs (0), sccs (), scc_order (),
+    loop_headers (), loop_parents (), loop_reducible (), loop_depths (),
+    innermost_loops ()
+{
+  compute ();
+}
+
+GraphStructure::GraphStructure (const FrozenMicrocode *prg)
+  : nb_vertices (prg->get_number_of_nodes ()), entry (prg->get_entry_id ()),
+    successors_begin (), predecessors_begin (),
+    successors (), predecessors (),
+    idom (), dom_pre (), dom_post (), ipdom (), pdom_pre (), pdom_post (),
+    nb_sccs (0), sccs (), scc_order (),
+    loop_headers (), loop_parents (), loop_reducible (), loop_depths (),
+    innermost_loops ()
+{
+  successors_begin.reserve (nb_vertices + 1);
+  successors.reserve (prg->get_number_of_arrows ());
+  for (size_t v = 0; v < nb_vertices; v++)
+    {
+      successors_begin.push_back (successors.size ());
+      for (size_t a = prg->get_successors_begin (v);
+	   a < prg->get_successors_end (v); a++)
+	if (prg->get_arrow_target (a) != FrozenMicrocode::NONE)
+	  successors.push_back (prg->get_arrow_target (a));
+    }
+  successors_begin.push_back (successors.size ());
+
+  compute ();
+}
+
+GraphStructure::~GraphStructure ()
+{
+}
+
+void
+GraphStructure::compute ()
+{
+  compute_predecessors ();
+  compute_sccs ();
+  compute_dominators ();
+  compute_post_dominators ();
+  compute_loops ();
+}
+
+void
+GraphStructure::compute_predecessors ()
+{
+  predecessors_begin.assign (nb_vertices + 1, 0);
+  for (size_t a = 0; a < successors.size (); a++)
+    predecessors_begin[successors[a] + 1]++;
+  for (size_t v = 0; v < nb_vertices; v++)
+    predecessors_begin[v + 1] += predecessors_begin[v];
+
+  vector<size_t> next (predecessors_begin.begin (),
+		       predecessors_begin.end () - 1);
+
+  predecessors.resize (successors.size ());
+  for (size_t v = 0; v < nb_vertices; v++)
+    for (size_t a = successors_begin[v]; a < successors_begin[v + 1]; a++)
+      predecessors[next[successors[a]]++] = v;
+}
+
+/* Tarjan's algorithm, with an explicit stack of the vertices being
+ * visited and of their next successor */
+void
+GraphStructure::compute_sccs ()
+{
+  vector<size_t> index (nb_vertices, NONE);
+  vector<size_t> low (nb_vertices, 0);
+  vector<bool> on_stack (nb_vertices, false);
+  vector<size_t> stack;
+  vector< pair<size_t, size_t> > todo;
+  size_t count = 0;
+
+  nb_sccs = 0;
+  sccs.assign (nb_vertices, NONE);
+  scc_order.clear ();
+  scc_order.reserve (nb_vertices);
+  for (size_t r = 0; r < nb_vertices; r++)
+    {
+      if (index[r] != NONE)
+	continue;
+
+      index[r] = low[r] = count++;
+      stack.push_back (r);
+      on_stack[r] = true;
+      todo.push_back (make_pair (r, successors_begin[r]));
+      while (! todo.empty ())
+	{
+	  size_t v = todo.back ().first;
+	  size_t a = todo.back ().second;
+
+	  if (a < successors_begin[v + 1])
+	    {
+	      size_t w = successors[a];
+
+	      todo.back ().second++;
+	      if (index[w] == NONE)
+		{
+		  index[w] = low[w] = count++;
+		  stack.push_back (w);
+		  on_stack[w] = true;
+		  todo.push_back (make_pair (w, successors_begin[w]));
+		}
+	      else if (on_stack[w] && index[w] < low[v])
+		low[v] = index[w];
+	      continue;
+	    }
+
+	  todo.pop_back ();
+	  if (! todo.empty () && low[v] < low[todo.back ().first])
+	    low[todo.back ().first] = low[v];
+	  if (low[v] != index[v])
+	    continue;
+
+	  size_t w;
+	  do
+	    {
+	      w = stack.back ();
+	      stack.pop_back ();
+	      on_stack[w] = false;
+	      sccs[w] = nb_sccs;
+	      scc_order.push_back (w);
+	    }
+	  while (w != v);
+	  nb_sccs++;
+	}
+    }
+}
+
+void
+GraphStructure::compute_dominators ()
+{
+  if (entry == NONE)
+    {
+      idom.assign (nb_vertices, NONE);
+      dom_pre.assign (nb_vertices, NONE);
+      dom_post.assign (nb_vertices, NONE);
+      return;
+    }
+
+  LengauerTarjan lt (nb_vertices, entry, successors_begin, successors,
+		     predecessors_begin, predecessors);
+  lt.get_dominators (idom, dom_pre, dom_post);
+}
+
+/* The reverse graph is augmented with the virtual exit X = nb_vertices.
+ * Components are taken in reverse topological order, so that a vertex
+ * that cannot reach an exit yet belongs to a terminal component: it is
+ * then made an exit, and the vertices that reach it are marked. The
+ * vertices without successors are the first ones found this way. */
+void
+GraphStructure::compute_post_dominators ()
+{
+  size_t X = nb_vertices;
+  vector<bool> is_exit (nb_vertices, false);
+  vector<bool> reaches_exit (nb_vertices, false);
+  vector<size_t> exits;
+  vector<size_t> todo;
+
+  for (size_t i = 0; i < nb_vertices; i++)
+    {
+      size_t x = scc_order[i];
+      if (reaches_exit[x])
+	continue;
+
+      is_exit[x] = reaches_exit[x] = true;
+      exits.push_back (x);
+      todo.push_back (x);
+      while (! todo.empty ())
+	{
+	  size_t v = todo.back ();
+
+	  todo.pop_back ();
+	  for (size_t p = predecessors_begin[v]; p < predecessors_begin[v + 1];
+	       p++)
+	    if (! reaches_exit[predecessors[p]])
+	      {
+		reaches_exit[predecessors[p]] = true;
+		todo.push_back (predecessors[p]);
+	      }
+	}
+    }
+
+  /* Successors in the reverse graph: the predecessors, then the exits
+   * for X */
+  vector<size_t> rsuccessors_begin (predecessors_begin);
+  vector<size_t> rsuccessors (predecessors);
+
+  rsuccessors.insert (rsuccessors.end (), exits.begin (), exits.end ());
+  rsuccessors_begin.push_back (rsuccessors.size ());
+
+  /* Predecessors in the reverse graph: the successors, and X for the
+   * exits */
+  vector<size_t> rpredecessors_begin (X + 2, 0);
+  vector<size_t> rpredecessors;
+
+  rpredecessors.reserve (successors.size () + exits.size ());
+  for (size_t v = 0; v < X; v++)
+    {
+      rpredecessors_begin[v] = rpredecessors.size ();
+      rpredecessors.insert (rpredecessors.end (),
+			    successors.begin () + successors_begin[v],
+			    successors.begin () + successors_begin[v + 1]);
+      if (is_exit[v])
+	rpredecessors.push_back (X);
+    }
+  rpredecessors_begin[X] = rpredecessors_begin[X + 1] = rpredecessors.size ();
+
+  LengauerTarjan lt (X + 1, X, rsuccessors_begin, rsuccessors,
+		     rpredecessors_begin, rpredecessors);
+  lt.get_dominators (ipdom, pdom_pre, pdom_post);
+  for (size_t v = 0; v < X; v++)
+    if (ipdom[v] == X)
+      ipdom[v] = NONE;
+}
+
+/* Representative of v in a union-find structure, with path
+ * compression */
+static size_t
+s_find (vector<size_t> &parent, size_t v)
+{
+  size_t r = v;
+
+  while (parent[r] != r)
+    r = parent[r];
+  while (parent[v] != r)
+    {
+      size_t next = parent[v];
+      parent[v] = r;
+      v = next;
+    }
+
+  return r;
+}
+
+/* Havlak's algorithm, with the handling of irreducible loops of
+ * Ramalingam that keeps it almost linear. The vertices are handled by
+ * their preorder number in the depth-first forest; last[w] is the
+ * greatest number in the subtree of w.
+ *
+ * The arcs of the forest and the back arcs are used as in Havlak's
+ * algorithm. Any other arc u -> v is only useful to the loops that
+ * contain the nearest common ancestor a of u and v in the forest: it is
+ * kept until a is handled, then becomes an arc from u to the header of
+ * the outermost loop built so far that contains v. The loops that
+ * contain v below a are entered by this arc, hence irreducible unless v
+ * is their header; so are all the loops that contain v when u is in
+ * another tree of the forest. */
+void
+GraphStructure::compute_loops ()
+{
+  size_t N = nb_vertices;
+  vector<size_t> number (N, NONE);
+  vector<size_t> vertex;
+  vector<size_t> parent (N, NONE);
+  vector<size_t> last (N, 0);
+  vector< pair<size_t, size_t> > todo;
+
+  /* Arcs that are neither in the forest nor back arcs, and the nearest
+   * common ancestor of their ends (NONE if they are in different
+   * trees), linked by ancestor. During the traversal, the ancestor of a
+   * visited vertex is the representative of its set in open; a vertex
+   * is merged into its parent when it is done. */
+  vector<size_t> open (N);
+  vector<bool> active (N, false);
+  vector<size_t> arc_source;
+  vector<size_t> arc_target;
+  vector<size_t> arc_ancestor;
+  vector<size_t> arc_next;
+  vector<size_t> arcs_head (N, NONE);
+
+  vertex.reserve (N);
+  for (size_t i = 0; i <= N; i++)
+    {
+      size_t r = i == 0 ? entry : i - 1;
+      if (r == NONE || number[r] != NONE)
+	continue;
+
+      number[r] = vertex.size ();
+      open[number[r]] = number[r];
+      active[number[r]] = true;
+      vertex.push_back (r);
+      todo.push_back (make_pair (r, successors_begin[r]));
+      while (! todo.empty ())
+	{
+	  size_t v = todo.back ().first;
+	  size_t a = todo.back ().second;
+	  size_t nv = number[v];
+
+	  if (a == successors_begin[v + 1])
+	    {
+	      last[nv] = vertex.size () - 1;
+	      active[nv] = false;
+	      if (parent[nv] != NONE)
+		open[nv] = parent[nv];
+	      todo.pop_back ();
+	      continue;
+	    }
+	  todo.back ().second++;
+
+	  size_t w = successors[a];
+	  if (number[w] == NONE)
+	    {
+	      number[w] = vertex.size ();
+	      open[number[w]] = number[w];
+	      active[number[w]] = true;
+	      parent[number[w]] = nv;
+	      vertex.push_back (w);
+	      todo.push_back (make_pair (w, successors_begin[w]));
+	    }
+	  else if (! active[number[w]])
+	    {
+	      size_t ancestor = s_find (open, number[w]);
+
+	      if (! active[ancestor])
+		ancestor = NONE;
+	      arc_source.push_back (nv);
+	      arc_target.push_back (number[w]);
+	      arc_ancestor.push_back (ancestor);
+	      arc_next.push_back (NONE);
+	      if (ancestor != NONE)
+		{
+		  arc_next.back () = arcs_head[ancestor];
+		  arcs_head[ancestor] = arc_source.size () - 1;
+		}
+	    }
+	}
+    }
+
+  /* header[v] is v, or the header of a loop containing v; extra
+   * predecessors are those of the arcs above */
+  vector<size_t> header (N);
+  for (size_t w = 0; w < N; w++)
+    header[w] = w;
+
+  vector<size_t> extra_head (N, NONE);
+  vector<size_t> extra_next (arc_source.size (), NONE);
+  vector<size_t> pool_stamp (N, NONE);
+  vector<size_t> pool;
+  vector<size_t> loop_of (N, NONE);
+
+  loop_headers.clear ();
+  loop_parents.clear ();
+  innermost_loops.assign (N, NONE);
+  for (size_t w = N; w-- > 0; )
+    {
+      for (size_t e = arcs_head[w]; e != NONE; e = arc_next[e])
+	{
+	  size_t v = s_find (header, arc_target[e]);
+
+	  extra_next[e] = extra_head[v];
+	  extra_head[v] = e;
+	}
+
+      size_t x = vertex[w];
+      bool self = false;
+
+      pool.clear ();
+      for (size_t p = predecessors_begin[x]; p < predecessors_begin[x + 1];
+	   p++)
+	{
+	  size_t v = number[predecessors[p]];
+
+	  if (v < w || v > last[w])
+	    continue;
+	  if (v == w)
+	    {
+	      self = true;
+	      continue;
+	    }
+
+	  v = s_find (header, v);
+	  if (pool_stamp[v] != w)
+	    {
+	      pool_stamp[v] = w;
+	      pool.push_back (v);
+	    }
+	}
+      if (pool.empty () && ! self)
+	continue;
+
+      /* The parent and the extra predecessors of the vertices of the
+       * loop are in the subtree of w */
+      for (size_t i = 0; i < pool.size (); i++)
+	{
+	  size_t y = pool[i];
+	  size_t e = extra_head[y];
+	  size_t z = parent[y];
+
+	  for (;;)
+	    {
+	      z = s_find (header, z);
+	      assert (w <= z && z <= last[w]);
+	      if (z != w && pool_stamp[z] != w)
+		{
+		  pool_stamp[z] = w;
+		  pool.push_back (z);
+		}
+
+	      if (e == NONE)
+		break;
+	      z = arc_source[e];
+	      e = extra_next[e];
+	    }
+	}
+
+      size_t l = loop_headers.size ();
+      loop_headers.push_back (x);
+      loop_parents.push_back (NONE);
+      loop_of[w] = l;
+      innermost_loops[x] = l;
+      for (size_t i = 0; i < pool.size (); i++)
+	{
+	  size_t y = pool[i];
+
+	  header[y] = w;
+	  if (loop_of[y] != NONE)
+	    loop_parents[loop_of[y]] = l;
+	  else
+	    innermost_loops[vertex[y]] = l;
+	}
+    }
+
+  /* The loops entered by an arc of the first list are those from the
+   * innermost loop of its target, or from the next one if the target is
+   * its header, up to the loops whose header precedes limit. Limits go
+   * from the inner loops to the outer ones. */
+  size_t nb_loops = loop_headers.size ();
+  vector<size_t> limit (nb_loops, N);
+
+  for (size_t e = 0; e < arc_source.size (); e++)
+    {
+      size_t v = vertex[arc_target[e]];
+      size_t l = innermost_loops[v];
+
+      if (l != NONE && loop_headers[l] == v)
+	l = loop_parents[l];
+      if (l == NONE)
+	continue;
+
+      size_t lim = arc_ancestor[e] == NONE ? 0 : arc_ancestor[e] + 1;
+      if (lim < limit[l])
+	limit[l] = lim;
+    }
+
+  loop_reducible.assign (nb_loops, true);
+  loop_depths.assign (nb_loops, 1);
+  for (size_t l = 0; l < nb_loops; l++)
+    {
+      size_t p = loop_parents[l];
+
+      loop_reducible[l] = number[loop_headers[l]] < limit[l];
+      if (p != NONE && limit[l] < limit[p])
+	limit[p] = limit[l];
+    }
+  for (size_t l = nb_loops; l-- > 0; )
+    if (loop_parents[l] != NONE)
+      loop_depths[l] = loop_depths[loop_parents[l]] + 1;
+}
+
+size_t
+GraphStructure::get_number_of_vertices () const
+{
+  return nb_vertices;
+}
+
+size_t
+GraphStructure::get_entry () const
+{
+  return entry;
+}
+
+size_t
+GraphStructure::get_immediate_dominator (size_t v) const
+{
+  return idom[v];
+}
+
+bool
+GraphStructure::is_reachable (size_t v) const
+{
+  return dom_pre[v] != NONE;
+}
+
+bool
+GraphStructure::dominates (size_t a, size_t b) const
+{
+  return (is_reachable (a) && is_reachable (b) &&
+	  dom_pre[a] <= dom_pre[b] && dom_post[b] <= dom_post[a]);
+}
+
+size_t
+GraphStructure::get_immediate_post_dominator (size_t v) const
+{
+  return ipdom[v];
+}
+
+bool
+GraphStructure::post_dominates (size_t a, size_t b) const
+{
+  return pdom_pre[a] <= pdom_pre[b] && pdom_post[b] <= pdom_post[a];
+}
+
+size_t
+GraphStructure::get_number_of_sccs () const
+{
+  return nb_sccs;
+}
+
+size_t
+GraphStructure::get_scc (size_t v) const
+{
+  return sccs[v];
+}
+
+size_t
+GraphStructure::get_number_of_loops () const
+{
+  return loop_headers.size ();
+}
+
+size_t
+GraphStructure::get_loop_header (size_t l) const
+{
+  return loop_headers[l];
+}
+
+size_t
+GraphStructure::get_loop_parent (size_t l) const
+{
+  return loop_parents[l];
+}
+
+bool
+GraphStructure::is_loop_reducible (size_t l) const
+{
+  return loop_reducible[l];
+}
+
+size_t
+GraphStructure::get_loop_depth (size_t l) const
+{
+  return loop_depths[l];
+}
+
+size_t
+GraphStructure::get_innermost_loop (size_t v) const
+{
+  return innermost_loops[v];
+}
+
+static void
+s_output_vertex (ostream &out, size_t v)
+{
+  if (v == GraphStructure::NONE)
+    out << "-";
+  else
+    out << v;
+}
+
+void
+GraphStructure::output_text (ostream &out) const
+{
+  for (size_t v = 0; v < nb_vertices; v++)
+    {
+      out << v << ": idom ";
+      s_output_vertex (out, idom[v]);
+      out << ", ipdom ";
+      s_output_vertex (out, ipdom[v]);
+      out << ", scc " << sccs[v] << ", loop ";
+      s_output_vertex (out, innermost_loops[v]);
+      out << endl;
+    }
+
+  for (size_t l = 0; l < loop_headers.size (); l++)
+    {
+      out << "loop " << l << ": header " << loop_headers[l] << ", parent ";
+      s_output_vertex (out, loop_parents[l]);
+      out << ", depth " << loop_depths[l]
+	  << (loop_reducible[l] ? "" : ", irreducible") << endl;
+    }
+}
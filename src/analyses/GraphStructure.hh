@@ -0,0 +1,164 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef ANALYSES_GRAPHSTRUCTURE_HH
+# define ANALYSES_GRAPHSTRUCTURE_HH
+
+# include <iostream>
+# include <vector>
+# include <utils/graph.hh>
+# include <kernel/FrozenMicrocode.hh>
+
+/*! Dominators, post-dominators, strongly connected components and loop
+ *  nesting forest of a directed graph.
+ *
+ *  The vertices are numbered from 0. The graph is given in compressed
+ *  sparse row form, built from a FrozenMicrocode snapshot (the vertices
+ *  are then the identifiers of the snapshot and the arrows without a
+ *  target are ignored), or from any GraphInterface such as CFG or
+ *  Microcode (the vertices are then the nodes in the order of
+ *  begin_nodes ()). Everything is computed once, in time almost linear
+ *  in the size of the graph, and every query below is answered in
+ *  constant time.
+ *
+ *  - Dominators are computed with the Lengauer-Tarjan algorithm over
+ *    the vertices reachable from the entry; the other vertices have no
+ *    dominator and dominate nothing.
+ *  - Post-dominators are computed on the reverse graph, from a virtual
+ *    exit that follows the vertices without successors and, so that
+ *    every vertex has one, a vertex of each terminal strongly connected
+ *    component that cannot reach them (an infinite loop).
+ *  - Components are numbered in reverse topological order: if there is
+ *    an arc from u to v and they are not in the same component, the
+ *    component of u has a greater number than the one of v.
+ *  - The loop nesting forest is built with Havlak's algorithm over a
+ *    depth-first forest started from the entry, then from the unvisited
+ *    vertices by increasing number. A loop is identified by its header;
+ *    a loop with several entries (irreducible) is headed by the entry
+ *    met first by the traversal. Inner loops are numbered before the
+ *    loops that contain them. */
+class GraphStructure
+{
+public:
+  /* Number of no vertex or no loop */
+  static const std::size_t NONE;
+
+  /*! The successors of vertex v are successors[i] for i from
+   *  successors_begin[v] to successors_begin[v + 1] - 1. entry may be
+   *  NONE. */
+  GraphStructure (std::size_t nb_vertices, std::size_t entry,
+		  const std::vector<std::size_t> &successors_begin,
+		  const std::vector<std::size_t> &successors);
+
+  explicit GraphStructure (const FrozenMicrocode *prg);
+
+  /*! The structure of G; vertex i is the i-th node of G->begin_nodes ().
+   *  The arcs are read from the predecessors of the nodes. */
+  template<typename Node, typename Edge, typename NodeStore>
+  static GraphStructure *
+  create (const GraphInterface<Node, Edge, NodeStore> *G);
+
+  ~GraphStructure ();
+
+  std::size_t get_number_of_vertices () const;
+  std::size_t get_entry () const;
+
+  /*! The immediate dominator of v, or NONE for the entry and for the
+   *  vertices that are not reachable from it. */
+  std::size_t get_immediate_dominator (std::size_t v) const;
+  bool is_reachable (std::size_t v) const;
+  /*! True if every path from the entry to b goes through a; a vertex
+   *  dominates itself. */
+  bool dominates (std::size_t a, std::size_t b) const;
+
+  /*! The immediate post-dominator of v, or NONE if it is the virtual
+   *  exit. */
+  std::size_t get_immediate_post_dominator (std::size_t v) const;
+  bool post_dominates (std::size_t a, std::size_t b) const;
+
+  std::size_t get_number_of_sccs () const;
+  std::size_t get_scc (std::size_t v) const;
+
+  std::size_t get_number_of_loops () const;
+  std::size_t get_loop_header (std::size_t l) const;
+  /*! The innermost loop containing loop l, or NONE */
+  std::size_t get_loop_parent (std::size_t l) const;
+  /*! True if loop l is only entered through its header */
+  bool is_loop_reducible (std::size_t l) const;
+  /*! Number of loops containing loop l, itself included */
+  std::size_t get_loop_depth (std::size_t l) const;
+  /*! The innermost loop containing v, or NONE */
+  std::size_t get_innermost_loop (std::size_t v) const;
+
+  void output_text (std::ostream &out) const;
+
+private:
+  void compute ();
+  void compute_predecessors ();
+  void compute_sccs ();
+  void compute_dominators ();
+  void compute_post_dominators ();
+  void compute_loops ();
+
+  std::size_t nb_vertices;
+  std::size_t entry;
+
+  /* Indexed by vertex, with a last element for the end of the last
+   * vertex */
+  std::vector<std::size_t> successors_begin;
+  std::vector<std::size_t> predecessors_begin;
+  std::vector<std::size_t> successors;
+  std::vector<std::size_t> predecessors;
+
+  /* Preorder and postorder numbers of the vertices in the dominator
+   * trees; the virtual exit is vertex nb_vertices of the post-dominator
+   * tree. */
+  std::vector<std::size_t> idom;
+  std::vector<std::size_t> dom_pre;
+  std::vector<std::size_t> dom_post;
+  std::vector<std::size_t> ipdom;
+  std::vector<std::size_t> pdom_pre;
+  std::vector<std::size_t> pdom_post;
+
+  std::size_t nb_sccs;
+  std::vector<std::size_t> sccs;
+  /* Vertices grouped by component, components in increasing order */
+  std::vector<std::size_t> scc_order;
+
+  std::vector<std::size_t> loop_headers;
+  std::vector<std::size_t> loop_parents;
+  std::vector<bool> loop_reducible;
+  std::vector<std::size_t> loop_depths;
+  std::vector<std::size_t> innermost_loops;
+};
+
+# include "GraphStructure.ii"
+
+#endif /* ! ANALYSES_GRAPHSTRUCTURE_HH */
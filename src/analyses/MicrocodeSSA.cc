@@ -0,0 +1,826 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "MicrocodeSSA.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include <analyses/GraphStructure.hh>
+#include <kernel/Expressions.hh>
+#include <kernel/annotations/SolvedJmpAnnotation.hh>
+#include <kernel/expressions/exprutils.hh>
+
+using namespace std;
+using namespace exprutils;
+
+const size_t MicrocodeSSA::NONE = (size_t) -1;
+
+/* Expressions read by the statement of arr, including the address of an
+ * assigned memory cell. */
+static void
+s_read_expressions (StmtArrow *arr, vector<const Expr *> &exprs)
+{
+  Statement *stmt = arr->get_stmt ();
+
+  if (arr->get_condition () != NULL)
+    exprs.push_back (arr->get_condition ());
+
+  if (stmt->is_Assignment ())
+    {
+      Assignment *a = (Assignment *) stmt;
+      exprs.push_back (a->get_rval ());
+      if (a->get_lval ()->is_MemCell ())
+	exprs.push_back (((const MemCell *) a->get_lval ())->get_addr ());
+    }
+  else if (stmt->is_Jump ())
+    exprs.push_back (((Jump *) stmt)->get_target ());
+
+  DynamicArrow *da = dynamic_cast<DynamicArrow *> (arr);
+  if (da != NULL)
+    exprs.push_back (da->get_target ());
+}
+
+static bool
+s_has_constant_address (const LValue *lv)
+{
+  return lv->is_MemCell () && ((const MemCell *) lv)->get_addr ()->is_Constant ();
+}
+
+static address_t
+s_cell_address (const LValue *lv)
+{
+  return ((Constant *) ((const MemCell *) lv)->get_addr ())->get_val ();
+}
+
+/* Number of bytes from the address of a memory cell to its last bit */
+static size_t
+s_cell_nb_bytes (const LValue *lv)
+{
+  return (lv->get_bv_offset () + lv->get_bv_size () + 7) / 8;
+}
+
+/*****************************************************************************/
+
+MicrocodeSSA::MicrocodeSSA (const Microcode *prg) : prg (prg)
+{
+  for (Microcode::const_node_iterator n = prg->begin_nodes ();
+       n != prg->end_nodes (); n++)
+    {
+      node_indexes[*n] = nodes.size ();
+      nodes.push_back (*n);
+      for (size_t s = 0; s < (*n)->get_successors ()->size (); s++)
+	{
+	  StmtArrow *arr = (*n)->get_successors ()->at (s);
+	  arrow_indexes[arr] = arrows.size ();
+	  arrows.push_back (arr);
+	}
+    }
+
+  number_variables ();
+
+  for (size_t v = 0; v < variables.size (); v++)
+    {
+      Definition d;
+      d.kind = ENTRY_DEF;
+      d.variable = v;
+      d.arrow = NULL;
+      d.node = NULL;
+      d.partial = false;
+      entry_definitions.push_back (definitions.size ());
+      definitions.push_back (d);
+    }
+
+  arrow_definitions.resize (arrows.size ());
+  arrow_uses.resize (arrows.size ());
+  vector<size_t> stamps (variables.size (), NONE);
+  for (size_t a = 0; a < arrows.size (); a++)
+    add_statement (a, stamps);
+
+  build_graph ();
+  compute_dominators ();
+  place_phis ();
+  rename ();
+}
+
+MicrocodeSSA::~MicrocodeSSA ()
+{
+}
+
+void
+MicrocodeSSA::number_variables ()
+{
+  vector<pair<address_t, uint64_t> > cells;
+
+  for (size_t a = 0; a < arrows.size (); a++)
+    {
+      vector<const Expr *> exprs;
+      Statement *stmt = arrows[a]->get_stmt ();
+
+      s_read_expressions (arrows[a], exprs);
+      if (stmt->is_Assignment ())
+	exprs.push_back (((Assignment *) stmt)->get_lval ());
+
+      for (size_t e = 0; e < exprs.size (); e++)
+	{
+	  list<const LValue *> lvs =
+	    collect_subterms_of_type<list<const LValue *>, LValue>
+	    (exprs[e], false);
+
+	  for (list<const LValue *>::iterator lv = lvs.begin ();
+	       lv != lvs.end (); lv++)
+	    {
+	      if ((*lv)->is_RegisterExpr ())
+		{
+		  const RegisterDesc *reg =
+		    ((const RegisterExpr *) *lv)->get_descriptor ();
+		  if (register_variables.find (reg) != register_variables.end ())
+		    continue;
+
+		  Variable var;
+		  var.is_register = true;
+		  var.reg = reg;
+		  var.addr = 0;
+		  var.nb_bytes = 0;
+		  register_variables[reg] = variables.size ();
+		  variables.push_back (var);
+		}
+	      else if (s_has_constant_address (*lv))
+		{
+		  address_t addr = s_cell_address (*lv);
+		  cells.push_back (make_pair (addr,
+					      (uint64_t) addr +
+					      s_cell_nb_bytes (*lv)));
+		}
+	    }
+	}
+    }
+
+  // Overlapping cells are merged into one variable
+  sort (cells.begin (), cells.end ());
+  for (size_t c = 0; c < cells.size (); )
+    {
+      uint64_t end = cells[c].second;
+      size_t next = c + 1;
+
+      while (next < cells.size () && cells[next].first < end)
+	end = max (end, cells[next++].second);
+
+      Variable var;
+      var.is_register = false;
+      var.reg = NULL;
+      var.addr = cells[c].first;
+      var.nb_bytes = end - cells[c].first;
+      memory_variables.push_back (variables.size ());
+      variables.push_back (var);
+      c = next;
+    }
+}
+
+size_t
+MicrocodeSSA::get_memory_variable (address_t addr) const
+{
+  size_t lo = 0;
+  size_t hi = memory_variables.size ();
+
+  // Last variable starting at or before addr
+  while (lo < hi)
+    {
+      size_t mid = (lo + hi) / 2;
+      if (variables[memory_variables[mid]].addr <= addr)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  if (lo == 0)
+    return NONE;
+
+  const Variable &var = variables[memory_variables[lo - 1]];
+  if ((uint64_t) addr >= (uint64_t) var.addr + var.nb_bytes)
+    return NONE;
+
+  return memory_variables[lo - 1];
+}
+
+void
+MicrocodeSSA::add_statement_uses (size_t a, const Expr *e,
+				  vector<size_t> &stamps)
+{
+  list<const LValue *> lvs =
+    collect_subterms_of_type<list<const LValue *>, LValue> (e, false);
+  vector<size_t> vars;
+
+  for (list<const LValue *>::iterator lv = lvs.begin (); lv != lvs.end ();
+       lv++)
+    {
+      if ((*lv)->is_MemCell () && ! s_has_constant_address (*lv))
+	vars.insert (vars.end (), memory_variables.begin (),
+		     memory_variables.end ());
+      else
+	vars.push_back (find_variable (*lv));
+    }
+
+  for (size_t i = 0; i < vars.size (); i++)
+    {
+      if (vars[i] == NONE || stamps[vars[i]] == a)
+	continue;
+      stamps[vars[i]] = a;
+
+      Use u;
+      u.variable = vars[i];
+      u.definition = NONE;
+      u.arrow = arrows[a];
+      u.phi = NONE;
+      u.operand = 0;
+      arrow_uses[a].push_back (uses.size ());
+      uses.push_back (u);
+    }
+}
+
+void
+MicrocodeSSA::add_statement (size_t a, vector<size_t> &stamps)
+{
+  vector<const Expr *> exprs;
+  Statement *stmt = arrows[a]->get_stmt ();
+
+  s_read_expressions (arrows[a], exprs);
+  for (size_t e = 0; e < exprs.size (); e++)
+    add_statement_uses (a, exprs[e], stamps);
+
+  if (! stmt->is_Assignment ())
+    return;
+
+  const LValue *lv = ((Assignment *) stmt)->get_lval ();
+  vector<pair<size_t, bool> > defs;
+
+  if (lv->is_RegisterExpr ())
+    {
+      const RegisterDesc *reg = ((const RegisterExpr *) lv)->get_descriptor ();
+      defs.push_back (make_pair (find_variable (lv),
+				 (lv->get_bv_offset () != 0 ||
+				  lv->get_bv_size () !=
+				  (int) reg->get_register_size ())));
+    }
+  else if (s_has_constant_address (lv))
+    {
+      size_t v = find_variable (lv);
+      defs.push_back (make_pair (v, (variables[v].addr != s_cell_address (lv) ||
+				     lv->get_bv_offset () != 0 ||
+				     (size_t) lv->get_bv_size () !=
+				     8 * variables[v].nb_bytes)));
+    }
+  else
+    {
+      for (size_t m = 0; m < memory_variables.size (); m++)
+	defs.push_back (make_pair (memory_variables[m], true));
+    }
+
+  // A partial definition keeps a part of the previous version
+  for (size_t i = 0; i < defs.size (); i++)
+    {
+      if (! defs[i].second || stamps[defs[i].first] == a)
+	continue;
+      stamps[defs[i].first] = a;
+
+      Use u;
+      u.variable = defs[i].first;
+      u.definition = NONE;
+      u.arrow = arrows[a];
+      u.phi = NONE;
+      u.operand = 0;
+      arrow_uses[a].push_back (uses.size ());
+      uses.push_back (u);
+    }
+
+  for (size_t i = 0; i < defs.size (); i++)
+    {
+      Definition d;
+      d.kind = ARROW_DEF;
+      d.variable = defs[i].first;
+      d.arrow = arrows[a];
+      d.node = NULL;
+      d.partial = defs[i].second;
+      arrow_definitions[a].push_back (definitions.size ());
+      definitions.push_back (d);
+    }
+}
+
+void
+MicrocodeSSA::build_graph ()
+{
+  size_t N = nodes.size ();
+  size_t V = 1 + N + arrows.size ();
+  vector<size_t> seen (N, NONE);
+
+  succs.resize (V);
+  preds.resize (V);
+
+  for (size_t a = 0; a < arrows.size (); a++)
+    {
+      StmtArrow *arr = arrows[a];
+      size_t va = 1 + N + a;
+      size_t src = node_indexes.find (arr->get_src ())->second;
+      vector<MicrocodeAddress> tgts;
+      Option<MicrocodeAddress> tgtopt = arr->extract_target ();
+
+      succs[1 + src].push_back (make_pair (va, preds[va].size ()));
+      preds[va].push_back (1 + src);
+
+      if (tgtopt.hasValue ())
+	tgts.push_back (tgtopt.getValue ());
+      else if (arr->has_annotation (SolvedJmpAnnotation::ID))
+	{
+	  SolvedJmpAnnotation *sja = (SolvedJmpAnnotation *)
+	    arr->get_annotation (SolvedJmpAnnotation::ID);
+	  for (SolvedJmpAnnotation::const_iterator i = sja->begin ();
+	       i != sja->end (); i++)
+	    tgts.push_back (*i);
+	}
+
+      for (size_t t = 0; t < tgts.size (); t++)
+	{
+	  if (! prg->has_node_at (tgts[t]))
+	    continue;
+
+	  size_t tgt = node_indexes.find (prg->get_node (tgts[t]))->second;
+	  if (seen[tgt] == a)
+	    continue;
+	  seen[tgt] = a;
+	  succs[va].push_back (make_pair (1 + tgt, preds[1 + tgt].size ()));
+	  preds[1 + tgt].push_back (va);
+	}
+    }
+
+  // The root enters the entry point and the nodes without predecessors
+  vector<size_t> entries;
+  if (prg->has_node_at (prg->entry_point ()))
+    entries.push_back (node_indexes.find (prg->get_entry_point ())->second);
+  for (size_t n = 0; n < N; n++)
+    if (preds[1 + n].empty () && (entries.empty () || entries[0] != n))
+      entries.push_back (n);
+  for (size_t e = 0; e < entries.size (); e++)
+    {
+      succs[0].push_back (make_pair (1 + entries[e],
+				     preds[1 + entries[e]].size ()));
+      preds[1 + entries[e]].push_back (0);
+    }
+}
+
+void
+MicrocodeSSA::compute_dominators ()
+{
+  size_t N = nodes.size ();
+  size_t V = succs.size ();
+  vector<bool> visited (V, false);
+  vector<size_t> stack;
+  size_t unvisited = 0;
+
+  // Search from the root. Once everything it reaches is visited, the
+  // root is given an edge to the first node not visited yet, thus the
+  // cycles that cannot be reached from an entry are dominated too.
+  visited[0] = true;
+  stack.push_back (0);
+  while (! stack.empty ())
+    {
+      size_t v = stack.back ();
+      stack.pop_back ();
+      for (size_t s = 0; s < succs[v].size (); s++)
+	{
+	  size_t w = succs[v][s].first;
+	  if (! visited[w])
+	    {
+	      visited[w] = true;
+	      stack.push_back (w);
+	    }
+	}
+
+      if (stack.empty ())
+	{
+	  while (unvisited < N && visited[1 + unvisited])
+	    unvisited++;
+	  if (unvisited < N)
+	    {
+	      succs[0].push_back (make_pair (1 + unvisited,
+					     preds[1 + unvisited].size ()));
+	      preds[1 + unvisited].push_back (0);
+	      visited[1 + unvisited] = true;
+	      stack.push_back (1 + unvisited);
+	    }
+	}
+    }
+
+  vector<size_t> begin (V + 1, 0);
+  vector<size_t> successors;
+  for (size_t v = 0; v < V; v++)
+    {
+      for (size_t s = 0; s < succs[v].size (); s++)
+	successors.push_back (succs[v][s].first);
+      begin[v + 1] = successors.size ();
+    }
+
+  GraphStructure G (V, 0, begin, successors);
+
+  idoms.resize (V);
+  idoms[0] = 0;
+  for (size_t v = 1; v < V; v++)
+    {
+      idoms[v] = G.get_immediate_dominator (v);
+      assert (idoms[v] != NONE);
+    }
+
+  // Dominance frontiers: a join point is in the frontier of the vertices
+  // from its predecessors up to its immediate dominator. Arrows have a
+  // single predecessor, thus frontiers only hold nodes.
+  frontiers.resize (V);
+  for (size_t v = 1; v < V; v++)
+    {
+      if (preds[v].size () < 2)
+	continue;
+
+      for (size_t p = 0; p < preds[v].size (); p++)
+	{
+	  for (size_t runner = preds[v][p]; runner != idoms[v];
+	       runner = idoms[runner])
+	    {
+	      if (! frontiers[runner].empty () && frontiers[runner].back () == v)
+		break;
+	      frontiers[runner].push_back (v);
+	    }
+	}
+    }
+
+  node_frontiers.resize (N);
+  for (size_t n = 0; n < N; n++)
+    for (size_t f = 0; f < frontiers[1 + n].size (); f++)
+      node_frontiers[n].push_back (nodes[frontiers[1 + n][f] - 1]);
+}
+
+void
+MicrocodeSSA::place_phis ()
+{
+  size_t N = nodes.size ();
+  size_t V = succs.size ();
+  vector<vector<size_t> > sites (variables.size ());
+  vector<bool> used (variables.size (), false);
+  vector<size_t> has_phi (V, NONE);
+  vector<size_t> added (V, NONE);
+
+  for (size_t u = 0; u < uses.size (); u++)
+    used[uses[u].variable] = true;
+  for (size_t a = 0; a < arrows.size (); a++)
+    for (size_t d = 0; d < arrow_definitions[a].size (); d++)
+      sites[definitions[arrow_definitions[a][d]].variable].push_back
+	(1 + N + a);
+
+  incoming_arrows.resize (N);
+  for (size_t n = 0; n < N; n++)
+    for (size_t p = 0; p < preds[1 + n].size (); p++)
+      incoming_arrows[n].push_back (preds[1 + n][p] == 0 ? NULL :
+				    arrows[preds[1 + n][p] - 1 - N]);
+
+  // Phi-functions are only placed for variables that are used
+  // ("semi-pruned" form), at the iterated dominance frontier of their
+  // definitions.
+  node_phis.resize (N);
+  for (size_t v = 0; v < variables.size (); v++)
+    {
+      if (! used[v])
+	continue;
+
+      vector<size_t> &worklist = sites[v];
+      worklist.push_back (0);
+      for (size_t w = 0; w < worklist.size (); w++)
+	added[worklist[w]] = v;
+
+      while (! worklist.empty ())
+	{
+	  size_t x = worklist.back ();
+	  worklist.pop_back ();
+
+	  for (size_t f = 0; f < frontiers[x].size (); f++)
+	    {
+	      size_t y = frontiers[x][f];
+	      if (has_phi[y] == v)
+		continue;
+	      has_phi[y] = v;
+
+	      Definition d;
+	      d.kind = PHI_DEF;
+	      d.variable = v;
+	      d.arrow = NULL;
+	      d.node = nodes[y - 1];
+	      d.partial = false;
+	      d.operands.assign (preds[y].size (), NONE);
+	      node_phis[y - 1].push_back (definitions.size ());
+	      definitions.push_back (d);
+
+	      if (added[y] != v)
+		{
+		  added[y] = v;
+		  worklist.push_back (y);
+		}
+	    }
+	}
+    }
+}
+
+void
+MicrocodeSSA::rename ()
+{
+  size_t N = nodes.size ();
+  size_t V = succs.size ();
+  vector<vector<size_t> > children (V);
+  vector<vector<size_t> > stacks (variables.size ());
+  vector<size_t> pushed;
+  // Vertex, next child and size of 'pushed' when the vertex was entered
+  vector<pair<size_t, pair<size_t, size_t> > > walk;
+
+  for (size_t v = 1; v < V; v++)
+    children[idoms[v]].push_back (v);
+  def_uses.resize (definitions.size ());
+
+  walk.push_back (make_pair ((size_t) 0, make_pair ((size_t) 0, (size_t) 0)));
+  while (! walk.empty ())
+    {
+      size_t v = walk.back ().first;
+      size_t &c = walk.back ().second.first;
+
+      if (c == 0)
+	{
+	  if (v == 0)
+	    for (size_t var = 0; var < variables.size (); var++)
+	      {
+		stacks[var].push_back (entry_definitions[var]);
+		pushed.push_back (var);
+	      }
+	  else if (v <= N)
+	    for (size_t p = 0; p < node_phis[v - 1].size (); p++)
+	      {
+		size_t d = node_phis[v - 1][p];
+		stacks[definitions[d].variable].push_back (d);
+		pushed.push_back (definitions[d].variable);
+	      }
+	  else
+	    {
+	      size_t a = v - 1 - N;
+	      for (size_t u = 0; u < arrow_uses[a].size (); u++)
+		{
+		  Use &use = uses[arrow_uses[a][u]];
+		  use.definition = stacks[use.variable].back ();
+		  def_uses[use.definition].push_back (arrow_uses[a][u]);
+		}
+	      for (size_t d = 0; d < arrow_definitions[a].size (); d++)
+		{
+		  size_t var = definitions[arrow_definitions[a][d]].variable;
+		  stacks[var].push_back (arrow_definitions[a][d]);
+		  pushed.push_back (var);
+		}
+	    }
+
+	  for (size_t s = 0; s < succs[v].size (); s++)
+	    {
+	      size_t w = succs[v][s].first;
+	      if (w > N)
+		continue;
+
+	      for (size_t p = 0; p < node_phis[w - 1].size (); p++)
+		{
+		  Definition &phi = definitions[node_phis[w - 1][p]];
+		  Use use;
+		  use.variable = phi.variable;
+		  use.definition = stacks[phi.variable].back ();
+		  use.arrow = (v == 0 ? NULL : arrows[v - 1 - N]);
+		  use.phi = node_phis[w - 1][p];
+		  use.operand = succs[v][s].second;
+		  phi.operands[use.operand] = use.definition;
+		  def_uses[use.definition].push_back (uses.size ());
+		  uses.push_back (use);
+		}
+	    }
+	}
+
+      if (c < children[v].size ())
+	{
+	  size_t w = children[v][c++];
+	  walk.push_back (make_pair (w, make_pair ((size_t) 0, pushed.size ())));
+	  continue;
+	}
+
+      for (size_t mark = walk.back ().second.second; pushed.size () > mark;
+	   pushed.pop_back ())
+	stacks[pushed.back ()].pop_back ();
+      walk.pop_back ();
+    }
+}
+
+/*****************************************************************************/
+
+const Microcode *
+MicrocodeSSA::get_program () const
+{
+  return prg;
+}
+
+size_t
+MicrocodeSSA::get_number_of_variables () const
+{
+  return variables.size ();
+}
+
+size_t
+MicrocodeSSA::get_number_of_definitions () const
+{
+  return definitions.size ();
+}
+
+size_t
+MicrocodeSSA::get_number_of_uses () const
+{
+  return uses.size ();
+}
+
+const MicrocodeSSA::Variable &
+MicrocodeSSA::get_variable (size_t v) const
+{
+  return variables[v];
+}
+
+const MicrocodeSSA::Definition &
+MicrocodeSSA::get_definition (size_t d) const
+{
+  return definitions[d];
+}
+
+const MicrocodeSSA::Use &
+MicrocodeSSA::get_use (size_t u) const
+{
+  return uses[u];
+}
+
+size_t
+MicrocodeSSA::find_variable (const LValue *lv) const
+{
+  if (lv->is_RegisterExpr ())
+    {
+      unordered_map<const RegisterDesc *, size_t>::const_iterator i =
+	register_variables.find (((const RegisterExpr *) lv)->get_descriptor ());
+      return i == register_variables.end () ? NONE : i->second;
+    }
+  if (s_has_constant_address (lv))
+    return get_memory_variable (s_cell_address (lv));
+
+  return NONE;
+}
+
+size_t
+MicrocodeSSA::get_entry_definition (size_t v) const
+{
+  return entry_definitions[v];
+}
+
+size_t
+MicrocodeSSA::get_node_index (const MicrocodeNode *n) const
+{
+  unordered_map<const MicrocodeNode *, size_t>::const_iterator i =
+    node_indexes.find (n);
+  assert (i != node_indexes.end ());
+
+  return i->second;
+}
+
+size_t
+MicrocodeSSA::get_arrow_index (const StmtArrow *arr) const
+{
+  unordered_map<const StmtArrow *, size_t>::const_iterator i =
+    arrow_indexes.find (arr);
+  assert (i != arrow_indexes.end ());
+
+  return i->second;
+}
+
+const vector<size_t> &
+MicrocodeSSA::get_definitions (const StmtArrow *arr) const
+{
+  return arrow_definitions[get_arrow_index (arr)];
+}
+
+const vector<size_t> &
+MicrocodeSSA::get_uses (const StmtArrow *arr) const
+{
+  return arrow_uses[get_arrow_index (arr)];
+}
+
+const vector<size_t> &
+MicrocodeSSA::get_phis (const MicrocodeNode *n) const
+{
+  return node_phis[get_node_index (n)];
+}
+
+const vector<StmtArrow *> &
+MicrocodeSSA::get_incoming_arrows (const MicrocodeNode *n) const
+{
+  return incoming_arrows[get_node_index (n)];
+}
+
+const vector<size_t> &
+MicrocodeSSA::get_def_uses (size_t d) const
+{
+  return def_uses[d];
+}
+
+size_t
+MicrocodeSSA::get_use_def (size_t u) const
+{
+  return uses[u].definition;
+}
+
+MicrocodeNode *
+MicrocodeSSA::get_immediate_dominator (const MicrocodeNode *n) const
+{
+  size_t d = idoms[1 + get_node_index (n)];
+
+  // An arrow is immediately dominated by its source
+  if (d > nodes.size ())
+    d = idoms[d];
+
+  return d == 0 ? NULL : nodes[d - 1];
+}
+
+const vector<MicrocodeNode *> &
+MicrocodeSSA::get_dominance_frontier (const MicrocodeNode *n) const
+{
+  return node_frontiers[get_node_index (n)];
+}
+
+string
+MicrocodeSSA::pp_definition (size_t d) const
+{
+  ostringstream oss;
+  const Variable &var = variables[definitions[d].variable];
+
+  if (var.is_register)
+    oss << "%" << var.reg->get_label ();
+  else
+    oss << "[0x" << hex << var.addr << dec << ";" << var.nb_bytes << "]";
+  oss << "#" << d;
+
+  return oss.str ();
+}
+
+void
+MicrocodeSSA::output_text (ostream &out) const
+{
+  for (size_t n = 0; n < nodes.size (); n++)
+    {
+      out << nodes[n]->get_loc () << endl;
+
+      for (size_t p = 0; p < node_phis[n].size (); p++)
+	{
+	  const Definition &phi = definitions[node_phis[n][p]];
+	  out << "  " << pp_definition (node_phis[n][p]) << " := phi (";
+	  for (size_t o = 0; o < phi.operands.size (); o++)
+	    out << (o == 0 ? "" : ", ") << pp_definition (phi.operands[o]);
+	  out << ")" << endl;
+	}
+
+      for (size_t s = 0; s < nodes[n]->get_successors ()->size (); s++)
+	{
+	  size_t a = get_arrow_index (nodes[n]->get_successors ()->at (s));
+
+	  out << "  " << arrows[a]->pp () << endl;
+	  for (size_t u = 0; u < arrow_uses[a].size (); u++)
+	    out << "    use "
+		<< pp_definition (uses[arrow_uses[a][u]].definition) << endl;
+	  for (size_t d = 0; d < arrow_definitions[a].size (); d++)
+	    out << "    def " << pp_definition (arrow_definitions[a][d])
+		<< (definitions[arrow_definitions[a][d]].partial ?
+		    " (partial)" : "") << endl;
+	}
+    }
+}
@@ -0,0 +1,213 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef ANALYSES_MICROCODESSA_HH
+# define ANALYSES_MICROCODESSA_HH
+
+# include <iostream>
+# include <string>
+# include <vector>
+# include <kernel/Architecture.hh>
+# include <kernel/Microcode.hh>
+# include <utils/unordered11.hh>
+
+/*! Static single assignment view of a Microcode program.
+ *
+ *  The variables are the registers and the memory cells with a constant
+ *  address; overlapping cells are merged into a single variable. Each
+ *  statement defines a new version of the variable it assigns; a
+ *  version is also defined at the entry of the program and by the
+ *  phi-functions placed at the iterated dominance frontiers of the
+ *  definitions. The def-use and use-def chains are built once, then
+ *  every query below is answered in constant time.
+ *
+ *  Definitions occur on arrows, hence the arrows are considered as
+ *  vertices of the dominator tree, between their source and their
+ *  targets. A virtual root enters the program at its entry point, at
+ *  the nodes without predecessors and, if needed, at some node of each
+ *  cycle that cannot be reached otherwise.
+ *
+ *  The view is conservative:
+ *  - an assignment to a part of a variable (sub-register, cell covering
+ *    part of a merged memory variable) also uses the previous version;
+ *  - an assignment to a memory cell with a non-constant address is such
+ *    a partial definition of every memory variable, and reading such a
+ *    cell uses every memory variable;
+ *  - a dynamic jump is followed to its SolvedJmpAnnotation targets, an
+ *    unresolved one has no successors. External statements are ignored.
+ *
+ *  The view refers to the nodes and arrows of the program, which must
+ *  not be modified while the view is used. */
+class MicrocodeSSA
+{
+public:
+  /* Index of no definition or no phi-function */
+  static const std::size_t NONE;
+
+  struct Variable {
+    bool is_register;
+    /* The register, for a register variable */
+    const RegisterDesc *reg;
+    /* First byte and number of bytes, for a memory variable */
+    address_t addr;
+    std::size_t nb_bytes;
+  };
+
+  enum DefinitionKind {
+    /* Value of the variable when the program is entered */
+    ENTRY_DEF,
+    /* Assignment of a statement */
+    ARROW_DEF,
+    /* Phi-function at the entry of a node */
+    PHI_DEF
+  };
+
+  struct Definition {
+    DefinitionKind kind;
+    std::size_t variable;
+    /* The arrow of an ARROW_DEF */
+    StmtArrow *arrow;
+    /* The node of a PHI_DEF */
+    MicrocodeNode *node;
+    /* An ARROW_DEF that keeps a part of the previous version */
+    bool partial;
+    /* Operands of a PHI_DEF, in the order of get_incoming_arrows () */
+    std::vector<std::size_t> operands;
+  };
+
+  struct Use {
+    std::size_t variable;
+    /* The definition reaching the use */
+    std::size_t definition;
+    /* The arrow whose statement uses the variable or, for an operand of
+     * a phi-function, the arrow the operand comes from (NULL for the
+     * entry of the program). */
+    StmtArrow *arrow;
+    /* The phi-function and the position of the operand, or NONE */
+    std::size_t phi;
+    std::size_t operand;
+  };
+
+  explicit MicrocodeSSA (const Microcode *prg);
+  ~MicrocodeSSA ();
+
+  const Microcode *get_program () const;
+
+  std::size_t get_number_of_variables () const;
+  std::size_t get_number_of_definitions () const;
+  std::size_t get_number_of_uses () const;
+
+  const Variable &get_variable (std::size_t v) const;
+  const Definition &get_definition (std::size_t d) const;
+  const Use &get_use (std::size_t u) const;
+
+  /*! The variable of a register or of a memory cell with a constant
+   *  address, or NONE if lv does not occur in the program. */
+  std::size_t find_variable (const LValue *lv) const;
+
+  std::size_t get_entry_definition (std::size_t v) const;
+
+  /*! Definitions and uses of the statement of arr. The uses of an
+   *  arrow do not include the operands of phi-functions. */
+  const std::vector<std::size_t> &get_definitions (const StmtArrow *arr) const;
+  const std::vector<std::size_t> &get_uses (const StmtArrow *arr) const;
+
+  /*! Phi-functions at the entry of n, and the arrows their operands come
+   *  from. A NULL arrow stands for the entry of the program. */
+  const std::vector<std::size_t> &get_phis (const MicrocodeNode *n) const;
+  const std::vector<StmtArrow *> &
+  get_incoming_arrows (const MicrocodeNode *n) const;
+
+  /*! Def-use chain: the uses reached by definition d, including the
+   *  operands of phi-functions. */
+  const std::vector<std::size_t> &get_def_uses (std::size_t d) const;
+
+  /*! Use-def chain: the definition reaching use u. */
+  std::size_t get_use_def (std::size_t u) const;
+
+  /*! The immediate dominator of n, or NULL if n is only dominated by
+   *  the entry of the program. */
+  MicrocodeNode *get_immediate_dominator (const MicrocodeNode *n) const;
+
+  /*! The nodes where the dominance of n ends. */
+  const std::vector<MicrocodeNode *> &
+  get_dominance_frontier (const MicrocodeNode *n) const;
+
+  void output_text (std::ostream &out) const;
+
+private:
+  std::size_t get_node_index (const MicrocodeNode *n) const;
+  std::size_t get_arrow_index (const StmtArrow *arr) const;
+  std::size_t get_memory_variable (address_t addr) const;
+  std::string pp_definition (std::size_t d) const;
+
+  void number_variables ();
+  void add_statement_uses (std::size_t a, const Expr *e,
+			   std::vector<std::size_t> &stamps);
+  /* Records the uses and definitions of the statement of arrow a; the
+   * variables already used by a are stamped with a. */
+  void add_statement (std::size_t a, std::vector<std::size_t> &stamps);
+  void build_graph ();
+  void compute_dominators ();
+  void place_phis ();
+  void rename ();
+
+  const Microcode *prg;
+
+  std::vector<MicrocodeNode *> nodes;
+  std::vector<StmtArrow *> arrows;
+  std::unordered_map<const MicrocodeNode *, std::size_t> node_indexes;
+  std::unordered_map<const StmtArrow *, std::size_t> arrow_indexes;
+
+  std::vector<Variable> variables;
+  std::unordered_map<const RegisterDesc *, std::size_t> register_variables;
+  /* Memory variables, by increasing address */
+  std::vector<std::size_t> memory_variables;
+
+  std::vector<Definition> definitions;
+  std::vector<Use> uses;
+  std::vector<std::size_t> entry_definitions;
+  std::vector<std::vector<std::size_t> > arrow_definitions;
+  std::vector<std::vector<std::size_t> > arrow_uses;
+  std::vector<std::vector<std::size_t> > node_phis;
+  std::vector<std::vector<StmtArrow *> > incoming_arrows;
+  std::vector<std::vector<std::size_t> > def_uses;
+
+  /* Vertex 0 is the root, followed by the nodes and by the arrows. An
+   * edge is stored with its position among the predecessors of its
+   * target. */
+  std::vector<std::vector<std::pair<std::size_t, std::size_t> > > succs;
+  std::vector<std::vector<std::size_t> > preds;
+  std::vector<std::size_t> idoms;
+  std::vector<std::vector<std::size_t> > frontiers;
+  std::vector<std::vector<MicrocodeNode *> > node_frontiers;
+};
+
+#endif /* ! ANALYSES_MICROCODESSA_HH */
@@ -2,11 +2,15 @@
 # define ABSTRACTMEMORYTRAVERSAL_HH
 
 # include <list>
+# include <string>
+# include <vector>
 # include <decoders/Decoder.hh>
 # include <utils/logs.hh>
 # include <kernel/Microcode.hh>
 # include <kernel/annotations/AsmAnnotation.hh>
 # include <kernel/annotations/NextInstAnnotation.hh>
+# include <analyses/cfgrecovery/WorklistStrategy.hh>
+# include <utils/WorkStealingPool.hh>
 # include <utils/unordered11.hh>
 
 template<typename AlgoSpec>
@@ -19,7 +23,9 @@ class AbstractMemoryTraversal
   ABSTRACT_MEMORY_TRAVERSAL_PROPERTY (bool, warn_on_unsolved_dynamic_jumps, \
 				      false)				\
   ABSTRACT_MEMORY_TRAVERSAL_PROPERTY (bool, warn_skipped_dynamic_jumps, false) \
-  ABSTRACT_MEMORY_TRAVERSAL_PROPERTY (int, number_of_visits_per_address, 1)
+  ABSTRACT_MEMORY_TRAVERSAL_PROPERTY (int, number_of_visits_per_address, 1) \
+  ABSTRACT_MEMORY_TRAVERSAL_PROPERTY (WorklistStrategy, worklist_strategy, \
+				      WORKLIST_FIFO)
 # undef ABSTRACT_MEMORY_TRAVERSAL_PROPERTY
 
 public:
@@ -43,6 +49,28 @@ public:
 
   void abort_computation ();
 
+  /* Registers a stepper for an additional thread (see compute()). The
+   * stepper is not deleted with the traversal. */
+  void add_stepper (Stepper *stepper);
+
+  /* Number of pending arrows whose successors have been computed. */
+  std::size_t get_number_of_steps () const;
+
+  /* Explores the program from the 'entrypoints'. Pending arrows are
+   * taken in the order given by the 'worklist_strategy' property.
+   *
+   * If additional steppers have been registered, the store of
+   * expressions is concurrent and the strategy is FIFO, the worklist is
+   * processed by rounds: the successors of all the arrows pending at the
+   * beginning of a round are computed concurrently, by one thread per
+   * stepper; they are then added to the state space and to the program
+   * by the calling thread in the order of the worklist. The other
+   * strategies may take the successors of an arrow right after it, so
+   * they always run on a single thread. The exploration, the visits of
+   * program points, the decoding and the state space thus evolve exactly
+   * as in the sequential mode. The arrows of states sharing a context are
+   * handled by the same thread, one after the other, since steppers may
+   * complete the context of the state they start from. */
   void compute (const std::list<ConcreteAddress> &entrypoints,
 		Microcode *result);
 
@@ -52,14 +80,61 @@ protected:
 
   virtual PendingArrow nextPendingArrow ();
 
+  virtual void addPendingArrow (const PendingArrow &pa);
+
   virtual bool skip_pending_arrow (const PendingArrow &pa);
 
   virtual void computePendingArrowsFor (State *s)
     throw (Decoder::Exception);
+
 private:
+  /* Processing of a pending arrow; 'succ' is NULL if the stepper failed,
+   * in which case 'error' is the reason. */
+  struct Step {
+    PendingArrow pa;
+    bool skipped;
+    StateSet *succ;
+    std::string error;
+  };
+
+  class StepJob : public WorkStealingPool::Job {
+  public:
+    StepJob (AbstractMemoryTraversal *traversal) : traversal (traversal) { }
+    virtual void run (int worker);
+
+    AbstractMemoryTraversal *traversal;
+    std::vector<Step *> steps;
+  };
+
+  /* Pending arrow of the worklist. The worklist is a heap whose top is
+   * the arrow with the lowest rank and, among them, the lowest sequence
+   * number; hence the reversed comparison. */
+  struct RankedArrow {
+    long rank;
+    unsigned long seq;
+    PendingArrow pa;
+
+    bool operator< (const RankedArrow &o) const {
+      return rank > o.rank || (rank == o.rank && seq > o.seq);
+    }
+  };
+
+  long rank_of (const RankedArrow &ra) const;
+  void rank_in_reverse_postorder ();
+
+  bool start_step (const PendingArrow &pa);
+  void compute_successors (Stepper *stepper, Step *step);
+  void end_step (Step *step);
+  void compute_rounds (WorkStealingPool *pool);
+
   ConcreteMemory *memory;
-  std::list<PendingArrow> worklist;
+  std::vector<RankedArrow> worklist;
+  unsigned long worklist_seq;
+  std::unordered_map<const MicrocodeNode *, long> rpo_ranks;
+  std::size_t rpo_nb_nodes;
+  std::size_t nb_steps;
   Stepper *stepper;
+  std::vector<Stepper *> steppers;
   Decoder *decoder;
   Microcode *program;
   StateSpace *states;
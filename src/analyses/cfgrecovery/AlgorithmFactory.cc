@@ -1,4 +1,5 @@
 #include <cassert>
+#include <vector>
 
 #include "LinearSweep.hh"
 #include "FloodTraversal.hh"
@@ -29,12 +30,20 @@ public:
 
   virtual ~GenAlgorithm () {
     delete stepper;
+    for (size_t i = 0; i < thread_steppers.size (); i++)
+      delete thread_steppers[i];
     delete states;
     delete traversal;
   }
 
+  virtual Stepper *create_stepper (AlgorithmFactory *F)
+    throw (AlgorithmFactory::InstanciationException &) {
+    return NULL;
+  }
+
   virtual void setup_stepper (AlgorithmFactory *F)
     throw (AlgorithmFactory::InstanciationException &) {
+    stepper = create_stepper (F);
   }
 
   virtual void setup_traversal (AlgorithmFactory *F) {
@@ -50,6 +59,14 @@ public:
     traversal->set_warn_on_unsolved_dynamic_jumps (F->get_warn_on_unsolved_dynamic_jumps ());
     traversal->set_warn_skipped_dynamic_jumps (F->get_warn_skipped_dynamic_jumps ());
     traversal->set_number_of_visits_per_address (F->get_max_number_of_visits_per_address ());
+    traversal->set_worklist_strategy (F->get_worklist_strategy ());
+
+    /* Each thread of the traversal has its own stepper. */
+    for (int i = 1; i < F->get_number_of_threads (); i++)
+      {
+	thread_steppers.push_back (create_stepper (F));
+	traversal->add_stepper (thread_steppers.back ());
+      }
   }
 
   virtual void setup (AlgorithmFactory *factory)
@@ -68,9 +85,18 @@ public:
     traversal->compute (entrypoints, result);
   }
 
+  virtual std::size_t get_number_of_states () const {
+    return states->size ();
+  }
+
+  virtual std::size_t get_number_of_steps () const {
+    return traversal->get_number_of_steps ();
+  }
+
 private:
   friend class AlgorithmFactory;
   Stepper *stepper;
+  std::vector<Stepper *> thread_steppers;
   StateSpace *states;
   Traversal *traversal;
 };
@@ -86,11 +112,11 @@ AlgorithmFactory::~AlgorithmFactory ()
 {
 }
 
-template<> void
-GenAlgorithm<LinearSweep>::setup_stepper (AlgorithmFactory *)
+template<> LinearSweep::Stepper *
+GenAlgorithm<LinearSweep>::create_stepper (AlgorithmFactory *)
   throw (AlgorithmFactory::InstanciationException &)
 {
-  stepper = new LinearSweep::Stepper ();
+  return new LinearSweep::Stepper ();
 }
 
 AlgorithmFactory::Algorithm *
@@ -104,13 +130,13 @@ AlgorithmFactory::buildLinearSweep ()
   return result;
 }
 
-template<> void
-GenAlgorithm<FloodTraversal>::setup_stepper (AlgorithmFactory *F)
+template<> FloodTraversal::Stepper *
+GenAlgorithm<FloodTraversal>::create_stepper (AlgorithmFactory *F)
   throw (AlgorithmFactory::InstanciationException &)
 {
   const Architecture *arch =
     F->get_decoder ()->get_arch ()->get_reference_arch();
-  stepper = new FloodTraversal::Stepper (F->get_memory (), arch);
+  return new FloodTraversal::Stepper (F->get_memory (), arch);
 }
 
 AlgorithmFactory::Algorithm *
@@ -124,13 +150,13 @@ AlgorithmFactory::buildFloodTraversal ()
   return result;
 }
 
-template<> void
-GenAlgorithm<RecursiveTraversal>::setup_stepper (AlgorithmFactory *F)
+template<> RecursiveTraversal::Stepper *
+GenAlgorithm<RecursiveTraversal>::create_stepper (AlgorithmFactory *F)
   throw (AlgorithmFactory::InstanciationException &)
 {
   const Architecture *arch =
     F->get_decoder ()->get_arch ()->get_reference_arch();
-  stepper = new RecursiveTraversal::Stepper (F->get_memory (), arch);
+  return new RecursiveTraversal::Stepper (F->get_memory (), arch);
 }
 
 AlgorithmFactory::Algorithm *
@@ -144,13 +170,15 @@ AlgorithmFactory::buildRecursiveTraversal ()
   return result;
 }
 
-template<> void
-GenAlgorithm<SymbolicSimulator>::setup_stepper (AlgorithmFactory *F)
+template<> SymbolicSimulator::Stepper *
+GenAlgorithm<SymbolicSimulator>::create_stepper (AlgorithmFactory *F)
   throw (AlgorithmFactory::InstanciationException &)
 {
+  SymbolicSimulator::Stepper *result;
+
   try
     {
-      stepper =
+      result =
 	new SymbolicSimulator::Stepper (F->get_memory (),
 					F->get_decoder ()->get_arch ());
     }
@@ -158,8 +186,10 @@ GenAlgorithm<SymbolicSimulator>::setup_stepper (AlgorithmFactory *F)
     {
       throw AlgorithmFactory::InstanciationException (e.what ());
     }
-  stepper->set_dynamic_jump_threshold (F->get_dynamic_jumps_threshold ());
-  stepper->set_map_dynamic_jumps_to_memory (F->get_map_dynamic_jumps_to_memory ());
+  result->set_dynamic_jump_threshold (F->get_dynamic_jumps_threshold ());
+  result->set_map_dynamic_jumps_to_memory (F->get_map_dynamic_jumps_to_memory ());
+
+  return result;
 }
 
 AlgorithmFactory::Algorithm *
@@ -173,13 +203,12 @@ AlgorithmFactory::buildSymbolicSimulator ()
   return result;
 }
 
-template<> void
-GenAlgorithm<ConcreteSimulator>::setup_stepper (AlgorithmFactory *F)
+template<> ConcreteSimulator::Stepper *
+GenAlgorithm<ConcreteSimulator>::create_stepper (AlgorithmFactory *F)
   throw (AlgorithmFactory::InstanciationException &)
 {
-  stepper =
-    new ConcreteSimulator::Stepper (F->get_memory (),
-				    F->get_decoder ()->get_arch ());
+  return new ConcreteSimulator::Stepper (F->get_memory (),
+					 F->get_decoder ()->get_arch ());
 }
 
 AlgorithmFactory::Algorithm *
@@ -4,6 +4,7 @@
 # include <stdexcept>
 # include <kernel/Microcode.hh>
 # include <decoders/Decoder.hh>
+# include <analyses/cfgrecovery/WorklistStrategy.hh>
 
 class AlgorithmFactory
 {
@@ -17,7 +18,10 @@ class AlgorithmFactory
   ALGORITHM_FACTORY_PROPERTY (bool, warn_skipped_dynamic_jumps, false)	\
   ALGORITHM_FACTORY_PROPERTY (bool, map_dynamic_jumps_to_memory, false)	\
   ALGORITHM_FACTORY_PROPERTY (int, dynamic_jumps_threshold, 1000) 	\
-  ALGORITHM_FACTORY_PROPERTY (int, max_number_of_visits_per_address, 1)
+  ALGORITHM_FACTORY_PROPERTY (int, max_number_of_visits_per_address, 1) \
+  ALGORITHM_FACTORY_PROPERTY (int, number_of_threads, 1)		\
+  ALGORITHM_FACTORY_PROPERTY (WorklistStrategy, worklist_strategy,	\
+			      WORKLIST_FIFO)
 
 public:
   class Exception : public std::runtime_error {
@@ -41,6 +45,11 @@ public:
     virtual void stop () = 0;
     virtual void compute (const std::list<ConcreteAddress> &ca,
 			  Microcode *result) = 0;
+
+    /* Size of the state space and number of pending arrows processed so
+     * far. */
+    virtual std::size_t get_number_of_states () const = 0;
+    virtual std::size_t get_number_of_steps () const = 0;
   };
 
   AlgorithmFactory ();
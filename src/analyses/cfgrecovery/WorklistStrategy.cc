@@ -0,0 +1,11 @@
+#include "WorklistStrategy.hh"
+
+#include <cstddef>
+
+const WorklistStrategyName WORKLIST_STRATEGIES[] = {
+  { "fifo", WORKLIST_FIFO },
+  { "dfs", WORKLIST_DFS },
+  { "rpo", WORKLIST_RPO },
+  { "fewest-visits", WORKLIST_FEWEST_VISITS },
+  { NULL, WORKLIST_FIFO }
+};
@@ -0,0 +1,28 @@
+#ifndef WORKLISTSTRATEGY_HH
+# define WORKLISTSTRATEGY_HH
+
+/* Orders in which a traversal takes its pending arrows. Arrows that are
+ * equivalent for a strategy are taken in the order they were found. */
+enum WorklistStrategy {
+  /* Breadth-first: the oldest arrow. */
+  WORKLIST_FIFO,
+  /* Depth-first: the most recent arrow. */
+  WORKLIST_DFS,
+  /* The arrow whose source comes first in a reverse postorder of the
+   * program recovered so far. Nodes decoded since the order was last
+   * computed come after all the others. */
+  WORKLIST_RPO,
+  /* The arrow whose source address has been visited the fewest times. */
+  WORKLIST_FEWEST_VISITS
+};
+
+/* Names of the strategies, as used in configuration files. The table
+ * ends with a NULL name. */
+struct WorklistStrategyName {
+  const char *name;
+  WorklistStrategy strategy;
+};
+
+extern const WorklistStrategyName WORKLIST_STRATEGIES[];
+
+#endif /* ! WORKLISTSTRATEGY_HH */
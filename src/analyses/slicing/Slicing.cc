@@ -407,8 +407,8 @@ DataDependencyLocalContext::run_backward (StaticArrow *arr)
       Expr *reg_pattern =
 	Expr::createEquality(ConditionalSet::EltSymbol (lval->get_bv_size ()), lval->ref ());
 
-      // The variable TMP is used to hide form EltSymbol = lval when one replaces lval by rval.
-      Variable *tmp = Variable::create ("TMP", BV_DEFAULT_SIZE);
+      // The boolean variable TMP is used to hide form EltSymbol = lval when one replaces lval by rval.
+      Variable *tmp = Variable::create ("TMP", 1);
       bottom_up_rewrite_pattern_and_assign (&(new_context->the_lvalues),
 					    reg_pattern, VarList (), tmp);
       reg_pattern->deref ();
@@ -714,6 +714,512 @@ DataDependency::get_simple_dependencies(const MicrocodeAddressProgramPoint &pp,
   return simple_result;
 }
 
+/*****************************************************************************/
+// BitsetDataDependency implementation
+/*****************************************************************************/
+
+static const std::size_t LVALUE_SET_WORD_BITS = 8 * sizeof (unsigned long);
+
+static bool
+s_set_contains (const vector<unsigned long> &set, size_t elt)
+{
+  return (set[elt / LVALUE_SET_WORD_BITS] >> (elt % LVALUE_SET_WORD_BITS)) & 1;
+}
+
+/* Returns true if elt was not in set */
+static bool
+s_set_add (vector<unsigned long> &set, size_t elt)
+{
+  unsigned long bit = 1UL << (elt % LVALUE_SET_WORD_BITS);
+  unsigned long &word = set[elt / LVALUE_SET_WORD_BITS];
+
+  if (word & bit)
+    return false;
+  word |= bit;
+
+  return true;
+}
+
+/* Adds to set the elements of other but skipped that are in mask, if
+ * any; returns true if set changed */
+static bool
+s_set_union (vector<unsigned long> &set, const vector<unsigned long> &other,
+	     size_t skipped, const vector<unsigned long> *mask)
+{
+  bool changed = false;
+
+  for (size_t w = 0; w < set.size (); w++)
+    {
+      unsigned long bits = other[w];
+
+      if (mask != NULL)
+	bits &= (*mask)[w];
+
+      if (w == skipped / LVALUE_SET_WORD_BITS)
+	bits &= ~(1UL << (skipped % LVALUE_SET_WORD_BITS));
+      if ((set[w] | bits) != set[w])
+	{
+	  set[w] |= bits;
+	  changed = true;
+	}
+    }
+
+  return changed;
+}
+
+/* Ranks the nodes of prg in postorder of its static arrows, thus a
+ * backward analysis taking the lowest rank first usually meets a node
+ * after its successors. */
+static void
+s_postorder (const Microcode *prg, vector<MicrocodeNode *> &nodes,
+	     unordered_map<const MicrocodeNode *, size_t> &ranks)
+{
+  vector<pair<MicrocodeNode *, size_t> > stack;
+
+  for (Microcode::const_node_iterator n = prg->begin_nodes ();
+       n != prg->end_nodes (); n++)
+    {
+      if (ranks.find (*n) != ranks.end ())
+	continue;
+
+      ranks[*n] = 0;
+      stack.push_back (make_pair (*n, (size_t) 0));
+      while (! stack.empty ())
+	{
+	  MicrocodeNode *node = stack.back ().first;
+	  vector<StmtArrow *> *succs = node->get_successors ();
+	  size_t &s = stack.back ().second;
+
+	  if (s == succs->size ())
+	    {
+	      ranks[node] = nodes.size ();
+	      nodes.push_back (node);
+	      stack.pop_back ();
+	      continue;
+	    }
+
+	  StaticArrow *sa = dynamic_cast<StaticArrow *> (succs->at (s++));
+	  if (sa == NULL || ! prg->has_node_at (sa->get_concrete_target ()))
+	    continue;
+
+	  MicrocodeNode *tgt = prg->get_node (sa->get_concrete_target ());
+	  if (ranks.find (tgt) == ranks.end ())
+	    {
+	      ranks[tgt] = 0;
+	      stack.push_back (make_pair (tgt, (size_t) 0));
+	    }
+	}
+    }
+}
+
+static bool
+s_has_flat_dependencies (const LValue *lv)
+{
+  if (lv->is_RegisterExpr ())
+    return true;
+  if (! lv->is_MemCell ())
+    return false;
+
+  // The rewriting of DataDependencyLocalContext::run_backward reduces to a
+  // substitution in flat sets only for cells of the default size at a
+  // constant address.
+  return (((const MemCell *) lv)->get_addr ()->is_Constant () &&
+	  lv->get_bv_offset () == 0 && lv->get_bv_size () == BV_DEFAULT_SIZE);
+}
+
+bool
+BitsetDataDependency::supports (const Microcode *prg,
+				const list<LocatedLValue> &seeds)
+{
+  for (list<LocatedLValue>::const_iterator llv = seeds.begin ();
+       llv != seeds.end (); llv++)
+    if (! s_has_flat_dependencies (llv->get_LValue ()))
+      return false;
+
+  for (Microcode::const_node_iterator n = prg->begin_nodes ();
+       n != prg->end_nodes (); n++)
+    {
+      vector<StmtArrow *> *succs = (*n)->get_successors ();
+
+      for (size_t s = 0; s < succs->size (); s++)
+	{
+	  Statement *stmt = succs->at (s)->get_stmt ();
+
+	  if (! stmt->is_Assignment ())
+	    continue;
+	  if (! s_has_flat_dependencies (((Assignment *) stmt)->get_lval ()))
+	    return false;
+
+	  list<const LValue *> deps =
+	    dependencies (((Assignment *) stmt)->get_rval ());
+	  for (list<const LValue *>::iterator d = deps.begin ();
+	       d != deps.end (); d++)
+	    if (! s_has_flat_dependencies (*d))
+	      return false;
+	}
+    }
+
+  return true;
+}
+
+size_t
+BitsetDataDependency::number (const LValue *lv)
+{
+  unordered_map<const Expr *, size_t>::iterator i = numbers.find (lv);
+
+  if (i != numbers.end ())
+    return i->second;
+
+  size_t result = lvalues.size ();
+  numbers[lv] = result;
+  lvalues.push_back ((LValue *) lv->ref ());
+
+  return result;
+}
+
+size_t
+BitsetDataDependency::get_rank (const MicrocodeAddress &pp) const
+{
+  if (! the_program->has_node_at (pp))
+    return nodes.size ();
+
+  return ranks.find (the_program->get_node (pp))->second;
+}
+
+BitsetDataDependency::BitsetDataDependency (Microcode *prg,
+					    const list<LocatedLValue> &seeds) :
+  the_program (prg)
+{
+  prg->regular_form ();
+
+  s_postorder (prg, nodes, ranks);
+  transfers.resize (nodes.size ());
+  predecessors.resize (nodes.size ());
+  for (size_t rank = 0; rank < nodes.size (); rank++)
+    {
+      vector<StmtArrow *> *succs = nodes[rank]->get_successors ();
+
+      for (size_t s = 0; s < succs->size (); s++)
+	{
+	  StaticArrow *sa = dynamic_cast<StaticArrow *> (succs->at (s));
+
+	  if (sa == NULL)
+	    continue;
+
+	  Transfer t;
+	  t.target = get_rank (sa->get_concrete_target ());
+	  if (t.target == nodes.size ())
+	    continue;
+
+	  t.is_assignment = sa->get_stmt ()->is_Assignment ();
+	  t.lvalue = 0;
+	  if (t.is_assignment)
+	    {
+	      Assignment *a = (Assignment *) sa->get_stmt ();
+	      list<const LValue *> deps = dependencies (a->get_rval ());
+
+	      t.lvalue = number (a->get_lval ());
+	      for (list<const LValue *>::iterator d = deps.begin ();
+		   d != deps.end (); d++)
+		t.deps.push_back (number (*d));
+	    }
+	  transfers[rank].push_back (t);
+	  predecessors[t.target].push_back (rank);
+	}
+    }
+
+  vector<pair<size_t, size_t> > seeded;
+  for (list<LocatedLValue>::const_iterator llv = seeds.begin ();
+       llv != seeds.end (); llv++)
+    {
+      MicrocodeAddress pp = llv->get_ProgramPoint ().to_MicrocodeAddress ();
+
+      // Same exception as DataDependency for a seed out of the program
+      seeded.push_back (make_pair (ranks[prg->get_node (pp)],
+				   number (llv->get_LValue ())));
+    }
+
+  size_t words =
+    (lvalues.size () + LVALUE_SET_WORD_BITS - 1) / LVALUE_SET_WORD_BITS;
+  watched.assign (nodes.size (), LValueSet (words, 0));
+  flat.assign (words, 0);
+  for (size_t lv = 0; lv < lvalues.size (); lv++)
+    if (lvalues[lv]->get_bv_size () == Expr::get_bv_default_size ())
+      s_set_add (flat, lv);
+  for (size_t i = 0; i < seeded.size (); i++)
+    {
+      size_t rank = seeded[i].first;
+      size_t lv = seeded[i].second;
+
+      s_set_add (watched[rank], lv);
+      pending.insert (predecessors[rank].begin (), predecessors[rank].end ());
+    }
+}
+
+BitsetDataDependency::~BitsetDataDependency ()
+{
+  for (size_t i = 0; i < lvalues.size (); i++)
+    lvalues[i]->deref ();
+}
+
+bool
+BitsetDataDependency::update (size_t rank)
+{
+  LValueSet &set = watched[rank];
+  bool changed = false;
+
+  for (size_t i = 0; i < transfers[rank].size (); i++)
+    {
+      const Transfer &t = transfers[rank][i];
+      const LValueSet &tgt = watched[t.target];
+
+      if (! t.is_assignment || ! s_set_contains (tgt, t.lvalue))
+	{
+	  changed = s_set_union (set, tgt, lvalues.size (), &flat) || changed;
+	  continue;
+	}
+
+      changed = s_set_union (set, tgt, t.lvalue, &flat) || changed;
+      for (size_t d = 0; d < t.deps.size (); d++)
+	if (s_set_contains (flat, t.deps[d]))
+	  changed = s_set_add (set, t.deps[d]) || changed;
+    }
+
+  return changed;
+}
+
+void
+BitsetDataDependency::ComputeFixpoint ()
+{
+  while (! pending.empty ())
+    {
+      size_t rank = *pending.begin ();
+
+      pending.erase (pending.begin ());
+      if (update (rank))
+	pending.insert (predecessors[rank].begin (),
+			predecessors[rank].end ());
+    }
+
+  logs::debug << "BitsetDataDependency: Fixpoint Reached!" << endl;
+}
+
+vector<const LValue *>
+BitsetDataDependency::get_dependencies (const MicrocodeAddress &pp) const
+{
+  vector<const LValue *> result;
+  size_t rank = get_rank (pp);
+
+  if (rank == nodes.size ())
+    return result;
+
+  for (size_t lv = 0; lv < lvalues.size (); lv++)
+    if (s_set_contains (watched[rank], lv) && s_set_contains (flat, lv))
+      result.push_back (lvalues[lv]);
+
+  return result;
+}
+
+bool
+BitsetDataDependency::is_influenced_by (const MicrocodeAddress &pp,
+					const LValue *lv) const
+{
+  vector<const LValue *> deps = get_dependencies (pp);
+
+  for (size_t d = 0; d < deps.size (); d++)
+    if (deps[d] == lv || (deps[d]->is_MemCell () && lv->is_MemCell ()))
+      return true;
+
+  return false;
+}
+
+/*****************************************************************************/
+// Liveness of the assigned registers, for useless_statements
+/*****************************************************************************/
+
+/* A register is live at a node when a path from the node reads it before
+ * assigning it. Paths follow the arrows explored by statement_used: an
+ * unresolved dynamic jump reads every register and a missing node ends
+ * the path. Only registers assigned somewhere in the program are
+ * numbered. */
+class RegisterLiveness
+{
+  struct Transfer {
+    bool reads_all;
+    std::vector<size_t> targets;
+    bool is_assignment;
+    size_t lvalue;
+    std::vector<size_t> uses;
+  };
+
+  const Microcode *prg;
+  vector<MicrocodeNode *> nodes;
+  unordered_map<const MicrocodeNode *, size_t> ranks;
+  unordered_map<const Expr *, size_t> numbers;
+  vector<vector<Transfer> > transfers;
+  vector<vector<size_t> > predecessors;
+  vector<vector<unsigned long> > live;
+
+  /* Targets of arr up to the first missing node, as DD_u_follow_edge */
+  bool
+  follow (StmtArrow *arr, vector<size_t> &targets) const
+  {
+    Option<MicrocodeAddress> tgtopt = arr->extract_target ();
+    vector<MicrocodeAddress> addrs;
+
+    if (tgtopt.hasValue ())
+      addrs.push_back (tgtopt.getValue ());
+    else if (arr->has_annotation (SolvedJmpAnnotation::ID))
+      {
+	SolvedJmpAnnotation *a = (SolvedJmpAnnotation *)
+	  arr->get_annotation (SolvedJmpAnnotation::ID);
+	for (SolvedJmpAnnotation::const_iterator i = a->begin ();
+	     i != a->end (); i++)
+	  addrs.push_back (*i);
+      }
+    else
+      return false;
+
+    for (size_t i = 0; i < addrs.size () && prg->has_node_at (addrs[i]); i++)
+      targets.push_back (ranks.find (prg->get_node (addrs[i]))->second);
+
+    return true;
+  }
+
+  void
+  add_uses (const Expr *e, const LValue *lv, vector<size_t> &uses) const
+  {
+    list<const RegisterExpr *> regs =
+      collect_subterms_of_type<list<const RegisterExpr *>, RegisterExpr>
+      (e, true);
+
+    for (list<const RegisterExpr *>::iterator r = regs.begin ();
+	 r != regs.end (); r++)
+      {
+	unordered_map<const Expr *, size_t>::const_iterator i =
+	  numbers.find (*r);
+	if (*r != lv && i != numbers.end ())
+	  uses.push_back (i->second);
+      }
+  }
+
+  bool
+  update (size_t rank)
+  {
+    vector<unsigned long> &set = live[rank];
+    bool changed = false;
+
+    for (size_t i = 0; i < transfers[rank].size (); i++)
+      {
+	const Transfer &t = transfers[rank][i];
+	size_t killed = t.is_assignment ? t.lvalue : numbers.size ();
+
+	for (size_t r = 0; t.reads_all && r < numbers.size (); r++)
+	  changed = s_set_add (set, r) || changed;
+	for (size_t s = 0; s < t.targets.size (); s++)
+	  changed = s_set_union (set, live[t.targets[s]], killed, NULL)
+	    || changed;
+	for (size_t u = 0; u < t.uses.size (); u++)
+	  changed = s_set_add (set, t.uses[u]) || changed;
+      }
+
+    return changed;
+  }
+
+public:
+  RegisterLiveness (const Microcode *prg) : prg (prg)
+  {
+    s_postorder (prg, nodes, ranks);
+
+    for (size_t rank = 0; rank < nodes.size (); rank++)
+      {
+	vector<StmtArrow *> *succs = nodes[rank]->get_successors ();
+
+	for (size_t s = 0; s < succs->size (); s++)
+	  {
+	    Statement *stmt = succs->at (s)->get_stmt ();
+
+	    if (stmt->is_Assignment () &&
+		((Assignment *) stmt)->get_lval ()->is_RegisterExpr () &&
+		numbers.find (((Assignment *) stmt)->get_lval ()) ==
+		numbers.end ())
+	      {
+		size_t n = numbers.size ();
+		numbers[((Assignment *) stmt)->get_lval ()] = n;
+	      }
+	  }
+      }
+
+    transfers.resize (nodes.size ());
+    predecessors.resize (nodes.size ());
+    for (size_t rank = 0; rank < nodes.size (); rank++)
+      {
+	vector<StmtArrow *> *succs = nodes[rank]->get_successors ();
+
+	for (size_t s = 0; s < succs->size (); s++)
+	  {
+	    StmtArrow *arr = succs->at (s);
+	    Transfer t;
+
+	    t.is_assignment = arr->get_stmt ()->is_Assignment ();
+	    t.reads_all = ! follow (arr, t.targets) && ! t.is_assignment;
+	    t.lvalue = numbers.size ();
+	    if (t.is_assignment)
+	      {
+		Assignment *a = (Assignment *) arr->get_stmt ();
+		unordered_map<const Expr *, size_t>::const_iterator i =
+		  numbers.find (a->get_lval ());
+
+		if (i != numbers.end ())
+		  t.lvalue = i->second;
+		add_uses (a->get_rval (), NULL, t.uses);
+		add_uses (a->get_lval (), a->get_lval (), t.uses);
+	      }
+	    for (size_t i = 0; i < t.targets.size (); i++)
+	      predecessors[t.targets[i]].push_back (rank);
+	    transfers[rank].push_back (t);
+	  }
+      }
+
+    size_t words =
+      (numbers.size () + LVALUE_SET_WORD_BITS - 1) / LVALUE_SET_WORD_BITS;
+    live.assign (nodes.size (), vector<unsigned long> (words, 0));
+
+    set<size_t> pending;
+    for (size_t rank = 0; rank < nodes.size (); rank++)
+      pending.insert (rank);
+    while (! pending.empty ())
+      {
+	size_t rank = *pending.begin ();
+
+	pending.erase (pending.begin ());
+	if (update (rank))
+	  pending.insert (predecessors[rank].begin (),
+			  predecessors[rank].end ());
+      }
+  }
+
+  /* Same answer as DataDependency::statement_used */
+  bool
+  is_used (StmtArrow *arr) const
+  {
+    if (! arr->get_stmt ()->is_Assignment ())
+      return true;
+
+    const LValue *the_lv = ((Assignment *) arr->get_stmt ())->get_lval ();
+    if (! the_lv->is_RegisterExpr ())
+      return true;
+
+    Option<MicrocodeAddress> tgtopt = arr->extract_target ();
+    if (! tgtopt.hasValue () || ! prg->has_node_at (tgtopt.getValue ()))
+      return true;
+
+    size_t rank = ranks.find (prg->get_node (tgtopt.getValue ()))->second;
+
+    return s_set_contains (live[rank], numbers.find (the_lv)->second);
+  }
+};
+
 /*****************************************************************************/
 
 std::vector<StmtArrow*>
@@ -729,71 +1235,120 @@ DataDependency::slice_it (Microcode *prg, const MicrocodeAddress &seed_loc,
   return result;
 }
 
+static std::vector<StmtArrow*>
+s_bitset_slice_it (Microcode *prg, const std::list<LocatedLValue> &seeds)
+{
+  BitsetDataDependency invfix (prg, seeds);
+  invfix.ComputeFixpoint ();
+
+  vector<StmtArrow*> result;
+
+  logs::debug << logs::separator << endl
+	      << "Dependencies:" << endl;
+
+  for (Microcode::const_node_iterator n = prg->begin_nodes ();
+       n != prg->end_nodes (); n++)
+    {
+      if (logs::debug_is_on)
+	{
+	  vector<const LValue *> deps = invfix.get_dependencies ((*n)->get_loc ());
+
+	  logs::debug << (*n)->get_loc () << " <== { ";
+	  for (size_t d = 0; d < deps.size (); d++)
+	    logs::debug << deps[d]->to_string () << " ";
+	  logs::debug << " }" << endl;
+	}
+
+      std::vector<StmtArrow *> * succs = (*n)->get_successors ();
+      for (int s = 0; s < (int) succs->size (); s++)
+	{
+	  if (! (*succs)[s]->get_stmt ()->is_Assignment ())
+	    continue;
+
+	  const LValue * the_lv =
+	    ((Assignment *) (*succs)[s]->get_stmt ())->get_lval ();
+	  Option<MicrocodeAddress> tgtopt = (*succs)[s]->extract_target ();
+	  if (!tgtopt.hasValue ())
+	    continue;
+
+	  if (invfix.is_influenced_by (tgtopt.getValue (), the_lv))
+	    result.push_back ((*succs)[s]);
+	  if (logs::debug_is_on)
+	    logs::debug << (*succs)[s]->pp () << endl;
+	}
+    }
+  logs::debug << logs::separator << endl;
+
+  return result;
+}
+
 std::vector<StmtArrow*>
 DataDependency::slice_it(Microcode *prg,
 			 const std::list<LocatedLValue> &seeds) {
   DataDependency::ConsiderJumpCondMode(true);
   DataDependency::OnlySimpleSetsMode(true);
 
+  // Flat sets of registers and constant memory cells are computed on
+  // bitsets; the conditional sets are only needed for other memory cells.
+  prg->regular_form ();
+  if (BitsetDataDependency::supports (prg, seeds))
+    return s_bitset_slice_it (prg, seeds);
+
   DataDependency invfix(prg, seeds);
   int max_step_nb = prg->get_number_of_nodes ();
   invfix.ComputeFixpoint(max_step_nb);
 
   vector<StmtArrow*> result;
 
-  if (logs::debug_is_on)
-    {
-      logs::debug << logs::separator << endl
-		 << "Dependencies:" << endl;
+  logs::debug << logs::separator << endl
+	      << "Dependencies:" << endl;
 
-      for (Microcode::const_node_iterator n = prg->begin_nodes ();
-	   n != prg->end_nodes (); n++)
+  for (Microcode::const_node_iterator n = prg->begin_nodes ();
+       n != prg->end_nodes (); n++)
+    {
+      if (logs::debug_is_on)
 	{
 	  logs::debug << (*n)->get_loc() << " <== ";
 	  std::vector<Expr*> deps =
 	    invfix.get_simple_dependencies((*n)->get_loc(), max_step_nb);
 	  print_expressions(& deps, 2);
 	  logs::debug << endl;
+	}
 
-	  std::vector<LValue*> lv_deps;
-
-	  std::vector<StmtArrow *> * succs = (*n)->get_successors();
-	  for (int s=0; s<(int) succs->size(); s++)
+      std::vector<StmtArrow *> * succs = (*n)->get_successors();
+      for (int s=0; s<(int) succs->size(); s++)
+	{
+	  if (! (*succs)[s]->get_stmt()->is_Assignment())
+	    continue;
+
+	  const LValue * the_lv =
+	    ((Assignment *) (*succs)[s]->get_stmt())->get_lval();
+	  Option<MicrocodeAddress> tgtopt = (*succs)[s]->extract_target();
+	  if (!tgtopt.hasValue())
+	    continue;
+
+	  MicrocodeAddress addr = tgtopt.getValue();
+	  std::vector<Expr*> tgt_deps =
+	    invfix.get_simple_dependencies (addr, max_step_nb);
+	  bool influence = false;
+	  for (int d=0; d<(int) tgt_deps.size(); d++)
 	    {
-	      if (! (*succs)[s]->get_stmt()->is_Assignment())
-		continue;
-
-	      const LValue * the_lv =
-		((Assignment *) (*succs)[s]->get_stmt())->get_lval();
-	      Option<MicrocodeAddress> tgtopt = (*succs)[s]->extract_target();
-	      if (!tgtopt.hasValue())
-		continue;
-
-	      MicrocodeAddress addr = tgtopt.getValue();
-	      std::vector<Expr*> tgt_deps =
-		invfix.get_simple_dependencies (addr, max_step_nb);
-	      bool influence = false;
-	      for (int d=0; d<(int) tgt_deps.size(); d++)
-		{
-		  // Case 1: one dependency contains the modified lv
-		  if ((tgt_deps[d]->contains(the_lv)) ||
+	      // Case 1: one dependency contains the modified lv
+	      if ((tgt_deps[d]->contains(the_lv)) ||
 		  // Case 2: the modified lv is a memory reference and
 		  // there is a memory reference in the dependency (brutal!)
-		      (tgt_deps[d]->is_MemCell() && the_lv->is_MemCell()))
-		    { influence = true; break; }
-		}
-	      for (int d=0; d<(int) tgt_deps.size(); d++)
-		tgt_deps[d]->deref ();
-	      if (influence) {
-		logs::debug <<  (*succs)[s]->pp() << endl;
-		result.push_back((*succs)[s]);
-	      }
-	      else
-		logs::debug << (*succs)[s]->pp() << endl;
+		  (tgt_deps[d]->is_MemCell() && the_lv->is_MemCell()))
+		{ influence = true; break; }
 	    }
+	  for (int d=0; d<(int) tgt_deps.size(); d++)
+	    tgt_deps[d]->deref ();
+	  if (influence)
+	    result.push_back((*succs)[s]);
+	  if (logs::debug_is_on)
+	    logs::debug << (*succs)[s]->pp() << endl;
 	}
-      logs::debug << logs::separator << endl;
     }
+  logs::debug << logs::separator << endl;
 
   return result;
 }
@@ -910,6 +1465,7 @@ std::vector<StmtArrow *>
 DataDependency::useless_statements (const Microcode * prg)
 {
   vector<StmtArrow*> result;
+  RegisterLiveness liveness (prg);
 
   for (Microcode::const_node_iterator n = prg->begin_nodes ();
        n != prg->end_nodes (); n++)
@@ -917,7 +1473,7 @@ DataDependency::useless_statements (const Microcode * prg)
       vector<StmtArrow *> *succs = (*n)->get_successors ();
       for (int s = 0; s<(int) succs->size (); s++)
 	{
-	  if (! DataDependency::statement_used (prg, (*succs)[s]))
+	  if (! liveness.is_used ((*succs)[s]))
 	    result.push_back ((*succs)[s]);
 	}
     }
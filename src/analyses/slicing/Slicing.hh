@@ -33,6 +33,8 @@
 
 #include <list>
 #include <map>
+#include <set>
+#include <vector>
 #include <analyses/cfgrecovery/MicrocodeAddressProgramPoint.hh>
 #include <kernel/Architecture.hh>
 #include <kernel/Microcode.hh>
@@ -40,6 +42,7 @@
 #include <kernel/microcode/MicrocodeNode.hh>
 #include <utils/Option.hh>
 #include <utils/map-helpers.hh>
+#include <utils/unordered11.hh>
 
 
 class DataDependency;
@@ -178,4 +181,66 @@ public:
 
 };
 
+/*! Same fixpoint as DataDependency in OnlySimpleSets() mode, where the
+ * watched l-values are flat sets: each l-value occurring in the program
+ * is numbered and the set of a program point is a bitset. Nodes are
+ * updated from a worklist in postorder, hence a node is usually updated
+ * after its successors. Only programs whose memory cells have constant
+ * addresses are supported (see supports()). */
+class BitsetDataDependency {
+public:
+  /*! Tells whether every l-value of prg and of the seeds is a register or
+   *  a memory cell with a constant address, whose dependencies do not need
+   *  conditional sets. */
+  static bool supports (const Microcode *prg,
+			const std::list<LocatedLValue> &seeds);
+
+  BitsetDataDependency (Microcode *prg, const std::list<LocatedLValue> &seeds);
+  ~BitsetDataDependency ();
+
+  void ComputeFixpoint ();
+
+  /*! The l-values watched at pp, in the order they have been numbered.
+   *  As with DataDependency::get_simple_dependencies, only the l-values of
+   *  the default size are listed. */
+  std::vector<const LValue *> get_dependencies (const MicrocodeAddress &pp) const;
+
+  /*! Tells whether an assignment to lv may change the l-values watched at
+   *  pp: lv is watched or, being a memory cell, some memory cell is. */
+  bool is_influenced_by (const MicrocodeAddress &pp, const LValue *lv) const;
+
+private:
+  typedef std::vector<unsigned long> LValueSet;
+
+  /* Backward effect of an arrow on the set of its target: the assigned
+   * l-value, if any, is replaced by the dependencies of the assigned
+   * value. */
+  struct Transfer {
+    std::size_t target;
+    bool is_assignment;
+    std::size_t lvalue;
+    std::vector<std::size_t> deps;
+  };
+
+  std::size_t number (const LValue *lv);
+  /* Rank of the node at pp, or nodes.size () if there is no such node */
+  std::size_t get_rank (const MicrocodeAddress &pp) const;
+  /* Recomputes the set of a node from the sets of its successors */
+  bool update (std::size_t rank);
+
+  Microcode *the_program;
+  /* Nodes in postorder and their ranks in this order */
+  std::vector<MicrocodeNode *> nodes;
+  std::unordered_map<const MicrocodeNode *, std::size_t> ranks;
+  std::vector<std::vector<Transfer> > transfers;
+  std::vector<std::vector<std::size_t> > predecessors;
+  std::vector<LValue *> lvalues;
+  std::unordered_map<const Expr *, std::size_t> numbers;
+  std::vector<LValueSet> watched;
+  /* The l-values of the default size, the only ones that a backward step
+   * keeps in a flat set (see ConditionalSet::cs_flatten) */
+  LValueSet flat;
+  std::set<std::size_t> pending;
+};
+
 #endif /* SLICING_H */
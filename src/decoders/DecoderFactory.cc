@@ -38,13 +38,28 @@
 
 #include <decoders/Decoder.hh>
 #include <decoders/binutils/BinutilsDecoder.hh>
+#include <decoders/binutils/X86DirectDecoder.hh>
 
 using namespace std;
 
 Decoder *DecoderFactory::get_Decoder(MicrocodeArchitecture *arch,
                                      ConcreteMemory *mem)
 {
-  Decoder *decoder = new BinutilsDecoder(arch, mem);
+  return get_Decoder(arch, mem, BINUTILS_DECODER);
+}
+
+Decoder *DecoderFactory::get_Decoder(MicrocodeArchitecture *arch,
+                                     ConcreteMemory *mem,
+                                     DecoderKind kind)
+{
+  Decoder *decoder;
+
+  if (kind == DIRECT_DECODER &&
+      (arch->get_proc () == Architecture::X86_32 ||
+       arch->get_proc () == Architecture::X86_64))
+    decoder = new X86DirectDecoder(arch, mem);
+  else
+    decoder = new BinutilsDecoder(arch, mem);
 
   return decoder;
 }
@@ -43,11 +43,21 @@
 class DecoderFactory : public Object
 {
 public:
+  /* Kind of decoder to issue. DIRECT_DECODER translates x86 instructions
+   * straight from their bytes and hands unsupported encodings over to
+   * binutils; for other architectures it is the same as BINUTILS_DECODER.
+   */
+  typedef enum { BINUTILS_DECODER, DIRECT_DECODER } DecoderKind;
+
   /* Produces a decoder given an architecture and a memory.
    * Note also that it is up to the Factory to check whether all the
    * necessary libraries are installed on the system or not. */
   static Decoder *get_Decoder(MicrocodeArchitecture *arch, ConcreteMemory *mem);
 
+  /* Same as above but for the given kind of decoder. */
+  static Decoder *get_Decoder(MicrocodeArchitecture *arch, ConcreteMemory *mem,
+			      DecoderKind kind);
+
   /* Returns a list of supported architectures */
   static std::list<std::string> *get_Decoder_supported_architectures();
 };
@@ -0,0 +1,301 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <config.h>
+
+#include <pthread.h>
+
+#include <exception>
+#include <vector>
+
+#include <kernel/Expressions.hh>
+#include <utils/logs.hh>
+
+#include "SpeculativeDecoder.hh"
+
+using namespace std;
+
+/* Data of a worker thread of the pre-pass. Chunks are shared by all the
+ * workers; 'next_chunk' is the index of the first chunk that no worker
+ * has taken yet. 'known' is NULL during the first round and the fragments
+ * of the first round during the second one. */
+struct SpeculativeDecoder::Worker {
+  pthread_t thread;
+  Decoder *decoder;
+  const ConcreteMemory *memory;
+  vector<Chunk> *chunks;
+  size_t *next_chunk;
+  const FragmentTable *known;
+  FragmentTable fragments;
+};
+
+SpeculativeDecoder::SpeculativeDecoder (MicrocodeArchitecture *arch,
+					ConcreteMemory *memory,
+					Decoder *decoder,
+					DecoderFactory::DecoderKind kind)
+  : Decoder (arch, memory), memory (memory), decoder (decoder), kind (kind),
+    fragments (), nb_threads (0), nb_hits (0), nb_misses (0)
+{
+}
+
+SpeculativeDecoder::~SpeculativeDecoder ()
+{
+  for (FragmentTable::iterator i = fragments.begin (); i != fragments.end ();
+       i++)
+    delete i->second.mc;
+}
+
+void *
+SpeculativeDecoder::run_worker (void *data)
+{
+  Worker *W = (Worker *) data;
+
+  for (;;)
+    {
+      size_t c = __sync_fetch_and_add (W->next_chunk, 1);
+
+      if (c >= W->chunks->size ())
+	break;
+
+      /* Each chunk is taken by one worker only. */
+      Chunk &chunk = (*W->chunks)[c];
+      address_t addr;
+      address_t end;
+
+      if (W->known == NULL)
+	{
+	  addr = chunk.start;
+	  end = chunk.end;
+	}
+      else
+	{
+	  addr = chunk.last;
+	  end = chunk.limit;
+	}
+
+      while (addr < end)
+	{
+	  if (W->known != NULL && W->known->find (addr) != W->known->end ())
+	    break;
+
+	  if (! W->memory->is_defined (ConcreteAddress (addr)))
+	    {
+	      addr++;
+	      continue;
+	    }
+
+	  Microcode *mc = new Microcode ();
+
+	  try
+	    {
+	      address_t next = W->decoder->decode (mc, addr).get_address ();
+	      Fragment F = { mc, next };
+
+	      W->fragments[addr] = F;
+	      addr = (next > addr ? next : addr + 1);
+	    }
+	  catch (std::exception &)
+	    {
+	      /* Not an instruction; if the traversal reaches this address
+	       * anyway, the wrapped decoder reports the error. */
+	      delete mc;
+	      addr++;
+	    }
+	}
+      chunk.last = addr;
+    }
+
+  return NULL;
+}
+
+void
+SpeculativeDecoder::run_workers (vector<Chunk> &chunks,
+				 const FragmentTable *known)
+{
+  size_t next_chunk = 0;
+  vector<Worker> workers (nb_threads);
+
+  for (int i = 0; i < nb_threads; i++)
+    {
+      workers[i].decoder = DecoderFactory::get_Decoder (arch, memory, kind);
+      workers[i].memory = memory;
+      workers[i].chunks = &chunks;
+      workers[i].next_chunk = &next_chunk;
+      workers[i].known = known;
+    }
+
+  if (nb_threads == 1)
+    run_worker (&workers[0]);
+  else
+    {
+      for (int i = 0; i < nb_threads; i++)
+	if (pthread_create (&workers[i].thread, NULL, run_worker,
+			    &workers[i]) != 0)
+	  {
+	    /* The remaining chunks are swept by the workers already
+	     * started, or by the current thread. */
+	    for (; i < nb_threads; i++)
+	      workers[i].thread = pthread_self ();
+	    break;
+	  }
+
+      for (int i = 0; i < nb_threads; i++)
+	if (pthread_equal (workers[i].thread, pthread_self ()))
+	  run_worker (&workers[i]);
+	else
+	  pthread_join (workers[i].thread, NULL);
+    }
+
+  /* Gathering of the fragments. Chunks do not overlap during the first
+   * round and the second round stops at the first known address; an
+   * address decoded twice by the second round yields the same fragment
+   * twice, so either of them is kept. */
+  for (int i = 0; i < nb_threads; i++)
+    {
+      for (FragmentTable::iterator f = workers[i].fragments.begin ();
+	   f != workers[i].fragments.end (); f++)
+	if (! fragments.insert (*f).second)
+	  delete f->second.mc;
+      delete workers[i].decoder;
+    }
+}
+
+void
+SpeculativeDecoder::prefetch (const list<BinaryLoader::section_t> &sections,
+			      int nb_threads, size_t chunk_size)
+{
+  vector<Chunk> chunks;
+
+  assert (chunk_size > 0);
+  for (list<BinaryLoader::section_t>::const_iterator s = sections.begin ();
+       s != sections.end (); s++)
+    {
+      address_t start = s->start.get_address ();
+      address_t end = start + s->size;
+
+      for (address_t a = start; a < end; a += chunk_size)
+	{
+	  Chunk C;
+
+	  C.start = a;
+	  C.end = (end - a > chunk_size ? a + chunk_size : end);
+	  C.limit = (end - C.end > chunk_size ? C.end + chunk_size : end);
+	  C.last = C.end;
+	  chunks.push_back (C);
+	}
+    }
+
+  if (nb_threads < 1)
+    nb_threads = 1;
+  if (nb_threads > 1 && ! Expr::has_concurrent_store ())
+    {
+      logs::warning << "warning: decoding ahead with a single thread since "
+		    << "the store of expressions is not concurrent ("
+		    << Expr::CONCURRENT_STORE_PROP << ")" << endl;
+      nb_threads = 1;
+    }
+  if ((size_t) nb_threads > chunks.size ())
+    nb_threads = chunks.size ();
+  if (nb_threads == 0)
+    return;
+  this->nb_threads = nb_threads;
+
+  run_workers (chunks, NULL);
+
+  /* The second round only reads the fragments of the first one. */
+  FragmentTable known;
+
+  known.swap (fragments);
+  run_workers (chunks, &known);
+  fragments.insert (known.begin (), known.end ());
+}
+
+ConcreteAddress
+SpeculativeDecoder::decode (Microcode *mc, const ConcreteAddress &addr)
+  throw (Decoder::Exception)
+{
+  FragmentTable::iterator i = fragments.find (addr.get_address ());
+
+  if (i == fragments.end ())
+    {
+      nb_misses++;
+      return decoder->decode (mc, addr);
+    }
+
+  /* A fragment is used once; further decodings of the same address are
+   * served by the wrapped decoder. */
+  ConcreteAddress result (i->second.next);
+
+  nb_hits++;
+  mc->merge (i->second.mc, 0);
+  delete i->second.mc;
+  fragments.erase (i);
+
+  return result;
+}
+
+ConcreteAddress
+SpeculativeDecoder::next (const ConcreteAddress &addr)
+  throw (Decoder::Exception)
+{
+  FragmentTable::const_iterator i = fragments.find (addr.get_address ());
+
+  if (i == fragments.end ())
+    return decoder->next (addr);
+
+  return ConcreteAddress (i->second.next);
+}
+
+size_t
+SpeculativeDecoder::get_nb_prefetched () const
+{
+  return fragments.size ();
+}
+
+size_t
+SpeculativeDecoder::get_nb_hits () const
+{
+  return nb_hits;
+}
+
+size_t
+SpeculativeDecoder::get_nb_misses () const
+{
+  return nb_misses;
+}
+
+void
+SpeculativeDecoder::output_prefetch_stats (std::ostream &out) const
+{
+  out << "decoding ahead (" << nb_threads << " threads): "
+      << nb_hits << " instructions used, "
+      << fragments.size () << " not used, "
+      << nb_misses << " decoded on demand" << endl;
+}
@@ -0,0 +1,127 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef SPECULATIVEDECODER_HH
+#define SPECULATIVEDECODER_HH
+
+#include <cstddef>
+#include <list>
+#include <ostream>
+#include <vector>
+
+#include <decoders/Decoder.hh>
+#include <decoders/DecoderFactory.hh>
+#include <io/binary/BinaryLoader.hh>
+#include <utils/unordered11.hh>
+
+/***************** SpeculativeDecoder class definition ****************/
+
+/* Decoder that translates in advance, on several threads, the
+ * instructions of the code sections of a binary.
+ *
+ * prefetch() splits the sections into chunks. Each worker thread takes
+ * the chunks one after the other and sweeps them linearly with its own
+ * decoder (issued by the DecoderFactory); every instruction it meets is
+ * translated into a Microcode fragment of its own. Since a chunk may
+ * begin in the middle of an instruction, a second round resumes the
+ * sweep of each chunk past its end until it falls in step with the sweep
+ * of the next chunk. The fragments of all the workers are gathered once
+ * they are done.
+ *
+ * decode() then merges the fragment of the requested instruction into
+ * the program (Microcode::merge) instead of translating it again.
+ * Addresses that the sweeps missed (e.g. overlapping instructions) are
+ * handed over to the wrapped decoder. Fragments enter the program only
+ * when the traversal asks for them, so the recovered program does not
+ * depend on the pre-pass.
+ *
+ * Workers run concurrently only if the store of expressions is
+ * concurrent (see Expr::CONCURRENT_STORE_PROP).
+ */
+class SpeculativeDecoder : public Decoder
+{
+public:
+  /* 'decoder' is used for the instructions that have not been
+   * prefetched; it is not deleted with this object. Workers use
+   * decoders of the given 'kind'. */
+  SpeculativeDecoder (MicrocodeArchitecture *arch, ConcreteMemory *memory,
+		      Decoder *decoder, DecoderFactory::DecoderKind kind);
+  virtual ~SpeculativeDecoder ();
+
+  /* Decodes the 'sections' using 'nb_threads' workers. Sections are
+   * split into chunks of 'chunk_size' bytes. */
+  void prefetch (const std::list<BinaryLoader::section_t> &sections,
+		 int nb_threads, std::size_t chunk_size);
+
+  virtual ConcreteAddress decode (Microcode *mc, const ConcreteAddress &addr)
+    throw (Exception);
+
+  virtual ConcreteAddress next (const ConcreteAddress &addr)
+    throw (Exception);
+
+  /* Number of prefetched instructions not used yet, number of
+   * instructions served from the prefetched ones and number of
+   * instructions handed over to the wrapped decoder */
+  std::size_t get_nb_prefetched () const;
+  std::size_t get_nb_hits () const;
+  std::size_t get_nb_misses () const;
+  void output_prefetch_stats (std::ostream &out) const;
+
+private:
+  struct Fragment {
+    Microcode *mc;
+    address_t next;
+  };
+  typedef std::unordered_map<address_t, Fragment> FragmentTable;
+
+  /* Bytes [start, end[ are swept by the first round; the sweep stops at
+   * 'last' (i.e. the address following the last instruction). The second
+   * round resumes it up to 'limit' at most. */
+  struct Chunk {
+    address_t start;
+    address_t end;
+    address_t limit;
+    address_t last;
+  };
+
+  struct Worker;
+  static void *run_worker (void *worker);
+  void run_workers (std::vector<Chunk> &chunks, const FragmentTable *known);
+
+  ConcreteMemory *memory;
+  Decoder *decoder;
+  DecoderFactory::DecoderKind kind;
+  FragmentTable fragments;
+  int nb_threads;
+  std::size_t nb_hits;
+  std::size_t nb_misses;
+};
+
+#endif /* SPECULATIVEDECODER_HH */
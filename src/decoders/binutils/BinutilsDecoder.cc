@@ -32,13 +32,17 @@
 
 #include <cstdarg>
 #include <cstdlib>
+#include <cstring>
 
 #include <vector>
 #include <utility>
 #include <cerrno>
 #include <cassert>
+#include <iomanip>
+#include <typeinfo>
 
 #include <kernel/annotations/AsmAnnotation.hh>
+#include <utils/MutexLock.hh>
 #include <decoders/binutils/arm/arm_decoder.hh>
 #include <decoders/binutils/msp430/msp430_decoder.hh>
 #include <decoders/binutils/sparc/sparc_decoder.hh>
@@ -54,6 +58,18 @@ using namespace std;
 #define DEFAULT_SKIP_ZEROES 8
 #define DEFAULT_SKIP_ZEROES_AT_END 3
 
+/* Bytes read ahead to look an instruction up in the translation cache
+ * (the longest x86 instruction is 15 bytes long) */
+#define TRANSLATION_WINDOW_SIZE 16
+/* Distance to the address where a new translation is decoded again to
+ * check that it does not depend on its position */
+#define TRANSLATION_PROBE_SHIFT 0x10001
+
+/* The disassemblers of libopcodes and the scanners of our parsers keep
+ * their state in global variables; decoders running in several threads
+ * use them one at a time. */
+static pthread_mutex_t s_binutils_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* Custom 'sprintf()' function for our decoders */
 static int s_binutils_sprintf(stringstream *stream, const char *format, ...);
 
@@ -66,6 +82,34 @@ static int s_binutils_read_memory(bfd_vma memaddr,
 /* Custom 'print_address()' function for our decoders */
 static void s_binutils_print_address(bfd_vma, struct disassemble_info *);
 
+/* Compare two translations of the same bytes decoded at 'start1' and
+ * 'start2' */
+static bool s_same_translation (const Microcode *mc1, address_t start1,
+				const Microcode *mc2, address_t start2);
+
+/* Reader serving a copy of some bytes as if they were located at
+ * address 'base' */
+class ShiftedBytesReader : public Decoder::RawBytesReader
+{
+public:
+  ShiftedBytesReader (address_t base, const string &bytes)
+    : base (base), bytes (bytes) { }
+
+  virtual ~ShiftedBytesReader () { }
+
+  virtual void read_buffer (address_t from, uint8_t *dest, size_t length)
+    throw (Decoder::Exception)
+  {
+    if (from < base || from - base + length > bytes.size ())
+      throw Decoder::OutOfBounds (from);
+    memcpy (dest, bytes.data () + (from - base), length);
+  }
+
+private:
+  address_t base;
+  const string &bytes;
+};
+
 /* This function returns a new _fake_ BFD structure. */
 bfd* new_bfd(void)
 {
@@ -108,14 +152,14 @@ void delete_bfd(bfd* abfd)
 
 BinutilsDecoder::BinutilsDecoder(MicrocodeArchitecture *arch,
 				 ConcreteMemory *mem)
-  : Decoder (arch, mem)
+  : Decoder (arch, mem), cache (), nb_cache_hits (0), nb_cache_misses (0)
 {
   init ();
 }
 
 BinutilsDecoder::BinutilsDecoder(MicrocodeArchitecture *arch,
 				 Decoder::RawBytesReader *reader)
-  : Decoder (arch, reader)
+  : Decoder (arch, reader), cache (), nb_cache_hits (0), nb_cache_misses (0)
 {
   init ();
 }
@@ -126,6 +170,11 @@ BinutilsDecoder::BinutilsDecoder(MicrocodeArchitecture *arch,
 
 BinutilsDecoder::~BinutilsDecoder()
 {
+  for (TranslationCache::iterator i = cache.begin (); i != cache.end (); i++)
+    delete i->second.mc;
+  /* Data built on 'arch' by the translation functions may hold
+   * expressions; it goes away with the last decoder of 'arch'. */
+  arch->deref_decoder_data ();
   delete this->instr_buffer;
   delete this->info;
 }
@@ -136,25 +185,41 @@ ConcreteAddress
 BinutilsDecoder::decode(Microcode *mc, const ConcreteAddress &address)
   throw (Decoder::Exception)
 {
-  ConcreteAddress result = this->next(address);
+  address_t start = address.get_address ();
+  string window = read_window (start);
+  TranslationCache::const_iterator i = lookup (window);
 
-  if (decoder == NULL)
-    throw Decoder::DecoderUnexpectedError("Decoder not implemented for "
-					  "this architecture");
+  if (i != cache.end () && i->second.mc != NULL)
+    {
+      nb_cache_hits++;
+      instantiate (mc, i->second, start);
+
+      return ConcreteAddress (start + i->first.size ());
+    }
 
-  if (this->decoder(arch, mc, instr_buffer->str(), address, result))
+  nb_cache_misses++;
+  if (i != cache.end () || window.empty ())
+    return translate (mc, address);
+
+  /* First occurrence of these bytes: the translation is built apart
+   * in order to be kept in the cache. */
+  Microcode *tmpl = new Microcode ();
+  ConcreteAddress result;
+
+  try
     {
-      MicrocodeNode *node =
-	mc->get_node (MicrocodeAddress (address.get_address ()));
-      node->add_annotation (AsmAnnotation::ID,
-			    new AsmAnnotation (instr_buffer->str ()));
+      result = translate (tmpl, address);
     }
-  else
+  catch (Decoder::Exception &)
     {
-      throw Decoder::DecoderUnexpectedError ("syntax error @" +
-					     address.to_string ());
+      delete tmpl;
+      throw;
     }
 
+  CachedTranslation tr = { tmpl, start };
+  instantiate (mc, tr, start);
+  add_to_cache (window, tmpl, address, result);
+
   return result;
 }
 
@@ -163,25 +228,272 @@ BinutilsDecoder::decode(Microcode *mc, const ConcreteAddress &address)
 ConcreteAddress
 BinutilsDecoder::next(const ConcreteAddress &address)
   throw (Exception)
+{
+  int instr_size = disassemble (address.get_address ());
+
+  if (instr_size <= 0)
+    throw Decoder::OutOfBounds (address.get_address ());
+
+  return ConcreteAddress(address.get_address () + instr_size);
+}
+
+/* --------------- */
+
+/* Runs the disassembler on the instruction at 'addr'; its text is left
+ * into instr_buffer. Returns the size of the instruction. */
+int
+BinutilsDecoder::disassemble (address_t addr)
 {
   /* Clearing out the previous decoded instruction */
   this->instr_buffer->str(string());
 
   /* Initializing the info structure */
   this->info->buffer = NULL;
-  this->info->buffer_vma = (bfd_vma) address.get_address ();
+  this->info->buffer_vma = (bfd_vma) addr;
   this->info->buffer_length = (bfd_size_type) INSTR_MAX_SIZE;
   this->info->section = NULL;
 
   /* Get next instruction address */
-  int instr_size = (*this->disassembler_fn)(this->info->buffer_vma, this->info);
+  MutexLock L (&s_binutils_lock);
 
-  if (instr_size <= 0)
-    throw Decoder::OutOfBounds (address.get_address ());
+  return (*this->disassembler_fn)(this->info->buffer_vma, this->info);
+}
 
-  return ConcreteAddress(address.get_address () + instr_size);
+/* --------------- */
+
+/* Disassembles and parses the instruction at 'address' into 'mc' */
+ConcreteAddress
+BinutilsDecoder::translate (Microcode *mc, const ConcreteAddress &address)
+{
+  /* The text of the instruction is needed: next() may be overridden by
+   * a subclass that does not run the disassembler. */
+  ConcreteAddress result = BinutilsDecoder::next (address);
+  bool parsed;
+
+  if (decoder == NULL)
+    throw Decoder::DecoderUnexpectedError("Decoder not implemented for "
+					  "this architecture");
+
+  {
+    MutexLock L (&s_binutils_lock);
+
+    parsed = this->decoder (arch, mc, instr_buffer->str (), address, result);
+  }
+
+  if (parsed)
+    {
+      MicrocodeNode *node =
+	mc->get_node (MicrocodeAddress (address.get_address ()));
+      node->add_annotation (AsmAnnotation::ID,
+			    new AsmAnnotation (instr_buffer->str ()));
+    }
+  else
+    {
+      throw Decoder::DecoderUnexpectedError ("syntax error @" +
+					     address.to_string ());
+    }
+
+  return result;
+}
+
+/* --------------- */
+
+/* Returns the bytes at 'addr' that may belong to an instruction. The
+ * window is shorter near the end of the memory. */
+string
+BinutilsDecoder::read_window (address_t addr)
+{
+  uint8_t bytes[TRANSLATION_WINDOW_SIZE];
+  size_t length = TRANSLATION_WINDOW_SIZE;
+
+  try
+    {
+      reader->read_buffer (addr, bytes, length);
+    }
+  catch (Decoder::Exception &)
+    {
+      for (length = 0; length < TRANSLATION_WINDOW_SIZE; length++)
+	{
+	  try
+	    {
+	      reader->read_buffer (addr + length, bytes + length, 1);
+	    }
+	  catch (Decoder::Exception &)
+	    {
+	      break;
+	    }
+	}
+    }
+
+  return string ((const char *) bytes, length);
+}
+
+BinutilsDecoder::TranslationCache::const_iterator
+BinutilsDecoder::lookup (const string &window) const
+{
+  TranslationCache::const_iterator i = cache.upper_bound (window);
+
+  if (i == cache.begin ())
+    return cache.end ();
+  --i;
+  if (window.compare (0, i->first.size (), i->first) != 0)
+    return cache.end ();
+
+  return i;
+}
+
+/* Records 'tmpl', the translation of the instruction in 'window'
+ * decoded at 'start'. The same bytes are decoded again at another
+ * address; unless both translations are equal up to the shift of
+ * addresses, 'tmpl' is dropped and the bytes are recorded as
+ * position-dependent. */
+void
+BinutilsDecoder::add_to_cache (const string &window, Microcode *tmpl,
+			       const ConcreteAddress &start,
+			       const ConcreteAddress &next)
+{
+  address_t addr = start.get_address ();
+  size_t length = next.get_address () - addr;
+
+  if (length > window.size ())
+    {
+      delete tmpl;
+      return;
+    }
+
+  address_t probe = (addr >= TRANSLATION_PROBE_SHIFT
+		     ? addr - TRANSLATION_PROBE_SHIFT
+		     : addr + TRANSLATION_PROBE_SHIFT);
+  ShiftedBytesReader R (probe, window);
+  void *saved_reader = info->application_data;
+  Microcode *other = new Microcode ();
+  bool reusable;
+
+  info->application_data = &R;
+  try
+    {
+      ConcreteAddress other_next = translate (other, ConcreteAddress (probe));
+
+      reusable = (other_next.get_address () - probe == length &&
+		  s_same_translation (tmpl, addr, other, probe));
+    }
+  catch (Decoder::Exception &)
+    {
+      reusable = false;
+    }
+  info->application_data = saved_reader;
+  delete other;
+
+  if (! reusable)
+    {
+      delete tmpl;
+      tmpl = NULL;
+    }
+  CachedTranslation tr = { tmpl, addr };
+  cache[window.substr (0, length)] = tr;
 }
 
+static MicrocodeAddress
+s_shift (const MicrocodeAddress &ma, address_t shift)
+{
+  return MicrocodeAddress (ma.getGlobal () + shift, ma.getLocal ());
+}
+
+static void
+s_copy_annotations (Annotable *dst, const Annotable *src)
+{
+  const Annotable::AnnotationMap *annotations = src->get_annotations ();
+
+  for (Annotable::AnnotationMap::const_iterator i = annotations->begin ();
+       i != annotations->end (); i++)
+    dst->add_annotation (i->first, (Annotation *) i->second->clone ());
+}
+
+/* Replays the cached translation 'tr' at address 'start' through the
+ * Microcode API, so arrow creation callbacks of 'mc' are triggered as
+ * if the instruction were decoded. */
+void
+BinutilsDecoder::instantiate (Microcode *mc, const CachedTranslation &tr,
+			      address_t start)
+{
+  address_t shift = start - tr.start;
+
+  Microcode_iterate_nodes (*tr.mc, n)
+    {
+      MicrocodeNode *node = mc->get_or_create_node (s_shift ((*n)->get_loc (),
+							    shift));
+      s_copy_annotations (node, *n);
+    }
+
+  Microcode_iterate_nodes (*tr.mc, n)
+    {
+      MicrocodeAddress src = s_shift ((*n)->get_loc (), shift);
+
+      MicrocodeNode_iterate_successors (**n, a)
+	{
+	  Statement *stmt = (*a)->get_stmt ();
+	  Expr *cond = (*a)->get_condition ()->ref ();
+	  StmtArrow *na;
+
+	  if ((*a)->is_dynamic ())
+	    {
+	      DynamicArrow *da = dynamic_cast<DynamicArrow *> (*a);
+
+	      assert (stmt->is_Jump ());
+	      na = mc->add_jump (src, da->get_target ()->ref (), cond);
+	    }
+	  else
+	    {
+	      StaticArrow *sa = dynamic_cast<StaticArrow *> (*a);
+	      MicrocodeAddress tgt = s_shift (sa->get_target (), shift);
+
+	      if (stmt->is_Skip ())
+		na = mc->add_skip (src, tgt, cond);
+	      else
+		{
+		  Assignment *as = dynamic_cast<Assignment *> (stmt);
+
+		  assert (as != NULL);
+		  na = mc->add_assignment (src, as->get_lval ()->ref (),
+					   as->get_rval ()->ref (), tgt, cond);
+		}
+	    }
+	  s_copy_annotations (na, *a);
+	}
+    }
+}
+
+size_t
+BinutilsDecoder::get_nb_cache_hits () const
+{
+  return nb_cache_hits;
+}
+
+size_t
+BinutilsDecoder::get_nb_cache_misses () const
+{
+  return nb_cache_misses;
+}
+
+void
+BinutilsDecoder::output_cache_stats (std::ostream &out) const
+{
+  size_t nb_decodes = nb_cache_hits + nb_cache_misses;
+  size_t nb_reusable = 0;
+
+  for (TranslationCache::const_iterator i = cache.begin ();
+       i != cache.end (); i++)
+    if (i->second.mc != NULL)
+      nb_reusable++;
+
+  out << "translation cache: " << nb_cache_hits << " hits, "
+      << nb_cache_misses << " misses";
+  if (nb_decodes > 0)
+    out << " (" << fixed << setprecision (1)
+	<< (100.0 * nb_cache_hits / nb_decodes) << "% hits)";
+  out << ", " << cache.size () << " entries ("
+      << (cache.size () - nb_reusable) << " position-dependent)" << endl;
+}
 
 std::string
 BinutilsDecoder::get_instruction (const ConcreteAddress &addr)
@@ -206,6 +518,8 @@ BinutilsDecoder::set_disassembler_info(struct disassemble_info *info)
 void
 BinutilsDecoder::init ()
 {
+  arch->ref_decoder_data ();
+
   /* Initializing BFD framework */
   bfd_init();
 
@@ -430,3 +744,100 @@ s_binutils_print_address(bfd_vma addr, struct disassemble_info *dinfo)
 {
   dinfo->fprintf_func(dinfo->stream, "0x%" BFD_VMA_FMT "x", addr);
 }
+
+static bool
+s_same_annotations (const Annotable *a1, const Annotable *a2)
+{
+  const Annotable::AnnotationMap *m1 = a1->get_annotations ();
+  const Annotable::AnnotationMap *m2 = a2->get_annotations ();
+
+  if (m1->size () != m2->size ())
+    return false;
+
+  for (Annotable::AnnotationMap::const_iterator i = m1->begin ();
+       i != m1->end (); i++)
+    {
+      Annotable::AnnotationMap::const_iterator j = m2->find (i->first);
+      ostringstream t1, t2;
+
+      if (j == m2->end ())
+	return false;
+      i->second->output_text (t1);
+      j->second->output_text (t2);
+      if (t1.str () != t2.str ())
+	return false;
+    }
+
+  return true;
+}
+
+/* Expressions are hash-consed, so statements are compared on the
+ * pointers of their expressions. */
+static bool
+s_same_statement (Statement *s1, Statement *s2)
+{
+  if (typeid (*s1) != typeid (*s2) || s1->is_External ())
+    return false;
+
+  vector<Expr **> *e1 = s1->expr_list ();
+  vector<Expr **> *e2 = s2->expr_list ();
+  bool result = (e1->size () == e2->size ());
+
+  for (size_t i = 0; result && i < e1->size (); i++)
+    result = (*(*e1)[i] == *(*e2)[i]);
+  delete e1;
+  delete e2;
+
+  return result;
+}
+
+static bool
+s_same_arrow (StmtArrow *a1, address_t start1, StmtArrow *a2,
+	      address_t start2)
+{
+  if (a1->is_static () != a2->is_static () ||
+      a1->get_condition () != a2->get_condition () ||
+      ! s_same_statement (a1->get_stmt (), a2->get_stmt ()) ||
+      ! s_same_annotations (a1, a2))
+    return false;
+
+  if (a1->is_dynamic ())
+    return (dynamic_cast<DynamicArrow *> (a1)->get_target () ==
+	    dynamic_cast<DynamicArrow *> (a2)->get_target ());
+
+  MicrocodeAddress t1 = dynamic_cast<StaticArrow *> (a1)->get_target ();
+  MicrocodeAddress t2 = dynamic_cast<StaticArrow *> (a2)->get_target ();
+
+  return (t1.getGlobal () - start1 == t2.getGlobal () - start2 &&
+	  t1.getLocal () == t2.getLocal ());
+}
+
+static bool
+s_same_translation (const Microcode *mc1, address_t start1,
+		    const Microcode *mc2, address_t start2)
+{
+  if (mc1->get_number_of_nodes () != mc2->get_number_of_nodes ())
+    return false;
+
+  Microcode_iterate_nodes (*mc1, n1)
+    {
+      MicrocodeAddress loc ((*n1)->get_loc ().getGlobal () - start1 + start2,
+			    (*n1)->get_loc ().getLocal ());
+
+      if (! mc2->has_node_at (loc))
+	return false;
+
+      MicrocodeNode *n2 = mc2->get_node (loc);
+      vector<StmtArrow *> *succ1 = (*n1)->get_successors ();
+      vector<StmtArrow *> *succ2 = n2->get_successors ();
+
+      if (succ1->size () != succ2->size () || ! s_same_annotations (*n1, n2))
+	return false;
+
+      for (size_t i = 0; i < succ1->size (); i++)
+	if (! s_same_arrow (succ1->at (i), start1, succ2->at (i), start2))
+	  return false;
+    }
+
+  return true;
+}
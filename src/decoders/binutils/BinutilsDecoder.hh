@@ -36,7 +36,10 @@
 #include <bfd.h>
 #include <dis-asm.h>
 
+#include <map>
+#include <ostream>
 #include <sstream>
+#include <string>
 
 #include <decoders/Decoder.hh>
 #include <kernel/Microcode.hh>
@@ -76,13 +79,51 @@ public:
   struct disassemble_info *get_disassembler_info();
   void set_disassembler_info(struct disassemble_info *info);
 
+  /***** Translation cache *****/
+
+  /* Number of instructions whose microcode has been instantiated from
+   * the translation cache (hits) or produced by the disassembler and
+   * the parser (misses) */
+  std::size_t get_nb_cache_hits () const;
+  std::size_t get_nb_cache_misses () const;
+  void output_cache_stats (std::ostream &out) const;
+
+protected:
+  /* Bytes at 'addr' that may belong to an instruction */
+  std::string read_window (address_t addr);
+
 private:
+  /* Translation of a byte sequence decoded at address 'start'. 'mc'
+   * is NULL when the translation depends on the address of the
+   * instruction (e.g. relative jumps or calls) and cannot be reused
+   * elsewhere. */
+  struct CachedTranslation {
+    Microcode *mc;
+    address_t start;
+  };
+  /* Instruction encodings are prefix-free, so the entry matching the
+   * bytes at some address is the greatest key lower or equal to these
+   * bytes (see lookup ()). */
+  typedef std::map<std::string, CachedTranslation> TranslationCache;
+
   void init ();
+  int disassemble (address_t addr);
+  ConcreteAddress translate (Microcode *mc, const ConcreteAddress &addr);
+  TranslationCache::const_iterator lookup (const std::string &window) const;
+  void add_to_cache (const std::string &window, Microcode *tmpl,
+		     const ConcreteAddress &start,
+		     const ConcreteAddress &next);
+  static void instantiate (Microcode *mc, const CachedTranslation &tr,
+			   address_t start);
+
   /* Decoder internal fields */
   decoder_ftype decoder;              /* Decoder function */
   struct disassemble_info *info;      /* Disassembler info */
   disassembler_ftype disassembler_fn; /* Disassembler function */
   std::stringstream *instr_buffer;    /* Disassembled instruction buffer */
+  TranslationCache cache;             /* Already translated instructions */
+  std::size_t nb_cache_hits;
+  std::size_t nb_cache_misses;
 };
 
 #endif /* BINUTILSDECODER_HH */
@@ -0,0 +1,132 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <config.h>
+
+#include <iomanip>
+
+#include <kernel/annotations/AsmAnnotation.hh>
+#include <decoders/binutils/x86/x86_direct_decoder.hh>
+
+#include "X86DirectDecoder.hh"
+
+using namespace std;
+
+static bool
+s_is_x86 (const MicrocodeArchitecture *arch)
+{
+  return (arch->get_proc () == Architecture::X86_32 ||
+	  arch->get_proc () == Architecture::X86_64);
+}
+
+X86DirectDecoder::X86DirectDecoder (MicrocodeArchitecture *arch,
+				    ConcreteMemory *mem)
+  : BinutilsDecoder (arch, mem), enabled (s_is_x86 (arch)),
+    nb_direct_decodings (0), nb_fallbacks (0)
+{
+}
+
+X86DirectDecoder::X86DirectDecoder (MicrocodeArchitecture *arch,
+				    Decoder::RawBytesReader *reader)
+  : BinutilsDecoder (arch, reader), enabled (s_is_x86 (arch)),
+    nb_direct_decodings (0), nb_fallbacks (0)
+{
+}
+
+X86DirectDecoder::~X86DirectDecoder ()
+{
+}
+
+ConcreteAddress
+X86DirectDecoder::decode (Microcode *mc, const ConcreteAddress &address)
+  throw (Decoder::Exception)
+{
+  address_t start = address.get_address ();
+  string text;
+  int size = 0;
+
+  if (enabled)
+    size = x86_direct_decoder_func (arch, mc, read_window (start), address,
+				    &text);
+
+  if (size == 0)
+    {
+      nb_fallbacks++;
+      return BinutilsDecoder::decode (mc, address);
+    }
+
+  nb_direct_decodings++;
+  MicrocodeNode *node = mc->get_node (MicrocodeAddress (start));
+  node->add_annotation (AsmAnnotation::ID, new AsmAnnotation (text));
+
+  return ConcreteAddress (start + size);
+}
+
+ConcreteAddress
+X86DirectDecoder::next (const ConcreteAddress &address)
+  throw (Decoder::Exception)
+{
+  address_t start = address.get_address ();
+  int size = 0;
+
+  if (enabled)
+    size = x86_direct_decoder_func (arch, NULL, read_window (start), address,
+				    NULL);
+
+  if (size == 0)
+    return BinutilsDecoder::next (address);
+
+  return ConcreteAddress (start + size);
+}
+
+size_t
+X86DirectDecoder::get_nb_direct_decodings () const
+{
+  return nb_direct_decodings;
+}
+
+size_t
+X86DirectDecoder::get_nb_fallbacks () const
+{
+  return nb_fallbacks;
+}
+
+void
+X86DirectDecoder::output_direct_stats (std::ostream &out) const
+{
+  size_t nb_decodes = nb_direct_decodings + nb_fallbacks;
+
+  out << "direct decoder: " << nb_direct_decodings << " instructions, "
+      << nb_fallbacks << " handed over to the disassembler";
+  if (nb_decodes > 0)
+    out << " (" << fixed << setprecision (1)
+	<< (100.0 * nb_direct_decodings / nb_decodes) << "% direct)";
+  out << endl;
+}
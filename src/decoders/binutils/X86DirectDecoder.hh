@@ -0,0 +1,68 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef X86DIRECTDECODER_HH
+#define X86DIRECTDECODER_HH
+
+#include <cstddef>
+#include <ostream>
+
+#include <decoders/binutils/BinutilsDecoder.hh>
+
+/* Decoder for x86-32 and x86-64 that translates the instructions
+ * straight from their bytes (see x86_direct_decoder_func). Encodings
+ * that it does not know are handed over to the disassembler and the
+ * parser of BinutilsDecoder. */
+class X86DirectDecoder : public BinutilsDecoder
+{
+public:
+  X86DirectDecoder (MicrocodeArchitecture *arch, ConcreteMemory *mem);
+  X86DirectDecoder (MicrocodeArchitecture *arch, RawBytesReader *reader);
+  virtual ~X86DirectDecoder ();
+
+  virtual ConcreteAddress decode (Microcode *mc, const ConcreteAddress &addr)
+    throw (Exception);
+
+  virtual ConcreteAddress next (const ConcreteAddress &addr)
+    throw (Exception);
+
+  /* Number of instructions translated from their bytes and number of
+   * instructions handed over to BinutilsDecoder */
+  std::size_t get_nb_direct_decodings () const;
+  std::size_t get_nb_fallbacks () const;
+  void output_direct_stats (std::ostream &out) const;
+
+private:
+  bool enabled;                       /* false if 'arch' is not x86 */
+  std::size_t nb_direct_decodings;
+  std::size_t nb_fallbacks;
+};
+
+#endif /* X86DIRECTDECODER_HH */
@@ -0,0 +1,1279 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Opcode-table-driven front end of the x86 translation functions.
+ *
+ * The usual path goes through libopcodes, which prints the instruction
+ * in AT&T syntax, and through the x86 scanner and parser, which rebuild
+ * the operands from this text before calling the translation function
+ * of the mnemonic. Here, prefixes, ModRM/SIB bytes and immediates are
+ * decoded directly; the operands are built the way the parser does it
+ * from the text that libopcodes would have printed, and this text is
+ * generated as well for the assembler annotation. Encodings that are
+ * not described below make x86_direct_decoder_func() return 0.
+ */
+
+#include <config.h>
+
+#include <cctype>
+#include <cstdio>
+
+#include <kernel/Expressions.hh>
+
+#include "x86_translation_functions.hh"
+#include "x86_direct_decoder.hh"
+
+using namespace std;
+
+/* Translation functions of a mnemonic for each number of operands */
+struct x86_mnemonic
+{
+  const char *name;
+  void (*translate0) (x86::parser_data &);
+  void (*translate1) (x86::parser_data &, Expr *);
+  void (*translate2) (x86::parser_data &, Expr *, Expr *);
+  void (*translate3) (x86::parser_data &, Expr *, Expr *, Expr *);
+};
+
+/* A mnemonic and its variants suffixed with the size of the operands;
+ * libopcodes uses the latter when no register gives this size. */
+struct x86_sized_mnemonic
+{
+  x86_mnemonic plain, b, w, l, q;
+};
+
+#define X86_MNEMONIC(tok)						\
+  { #tok, &x86_translate<X86_TOKEN(tok)>, &x86_translate<X86_TOKEN(tok)>, \
+      &x86_translate<X86_TOKEN(tok)>, &x86_translate<X86_TOKEN(tok)> }
+
+#define X86_NO_MNEMONIC { NULL, NULL, NULL, NULL, NULL }
+
+#define X86_SIZED_MNEMONIC(tok)						\
+  { X86_MNEMONIC (tok), X86_MNEMONIC (tok ## B), X86_MNEMONIC (tok ## W), \
+      X86_MNEMONIC (tok ## L), X86_MNEMONIC (tok ## Q) }
+
+/* Mnemonics that have no 'q' variant in the parser */
+#define X86_SIZED_MNEMONIC_32(tok)					\
+  { X86_MNEMONIC (tok), X86_MNEMONIC (tok ## B), X86_MNEMONIC (tok ## W), \
+      X86_MNEMONIC (tok ## L), X86_NO_MNEMONIC }
+
+#define X86_NO_SIZED_MNEMONIC						\
+  { X86_NO_MNEMONIC, X86_NO_MNEMONIC, X86_NO_MNEMONIC, X86_NO_MNEMONIC, \
+      X86_NO_MNEMONIC }
+
+/* Opcodes 00-3f and group 1 (80-83) */
+static const x86_sized_mnemonic s_arithmetic[8] = {
+  X86_SIZED_MNEMONIC (ADD), X86_SIZED_MNEMONIC (OR),
+  X86_SIZED_MNEMONIC_32 (ADC), X86_SIZED_MNEMONIC (SBB),
+  X86_SIZED_MNEMONIC (AND), X86_SIZED_MNEMONIC (SUB),
+  X86_SIZED_MNEMONIC (XOR), X86_SIZED_MNEMONIC (CMP)
+};
+
+/* Group 2 (c0, c1, d0-d3) */
+static const x86_sized_mnemonic s_shifts[8] = {
+  X86_SIZED_MNEMONIC_32 (ROL), X86_SIZED_MNEMONIC_32 (ROR),
+  X86_SIZED_MNEMONIC_32 (RCL), X86_SIZED_MNEMONIC_32 (RCR),
+  X86_SIZED_MNEMONIC_32 (SHL), X86_SIZED_MNEMONIC_32 (SHR),
+  X86_NO_SIZED_MNEMONIC, X86_SIZED_MNEMONIC_32 (SAR)
+};
+
+/* Group 3 (f6, f7) */
+static const x86_sized_mnemonic s_unary[8] = {
+  X86_SIZED_MNEMONIC (TEST), X86_NO_SIZED_MNEMONIC,
+  X86_SIZED_MNEMONIC (NOT), X86_SIZED_MNEMONIC (NEG),
+  X86_SIZED_MNEMONIC (MUL), X86_SIZED_MNEMONIC (IMUL),
+  X86_SIZED_MNEMONIC (DIV), X86_SIZED_MNEMONIC (IDIV)
+};
+
+static const x86_sized_mnemonic s_inc = X86_SIZED_MNEMONIC (INC);
+static const x86_sized_mnemonic s_dec = X86_SIZED_MNEMONIC (DEC);
+static const x86_sized_mnemonic s_mov = X86_SIZED_MNEMONIC (MOV);
+static const x86_sized_mnemonic s_test = X86_SIZED_MNEMONIC (TEST);
+static const x86_sized_mnemonic s_push = {
+  X86_MNEMONIC (PUSH), X86_NO_MNEMONIC, X86_MNEMONIC (PUSHW),
+  X86_MNEMONIC (PUSHL), X86_MNEMONIC (PUSHQ)
+};
+static const x86_sized_mnemonic s_pop = {
+  X86_MNEMONIC (POP), X86_NO_MNEMONIC, X86_MNEMONIC (POPW),
+  X86_MNEMONIC (POPL), X86_MNEMONIC (POPQ)
+};
+static const x86_sized_mnemonic s_nop = {
+  X86_MNEMONIC (NOP), X86_NO_MNEMONIC, X86_MNEMONIC (NOPW),
+  X86_MNEMONIC (NOPL), X86_NO_MNEMONIC
+};
+
+/* Conditional instructions indexed by the condition code of the
+ * opcode, named the way libopcodes prints them */
+static const x86_mnemonic s_jcc[16] = {
+  X86_MNEMONIC (JO), X86_MNEMONIC (JNO), X86_MNEMONIC (JB),
+  X86_MNEMONIC (JAE), X86_MNEMONIC (JE), X86_MNEMONIC (JNE),
+  X86_MNEMONIC (JBE), X86_MNEMONIC (JA), X86_MNEMONIC (JS),
+  X86_MNEMONIC (JNS), X86_MNEMONIC (JP), X86_MNEMONIC (JNP),
+  X86_MNEMONIC (JL), X86_MNEMONIC (JGE), X86_MNEMONIC (JLE),
+  X86_MNEMONIC (JG)
+};
+
+static const x86_mnemonic s_setcc[16] = {
+  X86_MNEMONIC (SETO), X86_MNEMONIC (SETNO), X86_MNEMONIC (SETB),
+  X86_MNEMONIC (SETAE), X86_MNEMONIC (SETE), X86_MNEMONIC (SETNE),
+  X86_MNEMONIC (SETBE), X86_MNEMONIC (SETA), X86_MNEMONIC (SETS),
+  X86_MNEMONIC (SETNS), X86_MNEMONIC (SETP), X86_MNEMONIC (SETNP),
+  X86_MNEMONIC (SETL), X86_MNEMONIC (SETGE), X86_MNEMONIC (SETLE),
+  X86_MNEMONIC (SETG)
+};
+
+static const x86_mnemonic s_cmovcc[16] = {
+  X86_MNEMONIC (CMOVO), X86_MNEMONIC (CMOVNO), X86_MNEMONIC (CMOVB),
+  X86_MNEMONIC (CMOVAE), X86_MNEMONIC (CMOVE), X86_MNEMONIC (CMOVNE),
+  X86_MNEMONIC (CMOVBE), X86_MNEMONIC (CMOVA), X86_MNEMONIC (CMOVS),
+  X86_MNEMONIC (CMOVNS), X86_MNEMONIC (CMOVP), X86_MNEMONIC (CMOVNP),
+  X86_MNEMONIC (CMOVL), X86_MNEMONIC (CMOVGE), X86_MNEMONIC (CMOVLE),
+  X86_MNEMONIC (CMOVG)
+};
+
+/* Instructions without operands (f4-fd) */
+static const x86_mnemonic s_hlt = X86_MNEMONIC (HLT);
+static const x86_mnemonic s_cmc = X86_MNEMONIC (CMC);
+static const x86_mnemonic s_flags[6] = {
+  X86_MNEMONIC (CLC), X86_MNEMONIC (STC), X86_MNEMONIC (CLI),
+  X86_MNEMONIC (STI), X86_MNEMONIC (CLD), X86_MNEMONIC (STD)
+};
+
+static const x86_mnemonic s_lea = X86_MNEMONIC (LEA);
+static const x86_mnemonic s_xchg = X86_MNEMONIC (XCHG);
+static const x86_mnemonic s_movabs = X86_MNEMONIC (MOVABS);
+static const x86_mnemonic s_movslq = X86_MNEMONIC (MOVSLQ);
+static const x86_mnemonic s_imul = X86_MNEMONIC (IMUL);
+static const x86_mnemonic s_movzbw = X86_MNEMONIC (MOVZBW);
+static const x86_mnemonic s_movzbl = X86_MNEMONIC (MOVZBL);
+static const x86_mnemonic s_movzwl = X86_MNEMONIC (MOVZWL);
+static const x86_mnemonic s_movsbw = X86_MNEMONIC (MOVSBW);
+static const x86_mnemonic s_movsbl = X86_MNEMONIC (MOVSBL);
+static const x86_mnemonic s_movswl = X86_MNEMONIC (MOVSWL);
+static const x86_mnemonic s_call = X86_MNEMONIC (CALL);
+static const x86_mnemonic s_callq = X86_MNEMONIC (CALLQ);
+static const x86_mnemonic s_jmp = X86_MNEMONIC (JMP);
+static const x86_mnemonic s_jmpq = X86_MNEMONIC (JMPQ);
+static const x86_mnemonic s_jmpw = X86_MNEMONIC (JMPW);
+static const x86_mnemonic s_ret = X86_MNEMONIC (RET);
+static const x86_mnemonic s_retq = X86_MNEMONIC (RETQ);
+static const x86_mnemonic s_retw = X86_MNEMONIC (RETW);
+static const x86_mnemonic s_leave = X86_MNEMONIC (LEAVE);
+static const x86_mnemonic s_leaveq = X86_MNEMONIC (LEAVEQ);
+static const x86_mnemonic s_leavew = X86_MNEMONIC (LEAVEW);
+
+/* Register names indexed by their encoding (REX extension included) */
+static const char *s_registers64[16] = {
+  "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+  "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+
+static const char *s_registers32[16] = {
+  "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+  "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+};
+
+static const char *s_registers16[16] = {
+  "ax", "cx", "dx", "bx", "sp", "bp", "si", "di",
+  "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w", "r15w"
+};
+
+static const char *s_registers8[8] = {
+  "al", "cl", "dl", "bl", "ah", "ch", "dh", "bh"
+};
+
+static const char *s_registers8_rex[16] = {
+  "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+  "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"
+};
+
+#define REX_B 0x1
+#define REX_X 0x2
+#define REX_R 0x4
+#define REX_W 0x8
+#define REX   0x40
+
+/* Operand of an instruction, as libopcodes prints it */
+struct x86_operand
+{
+  enum { REGISTER, IMMEDIATE, MEMORY, TARGET } type;
+  bool indirect;          /* '*' operand of calls and jumps */
+  const char *reg;        /* REGISTER */
+  const char *base;       /* MEMORY: base and index registers or NULL */
+  const char *index;
+  int scale;
+  bool has_disp;          /* MEMORY: the displacement is printed ... */
+  bool absolute;          /* ... as an address instead of an offset */
+  constant_t value;       /* immediate, displacement or target address */
+};
+
+struct x86_instruction
+{
+  const x86_mnemonic *mnemonic;
+  int nb_operands;
+  x86_operand operands[3]; /* AT&T order: sources first */
+};
+
+/* State of the decoding of an instruction */
+struct x86_decoding
+{
+  const string &bytes;
+  size_t pos;
+  address_t start;
+  bool mode64;
+  bool opsize16;          /* 66 prefix */
+  bool addr32;            /* 67 prefix, in 64 bits mode only */
+  int rex;                /* REX prefix or 0 */
+  /* libopcodes prints the prefixes that the instruction does not use;
+   * such encodings are left to it. */
+  bool used_opsize;
+  bool used_addr;
+  int used_rex;
+  x86_instruction *instr;
+
+  x86_decoding (const string &b, address_t s, bool m64, x86_instruction *i)
+    : bytes (b), pos (0), start (s), mode64 (m64), opsize16 (false),
+      addr32 (false), rex (0), used_opsize (false), used_addr (false),
+      used_rex (0), instr (i) { }
+};
+
+/* Reads a little-endian value of 'size' bytes, sign-extended */
+static bool
+s_fetch (x86_decoding &d, int size, constant_t &value)
+{
+  uword_t v = 0;
+
+  if (d.pos + size > d.bytes.size ())
+    return false;
+  for (int i = size - 1; i >= 0; i--)
+    v = (v << 8) | (uint8_t) d.bytes[d.pos + i];
+  d.pos += size;
+  if (size < 8 && (v & ((uword_t) 1 << (8 * size - 1))))
+    v |= ~(uword_t) 0 << (8 * size);
+  value = (constant_t) v;
+
+  return true;
+}
+
+static bool
+s_fetch_byte (x86_decoding &d, int &byte)
+{
+  if (d.pos >= d.bytes.size ())
+    return false;
+  byte = (uint8_t) d.bytes[d.pos++];
+
+  return true;
+}
+
+static constant_t
+s_truncate (constant_t value, int size)
+{
+  if (size >= 64)
+    return value;
+  return (constant_t) ((uword_t) value & (((uword_t) 1 << size) - 1));
+}
+
+/* Size of the operands of instructions that depend on prefixes */
+static int
+s_operand_size (x86_decoding &d)
+{
+  d.used_opsize = true;
+  if (d.rex & REX_W)
+    {
+      d.used_rex |= REX_W;
+      return 64;
+    }
+
+  return d.opsize16 ? 16 : 32;
+}
+
+/* Size of the operand of stack instructions (push, pop, call...) */
+static int
+s_stack_size (x86_decoding &d)
+{
+  d.used_opsize = true;
+  if (d.opsize16)
+    return 16;
+
+  return d.mode64 ? 64 : 32;
+}
+
+static const char *
+s_register_name (x86_decoding &d, int size, int num)
+{
+  switch (size)
+    {
+    case 8:
+      if (d.rex)
+	{
+	  d.used_rex |= REX;
+	  return s_registers8_rex[num];
+	}
+      return num < 8 ? s_registers8[num] : NULL;
+    case 16: return s_registers16[num];
+    case 32: return s_registers32[num];
+    default: return s_registers64[num];
+    }
+}
+
+static void
+s_add_operand (x86_decoding &d, const x86_operand &op)
+{
+  d.instr->operands[d.instr->nb_operands++] = op;
+}
+
+static x86_operand
+s_register (x86_decoding &d, int size, int num)
+{
+  x86_operand op = x86_operand ();
+
+  op.type = x86_operand::REGISTER;
+  op.reg = s_register_name (d, size, num);
+
+  return op;
+}
+
+static x86_operand
+s_immediate (constant_t value)
+{
+  x86_operand op = x86_operand ();
+
+  op.type = x86_operand::IMMEDIATE;
+  op.value = value;
+
+  return op;
+}
+
+/* Reads an immediate of 'nb_bytes' bytes, sign-extended and then
+ * truncated to 'size' bits as libopcodes prints it */
+static bool
+s_fetch_immediate (x86_decoding &d, int nb_bytes, int size, x86_operand &op)
+{
+  constant_t v;
+
+  if (! s_fetch (d, nb_bytes, v))
+    return false;
+  op = s_immediate (s_truncate (v, size));
+
+  return true;
+}
+
+/* Reads a relative displacement of 'nb_bytes' bytes; it has to be the
+ * last field of the instruction. */
+static bool
+s_fetch_target (x86_decoding &d, int nb_bytes, x86_operand &op)
+{
+  constant_t rel;
+
+  if (! s_fetch (d, nb_bytes, rel))
+    return false;
+
+  op = x86_operand ();
+  op.type = x86_operand::TARGET;
+  op.value = (constant_t) ((uword_t) d.start + d.pos + rel);
+  if (! d.mode64)
+    op.value = s_truncate (op.value, 32);
+
+  return true;
+}
+
+/* Decodes the ModRM byte and, if needed, the SIB byte and the
+ * displacement. 'rm' receives the register or memory operand of 'size'
+ * bits and 'reg' the register number of the middle field. */
+static bool
+s_modrm (x86_decoding &d, int size, x86_operand &rm, int &reg)
+{
+  int modrm;
+
+  if (! s_fetch_byte (d, modrm))
+    return false;
+
+  int mod = modrm >> 6;
+  reg = (modrm >> 3) & 0x7;
+  if (d.rex & REX_R)
+    reg |= 0x8;
+  int num = modrm & 0x7;
+
+  if (mod == 3)
+    {
+      if (d.rex & REX_B)
+	num |= 0x8;
+      d.used_rex |= d.rex & REX_B;
+      rm = s_register (d, size, num);
+
+      return rm.reg != NULL;
+    }
+
+  const char **addr_regs =
+    (d.mode64 && ! d.addr32) ? s_registers64 : s_registers32;
+  bool has_base = true;
+  constant_t disp = 0;
+
+  rm = x86_operand ();
+  rm.type = x86_operand::MEMORY;
+  d.used_addr = true;
+
+  if (num == 4)
+    {
+      int sib;
+
+      if (! s_fetch_byte (d, sib))
+	return false;
+
+      int scale = sib >> 6;
+      int index = (sib >> 3) & 0x7;
+      int base = sib & 0x7;
+
+      if (d.rex & REX_X)
+	index |= 0x8;
+      d.used_rex |= d.rex & REX_X;
+
+      if (index != 4)
+	{
+	  rm.index = addr_regs[index];
+	  rm.scale = 1 << scale;
+	}
+      /* libopcodes prints %eiz (or %riz) there */
+      else if (scale != 0 || base != 4)
+	{
+	  if (! (d.mode64 && base == 5 && mod == 0 && scale == 0))
+	    return false;
+	}
+
+      if (base == 5 && mod == 0)
+	{
+	  has_base = false;
+	  if (! s_fetch (d, 4, disp))
+	    return false;
+	}
+      else
+	{
+	  if (d.rex & REX_B)
+	    base |= 0x8;
+	  d.used_rex |= d.rex & REX_B;
+	  rm.base = addr_regs[base];
+	}
+    }
+  else if (num == 5 && mod == 0)
+    {
+      /* %rip-relative addressing is left to libopcodes */
+      if (d.mode64)
+	return false;
+      has_base = false;
+      if (! s_fetch (d, 4, disp))
+	return false;
+    }
+  else
+    {
+      if (d.rex & REX_B)
+	num |= 0x8;
+      d.used_rex |= d.rex & REX_B;
+      rm.base = addr_regs[num];
+    }
+
+  if (mod == 1 && ! s_fetch (d, 1, disp))
+    return false;
+  if (mod == 2 && ! s_fetch (d, 4, disp))
+    return false;
+
+  rm.has_disp = (mod != 0 || ! has_base);
+  rm.absolute = (rm.base == NULL && rm.index == NULL);
+  if (rm.absolute)
+    {
+      if (d.addr32)
+	return false;
+      rm.value = d.mode64 ? disp : s_truncate (disp, 32);
+    }
+  else
+    {
+      rm.value = disp;
+    }
+
+  return true;
+}
+
+/* Register operand designated by the middle field of the ModRM byte */
+static x86_operand
+s_modrm_register (x86_decoding &d, int size, int reg)
+{
+  d.used_rex |= d.rex & REX_R;
+
+  return s_register (d, size, reg);
+}
+
+/* Ends the decoding of an instruction whose operands are (rm, reg) in
+ * AT&T order, or (reg, rm) if 'reversed'. */
+static bool
+s_rm_reg (x86_decoding &d, int size, bool reversed)
+{
+  x86_operand rm;
+  int reg;
+
+  if (! s_modrm (d, size, rm, reg))
+    return false;
+
+  x86_operand r = s_modrm_register (d, size, reg);
+  if (r.reg == NULL)
+    return false;
+  s_add_operand (d, reversed ? r : rm);
+  s_add_operand (d, reversed ? rm : r);
+
+  return true;
+}
+
+/* Chooses the plain mnemonic if the size of the operands is given by
+ * a register, or its variant suffixed by 'size' otherwise */
+static const x86_mnemonic *
+s_sized (const x86_sized_mnemonic &m, int size, bool has_register)
+{
+  if (has_register)
+    return &m.plain;
+
+  switch (size)
+    {
+    case 8: return &m.b;
+    case 16: return &m.w;
+    case 32: return &m.l;
+    default: return &m.q;
+    }
+}
+
+static bool
+s_has_register (const x86_decoding &d)
+{
+  for (int i = 0; i < d.instr->nb_operands; i++)
+    if (d.instr->operands[i].type == x86_operand::REGISTER &&
+	! d.instr->operands[i].indirect)
+      return true;
+
+  return false;
+}
+
+/* Decodes the instructions with a two bytes opcode (0f xx) */
+static bool
+s_decode_0f (x86_decoding &d)
+{
+  x86_instruction *instr = d.instr;
+  x86_operand rm;
+  int opcode;
+  int size;
+  int reg;
+
+  if (! s_fetch_byte (d, opcode))
+    return false;
+
+  switch (opcode)
+    {
+    case 0x1f:   /* nop Ev */
+      size = s_operand_size (d);
+      if (! s_modrm (d, size, rm, reg) || reg != 0 ||
+	  rm.type != x86_operand::MEMORY)
+	return false;
+      s_add_operand (d, rm);
+      instr->mnemonic = s_sized (s_nop, size, false);
+      return true;
+
+    case 0x40: case 0x41: case 0x42: case 0x43:
+    case 0x44: case 0x45: case 0x46: case 0x47:
+    case 0x48: case 0x49: case 0x4a: case 0x4b:
+    case 0x4c: case 0x4d: case 0x4e: case 0x4f:   /* cmovcc Gv,Ev */
+      instr->mnemonic = &s_cmovcc[opcode & 0xf];
+      return s_rm_reg (d, s_operand_size (d), false);
+
+    case 0x80: case 0x81: case 0x82: case 0x83:
+    case 0x84: case 0x85: case 0x86: case 0x87:
+    case 0x88: case 0x89: case 0x8a: case 0x8b:
+    case 0x8c: case 0x8d: case 0x8e: case 0x8f:   /* jcc Jz */
+      if (d.opsize16)
+	return false;
+      instr->mnemonic = &s_jcc[opcode & 0xf];
+      if (! s_fetch_target (d, 4, rm))
+	return false;
+      s_add_operand (d, rm);
+      return true;
+
+    case 0x90: case 0x91: case 0x92: case 0x93:
+    case 0x94: case 0x95: case 0x96: case 0x97:
+    case 0x98: case 0x99: case 0x9a: case 0x9b:
+    case 0x9c: case 0x9d: case 0x9e: case 0x9f:   /* setcc Eb */
+      instr->mnemonic = &s_setcc[opcode & 0xf];
+      if (! s_modrm (d, 8, rm, reg))
+	return false;
+      s_add_operand (d, rm);
+      return true;
+
+    case 0xaf:   /* imul Gv,Ev */
+      instr->mnemonic = &s_imul;
+      return s_rm_reg (d, s_operand_size (d), false);
+
+    case 0xb6: case 0xb7: case 0xbe: case 0xbf:   /* movz/movs Gv,Eb/Ew */
+      {
+	bool byte_src = (opcode & 1) == 0;
+	bool sign = opcode >= 0xbe;
+
+	size = s_operand_size (d);
+	if (size == 64 || (! byte_src && size != 32))
+	  return false;
+	if (byte_src)
+	  instr->mnemonic = (size == 16) ? (sign ? &s_movsbw : &s_movzbw)
+	    : (sign ? &s_movsbl : &s_movzbl);
+	else
+	  instr->mnemonic = sign ? &s_movswl : &s_movzwl;
+
+	if (! s_modrm (d, byte_src ? 8 : 16, rm, reg))
+	  return false;
+	x86_operand r = s_modrm_register (d, size, reg);
+	s_add_operand (d, rm);
+	s_add_operand (d, r);
+	return true;
+      }
+
+    default:
+      return false;
+    }
+}
+
+/* Decodes the opcode and the operands of the instruction */
+static bool
+s_decode_opcode (x86_decoding &d, int opcode)
+{
+  x86_instruction *instr = d.instr;
+  x86_operand rm, imm;
+  int size;
+  int reg;
+
+  /* add, or, adc, sbb, and, sub, xor, cmp */
+  if (opcode < 0x40 && (opcode & 0x7) < 6)
+    {
+      const x86_sized_mnemonic &m = s_arithmetic[opcode >> 3];
+
+      switch (opcode & 0x7)
+	{
+	case 0: size = 8; if (! s_rm_reg (d, 8, true)) return false; break;
+	case 1:
+	  size = s_operand_size (d);
+	  if (! s_rm_reg (d, size, true))
+	    return false;
+	  break;
+	case 2: size = 8; if (! s_rm_reg (d, 8, false)) return false; break;
+	case 3:
+	  size = s_operand_size (d);
+	  if (! s_rm_reg (d, size, false))
+	    return false;
+	  break;
+	case 4:
+	  size = 8;
+	  if (! s_fetch_immediate (d, 1, 8, imm))
+	    return false;
+	  s_add_operand (d, imm);
+	  s_add_operand (d, s_register (d, 8, 0));
+	  break;
+	default:
+	  size = s_operand_size (d);
+	  if (! s_fetch_immediate (d, size == 16 ? 2 : 4, size, imm))
+	    return false;
+	  s_add_operand (d, imm);
+	  s_add_operand (d, s_register (d, size, 0));
+	  break;
+	}
+      instr->mnemonic = s_sized (m, size, s_has_register (d));
+      return true;
+    }
+
+  switch (opcode)
+    {
+    case 0x0f:
+      return s_decode_0f (d);
+
+    case 0x40: case 0x41: case 0x42: case 0x43:
+    case 0x44: case 0x45: case 0x46: case 0x47:   /* inc Zv */
+    case 0x48: case 0x49: case 0x4a: case 0x4b:
+    case 0x4c: case 0x4d: case 0x4e: case 0x4f:   /* dec Zv */
+      /* These are REX prefixes in 64 bits mode */
+      if (d.mode64)
+	return false;
+      instr->mnemonic = (opcode < 0x48) ? &s_inc.plain : &s_dec.plain;
+      s_add_operand (d, s_register (d, s_operand_size (d), opcode & 0x7));
+      return true;
+
+    case 0x50: case 0x51: case 0x52: case 0x53:
+    case 0x54: case 0x55: case 0x56: case 0x57:   /* push Zv */
+    case 0x58: case 0x59: case 0x5a: case 0x5b:
+    case 0x5c: case 0x5d: case 0x5e: case 0x5f:   /* pop Zv */
+      instr->mnemonic = (opcode < 0x58) ? &s_push.plain : &s_pop.plain;
+      d.used_rex |= d.rex & REX_B;
+      s_add_operand (d, s_register (d, s_stack_size (d),
+				   (opcode & 0x7) | ((d.rex & REX_B) << 3)));
+      return true;
+
+    case 0x63:   /* movslq Ed,Gq */
+      if (! d.mode64 || ! (d.rex & REX_W))
+	return false;
+      d.used_rex |= REX_W;
+      if (! s_modrm (d, 32, rm, reg))
+	return false;
+      instr->mnemonic = &s_movslq;
+      s_add_operand (d, rm);
+      s_add_operand (d, s_modrm_register (d, 64, reg));
+      return true;
+
+    case 0x68:   /* push Iz */
+    case 0x6a:   /* push Ib */
+      size = s_stack_size (d);
+      if (! s_fetch_immediate (d, opcode == 0x6a ? 1 : (size == 16 ? 2 : 4),
+			       size, imm))
+	return false;
+      /* Not sure how libopcodes prints these */
+      if (size == 64 && imm.value < 0)
+	return false;
+      s_add_operand (d, imm);
+      instr->mnemonic = (size == 16) ? &s_push.w :
+	(size == 64) ? &s_push.q : &s_push.plain;
+      return true;
+
+    case 0x69:   /* imul Iz,Ev,Gv */
+    case 0x6b:   /* imul Ib,Ev,Gv */
+      {
+	size = s_operand_size (d);
+	if (! s_modrm (d, size, rm, reg))
+	  return false;
+	x86_operand r = s_modrm_register (d, size, reg);
+	if (! s_fetch_immediate (d, opcode == 0x6b ? 1 : (size == 16 ? 2 : 4),
+				 size, imm))
+	  return false;
+	instr->mnemonic = &s_imul;
+	s_add_operand (d, imm);
+	s_add_operand (d, rm);
+	s_add_operand (d, r);
+	return true;
+      }
+
+    case 0x70: case 0x71: case 0x72: case 0x73:
+    case 0x74: case 0x75: case 0x76: case 0x77:
+    case 0x78: case 0x79: case 0x7a: case 0x7b:
+    case 0x7c: case 0x7d: case 0x7e: case 0x7f:   /* jcc Jb */
+      if (d.opsize16)
+	return false;
+      instr->mnemonic = &s_jcc[opcode & 0xf];
+      if (! s_fetch_target (d, 1, imm))
+	return false;
+      s_add_operand (d, imm);
+      return true;
+
+    case 0x80:   /* group 1 Eb,Ib */
+    case 0x81:   /* group 1 Ev,Iz */
+    case 0x83:   /* group 1 Ev,Ib */
+      size = (opcode == 0x80) ? 8 : s_operand_size (d);
+      if (! s_modrm (d, size, rm, reg))
+	return false;
+      if (! s_fetch_immediate (d, opcode == 0x81 ? (size == 16 ? 2 : 4) : 1,
+			       size, imm))
+	return false;
+      s_add_operand (d, imm);
+      s_add_operand (d, rm);
+      instr->mnemonic = s_sized (s_arithmetic[reg & 0x7], size, s_has_register (d));
+      return true;
+
+    case 0x84: case 0x85:   /* test Gv,Ev */
+      size = (opcode == 0x84) ? 8 : s_operand_size (d);
+      instr->mnemonic = &s_test.plain;
+      return s_rm_reg (d, size, true);
+
+    case 0x86: case 0x87:   /* xchg Gv,Ev */
+      size = (opcode == 0x86) ? 8 : s_operand_size (d);
+      instr->mnemonic = &s_xchg;
+      return s_rm_reg (d, size, true);
+
+    case 0x88: case 0x89:   /* mov Gv,Ev */
+      size = (opcode == 0x88) ? 8 : s_operand_size (d);
+      instr->mnemonic = &s_mov.plain;
+      return s_rm_reg (d, size, true);
+
+    case 0x8a: case 0x8b:   /* mov Ev,Gv */
+      size = (opcode == 0x8a) ? 8 : s_operand_size (d);
+      instr->mnemonic = &s_mov.plain;
+      return s_rm_reg (d, size, false);
+
+    case 0x8d:   /* lea M,Gv */
+      size = s_operand_size (d);
+      instr->mnemonic = &s_lea;
+      return (s_rm_reg (d, size, false) &&
+	      instr->operands[0].type == x86_operand::MEMORY);
+
+    case 0x8f:   /* pop Ev */
+      size = s_stack_size (d);
+      if (! s_modrm (d, size, rm, reg) || reg != 0)
+	return false;
+      s_add_operand (d, rm);
+      instr->mnemonic = s_sized (s_pop, size, s_has_register (d));
+      return true;
+
+    case 0x90:   /* nop */
+      if (d.rex || d.opsize16)
+	return false;
+      instr->mnemonic = &s_nop.plain;
+      return true;
+
+    case 0x91: case 0x92: case 0x93:
+    case 0x94: case 0x95: case 0x96: case 0x97:   /* xchg eAX,Zv */
+      size = s_operand_size (d);
+      d.used_rex |= d.rex & REX_B;
+      instr->mnemonic = &s_xchg;
+      s_add_operand (d, s_register (d, size, 0));
+      s_add_operand (d, s_register (d, size, (opcode & 0x7) |
+				   ((d.rex & REX_B) << 3)));
+      return true;
+
+    case 0xb0: case 0xb1: case 0xb2: case 0xb3:
+    case 0xb4: case 0xb5: case 0xb6: case 0xb7:   /* mov Ib,Zb */
+      d.used_rex |= d.rex & REX_B;
+      if (! s_fetch_immediate (d, 1, 8, imm))
+	return false;
+      instr->mnemonic = &s_mov.plain;
+      s_add_operand (d, imm);
+      s_add_operand (d, s_register (d, 8, (opcode & 0x7) |
+				   ((d.rex & REX_B) << 3)));
+      return d.instr->operands[1].reg != NULL;
+
+    case 0xb8: case 0xb9: case 0xba: case 0xbb:
+    case 0xbc: case 0xbd: case 0xbe: case 0xbf:   /* mov Iv,Zv */
+      size = s_operand_size (d);
+      d.used_rex |= d.rex & REX_B;
+      if (! s_fetch_immediate (d, size / 8, size, imm))
+	return false;
+      instr->mnemonic = (size == 64) ? &s_movabs : &s_mov.plain;
+      s_add_operand (d, imm);
+      s_add_operand (d, s_register (d, size, (opcode & 0x7) |
+				   ((d.rex & REX_B) << 3)));
+      return true;
+
+    case 0xc0: case 0xc1:   /* group 2 Ib,Ev */
+    case 0xd0: case 0xd1:   /* group 2 Ev (by 1) */
+    case 0xd2: case 0xd3:   /* group 2 %cl,Ev */
+      size = (opcode & 1) ? s_operand_size (d) : 8;
+      if (! s_modrm (d, size, rm, reg))
+	return false;
+      if (opcode <= 0xc1)
+	{
+	  if (! s_fetch_immediate (d, 1, 8, imm))
+	    return false;
+	  s_add_operand (d, imm);
+	}
+      else if (opcode >= 0xd2)
+	{
+	  s_add_operand (d, s_register (d, 8, 1));
+	}
+      s_add_operand (d, rm);
+      /* %cl does not give the size of the operand */
+      instr->mnemonic = s_sized (s_shifts[reg & 0x7], size,
+				 rm.type == x86_operand::REGISTER);
+      return true;
+
+    case 0xc2:   /* ret Iw */
+    case 0xc3:   /* ret */
+      size = s_stack_size (d);
+      instr->mnemonic = (size == 16) ? &s_retw :
+	(size == 64) ? &s_retq : &s_ret;
+      if (opcode == 0xc2)
+	{
+	  if (! s_fetch_immediate (d, 2, 16, imm))
+	    return false;
+	  s_add_operand (d, imm);
+	}
+      return true;
+
+    case 0xc6:   /* mov Ib,Eb */
+    case 0xc7:   /* mov Iz,Ev */
+      size = (opcode == 0xc6) ? 8 : s_operand_size (d);
+      if (! s_modrm (d, size, rm, reg) || reg != 0)
+	return false;
+      if (! s_fetch_immediate (d, size == 8 ? 1 : (size == 16 ? 2 : 4),
+			       size, imm))
+	return false;
+      s_add_operand (d, imm);
+      s_add_operand (d, rm);
+      instr->mnemonic = s_sized (s_mov, size, s_has_register (d));
+      return true;
+
+    case 0xc9:   /* leave */
+      size = s_stack_size (d);
+      instr->mnemonic = (size == 16) ? &s_leavew :
+	(size == 64) ? &s_leaveq : &s_leave;
+      return true;
+
+    case 0xe8:   /* call Jz */
+    case 0xe9:   /* jmp Jz */
+      if (d.opsize16)
+	return false;
+      if (! s_fetch_target (d, 4, imm))
+	return false;
+      s_add_operand (d, imm);
+      if (opcode == 0xe8)
+	instr->mnemonic = d.mode64 ? &s_callq : &s_call;
+      else
+	instr->mnemonic = d.mode64 ? &s_jmpq : &s_jmp;
+      return true;
+
+    case 0xeb:   /* jmp Jb */
+      if (d.opsize16)
+	return false;
+      if (! s_fetch_target (d, 1, imm))
+	return false;
+      s_add_operand (d, imm);
+      instr->mnemonic = &s_jmp;
+      return true;
+
+    case 0xf4:
+      instr->mnemonic = &s_hlt;
+      return true;
+
+    case 0xf5:
+      instr->mnemonic = &s_cmc;
+      return true;
+
+    case 0xf6:   /* group 3 Eb */
+    case 0xf7:   /* group 3 Ev */
+      size = (opcode == 0xf6) ? 8 : s_operand_size (d);
+      if (! s_modrm (d, size, rm, reg))
+	return false;
+      if ((reg & 0x7) == 0)
+	{
+	  if (! s_fetch_immediate (d, size == 8 ? 1 : (size == 16 ? 2 : 4),
+				   size, imm))
+	    return false;
+	  s_add_operand (d, imm);
+	}
+      s_add_operand (d, rm);
+      instr->mnemonic = s_sized (s_unary[reg & 0x7], size, s_has_register (d));
+      return true;
+
+    case 0xf8: case 0xf9: case 0xfa:
+    case 0xfb: case 0xfc: case 0xfd:
+      instr->mnemonic = &s_flags[opcode - 0xf8];
+      return true;
+
+    case 0xfe:   /* inc/dec Eb */
+      if (! s_modrm (d, 8, rm, reg) || (reg & 0x7) > 1)
+	return false;
+      s_add_operand (d, rm);
+      instr->mnemonic = s_sized ((reg & 0x7) ? s_dec : s_inc, 8, s_has_register (d));
+      return true;
+
+    case 0xff:
+      {
+	int modrm;
+
+	if (! s_fetch_byte (d, modrm))
+	  return false;
+	d.pos--;
+	switch ((modrm >> 3) & 0x7)
+	  {
+	  case 0: case 1:   /* inc/dec Ev */
+	    size = s_operand_size (d);
+	    if (! s_modrm (d, size, rm, reg))
+	      return false;
+	    s_add_operand (d, rm);
+	    instr->mnemonic = s_sized ((reg & 0x7) ? s_dec : s_inc, size,
+					 s_has_register (d));
+	    return true;
+
+	  case 2:   /* call *Ev */
+	  case 4:   /* jmp *Ev */
+	    size = s_stack_size (d);
+	    if (size == 16 && ((modrm >> 3) & 0x7) == 2)
+	      return false;
+	    if (! s_modrm (d, size, rm, reg))
+	      return false;
+	    rm.indirect = true;
+	    s_add_operand (d, rm);
+	    if (((modrm >> 3) & 0x7) == 2)
+	      instr->mnemonic = d.mode64 ? &s_callq : &s_call;
+	    else
+	      instr->mnemonic = (size == 16) ? &s_jmpw :
+		d.mode64 ? &s_jmpq : &s_jmp;
+	    return true;
+
+	  case 6:   /* push Ev */
+	    size = s_stack_size (d);
+	    if (! s_modrm (d, size, rm, reg))
+	      return false;
+	    s_add_operand (d, rm);
+	    instr->mnemonic = s_sized (s_push, size, s_has_register (d));
+	    return true;
+
+	  default:
+	    return false;
+	  }
+      }
+
+    default:
+      return false;
+    }
+}
+
+/* Decodes the prefixes and the instruction at the beginning of the
+ * bytes. Returns the size of the instruction or 0. */
+static int
+s_decode (x86_decoding &d)
+{
+  int byte;
+
+  d.instr->mnemonic = NULL;
+  d.instr->nb_operands = 0;
+
+  for (;;)
+    {
+      if (! s_fetch_byte (d, byte))
+	return 0;
+
+      if (byte == 0x66 && ! d.opsize16)
+	d.opsize16 = true;
+      else if (byte == 0x67 && d.mode64 && ! d.addr32)
+	d.addr32 = true;
+      else
+	break;
+    }
+
+  if (d.mode64 && (byte & 0xf0) == 0x40)
+    {
+      d.rex = byte;
+      if (! s_fetch_byte (d, byte))
+	return 0;
+    }
+
+  /* Other prefixes (segments, lock, rep...) are left to libopcodes */
+  if (! s_decode_opcode (d, byte) || d.instr->mnemonic == NULL ||
+      d.instr->mnemonic->name == NULL)
+    return 0;
+
+  for (int i = 0; i < d.instr->nb_operands; i++)
+    if (d.instr->operands[i].type == x86_operand::REGISTER &&
+	d.instr->operands[i].reg == NULL)
+      return 0;
+
+  if ((d.opsize16 && ! d.used_opsize) || (d.addr32 && ! d.used_addr) ||
+      (d.rex & ~d.used_rex & (REX_W | REX_R | REX_X | REX_B)) ||
+      (d.rex == REX && ! (d.used_rex & REX)))
+    return 0;
+
+  return d.pos;
+}
+
+static void
+s_output_hex (string &text, uword_t value)
+{
+  char buf[24];
+
+  snprintf (buf, sizeof (buf), "0x%llx", (unsigned long long) value);
+  text += buf;
+}
+
+static void
+s_output_operand (string &text, const x86_operand &op)
+{
+  if (op.indirect)
+    text += '*';
+
+  switch (op.type)
+    {
+    case x86_operand::REGISTER:
+      text += '%';
+      text += op.reg;
+      break;
+
+    case x86_operand::IMMEDIATE:
+      text += '$';
+      s_output_hex (text, op.value);
+      break;
+
+    case x86_operand::TARGET:
+      s_output_hex (text, op.value);
+      break;
+
+    case x86_operand::MEMORY:
+      if (op.has_disp)
+	{
+	  if (op.absolute || op.value >= 0)
+	    s_output_hex (text, op.value);
+	  else
+	    {
+	      text += '-';
+	      s_output_hex (text, - (uword_t) op.value);
+	    }
+	}
+      if (op.base != NULL || op.index != NULL)
+	{
+	  text += '(';
+	  if (op.base != NULL)
+	    {
+	      text += '%';
+	      text += op.base;
+	    }
+	  if (op.index != NULL)
+	    {
+	      text += ",%";
+	      text += op.index;
+	      text += ',';
+	      text += (char) ('0' + op.scale);
+	    }
+	  text += ')';
+	}
+      break;
+    }
+}
+
+/* Prints the instruction like libopcodes does */
+static void
+s_output_instruction (string &text, const x86_instruction &instr)
+{
+  const char *name = instr.mnemonic->name;
+  size_t len;
+
+  for (len = 0; name[len]; len++)
+    text += (char) tolower (name[len]);
+
+  if (instr.nb_operands == 0 && instr.mnemonic == &s_nop.plain)
+    return;
+
+  for (; len < 6; len++)
+    text += ' ';
+  text += ' ';
+
+  for (int i = 0; i < instr.nb_operands; i++)
+    {
+      if (i > 0)
+	text += ',';
+      s_output_operand (text, instr.operands[i]);
+    }
+}
+
+/* Builds the expression the parser gets from the text of 'op' */
+static Expr *
+s_build_operand (x86::parser_data &data, const x86_operand &op)
+{
+  int word_size = data.arch->get_word_size ();
+  Expr *result = NULL;
+
+  switch (op.type)
+    {
+    case x86_operand::REGISTER:
+      result = data.get_register (op.reg);
+      break;
+
+    case x86_operand::IMMEDIATE:
+      result = Constant::create (op.value, 0, word_size);
+      break;
+
+    case x86_operand::TARGET:
+      result = data.get_memory_reference (NULL, op.value, NULL);
+      break;
+
+    case x86_operand::MEMORY:
+      {
+	Expr *bis = NULL;
+
+	if (op.base != NULL && (bis = data.get_register (op.base)) == NULL)
+	  return NULL;
+
+	if (op.index != NULL)
+	  {
+	    Expr *index = data.get_register (op.index);
+
+	    if (index == NULL)
+	      {
+		if (bis != NULL)
+		  bis->deref ();
+		return NULL;
+	      }
+	    index = BinaryApp::create (BV_OP_MUL_U, index, op.scale);
+	    if (bis != NULL)
+	      bis = BinaryApp::create (BV_OP_ADD, bis, index);
+	    else
+	      bis = index;
+	  }
+	result = data.get_memory_reference (NULL, op.has_disp ? op.value : 0,
+					    bis);
+      }
+      break;
+    }
+
+  if (result != NULL && op.indirect)
+    result = MemCell::create (result, 0, word_size);
+
+  return result;
+}
+
+int
+x86_direct_decoder_func (MicrocodeArchitecture *arch, Microcode *mc,
+			 const string &bytes, const ConcreteAddress &start,
+			 string *text)
+{
+  x86_instruction instr;
+  x86_decoding d (bytes, start.get_address (), arch->get_word_size () == 64,
+		  &instr);
+  int size = s_decode (d);
+
+  if (size == 0 || (mc == NULL && text == NULL))
+    return size;
+
+  string instruction;
+  s_output_instruction (instruction, instr);
+  if (text != NULL)
+    *text = instruction;
+  if (mc == NULL)
+    return size;
+
+  x86::parser_data data (arch, mc, instruction, start.get_address (),
+			 start.get_address () + size);
+  Expr *ops[3];
+
+  for (int i = 0; i < instr.nb_operands; i++)
+    {
+      ops[i] = s_build_operand (data, instr.operands[i]);
+      if (ops[i] == NULL)
+	{
+	  /* Unknown register: the parser would have failed as well */
+	  for (int j = 0; j < i; j++)
+	    ops[j]->deref ();
+	  return 0;
+	}
+    }
+
+  switch (instr.nb_operands)
+    {
+    case 0: instr.mnemonic->translate0 (data); break;
+    case 1: instr.mnemonic->translate1 (data, ops[0]); break;
+    case 2: instr.mnemonic->translate2 (data, ops[0], ops[1]); break;
+    default: instr.mnemonic->translate3 (data, ops[0], ops[1], ops[2]);
+    }
+
+  return size;
+}
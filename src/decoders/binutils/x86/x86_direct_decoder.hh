@@ -0,0 +1,56 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef X86_DIRECT_DECODER_HH
+#define X86_DIRECT_DECODER_HH
+
+#include <string>
+
+#include <domains/concrete/ConcreteAddress.hh>
+#include <kernel/Microcode.hh>
+#include <kernel/microcode/MicrocodeArchitecture.hh>
+
+/* Decoding function for x86-32 and x86-64 architectures working
+ * straight from the bytes of the instruction located at 'start'
+ * (without going through the disassembler and the parser).
+ *
+ * Returns the size of the instruction, or 0 if its encoding is not
+ * handled by the opcode tables; the caller then falls back on the
+ * disassembler. The translation is added to 'mc' unless it is NULL.
+ * If 'text' is not NULL, it receives the instruction in AT&T syntax,
+ * as printed by libopcodes; operands given to the translation
+ * functions are the ones the parser would build from this text. */
+int
+x86_direct_decoder_func (MicrocodeArchitecture *arch, Microcode *mc,
+			 const std::string &bytes,
+			 const ConcreteAddress &start,
+			 std::string *text);
+
+#endif /* X86_DIRECT_DECODER_HH */
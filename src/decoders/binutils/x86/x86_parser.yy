@@ -32,6 +32,7 @@
 #include <map>
 #include <string>
 #include <stack>
+#include <pthread.h>
 
 #include <kernel/Architecture.hh>
 #include <kernel/Microcode.hh>
@@ -43,6 +44,8 @@
  * shared by all the parsers. */
 namespace x86 {
   typedef std::vector<MicrocodeNode *> MicrocodeNodeVector;
+  struct arch_data;
+
   struct parser_data
   {
     typedef enum {
@@ -58,7 +61,6 @@ namespace x86 {
     parser_data (MicrocodeArchitecture *arch, Microcode *out,
 		 const std::string &inst, address_t start,
 		 address_t next);
-    ~parser_data();
 
     LValue *get_flag (const char *flagname) const;
     LValue *get_tmp_register (const char *id, int size) const;
@@ -81,9 +83,48 @@ namespace x86 {
     const char *code_segment;
     const char *stack_segment;
     MicrocodeArchitecture *arch;
-    Expr *condition_codes[NB_CC];
+    arch_data *shared;      /* Data shared by all instructions of 'arch' */
+    Expr **condition_codes; /* Points to shared->condition_codes */
+  };
+
+  /* Data computed once per MicrocodeArchitecture and shared by the
+   * translation of all its instructions. */
+  struct arch_data : public MicrocodeArchitecture::DecoderData
+  {
+    /* Actual register (never an alias) and window of a register name */
+    struct register_ref {
+      const RegisterDesc *reg;
+      int offset;
+      int size;
+    };
+    typedef std::unordered_map<std::string, register_ref> register_table;
+
+    arch_data (MicrocodeArchitecture *arch);
+    virtual ~arch_data ();
+
+    /* Returns the data attached to 'arch', building it if needed */
+    static arch_data *get (MicrocodeArchitecture *arch);
+
+    const register_ref &get_register (const char *regname);
+
+    /* Same as get_register; the temporary register is added to 'arch'
+     * if it does not exist yet */
+    const register_ref &get_tmp_register (const char *regname, int size);
+
+    MicrocodeArchitecture *arch;
+    Expr *condition_codes[parser_data::NB_CC];
     std::unordered_set<const RegisterDesc *,
 		       RegisterDesc::Hash> segment_registers;
+
+    /* Registers of the architecture. This table is not modified once
+     * built; instructions may then be translated by several threads. */
+    register_table registers;
+
+    /* Other registers (temporaries) are added on first use, under
+     * 'lock'. References to elements of an unordered_map remain valid
+     * when it grows. */
+    register_table other_registers;
+    pthread_mutex_t lock;
   };
 }
 }
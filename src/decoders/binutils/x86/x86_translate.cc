@@ -29,9 +29,10 @@
  */
 
 #include <cassert>
+#include <cstdio>
 #include <string>
-#include <sstream>
 #include <io/expressions/expr-parser.hh>
+#include <utils/MutexLock.hh>
 #include "x86_translate.hh"
 
 #define TMPREG(_i) ("tmpr" #_i)
@@ -41,17 +42,113 @@
 using namespace std;
 
 
+static x86::arch_data::register_ref
+s_register_ref (const MicrocodeArchitecture *arch, const char *regname)
+{
+  x86::arch_data::register_ref ref;
+  const RegisterDesc *rd = arch->get_register (regname);
+
+  ref.offset = rd->get_window_offset ();
+  ref.size = rd->get_window_size ();
+  if (rd->is_alias ())
+    rd = arch->get_register (rd->get_label ());
+  ref.reg = rd;
+
+  return ref;
+}
+
+x86::arch_data::arch_data (MicrocodeArchitecture *a)
+  : arch (a), segment_registers (), registers ()
+{
+#define X86_CC(id,f) \
+  condition_codes[parser_data::X86_CC_ ## id] = expr_parser (f, a);
+#include "x86_cc.def"
+#undef X86_CC
+  segment_registers.insert (a->get_register ("cs"));
+  segment_registers.insert (a->get_register ("ds"));
+  segment_registers.insert (a->get_register ("es"));
+  segment_registers.insert (a->get_register ("fs"));
+  segment_registers.insert (a->get_register ("gs"));
+  segment_registers.insert (a->get_register ("ss"));
+
+  const RegisterSpecs *specs = a->get_reference_arch ()->get_registers ();
+  for (RegisterSpecs::const_iterator i = specs->begin (); i != specs->end ();
+       i++)
+    registers[i->first] = s_register_ref (a, i->first.c_str ());
+  pthread_mutex_init (&lock, NULL);
+}
+
+x86::arch_data::~arch_data ()
+{
+  for (int i = 0; i < parser_data::NB_CC; i++)
+    condition_codes[i]->deref ();
+  pthread_mutex_destroy (&lock);
+}
+
+/* Serializes the creation of the data of an architecture */
+static pthread_mutex_t s_arch_data_lock = PTHREAD_MUTEX_INITIALIZER;
+
+x86::arch_data *
+x86::arch_data::get (MicrocodeArchitecture *arch)
+{
+  MutexLock L (&s_arch_data_lock);
+  arch_data *result = dynamic_cast<arch_data *> (arch->get_decoder_data ());
+
+  if (result == NULL)
+    {
+      result = new arch_data (arch);
+      arch->set_decoder_data (result);
+    }
+
+  return result;
+}
+
+const x86::arch_data::register_ref &
+x86::arch_data::get_register (const char *regname)
+{
+  register_table::const_iterator i = registers.find (regname);
+
+  if (i != registers.end ())
+    return i->second;
+
+  MutexLock L (&lock);
+  i = other_registers.find (regname);
+  if (i == other_registers.end ())
+    {
+      register_ref ref = s_register_ref (arch, regname);
+      i = other_registers.insert (std::make_pair (std::string (regname),
+						  ref)).first;
+    }
+
+  return i->second;
+}
+
+const x86::arch_data::register_ref &
+x86::arch_data::get_tmp_register (const char *regname, int size)
+{
+  {
+    MutexLock L (&lock);
+
+    if (other_registers.find (regname) == other_registers.end () &&
+	! arch->has_tmp_register (regname))
+      arch->add_tmp_register (regname, size);
+  }
+
+  return get_register (regname);
+}
+
 LValue *
 x86::parser_data::get_tmp_register (const char *id, int size) const
 {
-  ostringstream oss;
+  char regname[32];
+
   assert (id != NULL);
-  oss << id << "_" << size;
-  string regname = oss.str ();
-  if (! arch->has_tmp_register (regname))
-    arch->add_tmp_register (regname, size);
+  snprintf (regname, sizeof (regname), "%s_%d", id, size);
+
+  const arch_data::register_ref &ref =
+    shared->get_tmp_register (regname, size);
 
-  return get_register (regname.c_str ());
+  return RegisterExpr::create (ref.reg, ref.offset, ref.size);
 }
 
 LValue *
@@ -59,14 +156,9 @@ x86::parser_data::get_register (const char *regname) const
 {
   assert (regname != NULL);
 
-  const RegisterDesc *rd = arch->get_register (regname);
-  int offset = rd->get_window_offset ();
-  int size = rd->get_window_size ();
-
-  if (rd->is_alias ())
-    rd = arch->get_register (rd->get_label ());
+  const arch_data::register_ref &ref = shared->get_register (regname);
 
-  return RegisterExpr::create (rd, offset, size);
+  return RegisterExpr::create (ref.reg, ref.offset, ref.size);
 }
 
 LValue *
@@ -108,21 +200,8 @@ x86::parser_data::parser_data (MicrocodeArchitecture *a, Microcode *out,
   code_segment = "cs";
   stack_segment = "ss";
 
-#define X86_CC(id,f) \
-  condition_codes[X86_CC_ ## id] = expr_parser (f, a);
-#include "x86_cc.def"
-#undef X86_CC
-  segment_registers.insert (a->get_register ("cs"));
-  segment_registers.insert (a->get_register ("ds"));
-  segment_registers.insert (a->get_register ("es"));
-  segment_registers.insert (a->get_register ("fs"));
-  segment_registers.insert (a->get_register ("gs"));
-  segment_registers.insert (a->get_register ("ss"));
-}
-
-x86::parser_data::~parser_data() {
-  for (int i = 0; i < NB_CC; i++)
-    condition_codes[i]->deref ();
+  shared = arch_data::get (a);
+  condition_codes = shared->condition_codes;
 }
 
 bool
@@ -131,8 +210,8 @@ x86::parser_data::is_segment_register (const Expr *expr)
   const RegisterExpr *reg = dynamic_cast<const RegisterExpr *> (expr);
   assert (reg != NULL);
 
-  return
-    segment_registers.find (reg->get_descriptor ()) != segment_registers.end ();
+  return (shared->segment_registers.find (reg->get_descriptor ()) !=
+	  shared->segment_registers.end ());
 }
 
 Expr *
@@ -31,6 +31,7 @@
 #include "ConcreteMemory.hh"
 
 #include <cassert>
+#include <cstring>
 #include <inttypes.h>
 
 #include <iomanip>
@@ -45,25 +46,139 @@
 
 using namespace std;
 
+/*****************************************************************************/
+/* Pages                                                                     */
+/*****************************************************************************/
+
+static inline bool
+s_is_defined (const uint64_t *defined, address_t offset)
+{
+  return (defined[offset / 64] >> (offset % 64)) & 1;
+}
+
+/* Checks that the 'size' bytes from 'offset' are all defined. */
+static inline bool
+s_are_defined (const uint64_t *defined, address_t offset, int size)
+{
+  for (int i = 0; i < size; i++)
+    if (! s_is_defined (defined, offset + i))
+      return false;
+  return true;
+}
+
+static inline std::size_t
+s_cell_hash (address_t a, uint8_t byte)
+{
+  return hash_mix (hash_mix (a) + byte);
+}
+
+static inline std::size_t
+s_register_hash (const RegisterDesc *r, const ConcreteValue &v)
+{
+  return hash_mix (hash_mix ((uintptr_t) r) + v.get ());
+}
+
+void
+ConcreteMemory::release_page (Page *page)
+{
+  if (__sync_sub_and_fetch (&page->refcount, 1) != 0)
+    return;
+
+  if (page->file != NULL)
+    page->file->deref ();
+  else
+    delete[] page->bytes;
+  delete page;
+}
+
+const ConcreteMemory::Page *
+ConcreteMemory::find_page (address_t a) const
+{
+  PageTable::const_iterator i = pages.find (a >> PAGE_BITS);
+
+  if (i == pages.end ())
+    return NULL;
+  return i->second;
+}
+
+ConcreteMemory::Page *
+ConcreteMemory::get_writable_page (address_t a)
+{
+  address_t pageno = a >> PAGE_BITS;
+  PageTable::iterator i = pages.lower_bound (pageno);
+
+  if (i == pages.end () || i->first != pageno)
+    {
+      Page *page = new Page ();
+
+      page->refcount = 1;
+      page->nb_defined = 0;
+      page->file = NULL;
+      page->bytes = new uint8_t[PAGE_SIZE];
+      memset (page->defined, 0, sizeof (page->defined));
+      pages.insert (i, PageTable::value_type (pageno, page));
+
+      return page;
+    }
+
+  /* The page is shared with another memory or lies in a mapped file; it
+   * is duplicated before being modified. */
+  if (i->second->refcount > 1 || i->second->file != NULL)
+    {
+      Page *page = new Page (*i->second);
+
+      page->refcount = 1;
+      page->file = NULL;
+      page->bytes = new uint8_t[PAGE_SIZE];
+      memcpy (page->bytes, i->second->bytes, PAGE_SIZE);
+      release_page (i->second);
+      i->second = page;
+    }
+
+  return i->second;
+}
+
+uint8_t
+ConcreteMemory::get_byte (address_t a) const
+{
+  const Page *page = find_page (a);
+
+  if (page != NULL && s_is_defined (page->defined, a % PAGE_SIZE))
+    return page->bytes[a % PAGE_SIZE];
+
+  if (base == NULL || ! base->is_defined (ConcreteAddress (a)))
+    throw UndefinedValueException ("at address " +
+				   ConcreteAddress (a).to_string ());
+
+  return base->get_byte (a);
+}
+
 /*****************************************************************************/
 /* Constructors                                                              */
 /*****************************************************************************/
 
 ConcreteMemory::ConcreteMemory() :
   Memory<ConcreteAddress, ConcreteValue>(), RegisterMap<ConcreteValue>(),
-  base (NULL), memory (), minaddr (MAX_ADDRESS), maxaddr (NULL_ADDRESS)
+  base (NULL), pages (), nb_cells (0), cells_hash (0),
+  cells_hash_pending (false), regs_hash (0), minaddr (MAX_ADDRESS),
+  maxaddr (NULL_ADDRESS)
 {
 }
 
 ConcreteMemory::ConcreteMemory(const ConcreteMemory &m) :
   Memory<ConcreteAddress,ConcreteValue> (m), RegisterMap<ConcreteValue> (m),
-  base (m.base), memory (m.memory), minaddr (m.minaddr), maxaddr (m.maxaddr)
+  base (m.base), pages (m.pages), nb_cells (m.nb_cells),
+  cells_hash (m.cells_hash), cells_hash_pending (m.cells_hash_pending),
+  regs_hash (m.regs_hash), minaddr (m.minaddr), maxaddr (m.maxaddr)
 {
+  for (PageTable::iterator i = pages.begin (); i != pages.end (); i++)
+    __sync_fetch_and_add (&i->second->refcount, 1);
 }
 
 ConcreteMemory::ConcreteMemory(const ConcreteMemory *base) :
   Memory<ConcreteAddress,ConcreteValue> (), RegisterMap<ConcreteValue> (),
-  base (base)
+  base (base), pages (), nb_cells (0), cells_hash (0),
+  cells_hash_pending (false), regs_hash (0)
 {
   if (base)
     base->get_address_range (minaddr, maxaddr);
@@ -76,7 +191,9 @@ ConcreteMemory::ConcreteMemory(const ConcreteMemory *base) :
 
 ConcreteMemory::~ConcreteMemory()
 {
-  memory.clear ();
+  for (PageTable::iterator i = pages.begin (); i != pages.end (); i++)
+    release_page (i->second);
+  pages.clear ();
 }
 
 /*****************************************************************************/
@@ -91,25 +208,32 @@ ConcreteMemory::get(const ConcreteAddress &addr,
 {
   word_t res = 0;
   address_t a = addr.get_address();
+  address_t offset = a % PAGE_SIZE;
+  const Page *page = NULL;
+
+  /* Cells that lie in a single page are read with one lookup. */
+  if (offset + size <= PAGE_SIZE)
+    page = find_page (a);
+
+  if (page != NULL && s_are_defined (page->defined, offset, size))
+    {
+      const uint8_t *bytes = page->bytes + offset;
+
+      for (int i = 0; i < size; i++)
+	res = (res << 8) |
+	  (e == Architecture::LittleEndian ? bytes[size - i - 1] : bytes[i]);
+
+      return ConcreteValue (8 * size, res);
+    }
 
   for (int i = 0; i < size; i++)
     {
       address_t cur =
 	(e == Architecture::LittleEndian ? a + size - i - 1 : a + i);
-      word_t byte;
 
       if (!is_defined (ConcreteAddress (cur)))
 	throw UndefinedValueException("at address " + addr.to_string ());
-      MemoryMap::const_iterator ci = memory.find (cur);
-      if (ci != memory.end ())
-	byte = ci->second;
-      else
-	{
-	  assert (base->is_defined (addr));
-	  byte = base->get (addr, 1, e).get ();
-	}
-
-      res = (res << 8) | byte;
+      res = (res << 8) | get_byte (cur);
     }
 
   return ConcreteValue (8 * size, res);
@@ -129,12 +253,22 @@ ConcreteMemory::put(const ConcreteAddress &addr,
 
   size /= 8;
 
+  Page *page = NULL;
+  address_t pageno = 0;
+
   for (int i = 0; i < size; i++)
     {
       address_t cur =
 	(e == Architecture::BigEndian ? a + size - i - 1 : a + i);
 
-      memory[cur] = v & 0xff;
+      /* The page is looked up again only when crossing its bounds. */
+      if (page == NULL || (cur >> PAGE_BITS) != pageno)
+	{
+	  page = get_writable_page (cur);
+	  pageno = cur >> PAGE_BITS;
+	}
+
+      put_byte (page, cur, v & 0xff);
       v >>= 8;
     }
 
@@ -144,10 +278,80 @@ ConcreteMemory::put(const ConcreteAddress &addr,
     maxaddr = a;
 }
 
+void
+ConcreteMemory::put_byte (Page *page, address_t a, uint8_t byte)
+{
+  address_t offset = a % PAGE_SIZE;
+
+  if (! s_is_defined (page->defined, offset))
+    {
+      page->defined[offset / 64] |= ((uint64_t) 1) << (offset % 64);
+      page->nb_defined++;
+      nb_cells++;
+    }
+  else
+    cells_hash -= s_cell_hash (a, page->bytes[offset]);
+  page->bytes[offset] = byte;
+  cells_hash += s_cell_hash (a, byte);
+}
+
+void
+ConcreteMemory::map(const ConcreteAddress &start, const uint8_t *data,
+		    std::size_t size, MappedFile *file)
+{
+  address_t a = start.get_address ();
+
+  assert (file->get_data () <= data &&
+	  data + size <= file->get_data () + file->get_size ());
+
+  for (std::size_t i = 0; i < size; )
+    {
+      address_t cur = a + i;
+      address_t offset = cur % PAGE_SIZE;
+      address_t pageno = cur >> PAGE_BITS;
+
+      /* Pages that are wholly covered and not yet allocated refer to the
+       * file; others receive a copy of the bytes. */
+      if (offset == 0 && size - i >= PAGE_SIZE &&
+	  pages.find (pageno) == pages.end ())
+	{
+	  Page *page = new Page ();
+
+	  page->refcount = 1;
+	  page->nb_defined = PAGE_SIZE;
+	  page->file = file;
+	  page->bytes = (uint8_t *) data + i;
+	  memset (page->defined, 0xff, sizeof (page->defined));
+	  file->ref ();
+	  pages[pageno] = page;
+	  nb_cells += PAGE_SIZE;
+	  cells_hash_pending = true;
+	  i += PAGE_SIZE;
+	  continue;
+	}
+
+      Page *page = get_writable_page (cur);
+
+      for (; i < size && offset < PAGE_SIZE; i++, offset++)
+	put_byte (page, a + i, data[i]);
+    }
+
+  if (size > 0)
+    {
+      if (a < minaddr)
+	minaddr = a;
+      if (maxaddr < a + size - 1)
+	maxaddr = a + size - 1;
+    }
+}
+
 bool
 ConcreteMemory::is_defined(const ConcreteAddress &a) const
 {
-  return (memory.find(a.get_address()) != memory.end() ||
+  address_t addr = a.get_address ();
+  const Page *page = find_page (addr);
+
+  return ((page != NULL && s_is_defined (page->defined, addr % PAGE_SIZE)) ||
 	  (base && base->is_defined (a)));
 }
 
@@ -158,6 +362,23 @@ ConcreteMemory::is_defined(const RegisterDesc *r) const
 	  (base && base->is_defined (r)));
 }
 
+void
+ConcreteMemory::put(const RegisterDesc *r, ConcreteValue v)
+{
+  if (RegisterMap<ConcreteValue>::is_defined (r))
+    regs_hash -= s_register_hash (r, RegisterMap<ConcreteValue>::get (r));
+  RegisterMap<ConcreteValue>::put (r, v);
+  regs_hash += s_register_hash (r, v);
+}
+
+void
+ConcreteMemory::clear(const RegisterDesc *r)
+{
+  if (RegisterMap<ConcreteValue>::is_defined (r))
+    regs_hash -= s_register_hash (r, RegisterMap<ConcreteValue>::get (r));
+  RegisterMap<ConcreteValue>::clear (r);
+}
+
 ConcreteValue
 ConcreteMemory::get(const RegisterDesc * r) const
     throw (UndefinedValueException)
@@ -185,18 +406,44 @@ ConcreteMemory::get(const RegisterDesc * r) const
 bool
 ConcreteMemory::equals (const ConcreteMemory &mem) const
 {
-  if (memory.size () != mem.memory.size ())
+  if (nb_cells != mem.nb_cells)
     return false;
 
   if (base != mem.base)
     return false;
 
-  for (MemoryMap::const_iterator i = memory.begin (); i != memory.end (); i++)
+  if (hashcode () != mem.hashcode ())
+    return false;
+
+  for (PageTable::const_iterator i = pages.begin (); i != pages.end (); i++)
     {
-      if (! mem.is_defined (i->first) ||
-	  ! (mem.get (i->first, 1,
-		      Architecture::LittleEndian).get () == i->second))
+      const Page *page = i->second;
+      const Page *other = mem.find_page (i->first << PAGE_BITS);
+
+      /* Pages shared since a copy are left unchanged by both memories. */
+      if (page == other)
+	continue;
+
+      if (other != NULL && page->nb_defined == other->nb_defined &&
+	  memcmp (page->defined, other->defined, sizeof (page->defined)) == 0)
+	{
+	  for (address_t off = 0; off < PAGE_SIZE; off++)
+	    if (s_is_defined (page->defined, off) &&
+		page->bytes[off] != other->bytes[off])
+	      return false;
+	  continue;
+	}
+
+      for (address_t off = 0; off < PAGE_SIZE; off++)
+	{
+	  address_t a = (i->first << PAGE_BITS) + off;
+
+	  if (! s_is_defined (page->defined, off))
+	    continue;
+	  if (! mem.is_defined (a) ||
+	      ! (mem.get_byte (a) == page->bytes[off]))
 	    return false;
+	}
     }
 
   for (RegisterMap<ConcreteValue>::const_reg_iterator i = mem.regs_begin ();
@@ -211,25 +458,22 @@ ConcreteMemory::equals (const ConcreteMemory &mem) const
 std::size_t
 ConcreteMemory::hashcode () const
 {
-  std::size_t result = 0;
-
-  for (MemoryMap::const_iterator i = memory.begin (); i != memory.end (); i++)
-    result = ((result << 3) + 19 * i->second);
-
-  for (RegisterMap<ConcreteValue>::const_reg_iterator i = regs_begin ();
-       i != regs_end (); i++) {
-    result = ((result << 3) + 19 * (intptr_t) i->second.get ());
-  }
+  if (cells_hash_pending)
+    {
+      cells_hash = 0;
+      for (const_memcell_iterator i = begin (); i != end (); i++)
+	cells_hash += s_cell_hash (i->first, i->second);
+      cells_hash_pending = false;
+    }
 
-  return result;
+  return cells_hash + regs_hash;
 }
 
 void
 ConcreteMemory::output_text(ostream &os) const
 {
   os << "Memory: " << endl;
-  for (MemoryMap::const_iterator mem = memory.begin(); mem != memory.end();
-       mem++)
+  for (const_memcell_iterator mem = begin(); mem != end(); mem++)
     os << "[ 0x" << hex << setfill('0')
        << nouppercase << setw(4) << (int) mem->first
        << " -> 0x" << hex << setfill('0')
@@ -257,11 +501,91 @@ ConcreteMemory::clone () const
 ConcreteMemory::const_memcell_iterator
 ConcreteMemory::begin () const
 {
-  return memory.begin ();
+  return const_memcell_iterator (pages.begin (), pages.end ());
 }
 
 ConcreteMemory::const_memcell_iterator
 ConcreteMemory::end () const
 {
-  return memory.end ();
+  return const_memcell_iterator (pages.end (), pages.end ());
+}
+
+/*****************************************************************************/
+/* Iterator over memory cells                                                */
+/*****************************************************************************/
+
+ConcreteMemory::const_memcell_iterator::const_memcell_iterator ()
+  : page (), last (), cell (0, 0)
+{
+}
+
+ConcreteMemory::const_memcell_iterator::const_memcell_iterator
+(PageTable::const_iterator page, PageTable::const_iterator last)
+  : page (page), last (last), cell (0, 0)
+{
+  seek (0);
+}
+
+/* Moves to the first defined cell located at or after 'offset' in the
+ * current page. */
+void
+ConcreteMemory::const_memcell_iterator::seek (address_t offset)
+{
+  for (; page != last; page++, offset = 0)
+    {
+      const Page *p = page->second;
+
+      while (offset < PAGE_SIZE)
+	{
+	  uint64_t w = p->defined[offset / 64] >> (offset % 64);
+
+	  if (w == 0)
+	    {
+	      offset = (offset / 64 + 1) * 64;
+	      continue;
+	    }
+	  while ((w & 1) == 0)
+	    {
+	      w >>= 1;
+	      offset++;
+	    }
+	  cell = value_type ((page->first << PAGE_BITS) + offset,
+			     p->bytes[offset]);
+	  return;
+	}
+    }
+}
+
+ConcreteMemory::const_memcell_iterator &
+ConcreteMemory::const_memcell_iterator::operator++ ()
+{
+  assert (page != last);
+  seek (cell.first % PAGE_SIZE + 1);
+
+  return *this;
+}
+
+ConcreteMemory::const_memcell_iterator
+ConcreteMemory::const_memcell_iterator::operator++ (int)
+{
+  const_memcell_iterator result (*this);
+
+  ++(*this);
+
+  return result;
+}
+
+bool
+ConcreteMemory::const_memcell_iterator::operator==
+(const const_memcell_iterator &other) const
+{
+  return (page == other.page &&
+	  (page == last || cell.first == other.cell.first));
+}
+
+bool
+ConcreteMemory::const_memcell_iterator::operator!=
+(const const_memcell_iterator &other) const
+{
+  return ! (*this == other);
 }
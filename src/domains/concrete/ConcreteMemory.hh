@@ -36,6 +36,7 @@
 #include <inttypes.h>
 
 #include <map>
+#include <utility>
 
 #include <domains/concrete/ConcreteValue.hh>
 #include <domains/concrete/ConcreteAddress.hh>
@@ -43,20 +44,68 @@
 #include <kernel/Memory.hh>
 #include <kernel/RegisterMap.hh>
 
+#include <utils/MappedFile.hh>
 #include <utils/Object.hh>
 #include <utils/tools.hh>
-#include <utils/unordered11.hh>
 
-/** \brief ConcreteMemory module which manage memory and also registers. */
+/** \brief ConcreteMemory module which manage memory and also registers.
+ *
+ * Memory cells are stored in pages of PAGE_SIZE bytes indexed by a
+ * sorted page table. Pages are shared between a memory and its copies
+ * and are duplicated on the first write (copy-on-write); hence cloning a
+ * memory only copies its page table. The bytes of a page may also lie in
+ * a file mapped into the address space (see map()). */
 class ConcreteMemory : public Memory<ConcreteAddress, ConcreteValue>,
 		       public RegisterMap<ConcreteValue>
 {
 public:
-  /** \brief Data structure used to encode the concrete memory. */
-  typedef std::unordered_map<address_t,
-				  uint8_t,
-				  std::hash<address_t> > MemoryMap;
-  typedef MemoryMap::const_iterator const_memcell_iterator;
+  /** \brief Size (in bytes) of a page and its logarithm. */
+  static const int PAGE_BITS = 12;
+  static const address_t PAGE_SIZE = ((address_t) 1) << PAGE_BITS;
+
+private:
+  /** \brief A page of memory; 'defined' tells which bytes have been
+   *   written. A page is shared by 'refcount' memories. If 'file' is
+   *   not NULL, 'bytes' points into this file and is never written. */
+  struct Page {
+    int refcount;
+    std::size_t nb_defined;
+    MappedFile *file;
+    uint8_t *bytes;
+    uint64_t defined[PAGE_SIZE / 64];
+  };
+
+  /** \brief Pages indexed by their number (i.e. address >> PAGE_BITS). */
+  typedef std::map<address_t, Page *> PageTable;
+
+public:
+  /** \brief Iterator over the defined memory cells; it yields pairs
+   *   (address, byte) by increasing address. */
+  class const_memcell_iterator {
+  public:
+    typedef std::pair<address_t, uint8_t> value_type;
+
+    const_memcell_iterator ();
+
+    const value_type &operator* () const { return cell; }
+    const value_type *operator-> () const { return &cell; }
+    const_memcell_iterator &operator++ ();
+    const_memcell_iterator operator++ (int);
+    bool operator== (const const_memcell_iterator &other) const;
+    bool operator!= (const const_memcell_iterator &other) const;
+
+  private:
+    friend class ConcreteMemory;
+
+    const_memcell_iterator (PageTable::const_iterator page,
+			    PageTable::const_iterator last);
+    void seek (address_t offset);
+
+    PageTable::const_iterator page;
+    PageTable::const_iterator last;
+    value_type cell;
+  };
+
   typedef ConcreteValue Value;
   typedef ConcreteAddress Address;
 
@@ -103,8 +152,9 @@ public:
     throw (UndefinedValueException);
 
   /** \brief Put the value v into the register */
+  virtual void put(const RegisterDesc *, ConcreteValue v);
 
-  using RegisterMap<ConcreteValue>::put;
+  virtual void clear(const RegisterDesc *);
 
   /** \brief Tells if the register has been written or not. */
   bool is_defined(const RegisterDesc *) const;
@@ -112,11 +162,24 @@ public:
   /** \brief Tells if the memory cell has been written or not. */
   bool is_defined(const ConcreteAddress &) const;
 
+  /** \brief Defines the 'size' cells from 'start' with the bytes at
+   *   'data', which must lie in 'file'. Whole pages refer to 'file'
+   *   instead of copying it until they are written; they hold a
+   *   reference on 'file'. */
+  void map(const ConcreteAddress &start, const uint8_t *data,
+	   std::size_t size, MappedFile *file);
+
 
   /***************************************************************************/
   /* Utils                                                                   */
   /***************************************************************************/
   virtual bool equals (const ConcreteMemory &mem) const;
+
+  /** \brief Hash value of the cells and registers defined in this
+   *   memory (not in its base). It does not depend on the order of the
+   *   writes and is maintained by put(); hence it is computed in
+   *   constant time, except after map() where the mapped cells are
+   *   hashed once. */
   virtual std::size_t hashcode () const;
   void output_text(std::ostream &) const;
   void get_address_range (address_t &min, address_t &max) const;
@@ -126,9 +189,25 @@ public:
   virtual ConcreteMemory *clone () const;
 
 private:
-  /** \brief The actual storage into memory. */
+  ConcreteMemory &operator= (const ConcreteMemory &);
+
+  static void release_page (Page *page);
+  const Page *find_page (address_t a) const;
+  Page *get_writable_page (address_t a);
+  void put_byte (Page *page, address_t a, uint8_t byte);
+  uint8_t get_byte (address_t a) const;
+
+  /** \brief Memory on top of which this one is built; cells and
+   *   registers that are not defined here are looked up in 'base'. */
   const ConcreteMemory *base;
-  MemoryMap memory;
+  /** \brief The actual storage into memory. */
+  PageTable pages;
+  std::size_t nb_cells;
+  /** \brief Sums of the hash values of the cells and of the registers;
+   *   'cells_hash' is recomputed if 'cells_hash_pending' is set. */
+  mutable std::size_t cells_hash;
+  mutable bool cells_hash_pending;
+  std::size_t regs_hash;
   address_t minaddr;
   address_t maxaddr;
 };
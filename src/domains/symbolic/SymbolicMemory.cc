@@ -31,13 +31,33 @@
 #include <kernel/expressions/exprutils.hh>
 #include "SymbolicMemory.hh"
 
+static inline std::size_t
+s_cell_hash (address_t a, const SymbolicValue &v)
+{
+  return hash_mix (hash_mix (a) + v.get_Expr ()->hash ());
+}
+
+static inline std::size_t
+s_register_hash (const RegisterDesc *r, const SymbolicValue &v)
+{
+  return hash_mix (hash_mix ((uintptr_t) r) + v.get_Expr ()->hash ());
+}
+
 SymbolicMemory::SymbolicMemory (const ConcreteMemory *base)
   : Memory<ConcreteAddress, SymbolicValue> (), RegisterMap<SymbolicValue> (),
-    base (base), memory ()
+    base (base), memory (), cells_hash (0), regs_hash (0)
 {
   base->get_address_range (minaddr, maxaddr);
 }
 
+SymbolicMemory::SymbolicMemory (const SymbolicMemory &other)
+  : Memory<ConcreteAddress, SymbolicValue> (other),
+    RegisterMap<SymbolicValue> (other), minaddr (other.minaddr),
+    maxaddr (other.maxaddr), base (other.base), memory (other.memory),
+    cells_hash (other.cells_hash), regs_hash (other.regs_hash)
+{
+}
+
 SymbolicMemory::~SymbolicMemory()
 {
 }
@@ -56,9 +76,9 @@ SymbolicMemory::get (const ConcreteAddress &a, int size_in_bytes,
   for (int i = 0; i < size_in_bytes && (i == 0 || result != NULL); i++, addr++)
     {
       Expr *byte = NULL;
-      MemoryMap::const_iterator ci = memory.find (addr.get_address ());
-      if (ci != memory.end ())
-	byte = ci->second.get_Expr ()->ref ();
+      const SymbolicValue *cell = memory.lookup (addr.get_address ());
+      if (cell != NULL)
+	byte = cell->get_Expr ()->ref ();
       else if (base->is_defined (addr))
 	{
 	  ConcreteValue v = base->get (addr, 1, e);
@@ -137,7 +157,13 @@ SymbolicMemory::put (const ConcreteAddress &a, const SymbolicValue &v,
 	TernaryApp::create (BV_OP_EXTRACT, value->ref (), e_off, e_size, 0, 8);
       exprutils::simplify (&tmp);
 
-      memory[addr] = SymbolicValue (tmp);
+      SymbolicValue byte (tmp);
+      const SymbolicValue *old = memory.lookup (addr);
+
+      if (old != NULL)
+	cells_hash -= s_cell_hash (addr, *old);
+      memory.put (addr, byte);
+      cells_hash += s_cell_hash (addr, byte);
       tmp->deref ();
     }
 
@@ -150,27 +176,33 @@ SymbolicMemory::put (const ConcreteAddress &a, const SymbolicValue &v,
 bool
 SymbolicMemory::is_defined (const ConcreteAddress &a) const
 {
-  return ((memory.find (a.get_address ()) != memory.end ()) ||
-	  base->is_defined (a));
+  return (memory.lookup (a.get_address ()) != NULL || base->is_defined (a));
 }
 
 
 SymbolicMemory *
 SymbolicMemory::clone () const
 {
-  SymbolicMemory *result = new SymbolicMemory (base);
-
-  for (const_reg_iterator i = regs_begin (); i != regs_end (); i++) {
-    result->put (i->first, i->second);
-  }
+  return new SymbolicMemory (*this);
+}
 
-  for (MemoryMap::const_iterator i = memory.begin (); i != memory.end (); i++) {
-    result->memory[i->first] = i->second;
-  }
-  result->minaddr = minaddr;
-  result->maxaddr = maxaddr;
+void
+SymbolicMemory::put (const RegisterDesc *rdesc, SymbolicValue v)
+{
+  if (RegisterMap<SymbolicValue>::is_defined (rdesc))
+    regs_hash -= s_register_hash (rdesc,
+				  RegisterMap<SymbolicValue>::get (rdesc));
+  RegisterMap<SymbolicValue>::put (rdesc, v);
+  regs_hash += s_register_hash (rdesc, v);
+}
 
-  return result;
+void
+SymbolicMemory::clear (const RegisterDesc *rdesc)
+{
+  if (RegisterMap<SymbolicValue>::is_defined (rdesc))
+    regs_hash -= s_register_hash (rdesc,
+				  RegisterMap<SymbolicValue>::get (rdesc));
+  RegisterMap<SymbolicValue>::clear (rdesc);
 }
 
 bool
@@ -221,14 +253,22 @@ SymbolicMemory::equals (const SymbolicMemory &mem) const
   if (base != mem.base)
     return false;
 
+  if (hashcode () != mem.hashcode ())
+    return false;
+
   try
     {
-      for (MemoryMap::const_iterator i = memory.begin (); i != memory.end ();
-	   i++)
+      /* Unmodified copies of each other have the same cells */
+      if (! memory.shares_root (mem.memory))
 	{
-	  SymbolicValue v = mem.get (i->first, 1, Architecture::LittleEndian);
-	  if (! i->second.equals (v))
-	    return false;
+	  for (MemoryMap::const_iterator i = memory.begin ();
+	       i != memory.end (); i++)
+	    {
+	      SymbolicValue v =
+		mem.get (i->first, 1, Architecture::LittleEndian);
+	      if (! i->second.equals (v))
+		return false;
+	    }
 	}
 
       for (RegisterMap<SymbolicValue>::const_reg_iterator i = regs_begin ();
@@ -249,20 +289,7 @@ SymbolicMemory::equals (const SymbolicMemory &mem) const
 std::size_t
 SymbolicMemory::hashcode () const
 {
-  std::size_t result = 0;
-
-  for (MemoryMap::const_iterator i = memory.begin (); i != memory.end (); i++) {
-    result = ((result << 3) + 19 * i->first +
-	      177 * (intptr_t) i->second.get_Expr ());
-  }
-
-  for (RegisterMap<SymbolicValue>::const_reg_iterator i = regs_begin ();
-       i != regs_end (); i++) {
-    result = ((result << 3) + 19 * (intptr_t) i->first +
-	      177 * (intptr_t) i->second.get_Expr ());
-  }
-
-  return result;
+  return cells_hash + regs_hash;
 }
 
 void
@@ -37,7 +37,7 @@
 # include <kernel/RegisterMap.hh>
 # include <domains/concrete/ConcreteMemory.hh>
 # include <domains/symbolic/SymbolicValue.hh>
-# include <utils/unordered11.hh>
+# include <utils/PersistentMap.hh>
 
 class SymbolicMemory
   : public Memory<ConcreteAddress, SymbolicValue>,
@@ -47,7 +47,9 @@ class SymbolicMemory
   address_t maxaddr;
 
 public:
-  typedef std::unordered_map<address_t, SymbolicValue> MemoryMap;
+  /* Cells are kept in a persistent map so that clone() is O(1) and the
+   * clones of a memory share the cells they do not overwrite. */
+  typedef PersistentMap<address_t, SymbolicValue> MemoryMap;
   typedef MemoryMap::const_iterator const_memcell_iterator;
   typedef ConcreteAddress Address;
   typedef SymbolicValue Value;
@@ -72,11 +74,16 @@ public:
   virtual SymbolicValue get(const RegisterDesc *rdesc) const
     throw (UndefinedValueException);
 
-  using RegisterMap<SymbolicValue>::put;
+  virtual void put (const RegisterDesc *rdesc, SymbolicValue v);
+  virtual void clear (const RegisterDesc *rdesc);
 
   virtual void output_text (std::ostream &out) const;
 
   virtual bool equals (const SymbolicMemory &mem) const;
+
+  /* Hash value of the cells and registers defined in this memory (not
+   * in its base); it does not depend on the order of the writes and is
+   * maintained by put(). */
   virtual std::size_t hashcode () const;
 
 
@@ -85,8 +92,13 @@ public:
   virtual const_memcell_iterator end () const;
 
 private:
+  SymbolicMemory (const SymbolicMemory &other);
+
   const ConcreteMemory *base;
   MemoryMap memory;
+  /* Sums of the hash values of the cells and of the registers */
+  std::size_t cells_hash;
+  std::size_t regs_hash;
 };
 
 #endif /* ! SYMBOLICMEMORY_HH */
@@ -98,9 +98,69 @@ SymbolicStepper::SymbolicStepper (ConcreteMemory *memory,
 }
 
 SymbolicStepper::~SymbolicStepper () {
+  for (size_t i = 0; i < asserted.size (); i++)
+    asserted[i]->deref ();
   delete solver;
 }
 
+/* Path conditions only grow by conjunction along a path: the solver keeps
+ * the levels it shares with the path condition of 'ctx' and only the
+ * missing conjuncts are pushed, one per level. */
+void
+SymbolicStepper::assert_path_condition (const SymbolicContext *ctx)
+{
+  std::vector<const Expr *> missing;
+  const Expr *pc = ctx->get_path_condition ();
+  size_t nb_kept = 0;
+
+  for (;;)
+    {
+      if (pc->is_TrueFormula ())
+	break;
+
+      std::unordered_map<const Expr *, size_t>::const_iterator i =
+	asserted_levels.find (pc);
+      if (i != asserted_levels.end ())
+	{
+	  nb_kept = i->second + 1;
+	  break;
+	}
+      missing.push_back (pc);
+
+      const BinaryApp *b = dynamic_cast<const BinaryApp *> (pc);
+      if (b == NULL || b->get_op () != BV_OP_AND || b->get_bv_size () != 1)
+	break;
+      pc = b->get_arg1 ();
+    }
+
+  while (asserted.size () > nb_kept)
+    {
+      solver->pop ();
+      asserted_levels.erase (asserted.back ());
+      asserted.back ()->deref ();
+      asserted.pop_back ();
+    }
+
+  while (! missing.empty ())
+    {
+      pc = missing.back ();
+      missing.pop_back ();
+
+      /* A conjunction extends the previous level, unless it is the
+       * innermost one. */
+      const BinaryApp *b = dynamic_cast<const BinaryApp *> (pc);
+      solver->push ();
+      if (b != NULL && b->get_op () == BV_OP_AND && b->get_bv_size () == 1 &&
+	  (asserted.empty () ? b->get_arg1 ()->is_TrueFormula ()
+	   : b->get_arg1 () == asserted.back ()))
+	solver->add_assertion (b->get_arg2 ());
+      else
+	solver->add_assertion (pc);
+      asserted_levels[pc] = asserted.size ();
+      asserted.push_back (pc->ref ());
+    }
+}
+
 ConcreteValue
 SymbolicStepper::value_to_ConcreteValue (const Context *ctx, const Value &v,
 					 bool *is_unique)
@@ -125,7 +185,8 @@ SymbolicStepper::value_to_ConcreteValue (const Context *ctx, const Value &v,
     }
   exprutils::simplify (&f);
 
-  Expr *cond = sc->get_path_condition ()->ref ();
+  assert_path_condition (sc);
+  Expr *cond = Constant::True ();
 
   std::vector<constant_t> *values =
     solver->evaluate (f, cond, is_unique ? 2 : 1);
@@ -258,10 +319,13 @@ SymbolicStepper::value_to_concrete_addresses (const Context *ctx,
 
   address_t range[2];
   sc->get_memory ()->get_address_range (range[0], range[1]);
-  Expr *cond = sc->get_path_condition ()->ref ();
+  assert_path_condition (sc);
+  Expr *cond;
 
   if (this->map_dynamic_jumps_to_memory)
-    cond = Expr::createLAnd (s_expr_in_range (e, range[0], range[1]), cond);
+    cond = s_expr_in_range (e, range[0], range[1]);
+  else
+    cond = Constant::True ();
 
   for (;;)
     {
@@ -276,12 +340,21 @@ SymbolicStepper::value_to_concrete_addresses (const Context *ctx,
   std::vector<Expr *> *expaddr =
     s_expand_memcell_indexes (solver, unkgen, this->arch, sc, f, cond,
 			      this->dynamic_jump_threshold);
+  /* The targets are evaluated concurrently if the solver can. */
+  int th = this->dynamic_jump_threshold;
+  std::vector<ExprSolver::Query *> queries;
   for (std::vector<Expr *>::size_type i = 0; i < expaddr->size (); i++)
     {
-      int th = this->dynamic_jump_threshold;
       Expr *aux = expaddr->at (i);
-      std::vector<constant_t> *tmp = solver->evaluate (aux, cond, th);
+      queries.push_back (solver->submit_evaluate (aux, cond, th));
       aux->deref ();
+    }
+  delete (expaddr);
+
+  for (size_t q = 0; q < queries.size (); q++)
+    {
+      std::vector<constant_t> *tmp = queries[q]->get_values ();
+      delete queries[q];
 
       if (th >= 0 && (int)tmp->size () >= th)
 	tmp->clear ();
@@ -290,7 +363,6 @@ SymbolicStepper::value_to_concrete_addresses (const Context *ctx,
 	result->push_back (tmp->at (i));
       delete tmp;
     }
-  delete (expaddr);
 
   f->deref ();
   cond->deref ();
@@ -320,7 +392,10 @@ SymbolicStepper::eval (const Context *ctx, const Expr *e)
       f = aux;
     }
   exprutils::simplify (&f);
-  Constant *c = solver->evaluate (f, sc->get_path_condition ());
+  assert_path_condition (sc);
+  Expr *cond = Constant::True ();
+  Constant *c = solver->evaluate (f, cond);
+  cond->deref ();
   if (c != NULL)
     {
       f->deref ();
@@ -345,11 +420,13 @@ SymbolicStepper::embed_eval (const SymbolicStepper::Value &v1,
 }
 
 
+/* Decides 'e' under the assertions of the solver: false if it is
+ * unsatisfiable and, if 'may_hold', true if its negation is. */
 static Option<bool>
 s_to_bool (ExprSolver *solver, SymbolicStepper::UnknownGenerator *unkgen,
 	   const Architecture *arch,
 	   const SymbolicContext *ctx, const Expr *e,
-	   Expr **symbval)
+	   Expr **symbval, bool may_hold)
 {
   Option<bool> result;
   RewriteWithAssignedValues r (ctx, unkgen, arch->get_endian ());
@@ -358,19 +435,29 @@ s_to_bool (ExprSolver *solver, SymbolicStepper::UnknownGenerator *unkgen,
   f->deref ();
   f = r.get_result ();
 
-  ExprSolver::Result sat = solver->check_sat (f, true);
+  /* Both sides of the branch are submitted together; the negation is
+   * dropped unanswered if 'f' is not satisfiable. */
+  ExprSolver::Query *pos = solver->submit_check_sat (f);
+  ExprSolver::Query *neg = NULL;
+  if (may_hold)
+    {
+      Expr *nf = Expr::createLNot (f->ref ());
+      neg = solver->submit_check_sat (nf);
+      nf->deref ();
+    }
+
+  ExprSolver::Result sat = pos->get_result ();
   if (sat == ExprSolver::SAT)
     {
-      Expr *tmp = Expr::createLNot (f->ref ());
-      sat = solver->check_sat (tmp, true);
-      if (sat  == ExprSolver::UNSAT)
+      if (neg != NULL && neg->get_result () == ExprSolver::UNSAT)
 	result = true;
-      tmp->deref ();
     }
   else if (sat == ExprSolver::UNSAT)
     {
       result = false;
     }
+  delete pos;
+  delete neg;
 
   if (! result.hasValue () && symbval != NULL)
     *symbval = f;
@@ -386,9 +473,15 @@ SymbolicStepper::restrict_to_condition (const Context *ctx, const Expr *cond)
   const SymbolicContext *sc = dynamic_cast<const SymbolicContext *> (ctx);
   assert (sc != NULL);
   SymbolicContext *result = NULL;
-  Expr *e = Expr::createLAnd (sc->get_path_condition ()->ref (), cond->ref ());
   Expr *val = NULL;
-  Option<bool> eval = s_to_bool (solver, unkgen, this->arch, sc, e, &val);
+
+  /* Only the new conjunct is sent along with the query. The condition
+   * holds if the whole path condition is valid; a path condition other
+   * than true is not, since it is made of conditions that did not hold. */
+  const Expr *pc = sc->get_path_condition ();
+  assert_path_condition (sc);
+  Option<bool> eval = s_to_bool (solver, unkgen, this->arch, sc, cond, &val,
+				 pc->is_TrueFormula ());
 
   if (eval.hasValue ())
     {
@@ -400,10 +493,11 @@ SymbolicStepper::restrict_to_condition (const Context *ctx, const Expr *cond)
     {
       assert (val != NULL);
       exprutils::simplify_level0 (&val);
+      if (! pc->is_TrueFormula ())
+	val = Expr::createLAnd (pc->ref (), val);
       result = sc->clone ();
       result->set_path_condition (val);
     }
-  e->deref ();
 
   return result;
 }
@@ -7,6 +7,7 @@
 # include <domains/symbolic/SymbolicMemory.hh>
 # include <domains/symbolic/SymbolicContext.hh>
 # include <domains/symbolic/SymbolicExprSemantics.hh>
+# include <utils/unordered11.hh>
 
 
 class SymbolicStepper :
@@ -14,6 +15,12 @@ class SymbolicStepper :
 {
 private:
   class ExprSolver *solver;
+  /* Path conditions asserted on 'solver', one per push: each one extends
+   * the previous one with a single conjunct. */
+  std::vector<Expr *> asserted;
+  std::unordered_map<const Expr *, std::size_t> asserted_levels;
+
+  void assert_path_condition (const SymbolicContext *ctx);
 
 public:
   typedef AbstractDomainStepper<MicrocodeAddressProgramPoint,
@@ -158,7 +158,8 @@ struct UnknownSymbolicValue : public UnknownValueGenerator<SymbolicValue>
   SymbolicValue unknown_value (int size) {
     static int vid = 0;
     std::ostringstream oss;
-    oss <<  "unkval_" << vid++;
+    /* Steppers of a parallel traversal share the generator. */
+    oss <<  "unkval_" << __sync_fetch_and_add (&vid, 1);
     Expr *var = Variable::create (oss.str (), size);
 
     SymbolicValue result (var);
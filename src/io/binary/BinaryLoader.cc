@@ -30,8 +30,14 @@
 
 #include "BinaryLoader.hh"
 
+#include <algorithm>
+
 using namespace std;
 
+BinaryLoader::BinaryLoader() : mapped_loading (false)
+{
+}
+
 string BinaryLoader::get_filename() const
 {
   return filename;
@@ -52,6 +58,25 @@ ConcreteAddress BinaryLoader::get_entrypoint() const
   return entrypoint;
 }
 
+const list<BinaryLoader::section_t> &
+BinaryLoader::get_sections() const
+{
+  return sections;
+}
+
+list<BinaryLoader::section_t>
+BinaryLoader::get_code_sections() const
+{
+  list<section_t> result;
+
+  for (list<section_t>::const_iterator s = sections.begin ();
+       s != sections.end (); s++)
+    if (find (s->flags.begin (), s->flags.end (), "CODE") != s->flags.end ())
+      result.push_back (*s);
+
+  return result;
+}
+
 bool
 BinaryLoader::load_symbol_table (SymbolTable *) const
 {
@@ -64,6 +89,18 @@ BinaryLoader::load_memory (ConcreteMemory *) const
   return false;
 }
 
+void
+BinaryLoader::set_mapped_loading (bool mapped)
+{
+  mapped_loading = mapped;
+}
+
+bool
+BinaryLoader::get_mapped_loading () const
+{
+  return mapped_loading;
+}
+
 static string flags_to_string(list<string> flags)
 {
   stringstream ss;
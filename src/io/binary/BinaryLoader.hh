@@ -31,6 +31,7 @@
 #ifndef IO_BINARYLOADER_HH
 #define IO_BINARYLOADER_HH
 
+#include <list>
 #include <string>
 #include <stdexcept>
 
@@ -117,6 +118,7 @@ public:
   } section_t;
 
   /******************** BinaryLoader Methods ***********************/
+  BinaryLoader();
   virtual ~BinaryLoader() { };
 
   void output_text(std::ostream &) const;
@@ -127,9 +129,20 @@ public:
   const Architecture * get_architecture() const;
   ConcreteAddress get_entrypoint() const;
 
+  /** \brief Sections of the binary and, among them, the ones holding
+   *  code (CODE flag) */
+  const std::list <section_t> &get_sections() const;
+  std::list <section_t> get_code_sections() const;
+
   virtual bool load_symbol_table (SymbolTable *table) const;
   virtual bool load_memory (ConcreteMemory *memory) const;
 
+  /** \brief When set, load_memory() maps the file into the address
+   *  space and the memory refers to it instead of copying its contents
+   *  (see ConcreteMemory::map). Disabled by default. */
+  void set_mapped_loading (bool mapped);
+  bool get_mapped_loading () const;
+
   virtual StubFactory *get_StubFactory () const = 0;
 
 protected:
@@ -141,6 +154,8 @@ protected:
 
   std::list <std::string> flags;  /* Flags embedded in the binary */
   std::list <section_t> sections; /* Sections embedded in the binary */
+
+  bool mapped_loading;
 };
 
 #endif /* IO_BINARYLOADER_HH */
@@ -29,8 +29,11 @@
  */
 #include "BinutilsBinaryLoader.hh"
 
+#include <algorithm>
 #include <cstdlib>
+#include <list>
 #include <sstream>
+#include <utility>
 
 #include <unistd.h>
 
@@ -179,7 +182,10 @@ BinutilsBinaryLoader::~BinutilsBinaryLoader()
 }
 
 void
-BinutilsBinaryLoader::fill_memory_from_sections (ConcreteMemory *memory) const {
+BinutilsBinaryLoader::fill_memory_from_sections (ConcreteMemory *memory,
+						 MappedFile *file) const {
+  /* Address ranges of the sections loaded so far */
+  list< pair<address_t, address_t> > loaded;
 
   for (struct bfd_section *bfd_section = abfd->sections;
        bfd_section != NULL;
@@ -207,6 +213,28 @@ BinutilsBinaryLoader::fill_memory_from_sections (ConcreteMemory *memory) const {
       bfd_size_type datasize = bfd_get_section_size(bfd_section);
       size_t size = (size_t) datasize / opb;
 
+      /* Sections stored as is in the file are mapped unless they
+       * overlap a section loaded before (which is reported below) */
+      bool mappable =
+	(file != NULL && opb == 1 &&
+	 (bfd_section->flags & SEC_HAS_CONTENTS) != 0 &&
+	 (bfd_section->flags & SEC_IN_MEMORY) == 0 &&
+	 (size_t) bfd_section->filepos + size <= file->get_size ());
+      address_t first = start.get_address ();
+
+      for (list< pair<address_t, address_t> >::iterator l = loaded.begin ();
+	   mappable && l != loaded.end (); l++)
+	if (first < l->second && l->first < first + size)
+	  mappable = false;
+      loaded.push_back (make_pair (first, first + size));
+
+      if (mappable)
+	{
+	  memory->map (start, file->get_data () + bfd_section->filepos, size,
+		       file);
+	  continue;
+	}
+
       /* Getting section data content */
       bfd_byte *data = (bfd_byte *) malloc(datasize);
       bfd_get_section_contents(abfd, bfd_section, data, 0, datasize);
@@ -261,7 +289,8 @@ struct elf_internal_phdr_from_bfd {
 };
 
 int
-BinutilsBinaryLoader::fill_memory_from_ELF_Phdrs(ConcreteMemory *memory) const {
+BinutilsBinaryLoader::fill_memory_from_ELF_Phdrs(ConcreteMemory *memory,
+						 MappedFile *file) const {
   long phdr_size = bfd_get_elf_phdr_upper_bound(abfd);
   struct elf_internal_phdr_from_bfd *phdrs;
   int nphdrs;
@@ -281,6 +310,20 @@ BinutilsBinaryLoader::fill_memory_from_ELF_Phdrs(ConcreteMemory *memory) const {
 
   for (int hdr = 0; hdr < nphdrs; hdr++) {
     size_t size = phdrs[hdr].p_filesz;
+
+    /* The part of the segment stored in the file is mapped; the
+     * remaining of the segment is zeroed. */
+    if (file != NULL && phdrs[hdr].p_offset + size <= file->get_size ()) {
+      memory->map(ConcreteAddress(phdrs[hdr].p_vaddr),
+		  file->get_data () + phdrs[hdr].p_offset,
+		  min ((bfd_vma) size, phdrs[hdr].p_memsz), file);
+
+      for (size_t i = size; i < phdrs[hdr].p_memsz; i++)
+	memory->put(ConcreteAddress(phdrs[hdr].p_vaddr + i), ConcreteValue(8, 0),
+		    Architecture::BigEndian);
+      continue;
+    }
+
     unsigned char *data = (unsigned char *) malloc(size);
     if (data == NULL)
       goto fail;
@@ -351,14 +394,27 @@ BinutilsBinaryLoader::load_memory (ConcreteMemory *memory) const
 {
   /* Prefer reading the ELF Phdr information because it's the authoritative
      information for ELF executables */
+  MappedFile *file = NULL;
+
+  if (mapped_loading && (file = MappedFile::map (filename)) == NULL)
+    logs::warning << "warning: cannot map '" << filename
+		  << "', its contents are copied" << endl;
+
+  bool done = false;
+
   if (bfd_get_flavour(abfd) == bfd_target_elf_flavour && abfd->flags & EXEC_P) {
-    if (fill_memory_from_ELF_Phdrs(memory) != -1)
-      return true;
+    if (fill_memory_from_ELF_Phdrs(memory, file) != -1)
+      done = true;
     else
       logs::warning << "Couldn't use ELF Program headers, using sections";
   }
 
-  fill_memory_from_sections(memory);
+  if (! done)
+    fill_memory_from_sections(memory, file);
+
+  /* Pages that refer to the file hold their own reference */
+  if (file != NULL)
+    file->deref ();
 
   return true;
 }
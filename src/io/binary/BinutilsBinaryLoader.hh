@@ -42,6 +42,7 @@
 #include <domains/concrete/ConcreteMemory.hh>
 #include <io/binary/BinaryLoader.hh>
 #include <kernel/SymbolTable.hh>
+#include <utils/MappedFile.hh>
 #include <utils/unordered11.hh>
 
 /*************** BinutilsBinaryLoader class definition ****************/
@@ -86,8 +87,10 @@ protected:
   std::string get_BFD_format() const;
   const Architecture *compute_BFD_architecture(const std::string machine,
 			       Architecture::endianness_t endianness) const;
-  void fill_memory_from_sections(ConcreteMemory *) const;
-  int fill_memory_from_ELF_Phdrs(ConcreteMemory *) const;
+  /* Contents are copied into the memory unless 'file' (the mapped
+   * binary) is not NULL */
+  void fill_memory_from_sections(ConcreteMemory *, MappedFile *file) const;
+  int fill_memory_from_ELF_Phdrs(ConcreteMemory *, MappedFile *file) const;
 };
 
 
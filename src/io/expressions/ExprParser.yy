@@ -197,6 +197,9 @@ lvalue:
 %% /***** Parser subroutines *****/
 
 # include <cassert>
+# include <utils/MutexLock.hh>
+
+static pthread_mutex_t s_expr_parser_lock = PTHREAD_MUTEX_INITIALIZER;
 
 void
 Parser::error(const Parser::location_type &loc, const string &msg)
@@ -207,6 +210,8 @@ Parser::error(const Parser::location_type &loc, const string &msg)
 Expr *
 expr_parser (const std::string &in, const MicrocodeArchitecture *arch)
 {
+  /* The scanner is not reentrant */
+  MutexLock L (&s_expr_parser_lock);
   ExprParser::ClientData data;
 
   ExprParser::init_lexer (in);
@@ -28,13 +28,13 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
-#include <list>
 #include "smtlib-writer.hh"
 
 #include <stdlib.h>
+#include <stdio.h>
 
-#include <iomanip>
 #include <cassert>
+#include <vector>
 
 #include <kernel/expressions/ExprVisitor.hh>
 #include <kernel/expressions/exprutils.hh>
@@ -43,104 +43,80 @@
 
 using namespace std;
 
-class SMTLibVisitor;
+static void
+s_append_dec (string &out, long long val)
+{
+  char buf[24];
+  int len = snprintf (buf, sizeof (buf), "%lld", val);
+  out.append (buf, len);
+}
 
-class CountSharedSubFormulas : public ConstExprVisitor
+static void
+s_append_hex (string &out, word_t val, int width)
 {
-  struct DFScounters {
-    int enter;
-    int leave;
-    int counter;
+  char buf[24];
+  int len = snprintf (buf, sizeof (buf), "%0*llx", width,
+		      (unsigned long long) val);
+  out.append (buf, len);
+}
+
+/* Finds the sub-formulas of a DAG that have several parents. Each node is
+ * visited once, so the pass is linear in the size of the DAG. Shared
+ * formulas are bound by nested 'let's in postorder, hence before the
+ * formulas that use them; they are named after their rank in preorder. */
+class SharedSubFormulas : public ConstExprVisitor
+{
+  struct Node {
+    int rank;
+    int nb_parents;
+    bool bound;
   };
 
-  typedef std::unordered_map<const Expr *, DFScounters> Counters;
-  typedef std::unordered_set<const Expr *> Done;
+  typedef std::unordered_map<const Expr *, Node> Nodes;
 
-  int max;
-  int date;
-  Counters counters;
-  list<const Expr *> shared;
-  Done done;
+  Nodes nodes;
+  std::vector<const Expr *> postorder;
+  int nb_shared;
 
 public :
 
-  CountSharedSubFormulas ()
-    : ConstExprVisitor (), max (0), date (0), counters (), shared (), done () {
-  }
-
-  virtual ~CountSharedSubFormulas () {
+  SharedSubFormulas ()
+    : ConstExprVisitor (), nodes (), postorder (), nb_shared (0) {
   }
 
-
-  bool operator () (const Expr *e1, const Expr *e2) {
-    return  counters[e1].leave < counters[e2].leave;
-  }
-
-  const list<const Expr *> &get_shared () const {
-    return shared;
+  virtual ~SharedSubFormulas () {
   }
 
-  void open_context (std::ostream &out, SMTLibVisitor &sw);
+  void open_context (std::string &out, ConstExprVisitor &writer);
 
-  void close_context (std::ostream &out) const {
-    int nb_symbols = shared.size ();
-    while (nb_symbols--)
-      out << ")";
+  void close_context (std::string &out) const {
+    out.append (nb_shared, ')');
   }
 
-  void output_shared_symbol (const DFScounters &c, std::ostream &out) const {
-    out << "_$" << dec << c.enter;
-  }
-
-  bool output_shared_expr (const Expr *e, std::ostream &out) {
-    if (done.find (e) == done.end ())
+  bool output_shared_expr (const Expr *e, std::string &out) const {
+    if (nb_shared == 0)
+      return false;
+    Nodes::const_iterator i = nodes.find (e);
+    if (i == nodes.end () || ! i->second.bound)
       return false;
-    Counters::const_iterator i = counters.find (e);
     output_shared_symbol (i->second, out);
 
     return true;
   }
 
-  int display_counters (std::ostream &out) const {
-    if (max <= 1)
-      return 0;
-
-    int *distrib = new int[max + 1];
-
-    for (int i = 0; i <= max; i++)
-      distrib[i] = 0;
-    for (Counters::const_iterator i = counters.begin (); i != counters.end ();
-	 i++)
-      distrib[i->second.counter]++;
-    out << "Shared Formulas: " << endl;
-    int result = 0;
-    for (int i = 2; i <= max; i++)
-      if (distrib[i] > 0)
-	{
-	  out << "shared " << i << " times : " << distrib[i] << endl;
-	  result++;
-	}
-    delete[] distrib;
-    return result;
-  }
+  /* Returns true if 'e' is visited for the first time. */
+  bool enter (const Expr *e) {
+    Node n = { (int) nodes.size () + 1, 1, false };
+    pair<Nodes::iterator, bool> i = nodes.insert (make_pair (e, n));
 
-  virtual int update_counter (const Expr *e) {
-    if (counters.find (e) == counters.end ())
-      {
-	date++;
-	counters[e].enter = date;
-	counters[e].counter = 1;
-	counters[e].leave = date;
-      }
-    else
-      {
-	counters[e].counter++;
-      }
+    if (! i.second)
+      i.first->second.nb_parents++;
 
-    if (counters[e].counter > max)
-      max = counters[e].counter;
+    return i.second;
+  }
 
-    return counters[e].counter;
+  void leave (const Expr *e) {
+    postorder.push_back (e);
   }
 
   virtual void visit (const Constant *) { }
@@ -153,33 +129,34 @@ public :
   virtual void visit (const Variable *) { }
 
   virtual void visit (const UnaryApp *e) {
-    if (update_counter (e) > 1)
+    if (! enter (e))
       return;
     e->get_arg1 ()->acceptVisitor (this);
-    counters[e].leave = date + 1;
+    leave (e);
   }
 
   virtual void visit (const BinaryApp *e) {
-    if (update_counter (e) > 1)
+    if (! enter (e))
       return;
     e->get_arg1 ()->acceptVisitor (this);
     e->get_arg2 ()->acceptVisitor (this);
-    counters[e].leave = date + 1;
+    leave (e);
   }
+
   virtual void visit (const TernaryApp *e) {
-    if (update_counter (e) > 1)
+    if (! enter (e))
       return;
     e->get_arg1 ()->acceptVisitor (this);
     e->get_arg2 ()->acceptVisitor (this);
     e->get_arg3 ()->acceptVisitor (this);
-    counters[e].leave = date + 1;
+    leave (e);
   }
 
   virtual void visit (const MemCell *e) {
-    if (update_counter (e) > 1)
+    if (! enter (e))
       return;
     e->get_addr ()->acceptVisitor (this);
-    counters[e].leave = date + 1;
+    leave (e);
   }
 
   virtual void visit (const RegisterExpr *) {
@@ -188,28 +165,34 @@ public :
   virtual void visit (const QuantifiedExpr *e) {
     throw SMTLibUnsupportedExpression (e->to_string ());
   }
+
+private:
+  void output_shared_symbol (const Node &n, std::string &out) const {
+    out += "_$";
+    s_append_dec (out, n.rank);
+  }
 };
 
 class SMTLibVisitor : public ConstExprVisitor
 {
-  ostream &out;
+  string &out;
   const string &memvar;
   int addrsize;
   Architecture::endianness_t endian;
-  CountSharedSubFormulas *cssf;
+  SharedSubFormulas *ssf;
 
 public:
 
 
-  SMTLibVisitor (ostream &o, const string &mv, int bpa,
+  SMTLibVisitor (string &o, const string &mv, int bpa,
 		 Architecture::endianness_t e)
     : ConstExprVisitor (), out (o), memvar (mv), addrsize (bpa), endian (e),
-      cssf (NULL) {}
+      ssf (NULL) {}
 
   ~SMTLibVisitor () { }
 
-  void set_cssf (CountSharedSubFormulas *cssf) {
-    this->cssf = cssf;
+  void set_ssf (SharedSubFormulas *ssf) {
+    this->ssf = ssf;
   }
 
   virtual void visit (const Constant *c) {
@@ -217,12 +200,15 @@ public:
     int bv_size = c->get_bv_size () ;
 
     if (c->get_bv_size () % 8 == 0)
-      out << "#x" << setw (bv_size / 4) << setfill ('0') << hex << val;
+      {
+	out += "#x";
+	s_append_hex (out, val, bv_size / 4);
+      }
     else
       {
-	out << "#b";
+	out += "#b";
 	while (bv_size--)
-	  out << dec << (0x1 & (val >> bv_size));
+	  out += (0x1 & (val >> bv_size)) ? '1' : '0';
       }
   }
 
@@ -232,16 +218,15 @@ public:
   }
 
   virtual void visit (const Variable *v) {
-    out << v->get_id ();
+    out += v->get_id ();
   }
 
   void extract_bv_window (const Expr *e) {
-    out << "(_ extract "
-	<< dec << (e->get_bv_offset () + e->get_bv_size () - 1)
-	<< " "
-	<< dec << e->get_bv_offset () << " "
-	<< ") ";
-
+    out += "(_ extract ";
+    s_append_dec (out, e->get_bv_offset () + e->get_bv_size () - 1);
+    out += ' ';
+    s_append_dec (out, e->get_bv_offset ());
+    out += " ) ";
   }
 
   bool has_boolean_bv (const Expr *e) {
@@ -285,22 +270,38 @@ public:
 
   void output_boolean (const Expr *e) {
     if (e->get_bv_size () > 1)
-      out << "(not (= ";
+      out += "(not (= ";
     else
-      out << "(= ";
+      out += "(= ";
     e->acceptVisitor (this);
-    out << " ";
+    out += ' ';
     if (e->get_bv_size () == 1)
-      out << "#b1";
+      out += "#b1";
     else if (e->get_bv_size () % 8 == 0)
-      out << "#x" << string (e->get_bv_size () / 4, '0') << ')';
+      {
+	out += "#x";
+	out.append (e->get_bv_size () / 4, '0');
+	out += ')';
+      }
     else
-      out << "#b" << string (e->get_bv_size (), '0') << ')';
-    out << ")";
+      {
+	out += "#b";
+	out.append (e->get_bv_size (), '0');
+	out += ')';
+      }
+    out += ')';
+  }
+
+  void output_extension (const char *ext_op, int ext) {
+    out += "((_ ";
+    out += ext_op;
+    out += ' ';
+    s_append_dec (out, ext);
+    out += ") ";
   }
 
   virtual void visit (const UnaryApp *e) {
-    if (cssf->output_shared_expr (e, out))
+    if (ssf->output_shared_expr (e, out))
       return;
     const char *op;
     bool extract = (e->get_bv_offset () != 0 ||
@@ -318,21 +319,23 @@ public:
 
     if (extract)
       {
-	out << "(";
+	out += '(';
 	extract_bv_window (e);
       }
     if (extend && e->get_bv_size () > e->get_arg1 ()->get_bv_size ())
       {
 	int ext = (e->get_bv_size () - e->get_arg1 ()->get_bv_size ());
-	out << "((_ sign_extend " << dec << ext << ") ";
+	output_extension ("sign_extend", ext);
       }
-    out << "(" << op << " ";
+    out += '(';
+    out += op;
+    out += ' ';
     e->get_arg1 ()->acceptVisitor (this);
-    out << ")";
+    out += ')';
     if (extend && e->get_bv_size () > e->get_arg1 ()->get_bv_size ())
-      out << ")";
+      out += ')';
     if (extract)
-      out << ")";
+      out += ')';
   }
 
   bool need_extract (const BinaryApp *e) {
@@ -351,7 +354,7 @@ public:
   }
 
   virtual void visit (const BinaryApp *e) {
-    if (cssf->output_shared_expr (e, out))
+    if (ssf->output_shared_expr (e, out))
       return;
 
     BinaryOp op = e->get_op ();
@@ -364,22 +367,22 @@ public:
     switch (op)
       {
       case BV_OP_AND: case BV_OP_OR:
-	out << "(";
+	out += '(';
 	if (extract)
 	  {
 	    extract_bv_window (e);
-	    out << "(";
+	    out += '(';
 	  }
 
-	out << (op == BV_OP_AND ? "bvand " : "bvor ");
+	out += (op == BV_OP_AND ? "bvand " : "bvor ");
 	e->get_arg1 ()->acceptVisitor (this);
-	out << " ";
+	out += ' ';
 	e->get_arg2 ()->acceptVisitor (this);
 	if (extract)
 	  {
-	    out << ")";
+	    out += ')';
 	  }
-	out << ")";
+	out += ')';
 	break;
 
       case BV_OP_MUL_S: with_sign = true;
@@ -421,44 +424,38 @@ public:
 
       output_binary_1:
 	if (ite)
-	  out << "(ite ";
+	  out += "(ite ";
 	if (extract)
 	  {
-	    out << "(";
+	    out += '(';
 	    extract_bv_window (e);
 	  }
 
-	out << "(" << op_str << " ";
+	out += '(';
+	out += op_str;
+	out += ' ';
 	if (extend && e->get_bv_size () > e->get_arg1 ()->get_bv_size ())
 	  {
 	    int ext = (e->get_bv_size () - e->get_arg1 ()->get_bv_size ());
-	    if (with_sign)
-	      out << "((_ sign_extend ";
-	    else
-	      out << "((_ zero_extend ";
-	    out << dec << ext << ") ";
+	    output_extension (with_sign ? "sign_extend" : "zero_extend", ext);
 	  }
 	e->get_arg1 ()->acceptVisitor (this);
 	if (extend && e->get_bv_size () > e->get_arg1 ()->get_bv_size ())
-	  out << ") ";
-	out << " ";
+	  out += ") ";
+	out += ' ';
 	if (extend && e->get_bv_size () > e->get_arg2 ()->get_bv_size ())
 	  {
 	    int ext = (e->get_bv_size () - e->get_arg2 ()->get_bv_size ());
-	    if (with_sign)
-	      out << "((_ sign_extend ";
-	    else
-	      out << "((_ zero_extend ";
-	    out << dec << ext << ") ";
+	    output_extension (with_sign ? "sign_extend" : "zero_extend", ext);
 	  }
 	e->get_arg2 ()->acceptVisitor (this);
 	if (extend && e->get_bv_size () > e->get_arg2 ()->get_bv_size ())
-	  out << ")";
-	out << ")";
+	  out += ')';
+	out += ')';
 	if (extract)
-	  out << ")";
+	  out += ')';
 	if (ite)
-	  out << " #b1 #b0)";
+	  out += " #b1 #b0)";
 	break;
 
       case BV_OP_ROR: op_str = "rotate_right"; goto output_binary_2;
@@ -468,7 +465,7 @@ public:
       output_binary_2:
 	if (extract)
 	  {
-	    out << "(";
+	    out += '(';
 	    extract_bv_window (e);
 	  }
 
@@ -479,13 +476,13 @@ public:
 	  word_t val = c->get_val ();
 	  if (op == BV_OP_EXTEND_U || op == BV_OP_EXTEND_S)
 	    val = c->get_val () - e->get_arg1 ()->get_bv_size ();
-	  out << "((_ " << op_str << " " << dec << val << ") ";
+	  output_extension (op_str, val);
 	  e->get_arg1 ()->acceptVisitor (this);
-	  out << ")";
+	  out += ')';
 	}
 
 	if (extract)
-	  out << ")";
+	  out += ')';
 	break;
 
       case BV_OP_POW:
@@ -495,7 +492,7 @@ public:
   }
 
   virtual void visit (const TernaryApp *e) {
-    if (cssf->output_shared_expr (e, out))
+    if (ssf->output_shared_expr (e, out))
       return;
 
     assert (e->get_op () == BV_OP_EXTRACT);
@@ -508,34 +505,39 @@ public:
     constant_t offset = expr_offset->get_val ();
     constant_t size = expr_size->get_val ();
     if (offset != e->get_bv_offset () || size != e->get_bv_size ())
-      {
-	out << "((_ extract "
-	    << dec << (e->get_bv_offset () + e->get_bv_size () - 1) << " "
-	    << e->get_bv_offset () << ") ";
-      }
-    out << "((_ extract "
-	<< dec << (offset + size - 1) << " " << offset << ") ";
+      output_extract (e->get_bv_offset (), e->get_bv_size ());
+    output_extract (offset, size);
     e->get_arg1 ()->acceptVisitor (this);
-    out << ")";
+    out += ')';
     if (offset != e->get_bv_offset () || size != e->get_bv_size ())
-      out << ")";
+      out += ')';
+  }
+
+  void output_extract (constant_t offset, constant_t size) {
+    out += "((_ extract ";
+    s_append_dec (out, offset + size - 1);
+    out += ' ';
+    s_append_dec (out, offset);
+    out += ") ";
   }
 
   virtual void visit (const MemCell *e) {
-    if (cssf->output_shared_expr (e, out))
+    if (ssf->output_shared_expr (e, out))
       return;
 
     if (e->get_bv_size () == 8 && e->get_bv_offset () == 0)
       {
 	// to be fixed !!!
 	int extend = addrsize - e->get_addr ()->get_bv_size ();
-	out << "(select " << memvar << " ";
+	out += "(select ";
+	out += memvar;
+	out += ' ';
 	if (extend > 0)
-	  out << "((_ zero_extend " << dec << extend << ") ";
+	  output_extension ("zero_extend", extend);
 	e->get_addr ()->acceptVisitor (this);
 	if (extend > 0)
-	  out << ")";
-	out << ")";
+	  out += ')';
+	out += ')';
       }
     else
       {
@@ -578,13 +580,13 @@ public:
 			e->get_bv_size () == rd->get_register_size ()));
     if (extract)
       {
-	out << "(";
+	out += '(';
 	extract_bv_window (e);
       }
-    out << rd->get_label ();
+    out += rd->get_label ();
     if (extract)
       {
-	out << ")";
+	out += ')';
       }
   }
 
@@ -595,55 +597,64 @@ public:
 
 
 void
-smtlib_writer (std::ostream &out, const Expr *ep, const std::string &memvar,
+smtlib_writer (std::string &out, const Expr *ep, const std::string &memvar,
 	       int addrsize, Architecture::endianness_t endian, bool as_boolean)
   throw (SMTLibUnsupportedExpression)
 {
-
-  CountSharedSubFormulas cssf;
+  SharedSubFormulas ssf;
   SMTLibVisitor writer (out, memvar, addrsize, endian);
-  writer.set_cssf (&cssf);
+  writer.set_ssf (&ssf);
 
   Expr *e = ep->ref ();
   exprutils::simplify (&e);
 
-  e->acceptVisitor (cssf);
-  //  if (cssf.display_counters (logs::debug) > 0) {
-    //    ((void) 0);
-    //exprutils::simplify (&e);
-    //  logs::debug << *e << endl;
-  //}
-  cssf.open_context (out, writer);
+  try
+    {
+      e->acceptVisitor (ssf);
+      ssf.open_context (out, writer);
+
+      if (as_boolean)
+	writer.output_boolean (e);
+      else
+	e->acceptVisitor (writer);
+      ssf.close_context (out);
+    }
+  catch (SMTLibUnsupportedExpression &)
+    {
+      e->deref ();
+      throw;
+    }
+  e->deref ();
+}
 
-  if (as_boolean)
-    writer.output_boolean (e);
-  else
-    e->acceptVisitor (writer);
-  cssf.close_context (out);
+void
+smtlib_writer (std::ostream &out, const Expr *e, const std::string &memvar,
+	       int addrsize, Architecture::endianness_t endian, bool as_boolean)
+  throw (SMTLibUnsupportedExpression)
+{
+  string buf;
 
+  smtlib_writer (buf, e, memvar, addrsize, endian, as_boolean);
+  out << buf;
   out.flush ();
-  e->deref ();
 }
 
 void
-CountSharedSubFormulas::open_context (std::ostream &out,
-				      SMTLibVisitor &sw)
+SharedSubFormulas::open_context (std::string &out, ConstExprVisitor &writer)
 {
-  for (Counters::const_iterator i = counters.begin (); i != counters.end ();
-       i++)
-    {
-      if (i->second.counter > 1)
-	shared.push_back (i->first);
-    }
-  shared.sort (*this);
-  for (list<const Expr *>::iterator i = shared.begin (); i != shared.end ();
-       i++)
+  for (size_t i = 0; i < postorder.size (); i++)
     {
-      out << "(let ((";
-      output_shared_symbol (counters[*i], out);
-      out << " ";
-      (*i)->acceptVisitor (sw);
-      out << ")) ";
-      done.insert (*i);
+      const Expr *e = postorder[i];
+      Node &n = nodes[e];
+
+      if (n.nb_parents <= 1)
+	continue;
+      out += "(let ((";
+      output_shared_symbol (n, out);
+      out += ' ';
+      e->acceptVisitor (writer);
+      out += ")) ";
+      n.bound = true;
+      nb_shared++;
     }
 }
@@ -34,6 +34,7 @@
 # include <kernel/Expressions.hh>
 # include <iostream>
 # include <stdexcept>
+# include <string>
 
 class SMTLibUnsupportedExpression : public std::runtime_error
 {
@@ -41,6 +42,14 @@ public:
   SMTLibUnsupportedExpression (std::string msg) : std::runtime_error (msg) { }
 };
 
+/* Appends the SMT-LIB form of 'e' to 'out'; sub-formulas shared in 'e'
+ * are bound by 'let's. A buffer can be reused for several formulas
+ * without being reallocated. */
+extern void
+smtlib_writer (std::string &out, const Expr *e, const std::string &memvar,
+	       int bits_per_addr, Architecture::endianness_t endian,
+	       bool as_boolean)
+  throw (SMTLibUnsupportedExpression);
 
 extern void
 smtlib_writer (std::ostream &out, const Expr *e, const std::string &memvar,
@@ -31,6 +31,7 @@
 #include <kernel/Expressions.hh>
 
 #include <algorithm>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -45,17 +46,37 @@
 #include <cassert>
 #include <cstdio>
 #include <cstring>
+#include <new>
+#include <pthread.h>
 
 using namespace std;
 
-Expr::ExprStore *Expr::expr_store = NULL;
+Expr::StoreShard *Expr::expr_store = NULL;
+size_t Expr::expr_store_nb_shards = 1;
+bool Expr::concurrent_store = false;
 bool Expr::non_empty_store_abort = false;
 const string Expr::NON_EMPTY_STORE_ABORT_PROP =
   "kernel.expr.non-empty-store-abort";
+const string Expr::CONCURRENT_STORE_PROP =
+  "kernel.expr.concurrent-store";
+const string Expr::STORE_SHARDS_PROP =
+  "kernel.expr.concurrent-store.nb-shards";
+
+/*! \brief A part of the store of expressions. An expression always goes
+ *  to the shard selected by its hash value; the lock is used only if the
+ *  store is concurrent. */
+struct Expr::StoreShard {
+  pthread_mutex_t lock;
+  ExprStore exprs;
+
+  StoreShard () : exprs (100) { pthread_mutex_init (&lock, NULL); }
+  ~StoreShard () { pthread_mutex_destroy (&lock); }
+};
 
 
 Expr::Expr(int bv_offset, int bv_size)
-  : bv_offset(bv_offset), bv_size(bv_size), refcount(0)
+  : bv_offset(bv_offset), bv_size(bv_size), refcount(0), immortal(false),
+    hashvalue(0)
 {
 }
 
@@ -63,6 +84,11 @@ Expr::~Expr()
 {
 }
 
+void
+Expr::release_subterms ()
+{
+}
+
 Expr *
 Expr::createLNot (Expr *arg1)
 {
@@ -267,7 +293,9 @@ Variable::~Variable()
 Variable *
 Variable::create (const std::string &id, size_in_bits_t size)
 {
-  return find_or_add (new Variable (id, size, 0, size));
+  Variable key (id, size, 0, size);
+
+  return find_or_add (key);
 }
 
 size_in_bits_t
@@ -296,10 +324,75 @@ Constant::Constant (constant_t v, int bv_offset, int bv_size)
   val = (constant_t) v;
 }
 
+Constant **Constant::small_constants = NULL;
+
+int
+Constant::small_constant_size_index (int bv_size)
+{
+  switch (bv_size)
+    {
+    case 1: return 0;
+    case 8: return 1;
+    case 16: return 2;
+    case 32: return 3;
+    case 64: return 4;
+    }
+  return -1;
+}
+
+void
+Constant::init_small_constants ()
+{
+  static const int sizes[NB_SMALL_CONSTANT_SIZES] = { 1, 8, 16, 32, 64 };
+
+  assert (small_constants == NULL);
+  small_constants = new Constant *[NB_SMALL_CONSTANT_SIZES *
+				   NB_SMALL_CONSTANTS];
+  for (int i = 0; i < NB_SMALL_CONSTANT_SIZES; i++)
+    {
+      assert (small_constant_size_index (sizes[i]) == i);
+      for (constant_t v = SMALL_CONSTANT_MIN; v <= SMALL_CONSTANT_MAX; v++)
+	{
+	  Constant key (v, 0, sizes[i]);
+	  Constant *c = find_or_add (key);
+
+	  c->set_immortal (true);
+	  small_constants[i * NB_SMALL_CONSTANTS + v - SMALL_CONSTANT_MIN] = c;
+	}
+    }
+}
+
+void
+Constant::terminate_small_constants ()
+{
+  if (small_constants == NULL)
+    return;
+
+  for (int i = 0; i < NB_SMALL_CONSTANT_SIZES * NB_SMALL_CONSTANTS; i++)
+    {
+      small_constants[i]->set_immortal (false);
+      small_constants[i]->deref ();
+    }
+  delete[] small_constants;
+  small_constants = NULL;
+}
+
 Constant *
 Constant::create (constant_t v, int bv_offset, int bv_size)
 {
-  return find_or_add (new Constant (v, bv_offset, bv_size));
+  if (bv_offset == 0 && small_constants != NULL &&
+      SMALL_CONSTANT_MIN <= v && v <= SMALL_CONSTANT_MAX)
+    {
+      int index = small_constant_size_index (bv_size);
+
+      if (index >= 0)
+	return small_constants[index * NB_SMALL_CONSTANTS + v -
+			       SMALL_CONSTANT_MIN];
+    }
+
+  Constant key (v, bv_offset, bv_size);
+
+  return find_or_add (key);
 }
 
 Constant::~Constant()
@@ -341,14 +434,17 @@ UnaryApp::create (UnaryOp op, Expr *arg1)
 UnaryApp *
 UnaryApp::create (UnaryOp op, Expr *arg1, int bv_offset, int bv_size)
 {
-  UnaryApp *tmp = new UnaryApp (op, arg1, bv_offset, bv_size);
-
-  tmp = find_or_add (tmp);
+  UnaryApp key (op, arg1, bv_offset, bv_size);
 
-  return tmp;
+  return find_or_add (key);
 }
 
 UnaryApp::~UnaryApp()
+{
+}
+
+void
+UnaryApp::release_subterms ()
 {
   arg1->deref ();
 }
@@ -404,7 +500,9 @@ BinaryApp::create (BinaryOp op, Expr *arg1, Expr *arg2, int bv_offset,
            op == BV_OP_NEQ )    ||
           arg1->get_bv_size () == arg2->get_bv_size ());
 
-  return find_or_add (new BinaryApp (op, arg1, arg2, bv_offset, bv_size));
+  BinaryApp key (op, arg1, arg2, bv_offset, bv_size);
+
+  return find_or_add (key);
 }
 
 BinaryApp *
@@ -417,6 +515,11 @@ BinaryApp::create (BinaryOp op, Expr *arg1, int arg2,  int bv_offset,
 }
 
 BinaryApp::~BinaryApp()
+{
+}
+
+void
+BinaryApp::release_subterms ()
 {
   arg1->deref ();
   arg2->deref ();
@@ -467,8 +570,9 @@ TernaryApp::create (TernaryOp op, Expr *arg1, Expr *arg2, Expr *arg3,
 		    int bv_offset, int bv_size)
 {
   //XXX: need to check bitvectors size here
-  return find_or_add (new TernaryApp (op, arg1, arg2, arg3, bv_offset,
-				      bv_size));
+  TernaryApp key (op, arg1, arg2, arg3, bv_offset, bv_size);
+
+  return find_or_add (key);
 }
 
 TernaryOp
@@ -505,6 +609,11 @@ TernaryApp::change_bit_vector (int new_bv_offset, int new_bv_size) const
 }
 
 TernaryApp::~TernaryApp()
+{
+}
+
+void
+TernaryApp::release_subterms ()
 {
   arg1->deref ();
   arg2->deref ();
@@ -520,6 +629,11 @@ QuantifiedExpr::QuantifiedExpr (bool exists_, Variable *var_, Expr *body_)
 }
 
 QuantifiedExpr::~QuantifiedExpr()
+{
+}
+
+void
+QuantifiedExpr::release_subterms ()
 {
   var->deref ();
   body->deref ();
@@ -555,7 +669,9 @@ QuantifiedExpr::change_bit_vector (int new_bv_offset, int new_bv_size) const
 QuantifiedExpr *
 QuantifiedExpr::create (bool exists, Variable *var, Expr *body)
 {
-  return find_or_add (new QuantifiedExpr (exists, var, body));
+  QuantifiedExpr key (exists, var, body);
+
+  return find_or_add (key);
 }
 
 QuantifiedExpr *
@@ -587,7 +703,9 @@ MemCell::MemCell(Expr *addr, Tag tag, int bv_offset, int bv_size)
 MemCell *
 MemCell::create (Expr *addr, Tag tag, int bv_offset, int bv_size)
 {
-  return find_or_add (new MemCell (addr, tag, bv_offset, bv_size));
+  MemCell key (addr, tag, bv_offset, bv_size);
+
+  return find_or_add (key);
 }
 
 MemCell *
@@ -597,6 +715,11 @@ MemCell::create (Expr *addr, int bv_offset, int bv_size)
 }
 
 MemCell::~MemCell()
+{
+}
+
+void
+MemCell::release_subterms ()
 {
   addr->deref ();
 }
@@ -640,9 +763,9 @@ RegisterExpr::create (const RegisterDesc *reg)
 RegisterExpr *
 RegisterExpr::create (const RegisterDesc *reg, int bv_offset, int bv_size)
 {
-  RegisterExpr *tmp = new RegisterExpr (reg, bv_offset, bv_size);
+  RegisterExpr key (reg, bv_offset, bv_size);
 
-  return find_or_add(tmp);
+  return find_or_add (key);
 }
 
 const RegisterDesc *
@@ -1035,65 +1158,71 @@ bool QuantifiedExpr::equal (const Expr *F) const
 /*****************************************************************************/
 size_t
 Expr::hash () const
+{
+  return hashvalue;
+}
+
+size_t
+Expr::compute_hash () const
 {
   return 23 * bv_offset + 47 * bv_size;
 }
 
 size_t
-Variable::hash () const
+Variable::compute_hash () const
 {
-  return (13 * this->Expr::hash() + 51 * std::hash<string>()(id) +
+  return (13 * this->Expr::compute_hash() + 51 * std::hash<string>()(id) +
 	  73 * size);
 }
 
 size_t
-RandomValue::hash () const
+RandomValue::compute_hash () const
 {
-  return this->Expr::hash ();
+  return this->Expr::compute_hash ();
 }
 
 size_t
-Constant::hash () const
+Constant::compute_hash () const
 {
-  return 13 * this->Expr::hash() + 51 * val;
+  return 13 * this->Expr::compute_hash() + 51 * val;
 }
 
 size_t
-UnaryApp::hash () const
+UnaryApp::compute_hash () const
 {
-  return 13 * this->Expr::hash() + 51 * op + 73 * arg1->hash ();
+  return 13 * this->Expr::compute_hash() + 51 * op + 73 * arg1->hash ();
 }
 
 size_t
-BinaryApp::hash () const
+BinaryApp::compute_hash () const
 {
-  return (13 * this->Expr::hash() + 51 * op + 73 * arg1->hash () +
+  return (13 * this->Expr::compute_hash() + 51 * op + 73 * arg1->hash () +
 	  119 * arg2->hash ());
 }
 
 size_t
-TernaryApp::hash () const
+TernaryApp::compute_hash () const
 {
   //XXX: check here again
-  return (13 * this->Expr::hash() + 51 * op + 73 * arg1->hash () +
+  return (13 * this->Expr::compute_hash() + 51 * op + 73 * arg1->hash () +
 	  119 * arg2->hash () +  227 * arg3->hash ());
 }
 
 size_t
-MemCell::hash () const
+MemCell::compute_hash () const
 {
-  return (13 * this->Expr::hash() + 19 * std::hash<string>()(tag) +
+  return (13 * this->Expr::compute_hash() + 19 * std::hash<string>()(tag) +
 	  111 * addr->hash ());
 }
 
 size_t
-RegisterExpr::hash () const
+RegisterExpr::compute_hash () const
 {
-  return 13 * this->Expr::hash() + regdesc->hashcode ();
+  return 13 * this->Expr::compute_hash() + regdesc->hashcode ();
 }
 
 size_t
-QuantifiedExpr::hash () const
+QuantifiedExpr::compute_hash () const
 {
   return (exists ? 111 :149) * var->hash () + body->hash ();
 }
@@ -1238,8 +1367,26 @@ Expr::init (const ConfigTable &cfg)
 {
   non_empty_store_abort =
     cfg.get_boolean (NON_EMPTY_STORE_ABORT_PROP, false);
+  concurrent_store = cfg.get_boolean (CONCURRENT_STORE_PROP, false);
+  expr_store_nb_shards = 1;
+  if (concurrent_store)
+    {
+      long nb_shards = cfg.get_integer (STORE_SHARDS_PROP, 64);
+      if (nb_shards > 1)
+	expr_store_nb_shards = nb_shards;
+    }
 
-  expr_store = new ExprStore (100);
+  expr_store = new StoreShard[expr_store_nb_shards];
+  ExprAllocation<Variable>::allocator.set_thread_safe (concurrent_store);
+  ExprAllocation<Constant>::allocator.set_thread_safe (concurrent_store);
+  ExprAllocation<RandomValue>::allocator.set_thread_safe (concurrent_store);
+  ExprAllocation<UnaryApp>::allocator.set_thread_safe (concurrent_store);
+  ExprAllocation<BinaryApp>::allocator.set_thread_safe (concurrent_store);
+  ExprAllocation<TernaryApp>::allocator.set_thread_safe (concurrent_store);
+  ExprAllocation<QuantifiedExpr>::allocator.set_thread_safe (concurrent_store);
+  ExprAllocation<MemCell>::allocator.set_thread_safe (concurrent_store);
+  ExprAllocation<RegisterExpr>::allocator.set_thread_safe (concurrent_store);
+  Constant::init_small_constants ();
   ExprSolver::init (cfg);
 }
 
@@ -1249,29 +1396,90 @@ Expr::terminate ()
   ExprSolver::terminate ();
   if (Expr::expr_store == NULL)
     return;
-  bool abortion = (Expr::expr_store->size () > 0) && non_empty_store_abort;
-  if (Expr::expr_store->size () > 0)
+  Constant::terminate_small_constants ();
+  size_t size = store_size ();
+  bool abortion = (size > 0) && non_empty_store_abort;
+  if (size > 0)
     {
       logs::error << "**** some exprs have not been deleted:" << endl;
       dumpStore ();
     }
-  delete Expr::expr_store;
+  delete[] Expr::expr_store;
   Expr::expr_store = NULL;
   if (abortion)
     abort ();
 }
 
+template<typename C> static void
+s_dump_class_stats (std::ostream &out, const char *name)
+{
+  const SlabAllocator &A = ExprAllocation<C>::allocator;
+  const ExprStoreCounters &c = ExprAllocation<C>::counters;
+
+  out << left << setw (16) << name << right
+      << setw (10) << A.get_nb_live_objects ()
+      << setw (14) << A.get_nb_live_objects () * A.get_object_size ()
+      << setw (14) << A.get_nb_reserved_bytes ()
+      << setw (12) << c.nb_lookups
+      << setw (12) << c.nb_hits;
+  if (c.nb_lookups > 0)
+    out << setw (9) << fixed << setprecision (1)
+	<< (100.0 * c.nb_hits / c.nb_lookups) << "%";
+  else
+    out << setw (10) << "-";
+  out << endl;
+}
+
+void
+Expr::dump_store_stats (std::ostream &out)
+{
+  out << left << setw (16) << "class" << right
+      << setw (10) << "live"
+      << setw (14) << "bytes"
+      << setw (14) << "reserved"
+      << setw (12) << "lookups"
+      << setw (12) << "hits"
+      << setw (10) << "hit ratio" << endl;
+  s_dump_class_stats<Variable> (out, "Variable");
+  s_dump_class_stats<Constant> (out, "Constant");
+  s_dump_class_stats<RandomValue> (out, "RandomValue");
+  s_dump_class_stats<UnaryApp> (out, "UnaryApp");
+  s_dump_class_stats<BinaryApp> (out, "BinaryApp");
+  s_dump_class_stats<TernaryApp> (out, "TernaryApp");
+  s_dump_class_stats<QuantifiedExpr> (out, "QuantifiedExpr");
+  s_dump_class_stats<MemCell> (out, "MemCell");
+  s_dump_class_stats<RegisterExpr> (out, "RegisterExpr");
+  if (expr_store != NULL)
+    out << "store: " << store_size () << " exprs in "
+	<< expr_store_nb_shards << " shard(s)" << endl;
+}
+
+size_t
+Expr::store_size ()
+{
+  size_t result = 0;
+
+  for (size_t s = 0; s < expr_store_nb_shards; s++)
+    result += expr_store[s].exprs.size ();
+
+  return result;
+}
+
 void
 Expr::dumpStore ()
 {
-  int nb = Expr::expr_store->size ();
-  ExprStore::iterator i = Expr::expr_store->begin ();
-  ExprStore::iterator end = Expr::expr_store->end ();
-  for (; i != end; i++, nb--)
+  for (size_t s = 0; s < expr_store_nb_shards; s++)
     {
-      assert (nb > 0);
-      logs::error << *i << ": "
-		 << *(*i) << " [refcount =" << (*i)->refcount << "]" << endl;
+      int nb = Expr::expr_store[s].exprs.size ();
+      ExprStore::iterator i = Expr::expr_store[s].exprs.begin ();
+      ExprStore::iterator end = Expr::expr_store[s].exprs.end ();
+      for (; i != end; i++, nb--)
+	{
+	  assert (nb > 0);
+	  logs::error << *i << ": "
+		      << *(*i) << " [refcount =" << (*i)->refcount << "]"
+		      << endl;
+	}
     }
 }
 
@@ -1288,52 +1496,161 @@ Expr::Hash::operator()(const Expr *const &F) const
 bool
 Expr::Equal::operator()(const Expr *const &F1, const Expr * const &F2) const
 {
-  return F1->equal (F2);
+  return F1->hash () == F2->hash () && F1->equal (F2);
+}
+
+Expr::StoreShard *
+Expr::get_shard (const Expr *F)
+{
+  return &expr_store[F->hash () % expr_store_nb_shards];
+}
+
+bool
+Expr::has_concurrent_store ()
+{
+  return concurrent_store;
+}
+
+bool
+Expr::is_immortal () const
+{
+  return immortal;
+}
+
+void
+Expr::set_immortal (bool value)
+{
+  assert (refcount == 1);
+  assert (immortal != value);
+  immortal = value;
 }
 
 Expr *
 Expr::ref () const
 {
-  assert (refcount > 0);
+  if (immortal)
+    return (Expr *) this;
 
-  refcount++;
+  if (concurrent_store)
+    __sync_fetch_and_add (&refcount, 1);
+  else
+    {
+      assert (refcount > 0);
+      refcount++;
+    }
   return (Expr *) this;
 }
 
 void
 Expr::deref ()
 {
-  assert (refcount > 0);
-  refcount--;
-  if (refcount == 0)
+  if (immortal)
+    return;
+  if (! concurrent_store)
     {
-      assert (expr_store->find (this) != expr_store->end ());
-      expr_store->erase (this);
-
-      delete this;
+      assert (refcount > 0);
+      refcount--;
+      if (refcount > 0)
+	return;
+      assert (expr_store->exprs.find (this) != expr_store->exprs.end ());
+      expr_store->exprs.erase (this);
     }
+  else
+    {
+      /* As long as we are not the last owner, the counter can be
+       * decremented without taking the lock. The counter is only read
+       * by the compare-and-swap, starting from a guess. */
+      int rc = 2;
+      for (;;)
+	{
+	  int old = __sync_val_compare_and_swap (&refcount, rc, rc - 1);
+	  if (old == rc)
+	    return;
+	  assert (old > 0);
+	  if (old == 1)
+	    break;
+	  rc = old;
+	}
+
+      /* The counter may only reach 0 under the lock of the shard; this
+       * prevents another thread from getting this expression from the
+       * store while it is being removed. */
+      StoreShard *shard = get_shard (this);
+      pthread_mutex_lock (&shard->lock);
+      bool last = (__sync_sub_and_fetch (&refcount, 1) == 0);
+      if (last)
+	shard->exprs.erase (this);
+      pthread_mutex_unlock (&shard->lock);
+      if (! last)
+	return;
+    }
+
+  /* Sub-terms are released out of the lock. */
+  release_subterms ();
+  delete this;
 }
 
 Expr *
-Expr::find_or_add_expr (Expr *F)
+Expr::find_or_add_expr (Expr &key, Expr *(*materialize) (const Expr &key),
+			ExprStoreCounters &counters)
 {
-  ExprStore::iterator i = expr_store->find (F);
-  assert (F->refcount == 0);
+  assert (key.refcount == 0);
+  key.hashvalue = key.compute_hash ();
+
+  Expr *result = NULL;
+  StoreShard *shard = get_shard (&key);
 
-  if (i == expr_store->end ())
+  if (concurrent_store)
     {
-      expr_store->insert (F);
-      F->refcount = 1;
+      pthread_mutex_lock (&shard->lock);
+      __sync_fetch_and_add (&counters.nb_lookups, 1);
     }
   else
+    counters.nb_lookups++;
+
+  ExprStore::iterator i = shard->exprs.find (&key);
+  bool found = (i != shard->exprs.end ());
+
+  if (found)
     {
-      if (F != *i)
-	delete F;
-      F = *i;
-      F->ref ();
+      result = *i;
+      if (concurrent_store)
+	{
+	  if (! result->immortal)
+	    __sync_fetch_and_add (&result->refcount, 1);
+	  __sync_fetch_and_add (&counters.nb_hits, 1);
+	}
+      else
+	{
+	  if (! result->immortal)
+	    result->refcount++;
+	  counters.nb_hits++;
+	}
     }
+  else
+    {
+      try
+	{
+	  result = materialize (key);
+	}
+      catch (std::bad_alloc &)
+	{
+	  if (concurrent_store)
+	    pthread_mutex_unlock (&shard->lock);
+	  throw;
+	}
+      result->refcount = 1;
+      shard->exprs.insert (result);
+    }
+
+  if (concurrent_store)
+    pthread_mutex_unlock (&shard->lock);
 
-  return F;
+  /* The node in the store holds its own references to the sub-terms. */
+  if (found)
+    key.release_subterms ();
+
+  return result;
 }
 
 
@@ -1351,18 +1668,13 @@ RandomValue::change_bit_vector (int new_bv_offset, int new_bv_size) const
 {
   assert (new_bv_offset == 0);
 
-  return new RandomValue (new_bv_size);
+  return RandomValue::create (new_bv_size);
 }
 
 RandomValue *
 RandomValue::create (int bv_size)
 {
-  RandomValue *tmp = new RandomValue (bv_size);
-
-  return find_or_add(tmp);
+  RandomValue key (bv_size);
 
+  return find_or_add (key);
 }
-
-
-
-
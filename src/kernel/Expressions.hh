@@ -30,12 +30,14 @@
 #ifndef KERNEL_EXPRESSIONS_HH
 #define KERNEL_EXPRESSIONS_HH
 
+#include <cassert>
 #include <string>
 
 #include <kernel/microcode/MicrocodeArchitecture.hh>
 #include <kernel/expressions/Operators.hh>
 #include <utils/Option.hh>
 #include <utils/ConfigTable.hh>
+#include <utils/SlabAllocator.hh>
 #include <utils/unordered11.hh>
 
 class ExprVisitor;
@@ -58,6 +60,47 @@ class QuantifiedExpr;   // --> LValue
 // class BitIntLVal; // --> LValue (template)
 /*****************************************************************************/
 
+/*****************************************************************************/
+/*! \brief Counters of the lookups of expressions in the store. */
+struct ExprStoreCounters {
+  unsigned long nb_lookups;
+  unsigned long nb_hits;
+};
+
+/*! \brief
+ *  Allocation of the nodes of the class C of expressions.
+ *
+ *  Each concrete class of expressions inherits this class. Its nodes are
+ *  then taken from a slab allocator dedicated to C; materialize() copies a
+ *  key built on the stack into a new node once the store has been probed
+ *  without success.
+ *****************************************************************************/
+template<typename C>
+class ExprAllocation {
+public:
+  static void *operator new (size_t size) {
+    assert (size <= allocator.get_object_size ());
+    return allocator.allocate ();
+  }
+
+  static void operator delete (void *ptr) {
+    allocator.release (ptr);
+  }
+
+  static Expr *materialize (const Expr &key) {
+    return new C (static_cast<const C &> (key));
+  }
+
+  static SlabAllocator allocator;
+  static ExprStoreCounters counters;
+};
+
+template<typename C>
+SlabAllocator ExprAllocation<C>::allocator (sizeof (C));
+
+template<typename C>
+ExprStoreCounters ExprAllocation<C>::counters = { 0, 0 };
+
 /*****************************************************************************/
 /*! \brief
  *  The class Expr (for Expression) is the main entry point for defining
@@ -105,15 +148,36 @@ protected:
 public:
   static const std::string NON_EMPTY_STORE_ABORT_PROP;
 
+  /*! \brief If true, the store of expressions is split into shards
+   *  protected by their own lock and reference counters are updated
+   *  atomically. Expressions can then be created and released from
+   *  several threads. */
+  static const std::string CONCURRENT_STORE_PROP;
+
+  /*! \brief Number of shards of the concurrent store. */
+  static const std::string STORE_SHARDS_PROP;
+
   static void init (const ConfigTable &cfg);
   static void terminate ();
 
+  /*! \brief True if the store has been initialized in concurrent mode
+   *  (see CONCURRENT_STORE_PROP). */
+  static bool has_concurrent_store ();
+
+  /*! \brief Display, for each class of expressions, the number of live
+   *  nodes, the memory they use and the ratio of lookups that found an
+   *  existing node in the store. */
+  static void dump_store_stats (std::ostream &out);
+
   virtual void acceptVisitor (ExprVisitor &visitor);
   virtual void acceptVisitor (ConstExprVisitor &visitor) const;
   virtual void acceptVisitor (ExprVisitor *visitor) = 0;
   virtual void acceptVisitor (ConstExprVisitor *visitor) const = 0;
 
-  virtual size_t hash () const;
+  /*! \brief The hash value of this expression. It is computed once
+   *  when the expression enters the store (see compute_hash) and then
+   *  simply read back. */
+  size_t hash () const;
   virtual bool equal (const Expr *F) const = 0;
 
   static Expr *createLNot (Expr *arg);
@@ -155,6 +219,11 @@ protected:
   virtual Expr *
   change_bit_vector (int new_bv_offset, int new_bv_size) const = 0;
 
+  /*! \brief Compute the hash value of this node. Sub-terms are already
+   *  in the store, thus only their cached hash values are used and the
+   *  computation does not depend on the size of the term. */
+  virtual size_t compute_hash () const;
+
 public:
   virtual Expr *
   extract_bit_vector (int new_bv_offset, int new_bv_size) const;
@@ -235,24 +304,59 @@ public:
 
   void deref ();
 
+  /*! \brief Immortal expressions stay in the store until
+   *  Expr::terminate (); ref () and deref () do nothing on them. */
+  bool is_immortal () const;
+
 
 protected:
 
-  static Expr *find_or_add_expr (Expr *F);
+  /*! \brief Make this expression immortal (or mortal again). The
+   *  expression must be referenced once, by the caller, and no other
+   *  thread may use the store: the flag is then read without
+   *  synchronization. */
+  void set_immortal (bool value);
+
+  /*! \brief Release the references held by this node on its
+   *  sub-terms. It is called when the node leaves the store or when
+   *  a lookup of the node succeeds (see find_or_add). */
+  virtual void release_subterms ();
+
+  /*! \brief Look for an expression equal to key in the store.
+   *
+   *  key is usually a temporary built on the stack by a create()
+   *  function; it owns the references to its sub-terms. If an equal
+   *  expression already exists, these references are released and the
+   *  existing node is returned; else the node is materialized from key
+   *  (which gives it the references) and inserted in the store. */
+  static Expr *find_or_add_expr (Expr &key,
+				 Expr *(*materialize) (const Expr &key),
+				 ExprStoreCounters &counters);
 
   template<typename C>
-  static C *find_or_add (C *F) {
-    Expr *res = find_or_add_expr (F);
-    return dynamic_cast<C *> (res);
+  static C *find_or_add (C &key) {
+    Expr *res = find_or_add_expr (key, ExprAllocation<C>::materialize,
+				  ExprAllocation<C>::counters);
+    return static_cast<C *> (res);
   }
 
 private:
   typedef std::unordered_set<Expr *, Expr::Hash, Expr::Equal> ExprStore;
+  struct StoreShard;
 
-  static ExprStore *expr_store;
+  static StoreShard *expr_store;
+  static size_t expr_store_nb_shards;
+  static bool concurrent_store;
   static bool non_empty_store_abort;
+  static StoreShard *get_shard (const Expr *F);
+  static size_t store_size ();
   static void dumpStore ();
+
+  /* Written atomically when the store is concurrent */
   mutable int refcount;
+  /* The reference held by the store is kept while immortal */
+  bool immortal;
+  size_t hashvalue;
 };
 
 /***************************************************************************/
@@ -264,7 +368,8 @@ private:
  *  a leaf defined by an identifier (a string). They can be used to define
  *  parameters of some piece of code for instance, or of a logical expr.
  ***************************************************************************/
-class Variable : public Expr {
+class Variable :
+  public Expr, public ExprAllocation<Variable> {
 private:
   /*! A Variable is defined by a string identifier */
   std::string id;
@@ -277,6 +382,7 @@ private:
 
 protected:
   virtual Expr *change_bit_vector (int new_bv_offset, int new_bv_size) const;
+  virtual size_t compute_hash () const;
 
 public:
   static Variable *create (const std::string &id, size_in_bits_t size);
@@ -287,7 +393,6 @@ public:
 
   /*! \brief syntactic equality of variables */
   virtual bool equal (const Expr *F) const;
-  virtual size_t hash () const;
   virtual bool has_type_of (const Expr *F) const;
 
   bool operator<(const Variable &other) const;  /* needed for using variables as key of maps */
@@ -302,15 +407,36 @@ public:
 /*! \brief
  *  Encoding of concrete word values.
  ***************************************************************************/
-class Constant : public Expr {
+class Constant :
+  public Expr, public ExprAllocation<Constant> {
 private:
+  friend class Expr;
+
   constant_t val;
 
   Constant(constant_t v, int bv_offset, int bv_size);
   virtual ~Constant();
 
+  /*! \brief Bounds of the values of the constants that are allocated
+   *  once for all by Expr::init () for the usual bit-vector sizes (1,
+   *  8, 16, 32 and 64 bits). These constants are never removed from
+   *  the store and create () returns them without looking up the store
+   *  nor updating their reference counter. */
+  static const constant_t SMALL_CONSTANT_MIN = -256;
+  static const constant_t SMALL_CONSTANT_MAX = 256;
+  static const int NB_SMALL_CONSTANT_SIZES = 5;
+  static const int NB_SMALL_CONSTANTS =
+    SMALL_CONSTANT_MAX - SMALL_CONSTANT_MIN + 1;
+
+  static Constant **small_constants;
+
+  static int small_constant_size_index (int bv_size);
+  static void init_small_constants ();
+  static void terminate_small_constants ();
+
 protected:
   virtual Expr *change_bit_vector (int new_bv_offset, int new_bv_size) const;
+  virtual size_t compute_hash () const;
 
 public:
 
@@ -327,7 +453,6 @@ public:
 
   /*! \brief syntactic equality of registers */
   virtual bool equal (const Expr *F) const;
-  virtual size_t hash () const;
   virtual bool has_type_of (const Expr *F) const;
 
   bool contains(const Expr *o) const;
@@ -337,20 +462,21 @@ public:
   virtual void acceptVisitor (ConstExprVisitor *visitor) const;
 };
 
-class RandomValue : public Expr {
+class RandomValue :
+  public Expr, public ExprAllocation<RandomValue> {
 private:
   RandomValue (int bv_size);
   virtual ~RandomValue();
 
 protected:
   virtual Expr *change_bit_vector (int new_bv_offset, int new_bv_size) const;
+  virtual size_t compute_hash () const;
 
 public:
   static RandomValue *create (int bv_size);
 
   /*! \brief syntaxic equality of registers */
   virtual bool equal (const Expr *F) const;
-  virtual size_t hash () const;
   virtual bool has_type_of (const Expr *F) const;
 
   bool contains(const Expr *o) const;
@@ -365,7 +491,8 @@ public:
  *  Application of a unary operator to an expression.
  *  Operators are defined in kernel/expressions/Operators.hh
  ***************************************************************************/
-class UnaryApp : public Expr {
+class UnaryApp :
+  public Expr, public ExprAllocation<UnaryApp> {
 private:
   /*! \brief The operator */
   UnaryOp op;
@@ -382,6 +509,8 @@ private:
 
 protected:
   virtual Expr *change_bit_vector (int new_bv_offset, int new_bv_size) const;
+  virtual size_t compute_hash () const;
+  virtual void release_subterms ();
 
 public:
   static UnaryApp *create (UnaryOp op, Expr *arg1);
@@ -393,7 +522,6 @@ public:
 
   /*! \brief syntaxic equality of registers */
   virtual bool equal (const Expr *F) const;
-  virtual size_t hash () const;
   virtual bool has_type_of (const Expr *F) const;
 
   bool contains(const Expr *o) const;
@@ -408,7 +536,8 @@ public:
  *  Application of a binary operator to an expression.
  *  Operators are defined in kernel/expressions/Operators.hh
  ***************************************************************************/
-class BinaryApp : public Expr {
+class BinaryApp :
+  public Expr, public ExprAllocation<BinaryApp> {
 private:
   /*! \brief The applied operator */
   BinaryOp op;
@@ -427,6 +556,8 @@ private:
 
 protected:
   virtual Expr *change_bit_vector (int new_bv_offset, int new_bv_size) const;
+  virtual size_t compute_hash () const;
+  virtual void release_subterms ();
 
 public:
   static BinaryApp *create (BinaryOp op, Expr *arg1, Expr *arg2);
@@ -444,7 +575,6 @@ public:
 
   /*! \brief syntaxic equality of registers */
   virtual bool equal (const Expr *F) const;
-  virtual size_t hash () const;
   virtual bool has_type_of (const Expr *F) const;
 
   bool contains(const Expr *o) const;
@@ -455,7 +585,8 @@ public:
 };
 
 /****************************************************************************/
-class TernaryApp: public Expr {
+class TernaryApp :
+  public Expr, public ExprAllocation<TernaryApp> {
 
 private:
   TernaryOp op;
@@ -468,6 +599,8 @@ private:
 
 protected:
   virtual Expr *change_bit_vector (int new_bv_offset, int new_bv_size) const;
+  virtual size_t compute_hash () const;
+  virtual void release_subterms ();
 
 public:
   static TernaryApp *create(TernaryOp op,
@@ -482,7 +615,6 @@ public:
   TernaryOp get_op() const;
 
   virtual bool equal(const Expr *F) const;
-  virtual size_t hash() const;
   virtual bool has_type_of(const Expr *F) const;
 
   bool contains(const Expr *o) const;
@@ -492,7 +624,8 @@ public:
   virtual void acceptVisitor (ConstExprVisitor *visitor) const;
 };
 
-class QuantifiedExpr : public Expr {
+class QuantifiedExpr :
+  public Expr, public ExprAllocation<QuantifiedExpr> {
 private:
   bool exists;
   Variable *var;
@@ -504,6 +637,8 @@ private:
 
 protected:
   virtual Expr *change_bit_vector (int new_bv_offset, int new_bv_size) const;
+  virtual size_t compute_hash () const;
+  virtual void release_subterms ();
 
 public:
   static QuantifiedExpr *create (bool exist, Variable *var, Expr *body);
@@ -517,7 +652,6 @@ public:
 
   /*! \brief syntaxic equality of registers */
   virtual bool equal (const Expr *F) const;
-  virtual size_t hash () const;
   virtual bool has_type_of (const Expr *F) const;
 
   bool contains(const Expr *o) const;
@@ -552,7 +686,8 @@ typedef std::string Tag;
  *  A memory cell is defined by a term indicating the address of the
  *  cell.
  ***************************************************************************/
-class MemCell : public LValue {
+class MemCell :
+  public LValue, public ExprAllocation<MemCell> {
 private:
   /*!\brief The address of the cell. Note that the The effective
    *  transformation of the expression into a real address is in charge
@@ -567,6 +702,8 @@ private:
 
 protected:
   virtual Expr *change_bit_vector (int new_bv_offset, int new_bv_size) const;
+  virtual size_t compute_hash () const;
+  virtual void release_subterms ();
 
 public:
   static MemCell *create (Expr *addr, Tag tag, int bv_offset,
@@ -584,7 +721,6 @@ public:
 
   /*! \brief syntaxic equality of registers */
   virtual bool equal (const Expr *F) const;
-  virtual size_t hash () const;
   virtual bool has_type_of (const Expr *F) const;
 
   bool contains(const Expr *o) const;
@@ -603,7 +739,8 @@ public:
  *
  * \todo replace RegisterExpr by variable and variable by symbol.
  ***************************************************************************/
-class RegisterExpr : public LValue {
+class RegisterExpr :
+  public LValue, public ExprAllocation<RegisterExpr> {
 private:
   const RegisterDesc *regdesc;
 
@@ -613,6 +750,7 @@ private:
 
 protected:
   virtual Expr *change_bit_vector (int new_bv_offset, int new_bv_size) const;
+  virtual size_t compute_hash () const;
 
 public:
 
@@ -625,7 +763,6 @@ public:
 
   /*! \brief syntaxic equality of registers */
   virtual bool equal (const Expr *F) const;
-  virtual size_t hash () const;
   virtual bool has_type_of (const Expr *F) const;
 
   bool contains(const Expr *o) const;
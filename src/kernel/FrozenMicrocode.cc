@@ -0,0 +1,273 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "FrozenMicrocode.hh"
+
+using namespace std;
+
+const size_t FrozenMicrocode::NONE = (size_t) -1;
+
+FrozenMicrocode::FrozenMicrocode (const Microcode *prg) :
+  GraphInterface<MicrocodeNode, StmtArrow, NodeStore> (),
+  prg (prg),
+  entry (NONE),
+  nodes (prg->begin_nodes (), prg->end_nodes ()),
+  ids (),
+  node_ids (),
+  successors_begin (),
+  predecessors_begin (),
+  arrows (),
+  arrow_sources (),
+  arrow_targets (),
+  predecessor_arrows (),
+  predecessor_sources ()
+{
+  size_t nb_nodes = nodes.size ();
+  size_t nb_arrows = 0;
+
+  ids.rehash (nb_nodes);
+  node_ids.rehash (nb_nodes);
+  successors_begin.reserve (nb_nodes + 1);
+  for (size_t n = 0; n < nb_nodes; n++)
+    {
+      ids[nodes[n]->get_loc ()] = n;
+      node_ids[nodes[n]] = n;
+      successors_begin.push_back (nb_arrows);
+      nb_arrows += nodes[n]->get_successors ()->size ();
+    }
+  successors_begin.push_back (nb_arrows);
+  entry = get_id (prg->entry_point ());
+
+  /* Arrows, counting the predecessors of each node */
+  arrows.reserve (nb_arrows);
+  arrow_sources.reserve (nb_arrows);
+  arrow_targets.reserve (nb_arrows);
+  predecessors_begin.assign (nb_nodes + 1, 0);
+  for (size_t n = 0; n < nb_nodes; n++)
+    {
+      MicrocodeNode_iterate_successors (*nodes[n], succ)
+	{
+	  Option<MicrocodeAddress> target = (*succ)->extract_target ();
+	  size_t t = target.hasValue () ? get_id (target.getValue ()) : NONE;
+
+	  arrows.push_back (*succ);
+	  arrow_sources.push_back (n);
+	  arrow_targets.push_back (t);
+	  if (t != NONE)
+	    predecessors_begin[t + 1]++;
+	}
+    }
+
+  /* Predecessor array, filled in the order of the arrows */
+  for (size_t n = 0; n < nb_nodes; n++)
+    predecessors_begin[n + 1] += predecessors_begin[n];
+  predecessor_arrows.resize (predecessors_begin[nb_nodes]);
+  predecessor_sources.resize (predecessors_begin[nb_nodes]);
+
+  vector<size_t> next (predecessors_begin.begin (),
+		       predecessors_begin.end () - 1);
+  for (size_t a = 0; a < nb_arrows; a++)
+    {
+      if (arrow_targets[a] == NONE)
+	continue;
+
+      size_t p = next[arrow_targets[a]]++;
+      predecessor_arrows[p] = a;
+      predecessor_sources[p] = arrow_sources[a];
+    }
+}
+
+FrozenMicrocode::~FrozenMicrocode ()
+{
+}
+
+const Microcode *
+FrozenMicrocode::get_program () const
+{
+  return prg;
+}
+
+size_t
+FrozenMicrocode::get_id (const MicrocodeAddress &addr) const
+{
+  id_map_type::const_iterator it = ids.find (addr);
+
+  if (it == ids.end ())
+    return NONE;
+
+  return it->second;
+}
+
+size_t
+FrozenMicrocode::get_id (const MicrocodeNode *n) const
+{
+  unordered_map<const MicrocodeNode *, size_t>::const_iterator it =
+    node_ids.find (n);
+
+  if (it == node_ids.end ())
+    return NONE;
+
+  return it->second;
+}
+
+FrozenMicrocode::const_node_iterator
+FrozenMicrocode::begin_nodes () const
+{
+  return nodes.begin ();
+}
+
+FrozenMicrocode::const_node_iterator
+FrozenMicrocode::end_nodes () const
+{
+  return nodes.end ();
+}
+
+FrozenMicrocode::node_iterator
+FrozenMicrocode::begin_nodes ()
+{
+  return nodes.begin ();
+}
+
+FrozenMicrocode::node_iterator
+FrozenMicrocode::end_nodes ()
+{
+  return nodes.end ();
+}
+
+MicrocodeNode *
+FrozenMicrocode::get_entry_point () const
+{
+  return entry == NONE ? NULL : nodes[entry];
+}
+
+string
+FrozenMicrocode::get_label_node (MicrocodeNode *n) const
+{
+  return prg->get_label_node (n);
+}
+
+pair<StmtArrow *, MicrocodeNode *>
+FrozenMicrocode::get_successor (size_t a) const
+{
+  MicrocodeNode *tgt = NULL;
+
+  if (arrow_targets[a] != NONE)
+    tgt = nodes[arrow_targets[a]];
+
+  return pair<StmtArrow *, MicrocodeNode *> (arrows[a], tgt);
+}
+
+pair<StmtArrow *, MicrocodeNode *>
+FrozenMicrocode::get_first_successor (MicrocodeNode *n) const
+{
+  size_t id = get_id (n);
+
+  if (id == NONE || successors_begin[id] == successors_begin[id + 1])
+    return pair<StmtArrow *, MicrocodeNode *> (NULL, NULL);
+
+  return get_successor (successors_begin[id]);
+}
+
+pair<StmtArrow *, MicrocodeNode *>
+FrozenMicrocode::get_next_successor (MicrocodeNode *n, StmtArrow *e) const
+{
+  size_t id = get_id (n);
+
+  if (id != NONE)
+    {
+      for (size_t a = successors_begin[id]; a + 1 < successors_begin[id + 1];
+	   a++)
+	{
+	  if (arrows[a] == e)
+	    return get_successor (a + 1);
+	}
+    }
+
+  return pair<StmtArrow *, MicrocodeNode *> (NULL, NULL);
+}
+
+int
+FrozenMicrocode::get_nb_successors (MicrocodeNode *n) const
+{
+  size_t id = get_id (n);
+
+  if (id == NONE)
+    return 0;
+
+  return successors_begin[id + 1] - successors_begin[id];
+}
+
+int
+FrozenMicrocode::get_nb_predecessors (MicrocodeNode *n) const
+{
+  size_t id = get_id (n);
+
+  if (id == NONE)
+    return 0;
+
+  return predecessors_begin[id + 1] - predecessors_begin[id];
+}
+
+pair<StmtArrow *, MicrocodeNode *>
+FrozenMicrocode::get_predecessor (MicrocodeNode *n, int i) const
+{
+  size_t p = predecessors_begin[get_id (n)] + i;
+
+  return pair<StmtArrow *, MicrocodeNode *> (arrows[predecessor_arrows[p]],
+					     nodes[predecessor_sources[p]]);
+}
+
+MicrocodeNode *
+FrozenMicrocode::get_source (StmtArrow *e) const
+{
+  size_t id = get_id (e->get_src ());
+
+  return id == NONE ? NULL : nodes[id];
+}
+
+MicrocodeNode *
+FrozenMicrocode::get_target (StmtArrow *e) const
+{
+  Option<MicrocodeAddress> target = e->extract_target ();
+
+  if (! target.hasValue ())
+    return NULL;
+
+  size_t id = get_id (target.getValue ());
+
+  return id == NONE ? NULL : nodes[id];
+}
+
+void
+FrozenMicrocode::output_text (ostream &out) const
+{
+  for (size_t n = 0; n < nodes.size (); n++)
+    out << n << ": " << nodes[n]->pp () << endl;
+}
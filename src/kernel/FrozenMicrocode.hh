@@ -0,0 +1,182 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef KERNEL_FROZENMICROCODE_HH
+# define KERNEL_FROZENMICROCODE_HH
+
+# include <iostream>
+# include <string>
+# include <vector>
+# include <kernel/Microcode.hh>
+# include <utils/unordered11.hh>
+
+/*! Read-only snapshot of a Microcode program in compressed sparse row
+ *  form, as returned by Microcode::freeze ().
+ *
+ *  Nodes are numbered from 0 in the order of the program. The arrows
+ *  are numbered by source, in the order of the successors of each node,
+ *  so that the arrows leaving node n are those from
+ *  get_successors_begin (n) to get_successors_end (n) - 1. The arrows
+ *  entering n are listed, in increasing order, in positions
+ *  get_predecessors_begin (n) to get_predecessors_end (n) - 1 of the
+ *  predecessor array. The target of an arrow is the node its target
+ *  address resolves to (see Microcode::get_target), or NONE; only
+ *  arrows with a target are predecessors.
+ *
+ *  The snapshot is also a GraphInterface over the nodes and arrows of
+ *  the program, with the same successors, so that the generic
+ *  traversals and visitors run on it. It refers to the nodes and arrows
+ *  of the program, which must not be modified while the snapshot is
+ *  used. */
+class FrozenMicrocode
+  : public GraphInterface<MicrocodeNode, StmtArrow, NodeStore>
+{
+public:
+  /* Identifier of no node */
+  static const std::size_t NONE;
+
+  explicit FrozenMicrocode (const Microcode *prg);
+  virtual ~FrozenMicrocode ();
+
+  const Microcode *get_program () const;
+
+  /* The accessors below are inline: they are the inner loops of the
+   * analyses that run on the snapshot. */
+  inline std::size_t get_number_of_nodes () const {
+    return nodes.size ();
+  }
+
+  inline std::size_t get_number_of_arrows () const {
+    return arrows.size ();
+  }
+
+  inline MicrocodeNode *get_node (std::size_t n) const {
+    return nodes[n];
+  }
+
+  /*! The identifier of the node at addr, or of n, or NONE if there is
+   *  no such node in the snapshot. */
+  std::size_t get_id (const MicrocodeAddress &addr) const;
+  std::size_t get_id (const MicrocodeNode *n) const;
+
+  /*! The identifier of the entry point, or NONE if it has no node. */
+  inline std::size_t get_entry_id () const {
+    return entry;
+  }
+
+  inline std::size_t get_successors_begin (std::size_t n) const {
+    return successors_begin[n];
+  }
+
+  inline std::size_t get_successors_end (std::size_t n) const {
+    return successors_begin[n + 1];
+  }
+
+  inline StmtArrow *get_arrow (std::size_t a) const {
+    return arrows[a];
+  }
+
+  inline std::size_t get_arrow_source (std::size_t a) const {
+    return arrow_sources[a];
+  }
+
+  /*! The target of arrow a, or NONE */
+  inline std::size_t get_arrow_target (std::size_t a) const {
+    return arrow_targets[a];
+  }
+
+  inline std::size_t get_predecessors_begin (std::size_t n) const {
+    return predecessors_begin[n];
+  }
+
+  inline std::size_t get_predecessors_end (std::size_t n) const {
+    return predecessors_begin[n + 1];
+  }
+
+  /*! The arrow at position p of the predecessor array and its source */
+  inline std::size_t get_predecessor_arrow (std::size_t p) const {
+    return predecessor_arrows[p];
+  }
+
+  inline std::size_t get_predecessor_source (std::size_t p) const {
+    return predecessor_sources[p];
+  }
+
+  /* GraphInterface interface (see graph.hh for doc.) */
+  const_node_iterator begin_nodes () const;
+  const_node_iterator end_nodes () const;
+  node_iterator begin_nodes ();
+  node_iterator end_nodes ();
+
+  MicrocodeNode *get_entry_point () const;
+  std::string get_label_node (MicrocodeNode *n) const;
+  std::pair<StmtArrow *, MicrocodeNode *>
+  get_first_successor (MicrocodeNode *n) const;
+  std::pair<StmtArrow *, MicrocodeNode *>
+  get_next_successor (MicrocodeNode *n, StmtArrow *e) const;
+  int get_nb_successors (MicrocodeNode *n) const;
+  int get_nb_predecessors (MicrocodeNode *n) const;
+  std::pair<StmtArrow *, MicrocodeNode *>
+  get_predecessor (MicrocodeNode *n, int i) const;
+  MicrocodeNode *get_source (StmtArrow *e) const;
+  MicrocodeNode *get_target (StmtArrow *e) const;
+
+  void output_text (std::ostream &out) const;
+
+private:
+  typedef std::unordered_map<MicrocodeAddress, std::size_t,
+			     std::hash<MicrocodeAddress>,
+			     EqualsFunctor<MicrocodeAddress> > id_map_type;
+
+  /* The arrow a and its target as a successor */
+  std::pair<StmtArrow *, MicrocodeNode *> get_successor (std::size_t a) const;
+
+  const Microcode *prg;
+  std::size_t entry;
+
+  store_type nodes;
+  id_map_type ids;
+  std::unordered_map<const MicrocodeNode *, std::size_t> node_ids;
+
+  /* Indexed by node, with a last element for the end of the last node */
+  std::vector<std::size_t> successors_begin;
+  std::vector<std::size_t> predecessors_begin;
+
+  /* Indexed by arrow */
+  std::vector<StmtArrow *> arrows;
+  std::vector<std::size_t> arrow_sources;
+  std::vector<std::size_t> arrow_targets;
+
+  /* Indexed by position in the predecessor array */
+  std::vector<std::size_t> predecessor_arrows;
+  std::vector<std::size_t> predecessor_sources;
+};
+
+#endif /* ! KERNEL_FROZENMICROCODE_HH */
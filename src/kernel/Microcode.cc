@@ -29,6 +29,7 @@
  */
 
 #include <kernel/Microcode.hh>
+#include <kernel/FrozenMicrocode.hh>
 
 #include <assert.h>
 #include <map>
@@ -48,6 +49,7 @@ Microcode::Microcode () :
   GraphInterface<MicrocodeNode, StmtArrow, NodeStore> (),
   nodes (),
   opt_nodes (),
+  pending_jumps (),
   start (MicrocodeAddress::null_addr ()),
   arrow_callbacks ()
 {
@@ -58,11 +60,34 @@ Microcode::Microcode (const Microcode &prg) :
   GraphInterface<MicrocodeNode, StmtArrow, NodeStore> (),
   nodes (),
   opt_nodes (),
+  pending_jumps (),
   start (prg.start),
   arrow_callbacks (prg.arrow_callbacks)
 {
   Microcode_iterate_nodes (prg, node)
     add_node (new MicrocodeNode (*(*node)));
+
+  /* Link the copied static arrows to the copied nodes. */
+  Microcode_iterate_nodes (*this, node)
+    {
+      MicrocodeNode_iterate_successors (**node, succ)
+	{
+	  if (! (*succ)->is_static ())
+	    {
+	      index_jump (*succ);
+	      continue;
+	    }
+
+	  StaticArrow *sa = (StaticArrow *) *succ;
+	  MicrocodeNode *tgt = NULL;
+	  if (has_node_at (sa->get_target ()))
+	    {
+	      tgt = get_node (sa->get_target ());
+	      tgt->add_predecessor (sa);
+	    }
+	  sa->set_tgt (tgt);
+	}
+    }
 }
 
 Microcode::~Microcode()
@@ -182,6 +207,7 @@ Microcode::add_jump(MicrocodeAddress beg, Expr *target, Expr *guard)
   if (guard == NULL)
     guard = Constant::True ();
   StmtArrow *a = b->add_successor(guard, target->ref (), new Jump(target));
+  index_jump (a);
   apply_callbacks (a);
 
   return a;
@@ -231,6 +257,9 @@ Microcode::merge (const Microcode *other, address_t shift, bool fold)
   Microcode_iterate_nodes(*other, in)
     address_map[(*in)->get_loc()] = MicrocodeAddress();
 
+  if (address_map.empty ())
+    return;
+
   first_address = address_map.begin()->first;
 
   for (it = address_map.begin(), local = 0;
@@ -289,8 +318,10 @@ Microcode::merge (const Microcode *other, address_t shift, bool fold)
 	      na = newsrc->add_successor (da->get_condition ()->ref (),
 					  da->get_target ()->ref (),
 					  da->get_stmt ()->clone ());
+	      index_jump (na);
 	    }
 	  s_copy_annotations (na, a, shift, fold);
+	  apply_callbacks (na);
 	}
     }
 }
@@ -304,6 +335,12 @@ Microcode::output_text (ostream & out) const
 }
 
 
+FrozenMicrocode *
+Microcode::freeze () const
+{
+  return new FrozenMicrocode (this);
+}
+
 static bool
 microcode_sort_ordering (MicrocodeNode *e1, MicrocodeNode *e2)
 {
@@ -316,77 +353,71 @@ Microcode::sort ()
   std::sort (begin_nodes (), end_nodes (), microcode_sort_ordering);
 }
 
-/*! \brief Produces a (new) static arrow from the current dynamic arrow
- *  by trying to extract the target with extract_target method. */
+/*! \brief Produces a (new) static arrow going to tgt from the current
+ *  dynamic arrow and records it as a predecessor of tgt in place of the
+ *  dynamic one. */
 
-static Option<StaticArrow*>
-make_static (Microcode *mc, DynamicArrow *da)
+static StaticArrow *
+make_static (MicrocodeNode *tgt, DynamicArrow *da)
 {
-  Option<MicrocodeAddress> t = da->extract_target();
+  StaticArrow *static_arrow =
+    new StaticArrow(da->get_src(),
+		    tgt,
+		    da->get_stmt()->clone(),
+		    da->get_annotations(),
+		    da->get_condition()->ref());
+  tgt->remove_predecessor (da);
+  tgt->add_predecessor (static_arrow);
 
-  if (t.hasValue())
-    {
-      MicrocodeNode *tgt = NULL;
-      if (! mc->has_node_at (t.getValue ()))
-	return Option<StaticArrow*>();
-
-      StaticArrow * static_arrow =
-	new StaticArrow(da->get_src(),
-			tgt,
-			da->get_stmt()->clone(),
-			da->get_annotations(),
-			da->get_condition()->ref());
-      return Option<StaticArrow*>(static_arrow);
-    }
-  else
-    return Option<StaticArrow*>();
+  return static_arrow;
 }
 
 void
 Microcode::simplify_and_clean_targets()
 {
-  set<MicrocodeNode *> new_nodes; // temporary list to record nodes to be added.
-
-  Microcode_nodes_pass(node)
+  // Missing nodes are appended to the program as they are found; they
+  // have no successor so that the pass over them is immediate.
+  for (store_type::size_type i = 0; i < nodes.size (); i++)
   {
-    vector<StmtArrow *> * succs = (*node)->get_successors();
-    vector<StmtArrow *>::iterator arr = succs->begin();
+    vector<StmtArrow *> * succs = nodes[i]->get_successors();
+    vector<StmtArrow *>::size_type arr = 0;
 
-    while (arr != succs->end())
+    // New static arrows are moved at the end of the successors; each
+    // of the original arrows is considered once.
+    for (vector<StmtArrow *>::size_type left = succs->size (); left > 0;
+	 left--)
       {
 	// For static arrow, one tests that the target well
-	// exists, if not, one adds it in the new node list.
-	if ((*arr)->is_static()) {
-	  StaticArrow * the_arrow = (StaticArrow *) *arr;
+	// exists, if not, one adds it.
+	if ((*succs)[arr]->is_static()) {
+	  StaticArrow * the_arrow = (StaticArrow *) (*succs)[arr];
 	  MicrocodeAddress addr = the_arrow->get_concrete_target();
 	  if (! has_node_at (addr))
-	    new_nodes.insert(new MicrocodeNode(addr));
+	    {
+	      MicrocodeNode *tgt = get_or_create_node (addr);
+	      the_arrow->set_tgt (tgt);
+	      tgt->add_predecessor (the_arrow);
+	    }
 	}
 	else
 	  {
 	    // For dynamic arrow, one tests if we can get the
 	    // target directly
-	    if ((*arr)->is_dynamic() && ((*arr)->extract_target().hasValue()))
+	    DynamicArrow *old_arrow = (DynamicArrow *) (*succs)[arr];
+	    Option<MicrocodeAddress> t = old_arrow->extract_target();
+	    if (t.hasValue())
 	      {
-		DynamicArrow *old_arrow = (DynamicArrow *) * arr;
 		StaticArrow * static_arrow =
-		  make_static (this, old_arrow).getValue();
+		  make_static (get_or_create_node (t.getValue ()), old_arrow);
 		delete old_arrow;
-		(*succs).erase(arr);
-		succs->push_back(static_arrow);
-		// \todo: adds the target node if it does not
-		// exists (at the moment this is done, but not
-		// optimized !!
-		arr = succs->begin();   // \todo optimisation...
+		succs->erase (succs->begin () + arr);
+		succs->push_back (static_arrow);
+		continue;
 	      }
 	  }
 	arr++;
       }
   }
-
-  for (set<MicrocodeNode *>::iterator new_node = new_nodes.begin();
-       new_node != new_nodes.end(); new_node++)
-    add_node (*new_node );
 }
 
 void
@@ -436,12 +467,12 @@ Microcode::get_next_successor(MicrocodeNode *n, StmtArrow *e) const
   try {
     bool found = false;
     while (it != end && ne == NULL) {
-      if (found && !(**it == *e)) {
+      if (found) {
 	ne = *it;
 	nn = this->get_target(ne);
       }
       else {
-	if (**it == *e)	found = true;
+	if (*it == e)	found = true;
 				*it++;
       }
     }
@@ -456,6 +487,21 @@ Microcode::get_nb_successors(MicrocodeNode *n) const
   return n->get_successors()->size();
 }
 
+int
+Microcode::get_nb_predecessors(MicrocodeNode *n) const
+{
+  if (n->get_predecessors() == NULL)
+    return 0;
+  return n->get_predecessors()->size();
+}
+
+pair<StmtArrow *, MicrocodeNode *>
+Microcode::get_predecessor(MicrocodeNode *n, int i) const
+{
+  StmtArrow *in = (*n->get_predecessors())[i];
+  return pair<StmtArrow *, MicrocodeNode *>(in, in->get_src());
+}
+
 MicrocodeNode *
 Microcode::get_source(StmtArrow *e) const
 {
@@ -516,6 +562,51 @@ void Microcode::add_node (MicrocodeNode *n)
   assert (! has_node_at (n->get_loc ()));
   nodes.push_back(n);
   opt_nodes[n->get_loc ()] = n;
+
+  jump_map_type::iterator j = pending_jumps.find (n->get_loc ());
+  if (j != pending_jumps.end ())
+    {
+      for (vector<StmtArrow *>::size_type i = 0; i < j->second.size (); i++)
+	n->add_predecessor (j->second[i]);
+      pending_jumps.erase (j);
+    }
+}
+
+void
+Microcode::index_jump (StmtArrow *a)
+{
+  Option<MicrocodeAddress> t = a->extract_target ();
+  if (! t.hasValue ())
+    return;
+
+  if (has_node_at (t.getValue ()))
+    get_node (t.getValue ())->add_predecessor (a);
+  else
+    pending_jumps[t.getValue ()].push_back (a);
+}
+
+void
+Microcode::unindex_jump (StmtArrow *a)
+{
+  Option<MicrocodeAddress> t = a->extract_target ();
+  if (! t.hasValue ())
+    return;
+
+  if (has_node_at (t.getValue ()))
+    {
+      get_node (t.getValue ())->remove_predecessor (a);
+      return;
+    }
+
+  jump_map_type::iterator j = pending_jumps.find (t.getValue ());
+  if (j == pending_jumps.end ())
+    return;
+  vector<StmtArrow *>::iterator i =
+    std::find (j->second.begin (), j->second.end (), a);
+  if (i != j->second.end ())
+    j->second.erase (i);
+  if (j->second.empty ())
+    pending_jumps.erase (j);
 }
 
 void
@@ -557,8 +648,10 @@ void Microcode::replace_nodes(MicrocodeNodeSet &to_replace, MicrocodeNode *nvo,
   for (node_iterator it = begin_nodes(); it != end_nodes ();)
     {
       MicrocodeNode *elem = *it;
-      for (StmtArrow *a = this->get_first_successor(elem).first; a != NULL; a = this->get_next_successor(elem, a).first)
+      bool replaced = (to_replace.find(elem) != to_replace.end());
+      MicrocodeNode_iterate_successors(*elem, succ)
         {
+          StmtArrow *a = *succ;
           MicrocodeNode *tgt = this->get_target(a);
           if (tgt != NULL)
             {
@@ -568,12 +661,25 @@ void Microcode::replace_nodes(MicrocodeNodeSet &to_replace, MicrocodeNode *nvo,
                   StaticArrow * sa = (StaticArrow *) a;
                   //Redirect arrows targets
                   sa->set_concrete_target(nvo->get_loc());
+                  if (!replaced)
+                    {
+                      sa->set_tgt(nvo);
+                      nvo->add_predecessor(sa);
+                    }
+                }
+              else if (replaced)
+                {
+                  //Arrows leaving the graph are no more predecessors
+                  tgt->remove_predecessor(a);
                 }
             }
+          else if (replaced && a->is_dynamic())
+            unindex_jump(a);
         }
       //Remove from graph
-      if (to_replace.find(elem) != to_replace.end())
+      if (replaced)
         {
+          opt_nodes.erase(elem->get_loc());
           it = nodes.erase(it);
         }
       else
@@ -587,7 +693,7 @@ void Microcode::replace_nodes(MicrocodeNodeSet &to_replace, MicrocodeNode *nvo,
       delete *it;
     }
   //Add new one
-  nodes.push_back(nvo);
+  add_node(nvo);
 }
 
 /*****************************************************************************/
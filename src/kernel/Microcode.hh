@@ -41,6 +41,7 @@
 
 class MCPath;
 class Expr;
+class FrozenMicrocode;
 
 /*****************************************************************************/
 /*! \brief This class defines the concept of Microcode Program.
@@ -72,6 +73,16 @@ private:
 			     EqualsFunctor<MicrocodeAddress> > node_map_type;
   node_map_type opt_nodes;
 
+  /* Jumps to a constant address whose node does not exist yet; they
+   * become predecessors of the node once it is added. */
+  typedef std::unordered_map<MicrocodeAddress, std::vector<StmtArrow *>,
+			     std::hash<MicrocodeAddress>,
+			     EqualsFunctor<MicrocodeAddress> > jump_map_type;
+  jump_map_type pending_jumps;
+
+  void index_jump (StmtArrow *a);
+  void unindex_jump (StmtArrow *a);
+
   /*! \brief the entry point of the program */
   MicrocodeAddress start;
 
@@ -121,6 +132,8 @@ public:
 
   void add_external(MicrocodeAddress beg, Expr *relation, MicrocodeAddress end);
 
+  /* Copies the nodes and arrows of 'other' into this program; arrow
+   * creation callbacks are applied to the copied arrows. */
   void merge (const Microcode *other, address_t shift, bool fold = false);
 
 /*****************************************************************************/
@@ -135,12 +148,20 @@ public:
   int get_nb_successors(MicrocodeNode *n) const;
   virtual std::string get_label_node(MicrocodeNode *n) const;
 
+  /* The predecessors of a node are the arrows that get_target() resolves
+   * to it, i.e. static arrows and jumps to a constant address; they are
+   * recorded in the node as arrows and nodes are added. */
+  int get_nb_predecessors(MicrocodeNode *n) const;
+  std::pair<StmtArrow *, MicrocodeNode *>
+  get_predecessor(MicrocodeNode *n, int i) const;
+
   /***************************************************************************/
 
   /*! \brief Replace a set of MicrocodeNodes with another
    *  MicrocodeNode. StaticArrows are redirected, while dynamic
    *  ones are not modified, so be careful. The element nvo will not
    *  be modified, i.e no arrow will be added with it as source.
+   *  Redirected arrows become predecessors of nvo.
    *  Replaced MicrocodeNodes are deleted.
    *  \param to_replace set of nodes to replace
    *  \param nvo new MicrocodeNode
@@ -153,6 +174,11 @@ public:
    *  to a set of nodes to another set of node. */
   std::set<MCPath> compute_static_paths(MicrocodeNodeSet origin, MicrocodeNodeSet target);
 
+  /*! \brief Compressed read-only snapshot of the program for the
+   *  analyses that do not modify it (see FrozenMicrocode.hh). The
+   *  caller must delete the snapshot, before modifying the program. */
+  FrozenMicrocode *freeze () const;
+
   /***************************************************************************/
   // Simplification
   /***************************************************************************/
@@ -164,7 +190,9 @@ public:
    * - Transform dynamic targets into static ones when it is given by
    *   a constant expression. This is a good filter to lighten previous
    *   step of construction of Microcode.
-   * - Adds missing node (i.e. the one pointed by static arrow) */
+   * - Adds missing node (i.e. the one pointed by static arrow)
+   * The new static arrows and the arrows targeting added nodes are
+   * recorded as predecessors of their targets. */
   void simplify_and_clean_targets();
 
   /*! Put the program into basic regular form:
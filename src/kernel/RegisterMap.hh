@@ -32,7 +32,7 @@
 #define KERNEL_REGISTERMAP_HH
 
 #include <kernel/Memory.hh>
-#include <utils/unordered11.hh>
+#include <utils/PersistentMap.hh>
 
 /** \brief Templatized class to represent the registers of a program.
  *
@@ -44,9 +44,12 @@ template <typename Value>
 class RegisterMap : public Object
 {
 public:
-  /** \brief Data structure used to encode the register table */
-  typedef std::unordered_map<const RegisterDesc *,
-			     Value, RegisterDesc::Hash > RegisterHashMap;
+  /** \brief Data structure used to encode the register table
+   *
+   * The table is persistent: copies of a RegisterMap share it and a
+   * put() only copies the part of the table that it modifies. */
+  typedef PersistentMap<const RegisterDesc *,
+			Value, RegisterDesc::Hash > RegisterHashMap;
   typedef typename RegisterHashMap::const_iterator const_reg_iterator;
   typedef typename RegisterHashMap::iterator reg_iterator;
 
@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "ExprCachingSolver.hh"
+
+#include <utils/logs.hh>
+
+using namespace std;
+
+ExprCachingSolver::ExprCachingSolver (const MicrocodeArchitecture *mca,
+				      ExprSolver *solver,
+				      std::size_t cache_size)
+  : ExprSolver (mca), solver (solver), cache_size (cache_size), answers (),
+    index (), depth (0), scope (NULL), scopes (), nb_lookups (0),
+    nb_hits (0), nb_subsumptions (0)
+{
+}
+
+ExprCachingSolver::~ExprCachingSolver ()
+{
+  if (debug_traces)
+    trace_lookup ("destruction", "summary");
+  clear ();
+  if (scope != NULL)
+    scope->deref ();
+  for (size_t i = 0; i < scopes.size (); i++)
+    if (scopes[i] != NULL)
+      scopes[i]->deref ();
+  delete solver;
+}
+
+void
+ExprCachingSolver::add_assertion (const Expr *e)
+  throw (UnexpectedResponseException)
+{
+  solver->add_assertion (e);
+  if (depth == 0)
+    clear ();
+  else
+    extend_scope (e);
+}
+
+ExprSolver::Result
+ExprCachingSolver::check_sat (const Expr *e, bool preserve)
+  throw (UnexpectedResponseException)
+{
+  if (! preserve)
+    {
+      Result result = solver->check_sat (e, preserve);
+      if (depth == 0)
+	clear ();
+      else
+	extend_scope (e);
+      return result;
+    }
+
+  nb_lookups++;
+  Expr *q = scoped (e);
+  Answer *a = lookup (QueryKey (q, NULL));
+  if (a != NULL)
+    {
+      nb_hits++;
+      trace_lookup ("check-sat", "hit");
+      q->deref ();
+
+      return a->result;
+    }
+
+  Answer na;
+  na.query = QueryKey (q, NULL);
+  na.complete = false;
+  if (has_unsat_conjunct (e))
+    {
+      nb_hits++;
+      nb_subsumptions++;
+      trace_lookup ("check-sat", "subsumed");
+      na.result = UNSAT;
+    }
+  else
+    {
+      trace_lookup ("check-sat", "miss");
+      try
+	{
+	  na.result = solver->check_sat (e, true);
+	}
+      catch (UnexpectedResponseException &)
+	{
+	  q->deref ();
+	  throw;
+	}
+    }
+  if (na.result != UNKNOWN)
+    store (na);
+  q->deref ();
+
+  return na.result;
+}
+
+ExprSolver::Result
+ExprCachingSolver::check_sat ()
+  throw (UnexpectedResponseException)
+{
+  return solver->check_sat ();
+}
+
+std::vector<constant_t> *
+ExprCachingSolver::evaluate (const Expr *e, const Expr *context,
+			     int nb_values, Result *status)
+  throw (UnexpectedResponseException)
+{
+  if (nb_values <= 0)
+    return solver->evaluate (e, context, nb_values, status);
+
+  nb_lookups++;
+  Expr *ctx = scoped (context);
+  Answer *a = lookup (QueryKey (e, ctx));
+  if (a != NULL && (a->complete || (size_t) nb_values <= a->values.size ()))
+    {
+      nb_hits++;
+      trace_lookup ("evaluate", "hit");
+      size_t n = std::min ((size_t) nb_values, a->values.size ());
+      ctx->deref ();
+      if (status != NULL)
+	*status = (a->complete && n == a->values.size ()) ? UNSAT : SAT;
+
+      return new std::vector<constant_t> (a->values.begin (),
+					  a->values.begin () + n);
+    }
+
+  if (has_unsat_conjunct (context))
+    {
+      nb_hits++;
+      nb_subsumptions++;
+      trace_lookup ("evaluate", "subsumed");
+      ctx->deref ();
+      if (status != NULL)
+	*status = UNSAT;
+
+      return new std::vector<constant_t> ();
+    }
+
+  trace_lookup ("evaluate", "miss");
+  std::vector<constant_t> *result;
+  Result r;
+  try
+    {
+      result = solver->evaluate (e, context, nb_values, &r);
+    }
+  catch (UnexpectedResponseException &)
+    {
+      ctx->deref ();
+      throw;
+    }
+  if (status != NULL)
+    *status = r;
+
+  /* Values found before the solver gave up are not known to be all of
+   * them, nor is an empty enumeration a proof of unsatisfiability. */
+  if (r != UNKNOWN)
+    {
+      Answer na;
+      na.query = QueryKey (e, ctx);
+      na.result = result->empty () ? UNSAT : SAT;
+      na.values = *result;
+      na.complete = (r == UNSAT);
+      store (na);
+
+      if (result->empty ())
+	{
+	  /* The value of 'e' is unconstrained; hence 'context' is UNSAT. */
+	  na.query = QueryKey (ctx, NULL);
+	  store (na);
+	}
+    }
+  ctx->deref ();
+
+  return result;
+}
+
+void
+ExprCachingSolver::push ()
+  throw (UnexpectedResponseException)
+{
+  solver->push ();
+  depth++;
+  scopes.push_back (scope == NULL ? NULL : scope->ref ());
+}
+
+void
+ExprCachingSolver::pop ()
+  throw (UnexpectedResponseException)
+{
+  solver->pop ();
+  depth--;
+  if (scope != NULL)
+    scope->deref ();
+  scope = scopes.back ();
+  scopes.pop_back ();
+}
+
+Constant *
+ExprCachingSolver::get_value_of (const Expr *var)
+  throw (UnexpectedResponseException)
+{
+  return solver->get_value_of (var);
+}
+
+std::size_t
+ExprCachingSolver::get_nb_lookups () const
+{
+  return nb_lookups;
+}
+
+std::size_t
+ExprCachingSolver::get_nb_hits () const
+{
+  return nb_hits;
+}
+
+std::size_t
+ExprCachingSolver::get_nb_subsumptions () const
+{
+  return nb_subsumptions;
+}
+
+/* Returns 'e' conjoined with the assertions made since the base level. */
+Expr *
+ExprCachingSolver::scoped (const Expr *e) const
+{
+  if (scope == NULL)
+    return e->ref ();
+
+  return Expr::createLAnd (scope->ref (), e->ref ());
+}
+
+void
+ExprCachingSolver::extend_scope (const Expr *e)
+{
+  Expr *s = scoped (e);
+  if (scope != NULL)
+    scope->deref ();
+  scope = s;
+}
+
+ExprCachingSolver::Answer *
+ExprCachingSolver::lookup (const QueryKey &q)
+{
+  AnswerMap::iterator i = index.find (q);
+
+  if (i == index.end ())
+    return NULL;
+  answers.splice (answers.begin (), answers, i->second);
+
+  return &answers.front ();
+}
+
+void
+ExprCachingSolver::store (const Answer &a)
+{
+  if (cache_size == 0)
+    return;
+
+  AnswerMap::iterator i = index.find (a.query);
+  if (i != index.end ())
+    {
+      *i->second = a;
+      answers.splice (answers.begin (), answers, i->second);
+      return;
+    }
+
+  a.query.first->ref ();
+  if (a.query.second != NULL)
+    a.query.second->ref ();
+  answers.push_front (a);
+  index[a.query] = answers.begin ();
+
+  if (answers.size () > cache_size)
+    {
+      Answer &last = answers.back ();
+      index.erase (last.query);
+      ((Expr *) last.query.first)->deref ();
+      if (last.query.second != NULL)
+	((Expr *) last.query.second)->deref ();
+      answers.pop_back ();
+    }
+}
+
+/* Looks for a conjunct of 'e' known to be unsatisfiable. */
+bool
+ExprCachingSolver::has_unsat_conjunct (const Expr *e)
+{
+  std::vector<const Expr *> todo (1, e);
+
+  while (! todo.empty ())
+    {
+      const Expr *c = todo.back ();
+      todo.pop_back ();
+
+      if (c != e)
+	{
+	  AnswerMap::const_iterator i = index.find (QueryKey (c, NULL));
+	  if (i != index.end () && i->second->result == UNSAT)
+	    return true;
+	}
+
+      const BinaryApp *b = dynamic_cast<const BinaryApp *> (c);
+      if (b != NULL && b->get_op () == BV_OP_AND && b->get_bv_size () == 1)
+	{
+	  todo.push_back (b->get_arg1 ());
+	  todo.push_back (b->get_arg2 ());
+	}
+    }
+
+  return false;
+}
+
+void
+ExprCachingSolver::clear ()
+{
+  for (AnswerList::iterator a = answers.begin (); a != answers.end (); a++)
+    {
+      ((Expr *) a->query.first)->deref ();
+      if (a->query.second != NULL)
+	((Expr *) a->query.second)->deref ();
+    }
+  answers.clear ();
+  index.clear ();
+}
+
+void
+ExprCachingSolver::trace_lookup (const char *what, const char *outcome) const
+{
+  if (! debug_traces)
+    return;
+
+  logs::debug << std::dec << "solver cache " << outcome << " on " << what << ": "
+	      << nb_hits << "/" << nb_lookups << " hits";
+  if (nb_lookups > 0)
+    logs::debug << " (" << (100 * nb_hits / nb_lookups) << "%)";
+  logs::debug << ", " << nb_subsumptions << " by subsumption, "
+	      << answers.size () << " answers" << endl;
+}
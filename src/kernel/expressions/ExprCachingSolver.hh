@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef KERNEL_EXPRESSIONS_EXPRCACHINGSOLVER_HH
+# define KERNEL_EXPRESSIONS_EXPRCACHINGSOLVER_HH
+
+# include <list>
+# include <vector>
+# include <kernel/expressions/ExprSolver.hh>
+# include <utils/unordered11.hh>
+
+/* Decorator remembering the answers of another solver. Since expressions
+ * are hash-consed, a query is identified by the pointers of its formula
+ * and of its context. A query made under pushed assertions is identified
+ * as the same query conjoined with these assertions, and the cache is
+ * cleared whenever an assertion is added to the base level. At most
+ * 'cache_size' answers are kept, the least recently used ones being
+ * evicted first.
+ *
+ * A formula is also known to be unsatisfiable as soon as one of its
+ * conjuncts is. */
+class ExprCachingSolver : public ExprSolver
+{
+public:
+  ExprCachingSolver (const MicrocodeArchitecture *mca, ExprSolver *solver,
+		     std::size_t cache_size);
+
+  virtual ~ExprCachingSolver ();
+
+  virtual void add_assertion (const Expr *e)
+    throw (UnexpectedResponseException);
+
+  virtual Result check_sat (const Expr *e, bool preserve)
+    throw (UnexpectedResponseException);
+
+  virtual Result check_sat ()
+    throw (UnexpectedResponseException);
+
+  virtual std::vector<constant_t> *
+  evaluate (const Expr *e, const Expr *context, int nb_values,
+	    Result *status = NULL)
+    throw (UnexpectedResponseException);
+
+  virtual void push ()
+    throw (UnexpectedResponseException);
+  virtual void pop ()
+    throw (UnexpectedResponseException);
+  virtual Constant *get_value_of (const Expr *var)
+    throw (UnexpectedResponseException);
+
+  /* Number of queries answered by the cache (among which, by one of
+   * their conjuncts) out of the preserving queries. */
+  std::size_t get_nb_lookups () const;
+  std::size_t get_nb_hits () const;
+  std::size_t get_nb_subsumptions () const;
+
+private:
+  /* The context of a satisfiability query is NULL. */
+  typedef std::pair<const Expr *, const Expr *> QueryKey;
+
+  struct QueryKeyHash {
+    std::size_t operator() (const QueryKey &q) const {
+      return (std::size_t) q.first * 31 + (std::size_t) q.second;
+    }
+  };
+
+  struct Answer {
+    QueryKey query;
+    Result result;
+    /* Values found by evaluate(); 'complete' if there are no others. */
+    std::vector<constant_t> values;
+    bool complete;
+  };
+
+  typedef std::list<Answer> AnswerList;
+  typedef std::unordered_map<QueryKey, AnswerList::iterator,
+			     QueryKeyHash> AnswerMap;
+
+  Expr *scoped (const Expr *e) const;
+  void extend_scope (const Expr *e);
+  Answer *lookup (const QueryKey &q);
+  void store (const Answer &a);
+  bool has_unsat_conjunct (const Expr *e);
+  void clear ();
+  void trace_lookup (const char *what, const char *outcome) const;
+
+  ExprSolver *solver;
+  std::size_t cache_size;
+  /* Most recently used answers first. */
+  AnswerList answers;
+  AnswerMap index;
+  int depth;
+  /* Conjunction of the assertions made since the base level, NULL if
+   * none; one entry per push for the enclosing levels. */
+  Expr *scope;
+  std::vector<Expr *> scopes;
+  std::size_t nb_lookups;
+  std::size_t nb_hits;
+  std::size_t nb_subsumptions;
+};
+
+#endif /* ! KERNEL_EXPRESSIONS_EXPRCACHINGSOLVER_HH */
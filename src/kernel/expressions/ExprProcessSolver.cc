@@ -33,10 +33,10 @@
 #include <io/expressions/smtlib-writer.hh>
 #include <kernel/expressions/exprutils.hh>
 #include <io/expressions/expr-parser.hh>
-#include <utils/FileStreamBuffer.hh>
 #include <utils/logs.hh>
 #include <utils/unordered11.hh>
 
+#include <cerrno>
 #include <csignal>
 #include <cstdio>
 #include <cstring>
@@ -51,8 +51,6 @@ typedef ExprSolver::UnexpectedResponseException UnexpectedResponseException;
 
 #define MEMORY_VAR "MEM"
 
-typedef FileStreamBuffer<char, char_traits<char> > file_buffer;
-
 static const std::string SOLVER_NAME = "process";
 
 static const std::string PROP_PREFIX = "kernel.expr.solver." + SOLVER_NAME;
@@ -125,12 +123,14 @@ s_solver_args ()
 
 static bool
 s_create_pipe (const std::string &cmd, const vector<string> &args,
-	       FILE **rwstreams, pid_t *p_cpid);
+	       int *rwfds, pid_t *p_cpid);
 
 ExprProcessSolver::ExprProcessSolver (const MicrocodeArchitecture *mca,
 				      const string &cmd,
-				      istream *r, ostream *w, pid_t cpid)
-  : ExprSolver (mca), command (cmd), in (r), out (w), childpid (cpid)
+				      int r, int w, pid_t cpid)
+  : ExprSolver (mca), command (cmd), in (r), out (w), childpid (cpid),
+    output (), input (), input_pos (0), nb_bytes_sent (0),
+    global_declarations (false), declared (), scopes ()
 {
 }
 
@@ -139,16 +139,14 @@ ExprProcessSolver::create (const MicrocodeArchitecture *mca)
   throw (UnexpectedResponseException, UnknownSolverException)
 {
   pid_t cpid = 0;
-  FILE *pipestreams[2] = {NULL, NULL};
+  int pipefds[2] = {-1, -1};
   ExprProcessSolver *result = NULL;
   const std::string &cmd = s_solver_command ();
   const std::vector<std::string> &args = s_solver_args ();
 
-  if (s_create_pipe (cmd, args, pipestreams, &cpid))
+  if (s_create_pipe (cmd, args, pipefds, &cpid))
     {
-      istream *i = new istream (new file_buffer (pipestreams[0]));
-      ostream *o = new ostream (new file_buffer (pipestreams[1]));
-      result = new ExprProcessSolver (mca, cmd, i, o, cpid);
+      result = new ExprProcessSolver (mca, cmd, pipefds[0], pipefds[1], cpid);
       try
 	{
 	  if (! result->init ())
@@ -171,10 +169,8 @@ ExprProcessSolver::~ExprProcessSolver ()
 {
   kill (childpid, SIGTERM);
 
-  delete in->rdbuf ();
-  delete out->rdbuf ();
-  delete in;
-  delete out;
+  close (in);
+  close (out);
 }
 
 ExprSolver::Result
@@ -183,26 +179,16 @@ ExprProcessSolver::check_sat (const Expr *e, bool preserve)
 {
   if (debug_traces)
     BEGIN_DBG_BLOCK ("check_sat : " + e->to_string ());
+  std::size_t start = nb_bytes_sent;
+  /* Symbols are declared out of the scope of the query to be kept. */
+  declare_variable (e);
   if (preserve)
     push ();
   ExprSolver::Result result = ExprSolver::UNKNOWN;
 
-  declare_variable (e);
-
-  if (debug_traces)
-    {
-      logs::debug << "(assert ";
-      smtlib_writer (logs::debug, e, MEMORY_VAR,
-		     mca->get_address_size (),
-		     mca->get_endian (), true);
-      logs::debug << ") " << endl;
-    }
-  *out << "(assert ";
-  smtlib_writer (*out, e, MEMORY_VAR, mca->get_address_size (),
-		 mca->get_endian (), true);
-  *out << ") " << endl;
+  append_assertion (e);
 
-  if (read_status ())
+  if (send_output ())
     {
       string res = exec_command ("(check-sat)");
       if (res == "sat")
@@ -220,7 +206,10 @@ ExprProcessSolver::check_sat (const Expr *e, bool preserve)
     pop ();
 
   if (debug_traces)
-    END_DBG_BLOCK ();
+    {
+      logs::debug << (nb_bytes_sent - start) << " bytes sent" << endl;
+      END_DBG_BLOCK ();
+    }
 
   return result;
 }
@@ -229,21 +218,10 @@ void
 ExprProcessSolver::add_assertion (const Expr *e)
   throw (UnexpectedResponseException)
 {
-  if (debug_traces)
-    {
-      logs::debug << "(assert ";
-      smtlib_writer (logs::debug, e, MEMORY_VAR,
-		     mca->get_address_size (),
-		     mca->get_endian (), true);
-      logs::debug << ") " << endl;
-    }
-
-  *out << "(assert ";
-  smtlib_writer (*out, e, MEMORY_VAR, mca->get_address_size (),
-		 mca->get_endian (), true);
-  *out << ") " << endl;
+  declare_variable (e);
+  append_assertion (e);
 
-  if (! read_status ())
+  if (! send_output ())
     throw UnexpectedResponseException ("error while adding assertion" +
 				       e->to_string ());
 }
@@ -282,10 +260,9 @@ ExprProcessSolver::exec_command (const std::string &s)
 string
 ExprProcessSolver::exec_command (const char *s)
 {
-  if (debug_traces)
-    logs::debug << s << endl;
-  *out << s << endl;
-  out->flush ();
+  output += s;
+  output += '\n';
+  flush_output ();
 
   return get_result ();
 }
@@ -293,14 +270,57 @@ ExprProcessSolver::exec_command (const char *s)
 bool
 ExprProcessSolver::send_command (const char *s, bool allow_unsupported)
 {
-  if (debug_traces)
-    logs::debug << s << endl;
-  *out << s << endl;
-  out->flush ();
+  output += s;
+
+  return send_output (allow_unsupported);
+}
+
+bool
+ExprProcessSolver::send_output (bool allow_unsupported)
+{
+  output += '\n';
+  flush_output ();
 
   return read_status (allow_unsupported);
 }
 
+void
+ExprProcessSolver::append_assertion (const Expr *e)
+{
+  output += "(assert ";
+  smtlib_writer (output, e, MEMORY_VAR, mca->get_address_size (),
+		 mca->get_endian (), true);
+  output += ") ";
+}
+
+void
+ExprProcessSolver::flush_output ()
+  throw (UnexpectedResponseException)
+{
+  const char *buf = output.data ();
+  size_t len = output.size ();
+
+  if (debug_traces)
+    logs::debug << output << flush;
+
+  while (len > 0)
+    {
+      ssize_t n = write (out, buf, len);
+      if (n < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  output.clear ();
+	  throw UnexpectedResponseException (string ("write to solver: ") +
+					     strerror (errno));
+	}
+      buf += n;
+      len -= n;
+      nb_bytes_sent += n;
+    }
+  output.clear ();
+}
+
 bool
 ExprProcessSolver::send_command (const std::string &s, bool allow_unsupported)
 {
@@ -311,10 +331,16 @@ bool
 ExprProcessSolver::write_header ()
   throw (UnexpectedResponseException)
 {
-  return (send_command ("(set-option :print-success true) ") &&
-	  send_command ("(set-option :produce-models true) ") &&
-	  send_command ("(set-option :interactive-mode false) ", true) &&
-	  send_command ("(set-logic QF_AUFBV) "));
+  if (! (send_command ("(set-option :print-success true) ") &&
+	 send_command ("(set-option :produce-models true) ") &&
+	 send_command ("(set-option :interactive-mode false) ", true)))
+    return false;
+
+  /* Otherwise, declarations made in a scope are lost when it is popped. */
+  string st = exec_command ("(set-option :global-declarations true) ");
+  global_declarations = (st == "success");
+
+  return send_command ("(set-logic QF_AUFBV) ");
 }
 
 bool
@@ -331,37 +357,65 @@ ExprProcessSolver::read_status (bool allow_unsupported)
   throw UnexpectedResponseException ("read-status: " + st);
 }
 
+static string
+s_bitvector_sort (int bv_size)
+{
+  char buf[32];
+  snprintf (buf, sizeof (buf), "(_ BitVec %d)", bv_size);
+
+  return buf;
+}
+
+bool
+ExprProcessSolver::declare_symbol (const string &id, const string &sort)
+{
+  Declarations::const_iterator i = declared.find (id);
+
+  if (i != declared.end ())
+    {
+      if (i->second == sort)
+	return true;
+      logs::warning << "solver symbol " << id << " already declared as "
+		    << i->second << endl;
+      return false;
+    }
+
+  output += "(declare-fun ";
+  output += id;
+  output += " () ";
+  output += sort;
+  output += ") ";
+  if (! send_output ())
+    return false;
+
+  declared[id] = sort;
+  if (! global_declarations && ! scopes.empty ())
+    scopes.back ().push_back (id);
+
+  return true;
+}
+
 bool
 ExprProcessSolver::declare_variable (const Expr *e)
 {
   typedef unordered_set<const Expr *> ExprSet;
-  {
-    ostringstream oss;
-
-    oss << "(declare-fun " << MEMORY_VAR << " () (Array "
-	<< "(_ BitVec " << mca->get_address_size () << " ) "
-       << "(_ BitVec 8 ) "
-	<< ")) ";
-    if (! send_command (oss.str ()))
-      return false;
-  }
+
+  if (! declare_symbol (MEMORY_VAR, "(Array " +
+			s_bitvector_sort (mca->get_address_size ()) + " " +
+			s_bitvector_sort (8) + ")"))
+    return false;
 
   ExprSet vars = collect_subterms_of_type<ExprSet, Variable> (e, true);
 
   for (ExprSet::const_iterator i = vars.begin (); i != vars.end (); i++)
     {
       const Variable *v = dynamic_cast<const Variable *>(*i);
-      ostringstream oss;
       assert (v != NULL);
-      oss << "(declare-fun " << v->get_id () << " () "
-	  << "(_ BitVec " << v->get_bv_size () << ") "
-	  << ") ";
-      if (! send_command (oss.str ()))
+      if (! declare_symbol (v->get_id (), s_bitvector_sort (v->get_bv_size ())))
 	return false;
     }
 
   vars = collect_subterms_of_type<ExprSet, RegisterExpr> (e, true);
-  unordered_set<const RegisterDesc *> cache;
   for (ExprSet::const_iterator i = vars.begin (); i != vars.end (); i++)
     {
       const RegisterExpr *reg = dynamic_cast<const RegisterExpr *>(*i);
@@ -370,17 +424,10 @@ ExprProcessSolver::declare_variable (const Expr *e)
 
       const RegisterDesc *regdesc = reg->get_descriptor ();
 
-      if (! (cache.find (regdesc) == cache.end ()))
-	continue;
-
       assert (! regdesc->is_alias ());
-      ostringstream oss;
-      oss << "(declare-fun " << regdesc->get_label () << " () "
-	  << "(_ BitVec " << regdesc->get_register_size () << ") "
-	  << ") ";
-      if (! send_command (oss.str ()))
+      if (! declare_symbol (regdesc->get_label (),
+			    s_bitvector_sort (regdesc->get_register_size ())))
 	return false;
-      cache.insert (regdesc);
     }
   return true;
 }
@@ -388,9 +435,36 @@ ExprProcessSolver::declare_variable (const Expr *e)
 string
 ExprProcessSolver::get_result ()
 {
-  string result;
+  string::size_type eol;
+
+  while ((eol = input.find ('\n', input_pos)) == string::npos)
+    {
+      char buf[4096];
+      ssize_t n = read (in, buf, sizeof (buf));
+
+      if (n < 0 && errno == EINTR)
+	continue;
+      if (n <= 0)
+	{
+	  /* The solver is gone: the last line is unterminated. */
+	  string result = input.substr (input_pos);
+	  input.clear ();
+	  input_pos = 0;
+	  return result;
+	}
+      input.erase (0, input_pos);
+      input_pos = 0;
+      input.append (buf, n);
+    }
+
+  string result = input.substr (input_pos, eol - input_pos);
+  input_pos = eol + 1;
+  if (input_pos == input.size ())
+    {
+      input.clear ();
+      input_pos = 0;
+    }
 
-  getline (*in, result);
   return result;
 }
 
@@ -400,6 +474,7 @@ ExprProcessSolver::push ()
 {
   if (! send_command ("(push 1)"))
     throw UnexpectedResponseException ("push: failure");
+  scopes.push_back (vector<string> ());
 }
 
 void
@@ -408,6 +483,13 @@ ExprProcessSolver::pop ()
 {
   if (! send_command ("(pop 1)"))
     throw UnexpectedResponseException ("pop: failure");
+  if (! scopes.empty ())
+    {
+      const vector<string> &ids = scopes.back ();
+      for (size_t i = 0; i < ids.size (); i++)
+	declared.erase (ids[i]);
+      scopes.pop_back ();
+    }
 }
 
 static bool
@@ -528,18 +610,13 @@ s_parse_result_line (const string &line, vector< pair<string,string> > &result)
   return ! result.empty ();
 }
 
-Constant *
-ExprProcessSolver::get_value_of (const Expr *e)
+/* Parses the answer 'res' to a get-value command on 'e'. */
+static Constant *
+s_parse_value (const string &res, const Expr *e,
+	       const MicrocodeArchitecture *mca)
   throw (UnexpectedResponseException)
 {
   Constant *result = NULL;
-  ostringstream oss;
-  oss << "(get-value (";
-  smtlib_writer (oss, e, MEMORY_VAR, mca->get_address_size (),
-		 mca->get_endian (), false);
-  oss << "))";
-
-  string res = exec_command (oss.str ());
   vector< pair<string,string> > couples;
   if (s_parse_result_line (res, couples))
     {
@@ -584,10 +661,103 @@ ExprProcessSolver::get_value_of (const Expr *e)
   return result;
 }
 
+string
+ExprProcessSolver::get_value_command (const Expr *e) const
+{
+  string result ("(get-value (");
+  smtlib_writer (result, e, MEMORY_VAR, mca->get_address_size (),
+		 mca->get_endian (), false);
+  result += "))";
+
+  return result;
+}
+
+Constant *
+ExprProcessSolver::get_value_of (const Expr *e)
+  throw (UnexpectedResponseException)
+{
+  string res = exec_command (get_value_command (e));
+
+  return s_parse_value (res, e, mca);
+}
+
+/* The enumeration is pipelined: the clause excluding the previous value
+ * is sent with the next check-sat command, so that each value costs two
+ * exchanges with the solver. The get-value query is only sent once the
+ * solver answered sat: solvers disagree on how they answer it otherwise. */
+ExprSolver::Result
+ExprProcessSolver::enumerate_values (const Variable *var, const Expr *phi,
+				     int nb_values,
+				     std::vector<constant_t> *values)
+  throw (UnexpectedResponseException)
+{
+  string get_value = get_value_command (var);
+  std::size_t start = nb_bytes_sent;
+  Result result = SAT;
+
+  declare_variable (phi);
+  push ();
+  append_assertion (phi);
+
+  /* The scope is left on errors too, so that the declarations of the
+   * process remain those of 'scopes'. */
+  try
+    {
+      for (;;)
+	{
+	  output += "\n(check-sat)\n";
+	  flush_output ();
+
+	  if (! read_status ())
+	    throw UnexpectedResponseException ("error while adding assertion" +
+					       phi->to_string ());
+	  string res = get_result ();
+	  if (debug_traces)
+	    logs::debug << res << endl;
+	  if (res != "sat")
+	    {
+	      if (res == "unsat")
+		result = UNSAT;
+	      else if (res == "unknown")
+		result = UNKNOWN;
+	      else
+		throw UnexpectedResponseException ("check-sat: " + res);
+	      break;
+	    }
+
+	  string model = exec_command (get_value);
+	  if (debug_traces)
+	    logs::debug << model << endl;
+	  Constant *c = s_parse_value (model, var, mca);
+	  values->push_back (c->get_val ());
+	  if (--nb_values == 0)
+	    {
+	      c->deref ();
+	      break;
+	    }
+
+	  Expr *nc = Expr::createDisequality (var->ref (), c);
+	  append_assertion (nc);
+	  nc->deref ();
+	}
+    }
+  catch (UnexpectedResponseException &)
+    {
+      pop ();
+      throw;
+    }
+  pop ();
+
+  if (debug_traces)
+    logs::debug << (nb_bytes_sent - start) << " bytes sent" << endl;
+
+  return result;
+}
+
 
 static bool
 s_create_pipe (const std::string &cmd, const vector<string> &args,
-	       FILE **rwstreams, pid_t *p_cpid)
+	       int *rwfds, pid_t *p_cpid)
 {
   int parent_child_pipe[2];
   int child_parent_pipe[2];
@@ -646,8 +816,8 @@ s_create_pipe (const std::string &cmd, const vector<string> &args,
       *p_cpid = cpid;
       close (parent_child_pipe[0]); // close read part of P --> C
       close (child_parent_pipe[1]); // close write part of C --> P
-      rwstreams[0] = fdopen (child_parent_pipe[0], "r");
-      rwstreams[1] = fdopen (parent_child_pipe[1], "w");
+      rwfds[0] = child_parent_pipe[0];
+      rwfds[1] = parent_child_pipe[1];
     }
 
   return true;
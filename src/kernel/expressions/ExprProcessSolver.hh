@@ -32,20 +32,39 @@
 # define KERNEL_EXPRESSIONS_EXPRPROCESSSOLVER_HH
 
 # include <csignal>
-# include <iostream>
+# include <string>
 # include <vector>
 # include <kernel/expressions/ExprSolver.hh>
+# include <utils/unordered11.hh>
 
 class ExprProcessSolver : public ExprSolver
 {
 protected:
   std::string command;
-  std::istream *in;
-  std::ostream *out;
+  /* Pipes from and to the solver */
+  int in;
+  int out;
   pid_t childpid;
+  /* Commands are formatted in 'output' and sent with a single write;
+   * answers are read by blocks in 'input', from 'input_pos'. Buffers are
+   * kept from one command to the other. */
+  std::string output;
+  std::string input;
+  std::string::size_type input_pos;
+  std::size_t nb_bytes_sent;
+
+  /* Symbols are declared once and kept as long as the solver knows them:
+   * for its whole life if it supports global declarations, otherwise
+   * until the scope they were declared in is popped. 'declared' maps
+   * symbols to their sorts; 'scopes' lists the symbols declared in each
+   * pushed scope. */
+  typedef std::unordered_map<std::string, std::string> Declarations;
+  bool global_declarations;
+  Declarations declared;
+  std::vector< std::vector<std::string> > scopes;
 
   ExprProcessSolver (const MicrocodeArchitecture *mca, const std::string &cmd,
-		     std::istream *r, std::ostream *w, pid_t cpid);
+		     int r, int w, pid_t cpid);
 
 public:
 
@@ -78,15 +97,26 @@ public:
     throw (UnexpectedResponseException);
 
 protected:
+  virtual Result enumerate_values (const Variable *var, const Expr *phi,
+				   int nb_values,
+				   std::vector<constant_t> *values)
+    throw (UnexpectedResponseException);
+
   bool init () throw (UnexpectedResponseException);
   bool write_header () throw (UnexpectedResponseException);
   bool read_status (bool allow_unsupported = false) throw (UnexpectedResponseException);
+  void append_assertion (const Expr *e);
+  void flush_output () throw (UnexpectedResponseException);
   bool send_command (const std::string &s, bool allow_unsupported = false);
+  /* Sends the commands in 'output' and reads the status of the last. */
+  bool send_output (bool allow_unsupported = false);
   bool send_command (const char *s, bool allow_unsupported = false);
   std::string exec_command (const std::string &s);
   std::string exec_command (const char *s);
+  bool declare_symbol (const std::string &id, const std::string &sort);
   bool declare_variable (const Expr *e);
   std::string get_result ();
+  std::string get_value_command (const Expr *e) const;
 
 };
 
@@ -31,16 +31,25 @@
 #include "ExprSolver.hh"
 
 #include <utils/logs.hh>
+#include <kernel/expressions/ExprCachingSolver.hh>
+#include <kernel/expressions/ExprSolverPool.hh>
 #include <kernel/expressions/ExprProcessSolver.hh>
 #include <kernel/expressions/ExprMathsatSolver.hh>
 #include <vector>
 #include <cassert>
+#include <iomanip>
+#include <sstream>
+#include <sys/time.h>
 
 using namespace std;
 
 static const std::string PROP_PREFIX = "kernel.expr.solver";
 const std::string ExprSolver::SOLVER_NAME_PROP = PROP_PREFIX + ".name";
 const std::string ExprSolver::DEBUG_TRACES_PROP = PROP_PREFIX + ".debug-traces";
+const std::string ExprSolver::CACHE_SIZE_PROP = PROP_PREFIX + ".cache-size";
+const std::string ExprSolver::POOL_SIZE_PROP = PROP_PREFIX + ".pool-size";
+
+static const int DEFAULT_CACHE_SIZE = 4096;
 
 
 
@@ -85,6 +94,53 @@ static SolverModule *default_solver ()
 
 bool ExprSolver::debug_traces = false;
 
+/* Latencies of evaluate() calls; bucket i counts the calls that took less
+ * than 10^(i+2) microseconds (the last one, all the others). */
+#define NB_LATENCY_BUCKETS 5
+
+static struct {
+  unsigned long nb_calls;
+  unsigned long nb_values;
+  unsigned long total_us;
+  unsigned long max_us;
+  unsigned long buckets[NB_LATENCY_BUCKETS];
+} evaluate_stats;
+
+static unsigned long
+s_now_us ()
+{
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+
+  return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+
+/* Solvers of a parallel traversal update the statistics concurrently. */
+static void
+s_account_evaluate (unsigned long us, std::size_t nb_values)
+{
+  int b = 0;
+  for (unsigned long bound = 100; b < NB_LATENCY_BUCKETS - 1 && us >= bound;
+       bound *= 10)
+    b++;
+
+  __sync_fetch_and_add (&evaluate_stats.nb_calls, 1);
+  __sync_fetch_and_add (&evaluate_stats.nb_values, nb_values);
+  __sync_fetch_and_add (&evaluate_stats.total_us, us);
+  __sync_fetch_and_add (&evaluate_stats.buckets[b], 1);
+
+  unsigned long max = evaluate_stats.max_us;
+  while (us > max)
+    {
+      unsigned long old =
+	__sync_val_compare_and_swap (&evaluate_stats.max_us, max, us);
+      if (old == max)
+	break;
+      max = old;
+    }
+}
+
 
 void
 ExprSolver::init (const ConfigTable &cfg)
@@ -104,11 +160,50 @@ ExprSolver::terminate ()
     modules[i].terminate ();
 }
 
+static ExprSolver *
+s_create_solver (const MicrocodeArchitecture *mca)
+{
+  ExprSolver *result = default_solver ()->instantiate (mca);
+  long cache_size = CONFIG->get_integer (ExprSolver::CACHE_SIZE_PROP,
+					 DEFAULT_CACHE_SIZE);
+
+  if (result != NULL && cache_size > 0)
+    result = new ExprCachingSolver (mca, result, cache_size);
+
+  return result;
+}
+
 ExprSolver *
 ExprSolver::create_default_solver (const MicrocodeArchitecture *mca)
   throw (UnexpectedResponseException, UnknownSolverException)
 {
-  return default_solver ()->instantiate (mca);
+  ExprSolver *result = s_create_solver (mca);
+  long pool_size = CONFIG->get_integer (POOL_SIZE_PROP, 0);
+
+  if (pool_size > 0 && ! Expr::has_concurrent_store ())
+    {
+      logs::warning << "warning: answering solver queries on demand since "
+		    << "the store of expressions is not concurrent ("
+		    << Expr::CONCURRENT_STORE_PROP << ")" << endl;
+      pool_size = 0;
+    }
+
+  if (result != NULL && pool_size > 0)
+    {
+      std::vector<ExprSolver *> workers;
+
+      for (long i = 0; i < pool_size; i++)
+	{
+	  ExprSolver *s = s_create_solver (mca);
+	  if (s == NULL)
+	    break;
+	  workers.push_back (s);
+	}
+      if (! workers.empty ())
+	result = new ExprSolverPool (mca, result, workers);
+    }
+
+  return result;
 }
 
 ExprSolver::ExprSolver (const MicrocodeArchitecture *mca) : mca (mca)
@@ -146,48 +241,242 @@ ExprSolver::evaluate (const Expr *e, const Expr *context)
 }
 
 std::vector<constant_t> *
-ExprSolver::evaluate (const Expr *e, const Expr *context, int nb_values)
+ExprSolver::evaluate (const Expr *e, const Expr *context, int nb_values,
+		      Result *status)
   throw (UnexpectedResponseException)
 {
   std::vector<constant_t> *result = new std::vector<constant_t> ();
-  if (nb_values == 0)
+  if (status != NULL)
+    *status = SAT;
+  if (nb_values <= 0)
     return result;
 
   if (debug_traces)
     BEGIN_DBG_BLOCK ("evaluate : " + e->to_string () + " with context " +
 		     context->to_string ());
 
-  Variable *var = Variable::create ("_unk", e->get_bv_size ());
+  /* Solvers may keep their declarations: the name of the variable tells
+   * its size. */
+  std::ostringstream id;
+  id << "_unk" << std::dec << e->get_bv_size ();
+  Variable *var = Variable::create (id.str (), e->get_bv_size ());
   Expr *phi = Expr::createLAnd (Expr::createEquality (var->ref (), e->ref ()),
 				context->ref ( ));
+  unsigned long start = s_now_us ();
+  Result r;
 
-  push ();
-  if (check_sat (phi, false) == SAT)
+  try
+    {
+      r = enumerate_values (var, phi, nb_values, result);
+    }
+  catch (UnexpectedResponseException &)
     {
       phi->deref ();
-      while (nb_values > 0 && check_sat () == SAT)
+      var->deref ();
+      delete result;
+      if (debug_traces)
+	END_DBG_BLOCK ();
+      throw;
+    }
+
+  unsigned long us = s_now_us () - start;
+  s_account_evaluate (us, result->size ());
+  phi->deref ();
+  var->deref ();
+  if (status != NULL)
+    *status = r;
+  if (debug_traces)
+    {
+      logs::debug << result->size () << " values in " << us << " us"
+		  << std::endl;
+      END_DBG_BLOCK ();
+    }
+
+  return result;
+}
+
+ExprSolver::Result
+ExprSolver::enumerate_values (const Variable *var, const Expr *phi,
+			      int nb_values, std::vector<constant_t> *values)
+  throw (UnexpectedResponseException)
+{
+  push ();
+  Result result = check_sat (phi, false);
+  while (result == SAT && nb_values > 0)
+    {
+      result = check_sat ();
+      if (result != SAT)
+	break;
+
+      Constant *c = get_value_of (var);
+      if (debug_traces)
+	logs::debug << "value = " << *c << std::endl;
+
+      values->push_back (c->get_val ());
+      Expr *nc = Expr::createDisequality (var->ref (), c->ref ());
+      add_assertion (nc);
+      nc->deref ();
+      c->deref ();
+      nb_values--;
+    }
+  pop ();
+
+  return result;
+}
+
+ExprSolver::Query *
+ExprSolver::submit_check_sat (const Expr *e)
+{
+  return new Query (this, e, NULL, 0);
+}
+
+ExprSolver::Query *
+ExprSolver::submit_evaluate (const Expr *e, const Expr *context,
+			     int nb_values)
+{
+  return new Query (this, e, context, nb_values);
+}
+
+ExprSolver::Query::Query (ExprSolver *solver, const Expr *e,
+			  const Expr *context, int nb_values)
+  : solver (solver), pool (NULL), e (e->ref ()),
+    context (context == NULL ? NULL : context->ref ()),
+    nb_values (nb_values), assertions (), result (UNKNOWN), values (NULL),
+    error (), failed (false), done (false)
+{
+  pthread_mutex_init (&lock, NULL);
+  pthread_cond_init (&cond, NULL);
+}
+
+ExprSolver::Query::~Query ()
+{
+  /* A query a worker of the pool took has to be answered before it goes
+   * away; the pool outlives the queries it did not answer yet. */
+  if (pool != NULL)
+    {
+      pthread_mutex_lock (&lock);
+      bool answered = done;
+      pthread_mutex_unlock (&lock);
+
+      if (! answered && ! pool->cancel (this))
 	{
-	  Constant *c = get_value_of (var);
-	  if (debug_traces)
-	    logs::debug << "value = " << *c << std::endl;
-
-	  result->push_back (c->get_val ());
-	  Expr *nc = Expr::createDisequality (var->ref (), c->ref ());
-	  add_assertion (nc);
-	  nc->deref ();
-	  c->deref ();
-	  nb_values--;
+	  pthread_mutex_lock (&lock);
+	  while (! done)
+	    pthread_cond_wait (&cond, &lock);
+	  pthread_mutex_unlock (&lock);
 	}
     }
+
+  e->deref ();
+  if (context != NULL)
+    context->deref ();
+  for (size_t i = 0; i < assertions.size (); i++)
+    assertions[i]->deref ();
+  delete values;
+  pthread_mutex_destroy (&lock);
+  pthread_cond_destroy (&cond);
+}
+
+void
+ExprSolver::Query::run (ExprSolver *s)
+{
+  try
+    {
+      if (context == NULL)
+	result = s->check_sat (e, true);
+      else
+	values = s->evaluate (e, context, nb_values, &result);
+      set_done ();
+    }
+  catch (SolverException &x)
+    {
+      fail (x.what ());
+    }
+}
+
+void
+ExprSolver::Query::fail (const std::string &msg)
+{
+  error = msg;
+  failed = true;
+  set_done ();
+}
+
+void
+ExprSolver::Query::set_done ()
+{
+  pthread_mutex_lock (&lock);
+  done = true;
+  pthread_cond_broadcast (&cond);
+  pthread_mutex_unlock (&lock);
+}
+
+void
+ExprSolver::Query::wait ()
+  throw (UnexpectedResponseException)
+{
+  if (solver != NULL)
+    {
+      if (! done)
+	run (solver);
+    }
   else
     {
-      phi->deref ();
+      pthread_mutex_lock (&lock);
+      while (! done)
+	pthread_cond_wait (&cond, &lock);
+      pthread_mutex_unlock (&lock);
     }
 
-  pop ();
-  var->deref ();
-  if (debug_traces)
-    END_DBG_BLOCK ();
+  if (failed)
+    throw UnexpectedResponseException (error);
+}
+
+ExprSolver::Result
+ExprSolver::Query::get_result ()
+  throw (UnexpectedResponseException)
+{
+  assert (context == NULL);
+  wait ();
 
   return result;
 }
+
+std::vector<constant_t> *
+ExprSolver::Query::get_values ()
+  throw (UnexpectedResponseException)
+{
+  assert (context != NULL);
+  wait ();
+  std::vector<constant_t> *result = values;
+  values = NULL;
+
+  return result;
+}
+
+void
+ExprSolver::output_evaluate_stats (std::ostream &out)
+{
+  static const char *bucket_names[NB_LATENCY_BUCKETS] = {
+    "< 100us", "< 1ms", "< 10ms", "< 100ms", ">= 100ms"
+  };
+  unsigned long nb_calls = evaluate_stats.nb_calls;
+
+  out << "solver evaluations: " << nb_calls << " calls, "
+      << evaluate_stats.nb_values << " values";
+  if (nb_calls > 0)
+    {
+      /* Formatted aside to leave the flags of 'out' untouched */
+      std::ostringstream oss;
+
+      oss << ", " << std::fixed << std::setprecision (3)
+	  << evaluate_stats.total_us / 1000.0 << " ms ("
+	  << (evaluate_stats.total_us / (double) nb_calls) / 1000.0
+	  << " ms/call, max " << evaluate_stats.max_us / 1000.0 << " ms)";
+      for (int b = 0; b < NB_LATENCY_BUCKETS; b++)
+	oss << (b == 0 ? "; " : ", ") << bucket_names[b] << ": "
+	    << evaluate_stats.buckets[b];
+      out << oss.str ();
+    }
+  out << endl;
+}
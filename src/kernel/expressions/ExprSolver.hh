@@ -31,11 +31,15 @@
 #ifndef KERNEL_EXPRESSIONS_EXPRSOLVER_HH
 # define KERNEL_EXPRESSIONS_EXPRSOLVER_HH
 
+# include <pthread.h>
+# include <iosfwd>
 # include <stdexcept>
 # include <vector>
 # include <kernel/Expressions.hh>
 # include <utils/ConfigTable.hh>
 
+class ExprSolverPool;
+
 class ExprSolver
 {
 public:
@@ -61,6 +65,14 @@ public:
 
   static const std::string SOLVER_NAME_PROP;
   static const std::string DEBUG_TRACES_PROP;
+  /* Number of answers remembered by default solvers (0 disables the
+   * cache; see ExprCachingSolver). */
+  static const std::string CACHE_SIZE_PROP;
+  /* Number of solvers answering submitted queries concurrently (0 answers
+   * them on demand with the solver itself; see ExprSolverPool). The
+   * workers need the concurrent store of expressions: without it, the
+   * queries are answered on demand. */
+  static const std::string POOL_SIZE_PROP;
 
   static void init (const ConfigTable &cfg)
     throw (UnknownSolverException);
@@ -72,6 +84,56 @@ public:
 
   enum Result { SAT, UNSAT, UNKNOWN };
 
+  /* A query whose answer may be computed while its submitter goes on; see
+   * submit_check_sat() and submit_evaluate(). A pool answers the query
+   * under the assertions made before it was submitted; a solver answering
+   * on demand uses its assertions at the time the query is waited for. */
+  class Query
+  {
+  public:
+    /* A query that no one started to answer is dropped; otherwise its
+     * answer is waited for. */
+    ~Query ();
+
+    /* Both block until the query is answered and raise the errors of the
+     * solver. The caller owns the values; later calls return NULL. */
+    Result get_result () throw (UnexpectedResponseException);
+    std::vector<constant_t> *get_values ()
+      throw (UnexpectedResponseException);
+
+  private:
+    friend class ExprSolver;
+    friend class ExprSolverPool;
+
+    Query (ExprSolver *solver, const Expr *e, const Expr *context,
+	   int nb_values);
+    Query (const Query &);
+    Query &operator= (const Query &);
+
+    void run (ExprSolver *solver);
+    void fail (const std::string &msg);
+    void set_done ();
+    void wait () throw (UnexpectedResponseException);
+
+    /* Solver that answers the query when it is waited for; NULL if
+     * 'pool' answers it. */
+    ExprSolver *solver;
+    ExprSolverPool *pool;
+    Expr *e;
+    /* NULL for a check-sat query */
+    Expr *context;
+    int nb_values;
+    /* Assertions the query is answered under (see ExprSolverPool) */
+    std::vector<Expr *> assertions;
+    Result result;
+    std::vector<constant_t> *values;
+    std::string error;
+    bool failed;
+    bool done;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+  };
+
   virtual ~ExprSolver ();
 
   virtual void add_assertion (const Expr *e)
@@ -86,10 +148,27 @@ public:
   virtual Constant *evaluate (const Expr *e, const Expr *context)
     throw (UnexpectedResponseException);
 
+  /* Returns at most 'nb_values' distinct values that 'e' takes in models
+   * of 'context'. If 'status' is not NULL, it receives UNSAT if 'e' has no
+   * other value, SAT if the enumeration stopped at 'nb_values' values and
+   * UNKNOWN if the solver could not decide. The latency of each call is
+   * accounted in the statistics output by output_evaluate_stats(). */
   virtual std::vector<constant_t> *
-  evaluate (const Expr *e, const Expr *context, int nb_values)
+  evaluate (const Expr *e, const Expr *context, int nb_values,
+	    Result *status = NULL)
     throw (UnexpectedResponseException);
 
+  /* Asynchronous versions of check_sat(e, true) and evaluate(); the
+   * caller deletes the query. By default the query is answered by this
+   * solver once it is waited for; it is not answered at all if it is
+   * deleted first. */
+  virtual Query *submit_check_sat (const Expr *e);
+  virtual Query *submit_evaluate (const Expr *e, const Expr *context,
+				  int nb_values);
+
+  /* Statistics of the calls to evaluate() of all the solvers. */
+  static void output_evaluate_stats (std::ostream &out);
+
   virtual void push ()
     throw (UnexpectedResponseException) = 0;
   virtual void pop ()
@@ -100,6 +179,15 @@ public:
 protected:
   ExprSolver (const MicrocodeArchitecture *mca);
 
+  /* Appends to 'values' at most 'nb_values' distinct values of 'var' in
+   * models of 'phi'; assertions are left unchanged. Returns the status of
+   * the enumeration as evaluate() does. The default implementation asks
+   * for one model at a time, each excluding the values already found. */
+  virtual Result enumerate_values (const Variable *var, const Expr *phi,
+				   int nb_values,
+				   std::vector<constant_t> *values)
+    throw (UnexpectedResponseException);
+
   const MicrocodeArchitecture *mca;
 
   static bool debug_traces;
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "ExprSolverPool.hh"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+ExprSolverPool::ExprSolverPool (const MicrocodeArchitecture *mca,
+				ExprSolver *solver,
+				const std::vector<ExprSolver *> &W)
+  : ExprSolver (mca), solver (solver), workers (), assertions (), levels (),
+    queries (), terminating (false)
+{
+  assert (W.empty () || Expr::has_concurrent_store ());
+  pthread_mutex_init (&lock, NULL);
+  pthread_cond_init (&cond, NULL);
+
+  for (size_t i = 0; i < W.size (); i++)
+    {
+      Worker *w = new Worker;
+      w->pool = this;
+      w->solver = W[i];
+      if (pthread_create (&w->thread, NULL, run_thread, w) == 0)
+	workers.push_back (w);
+      else
+	{
+	  delete W[i];
+	  delete w;
+	}
+    }
+}
+
+ExprSolverPool::~ExprSolverPool ()
+{
+  pthread_mutex_lock (&lock);
+  terminating = true;
+  pthread_cond_broadcast (&cond);
+  pthread_mutex_unlock (&lock);
+
+  for (size_t i = 0; i < workers.size (); i++)
+    {
+      Worker *w = workers[i];
+      pthread_join (w->thread, NULL);
+      for (size_t a = 0; a < w->assertions.size (); a++)
+	w->assertions[a]->deref ();
+      delete w->solver;
+      delete w;
+    }
+  for (size_t a = 0; a < assertions.size (); a++)
+    assertions[a]->deref ();
+  delete solver;
+
+  pthread_mutex_destroy (&lock);
+  pthread_cond_destroy (&cond);
+}
+
+void
+ExprSolverPool::add_assertion (const Expr *e)
+  throw (UnexpectedResponseException)
+{
+  solver->add_assertion (e);
+  assertions.push_back (e->ref ());
+}
+
+ExprSolver::Result
+ExprSolverPool::check_sat (const Expr *e, bool preserve)
+  throw (UnexpectedResponseException)
+{
+  Result result = solver->check_sat (e, preserve);
+  if (! preserve)
+    assertions.push_back (e->ref ());
+
+  return result;
+}
+
+ExprSolver::Result
+ExprSolverPool::check_sat ()
+  throw (UnexpectedResponseException)
+{
+  return solver->check_sat ();
+}
+
+std::vector<constant_t> *
+ExprSolverPool::evaluate (const Expr *e, const Expr *context, int nb_values,
+			  Result *status)
+  throw (UnexpectedResponseException)
+{
+  return solver->evaluate (e, context, nb_values, status);
+}
+
+ExprSolver::Query *
+ExprSolverPool::submit_check_sat (const Expr *e)
+{
+  return submit (new Query (NULL, e, NULL, 0));
+}
+
+ExprSolver::Query *
+ExprSolverPool::submit_evaluate (const Expr *e, const Expr *context,
+				 int nb_values)
+{
+  return submit (new Query (NULL, e, context, nb_values));
+}
+
+void
+ExprSolverPool::push ()
+  throw (UnexpectedResponseException)
+{
+  solver->push ();
+  levels.push_back (assertions.size ());
+}
+
+void
+ExprSolverPool::pop ()
+  throw (UnexpectedResponseException)
+{
+  solver->pop ();
+  assert (! levels.empty ());
+  while (assertions.size () > levels.back ())
+    {
+      assertions.back ()->deref ();
+      assertions.pop_back ();
+    }
+  levels.pop_back ();
+}
+
+Constant *
+ExprSolverPool::get_value_of (const Expr *var)
+  throw (UnexpectedResponseException)
+{
+  return solver->get_value_of (var);
+}
+
+int
+ExprSolverPool::get_nb_workers () const
+{
+  return workers.size ();
+}
+
+ExprSolver::Query *
+ExprSolverPool::submit (Query *q)
+{
+  /* Without workers, the main solver answers on demand. */
+  if (workers.empty ())
+    {
+      q->solver = solver;
+      return q;
+    }
+
+  for (size_t a = 0; a < assertions.size (); a++)
+    q->assertions.push_back (assertions[a]->ref ());
+  q->pool = this;
+
+  pthread_mutex_lock (&lock);
+  queries.push_back (q);
+  pthread_cond_signal (&cond);
+  pthread_mutex_unlock (&lock);
+
+  return q;
+}
+
+bool
+ExprSolverPool::cancel (Query *q)
+{
+  pthread_mutex_lock (&lock);
+  std::deque<Query *>::iterator i =
+    std::find (queries.begin (), queries.end (), q);
+  bool result = (i != queries.end ());
+  if (result)
+    queries.erase (i);
+  pthread_mutex_unlock (&lock);
+
+  return result;
+}
+
+void *
+ExprSolverPool::run_thread (void *worker)
+{
+  Worker *W = (Worker *) worker;
+  W->pool->work (W);
+
+  return NULL;
+}
+
+void
+ExprSolverPool::work (Worker *W)
+{
+  for (;;)
+    {
+      pthread_mutex_lock (&lock);
+      while (queries.empty () && ! terminating)
+	pthread_cond_wait (&cond, &lock);
+      if (queries.empty ())
+	{
+	  pthread_mutex_unlock (&lock);
+	  break;
+	}
+      Query *q = queries.front ();
+      queries.pop_front ();
+      pthread_mutex_unlock (&lock);
+
+      try
+	{
+	  update_assertions (W, q);
+	}
+      catch (SolverException &x)
+	{
+	  q->fail (x.what ());
+	  continue;
+	}
+      q->run (W->solver);
+    }
+}
+
+/* Assertions usually only grow between queries, or are popped back to a
+ * common prefix: the worker keeps the ones it shares with the query and
+ * only asserts the missing ones. */
+void
+ExprSolverPool::update_assertions (Worker *W, const Query *q)
+  throw (UnexpectedResponseException)
+{
+  const std::vector<Expr *> &A = q->assertions;
+  size_t n = 0;
+
+  while (n < W->assertions.size () && n < A.size () &&
+	 W->assertions[n] == A[n])
+    n++;
+
+  while (W->assertions.size () > n)
+    {
+      W->solver->pop ();
+      W->assertions.back ()->deref ();
+      W->assertions.pop_back ();
+    }
+
+  for (; n < A.size (); n++)
+    {
+      W->solver->push ();
+      W->solver->add_assertion (A[n]);
+      W->assertions.push_back (A[n]->ref ());
+    }
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef KERNEL_EXPRESSIONS_EXPRSOLVERPOOL_HH
+# define KERNEL_EXPRESSIONS_EXPRSOLVERPOOL_HH
+
+# include <pthread.h>
+# include <deque>
+# include <vector>
+# include <kernel/expressions/ExprSolver.hh>
+
+/* Decorator answering submitted queries concurrently. Each worker solver
+ * is used by its own thread, which takes the queries in the order they
+ * were submitted; the other requests are forwarded to the main solver.
+ * The pool keeps track of the assertions made on the main solver so that
+ * a worker first brings its own assertions up to date with the ones that
+ * held when the query was submitted. */
+class ExprSolverPool : public ExprSolver
+{
+public:
+  /* The pool owns 'solver' and the 'workers'. Since the workers build
+   * expressions, the store of expressions has to be concurrent if there
+   * are any. */
+  ExprSolverPool (const MicrocodeArchitecture *mca, ExprSolver *solver,
+		  const std::vector<ExprSolver *> &workers);
+
+  /* Queries still pending are answered first. */
+  virtual ~ExprSolverPool ();
+
+  virtual void add_assertion (const Expr *e)
+    throw (UnexpectedResponseException);
+
+  virtual Result check_sat (const Expr *e, bool preserve)
+    throw (UnexpectedResponseException);
+
+  virtual Result check_sat ()
+    throw (UnexpectedResponseException);
+
+  virtual std::vector<constant_t> *
+  evaluate (const Expr *e, const Expr *context, int nb_values,
+	    Result *status = NULL)
+    throw (UnexpectedResponseException);
+
+  virtual Query *submit_check_sat (const Expr *e);
+  virtual Query *submit_evaluate (const Expr *e, const Expr *context,
+				  int nb_values);
+
+  virtual void push ()
+    throw (UnexpectedResponseException);
+  virtual void pop ()
+    throw (UnexpectedResponseException);
+  virtual Constant *get_value_of (const Expr *var)
+    throw (UnexpectedResponseException);
+
+  int get_nb_workers () const;
+
+private:
+  friend class ExprSolver::Query;
+
+  struct Worker {
+    ExprSolverPool *pool;
+    ExprSolver *solver;
+    pthread_t thread;
+    /* Assertions made on 'solver', each above its own push. */
+    std::vector<Expr *> assertions;
+  };
+
+  ExprSolverPool (const ExprSolverPool &);
+  ExprSolverPool &operator= (const ExprSolverPool &);
+
+  static void *run_thread (void *worker);
+  void work (Worker *W);
+  void update_assertions (Worker *W, const Query *q)
+    throw (UnexpectedResponseException);
+  Query *submit (Query *q);
+  /* Removes 'q' from the pending queries; false if a worker took it. */
+  bool cancel (Query *q);
+
+  ExprSolver *solver;
+  std::vector<Worker *> workers;
+  /* Assertions made on 'solver' and number of them at each push */
+  std::vector<Expr *> assertions;
+  std::vector<std::size_t> levels;
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  std::deque<Query *> queries;
+  bool terminating;
+};
+
+#endif /* ! KERNEL_EXPRESSIONS_EXPRSOLVERPOOL_HH */
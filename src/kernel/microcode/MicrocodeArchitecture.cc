@@ -34,12 +34,13 @@
 MicrocodeArchitecture::MicrocodeArchitecture (const Architecture *arch)
   : Architecture (arch->get_proc (), arch->get_endian (),
 		  arch->get_word_size (), arch->get_address_size ()),
-    reference_arch (arch)
+    reference_arch (arch), decoder_data (NULL), nb_decoder_data_refs (0)
 {
 }
 
 MicrocodeArchitecture::~MicrocodeArchitecture ()
 {
+  delete decoder_data;
 }
 
 const Architecture *
@@ -76,3 +77,33 @@ MicrocodeArchitecture::get_tmp_registers() const
 {
   return get_registers ();
 }
+
+MicrocodeArchitecture::DecoderData *
+MicrocodeArchitecture::get_decoder_data () const
+{
+  return decoder_data;
+}
+
+void
+MicrocodeArchitecture::set_decoder_data (DecoderData *data)
+{
+  if (data != decoder_data)
+    delete decoder_data;
+  decoder_data = data;
+}
+
+void
+MicrocodeArchitecture::ref_decoder_data ()
+{
+  __sync_fetch_and_add (&nb_decoder_data_refs, 1);
+}
+
+void
+MicrocodeArchitecture::deref_decoder_data ()
+{
+  int refs = __sync_sub_and_fetch (&nb_decoder_data_refs, 1);
+
+  assert (refs >= 0);
+  if (refs == 0)
+    set_decoder_data (NULL);
+}
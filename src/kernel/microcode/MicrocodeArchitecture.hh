@@ -36,6 +36,17 @@
 class MicrocodeArchitecture : private Architecture
 {
 public :
+  /* Data that a decoder computes once for all the instructions of an
+   * architecture. It is owned by the MicrocodeArchitecture and shared by
+   * all the decoders of the architecture, each of which holds a
+   * reference on it (see ref_decoder_data ()). Since it may hold
+   * expressions, it is released with the last reference, and the
+   * decoders should go away before Expr::terminate () is called. */
+  class DecoderData {
+  public:
+    virtual ~DecoderData () { }
+  };
+
   MicrocodeArchitecture (const Architecture *arch);
 
   virtual ~MicrocodeArchitecture ();
@@ -50,6 +61,17 @@ public :
 
   const RegisterSpecs *get_tmp_registers() const;
 
+  DecoderData *get_decoder_data () const;
+
+  /* Replace (and delete) the current decoder data */
+  void set_decoder_data (DecoderData *data);
+
+  /* Counts the decoders using the data; it is deleted once the last of
+   * them releases it. Decoders should not be created while the last one
+   * is deleted. */
+  void ref_decoder_data ();
+  void deref_decoder_data ();
+
   using Architecture::get_proc;
   using Architecture::get_endian;
   using Architecture::get_word_size;
@@ -57,6 +79,8 @@ public :
 
 private:
   const Architecture *reference_arch;
+  DecoderData *decoder_data;
+  int nb_decoder_data_refs;
 };
 
 #endif /* ! KERNELMICROCODEARCHITECTURE_HH */
@@ -35,6 +35,7 @@
 #include <sstream>
 #include <list>
 #include <set>
+#include <algorithm>
 
 using namespace std;
 
@@ -105,7 +106,11 @@ MicrocodeNode::MicrocodeNode(const MicrocodeNode &snode) :
   loc = snode.loc;
   successors = new vector<StmtArrow *>;
   MicrocodeNode_iterate_successors(snode, arr)
-  successors->push_back((*arr)->clone());
+    {
+      StmtArrow *a = (*arr)->clone();
+      a->set_src(this);
+      successors->push_back(a);
+    }
 }
 
 MicrocodeNode * MicrocodeNode::clone() const
@@ -127,12 +132,20 @@ MicrocodeNode::add_predecessor (StmtArrow * arr)
 {
   if (predecessors == NULL)
     predecessors = new std::vector<StmtArrow *> ();
-  for (int k = 0; k < (int) predecessors->size (); k++)
-    if (*((*predecessors)[k]) == (*arr))
-      return;
   predecessors->push_back(arr);
 }
 
+void
+MicrocodeNode::remove_predecessor (StmtArrow * arr)
+{
+  if (predecessors == NULL)
+    return;
+  std::vector<StmtArrow *>::iterator i =
+    std::find (predecessors->begin (), predecessors->end (), arr);
+  if (i != predecessors->end ())
+    predecessors->erase (i);
+}
+
 const MicrocodeAddress &MicrocodeNode::get_loc() const {
   return loc;
 }
@@ -283,7 +296,7 @@ StmtArrow::StmtArrow(MicrocodeNode *src, Statement *stmt,
 {
 }
 
-StmtArrow::StmtArrow(const StmtArrow &arr): Annotable(arr)
+StmtArrow::StmtArrow(const StmtArrow &arr): Annotable(arr), src(arr.src)
 {
   stmt = arr.stmt->clone();
   condition = NULL;
@@ -346,7 +359,7 @@ bool StmtArrow::operator==(const StmtArrow &other)
 
   if ((!this->is_dynamic()) && !other.is_dynamic())
     return ((StaticArrow *) this)->get_concrete_target().equals(
-		((StaticArrow *) this)->get_concrete_target());
+		((StaticArrow *) &other)->get_concrete_target());
   return false;
 }
 
@@ -408,7 +421,8 @@ StaticArrow::StaticArrow(MicrocodeNode * src, MicrocodeNode * tgt,
 
 StaticArrow::StaticArrow(const StaticArrow &other) :
   StmtArrow(other),
-  target(other.target)
+  target(other.target),
+  tgt(other.tgt)
 {}
 
 StaticArrow::~StaticArrow() {}
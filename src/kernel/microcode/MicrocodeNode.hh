@@ -69,7 +69,8 @@ private:
    * address. */
   MicrocodeAddress loc;
   std::vector<StmtArrow *> * successors;
-  /* computed during the optimization step */
+  /* static arrows targeting this node, in the order they were added;
+   * NULL if there is none yet */
   std::vector<StmtArrow *> * predecessors;
 
   // TODO *** TODO *** TODO *** TODO ***
@@ -85,6 +86,7 @@ public:
   MicrocodeNode * clone() const;
 
   void add_predecessor(StmtArrow * arr);
+  void remove_predecessor(StmtArrow * arr);
 
   const MicrocodeAddress &get_loc() const;
   std::vector<StmtArrow *> * get_successors() const;
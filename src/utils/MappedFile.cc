@@ -0,0 +1,79 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "MappedFile.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile *
+MappedFile::map (const std::string &filename)
+{
+  int fd = open (filename.c_str (), O_RDONLY);
+  struct stat st;
+  void *data = MAP_FAILED;
+
+  if (fd < 0)
+    return NULL;
+  if (fstat (fd, &st) == 0 && st.st_size > 0)
+    data = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  /* The mapping remains valid once the descriptor is closed. */
+  close (fd);
+
+  if (data == MAP_FAILED)
+    return NULL;
+
+  return new MappedFile ((const uint8_t *) data, st.st_size);
+}
+
+MappedFile::MappedFile (const uint8_t *data, std::size_t size)
+  : refcount (1), data (data), size (size)
+{
+}
+
+MappedFile::~MappedFile ()
+{
+  munmap ((void *) data, size);
+}
+
+void
+MappedFile::ref ()
+{
+  __sync_fetch_and_add (&refcount, 1);
+}
+
+void
+MappedFile::deref ()
+{
+  if (__sync_sub_and_fetch (&refcount, 1) == 0)
+    delete this;
+}
@@ -0,0 +1,64 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef UTILS_MAPPEDFILE_HH
+#define UTILS_MAPPEDFILE_HH
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include <string>
+
+/* A file mapped read-only into the address space. The mapping is shared
+ * by reference counting and is unmapped with the last reference. */
+class MappedFile
+{
+public:
+  /* Maps the whole file 'filename'; returns NULL if the file cannot be
+   * opened or mapped. The result has one reference. */
+  static MappedFile *map (const std::string &filename);
+
+  const uint8_t *get_data () const { return data; }
+  std::size_t get_size () const { return size; }
+
+  void ref ();
+  void deref ();
+
+private:
+  MappedFile (const uint8_t *data, std::size_t size);
+  MappedFile (const MappedFile &);
+  ~MappedFile ();
+
+  int refcount;
+  const uint8_t *data;
+  std::size_t size;
+};
+
+#endif /* UTILS_MAPPEDFILE_HH */
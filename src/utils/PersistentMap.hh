@@ -0,0 +1,147 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef UTILS_PERSISTENTMAP_HH
+#define UTILS_PERSISTENTMAP_HH
+
+#include <stddef.h>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <utils/unordered11.hh>
+
+/* An ordered map whose copies share their structure. It is a treap in
+ * which the priority of a key is derived from its hash value; the shape
+ * of the tree thus only depends on the set of keys, and two maps with
+ * the same contents built in any order have identical shapes.
+ *
+ * Nodes are reference counted. Copying a map is O(1); put() and erase()
+ * are O(log n) and copy only the nodes on the path to the modified key
+ * that are still shared with another map, nodes owned by a single map
+ * are updated in place. Reference counts are updated atomically so that
+ * copies may be handed to other threads; a given map object must not
+ * be modified concurrently. */
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+	  typename Compare = std::less<Key> >
+class PersistentMap
+{
+  struct Node;
+
+public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+  typedef std::pair<const Key, Value> value_type;
+
+  /* In-order iterator; entries cannot be modified through it. */
+  class const_iterator
+  {
+  public:
+    const_iterator () : path () { }
+
+    const value_type &operator* () const { return path.back ()->entry; }
+    const value_type *operator-> () const { return &path.back ()->entry; }
+    const_iterator &operator++ ();
+    const_iterator operator++ (int);
+    bool operator== (const const_iterator &other) const;
+    bool operator!= (const const_iterator &other) const;
+
+  private:
+    friend class PersistentMap;
+
+    void push_leftmost (const Node *n);
+
+    /* Nodes from the root whose entry is still to be visited; the back
+     * is the current entry and the path is empty at the end. */
+    std::vector<const Node *> path;
+  };
+  typedef const_iterator iterator;
+
+  PersistentMap ();
+  PersistentMap (const PersistentMap &other);
+  ~PersistentMap ();
+
+  PersistentMap &operator= (const PersistentMap &other);
+
+  std::size_t size () const { return nb_entries; }
+  bool empty () const { return nb_entries == 0; }
+
+  const_iterator begin () const;
+  const_iterator end () const;
+  const_iterator find (const Key &k) const;
+
+  /* Returns the value bound to 'k' or NULL. */
+  const Value *lookup (const Key &k) const;
+
+  /* Binds 'k' to 'v', replacing any previous binding. */
+  void put (const Key &k, const Value &v);
+
+  /* Removes the binding of 'k'; returns false if there was none. */
+  bool erase (const Key &k);
+
+  void clear ();
+
+  /* Tells whether the two maps are copies of each other that have not
+   * been modified since; such maps have the same contents. */
+  bool shares_root (const PersistentMap &other) const {
+    return root == other.root;
+  }
+
+private:
+  struct Node {
+    Node (const Key &k, const Value &v, std::size_t priority)
+      : refcount (1), left (NULL), right (NULL), priority (priority),
+	entry (k, v) { }
+
+    int refcount;
+    Node *left;
+    Node *right;
+    std::size_t priority;
+    value_type entry;
+  };
+
+  static std::size_t s_priority (const Key &k);
+  static bool s_above (const Node *a, const Node *b);
+  static void s_ref (Node *n);
+  static void s_release (Node *n);
+  static Node *s_writable (Node *n);
+  static Node *s_insert (Node *n, const Key &k, const Value &v,
+			 std::size_t priority, bool &added);
+  static Node *s_remove (Node *n, const Key &k);
+  static Node *s_merge (Node *l, Node *r);
+
+  Node *root;
+  std::size_t nb_entries;
+};
+
+#include "PersistentMap.ii"
+
+#endif /* UTILS_PERSISTENTMAP_HH */
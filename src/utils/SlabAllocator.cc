@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2010-2015, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "SlabAllocator.hh"
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+SlabAllocator::SlabAllocator (size_t object_size, size_t nb_objects_per_slab)
+  : object_size (object_size), nb_objects_per_slab (nb_objects_per_slab),
+    slabs (), free_list (NULL), nb_live_objects (0), thread_safe (false)
+{
+  /* Keep objects aligned on a pointer boundary. */
+  if (this->object_size < sizeof (FreeCell))
+    this->object_size = sizeof (FreeCell);
+  this->object_size = ((this->object_size + sizeof (void *) - 1) /
+		       sizeof (void *)) * sizeof (void *);
+  assert (nb_objects_per_slab > 0);
+  pthread_mutex_init (&lock, NULL);
+}
+
+SlabAllocator::~SlabAllocator ()
+{
+  /* Objects still alive (e.g. leaked expressions reported by
+   * Expr::terminate) may be used up to the end of the process. */
+  if (nb_live_objects == 0)
+    {
+      for (size_t i = 0; i < slabs.size (); i++)
+	free (slabs[i]);
+    }
+  pthread_mutex_destroy (&lock);
+}
+
+void
+SlabAllocator::add_slab ()
+{
+  char *slab = (char *) malloc (object_size * nb_objects_per_slab);
+
+  if (slab == NULL)
+    throw std::bad_alloc ();
+  slabs.push_back (slab);
+
+  for (size_t i = nb_objects_per_slab; i > 0; i--)
+    {
+      FreeCell *cell = (FreeCell *) (slab + (i - 1) * object_size);
+      cell->next = free_list;
+      free_list = cell;
+    }
+}
+
+void *
+SlabAllocator::allocate ()
+{
+  if (thread_safe)
+    pthread_mutex_lock (&lock);
+
+  if (free_list == NULL)
+    {
+      try
+	{
+	  add_slab ();
+	}
+      catch (std::bad_alloc &)
+	{
+	  if (thread_safe)
+	    pthread_mutex_unlock (&lock);
+	  throw;
+	}
+    }
+  FreeCell *result = free_list;
+  free_list = result->next;
+  nb_live_objects++;
+
+  if (thread_safe)
+    pthread_mutex_unlock (&lock);
+
+  return result;
+}
+
+void
+SlabAllocator::release (void *ptr)
+{
+  if (ptr == NULL)
+    return;
+
+  if (thread_safe)
+    pthread_mutex_lock (&lock);
+
+  assert (nb_live_objects > 0);
+  FreeCell *cell = (FreeCell *) ptr;
+  cell->next = free_list;
+  free_list = cell;
+  nb_live_objects--;
+
+  if (thread_safe)
+    pthread_mutex_unlock (&lock);
+}
+
+void
+SlabAllocator::set_thread_safe (bool value)
+{
+  thread_safe = value;
+}
+
+size_t
+SlabAllocator::get_object_size () const
+{
+  return object_size;
+}
+
+size_t
+SlabAllocator::get_nb_live_objects () const
+{
+  return nb_live_objects;
+}
+
+size_t
+SlabAllocator::get_nb_reserved_bytes () const
+{
+  return slabs.size () * nb_objects_per_slab * object_size;
+}
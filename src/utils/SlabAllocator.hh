@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2010-2015, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef UTILS_SLABALLOCATOR_HH
+# define UTILS_SLABALLOCATOR_HH
+
+# include <cstddef>
+# include <vector>
+# include <pthread.h>
+
+/** \brief Allocator of fixed-size objects.
+ *
+ * Memory is reserved by slabs of several objects; released objects are
+ * kept in a free list and reused by further allocations. Slabs are
+ * given back to the system only when the allocator is destroyed and no
+ * object is alive anymore.
+ */
+class SlabAllocator
+{
+public:
+  SlabAllocator (size_t object_size, size_t nb_objects_per_slab = 1024);
+  ~SlabAllocator ();
+
+  void *allocate ();
+  void release (void *ptr);
+
+  /** \brief If set, allocate() and release() can be called concurrently. */
+  void set_thread_safe (bool value);
+
+  size_t get_object_size () const;
+  size_t get_nb_live_objects () const;
+  size_t get_nb_reserved_bytes () const;
+
+private:
+  struct FreeCell {
+    FreeCell *next;
+  };
+
+  void add_slab ();
+
+  size_t object_size;
+  size_t nb_objects_per_slab;
+  std::vector<char *> slabs;
+  FreeCell *free_list;
+  size_t nb_live_objects;
+  bool thread_safe;
+  pthread_mutex_t lock;
+};
+
+#endif /* ! UTILS_SLABALLOCATOR_HH */
@@ -0,0 +1,182 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "WorkStealingPool.hh"
+
+#include <utils/MutexLock.hh>
+
+using namespace std;
+
+WorkStealingPool::WorkStealingPool (int nb_workers)
+  : workers (), nb_batches (0), nb_busy (0), terminating (false)
+{
+  pthread_mutex_init (&lock, NULL);
+  pthread_cond_init (&start_cond, NULL);
+  pthread_cond_init (&done_cond, NULL);
+
+  for (int i = 0; i < nb_workers || i == 0; i++)
+    {
+      Worker *W = new Worker ();
+
+      W->pool = this;
+      W->index = i;
+      W->thread = pthread_self ();
+      pthread_mutex_init (&W->lock, NULL);
+      if (i > 0 && pthread_create (&W->thread, NULL, run_thread, W) != 0)
+	{
+	  pthread_mutex_destroy (&W->lock);
+	  delete W;
+	  break;
+	}
+      workers.push_back (W);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool ()
+{
+  {
+    MutexLock ml (&lock);
+    terminating = true;
+    pthread_cond_broadcast (&start_cond);
+  }
+
+  for (size_t i = 0; i < workers.size (); i++)
+    {
+      if (i > 0)
+	pthread_join (workers[i]->thread, NULL);
+      pthread_mutex_destroy (&workers[i]->lock);
+      delete workers[i];
+    }
+  pthread_cond_destroy (&done_cond);
+  pthread_cond_destroy (&start_cond);
+  pthread_mutex_destroy (&lock);
+}
+
+int
+WorkStealingPool::get_nb_workers () const
+{
+  return workers.size ();
+}
+
+void
+WorkStealingPool::run (const vector<Job *> &jobs)
+{
+  if (jobs.empty ())
+    return;
+
+  /* The threads are idle, the deques can be filled without locking. */
+  for (size_t i = 0; i < jobs.size (); i++)
+    workers[i % workers.size ()]->jobs.push_back (jobs[i]);
+
+  if (workers.size () > 1)
+    {
+      MutexLock ml (&lock);
+      nb_batches++;
+      nb_busy = workers.size () - 1;
+      pthread_cond_broadcast (&start_cond);
+    }
+
+  work (workers[0]);
+
+  MutexLock ml (&lock);
+  while (nb_busy > 0)
+    pthread_cond_wait (&done_cond, &lock);
+}
+
+void *
+WorkStealingPool::run_thread (void *data)
+{
+  Worker *W = (Worker *) data;
+  WorkStealingPool *pool = W->pool;
+  unsigned long nb_batches = 0;
+
+  for (;;)
+    {
+      {
+	MutexLock ml (&pool->lock);
+	while (! pool->terminating && pool->nb_batches == nb_batches)
+	  pthread_cond_wait (&pool->start_cond, &pool->lock);
+	if (pool->terminating)
+	  break;
+	nb_batches = pool->nb_batches;
+      }
+
+      pool->work (W);
+
+      MutexLock ml (&pool->lock);
+      if (--pool->nb_busy == 0)
+	pthread_cond_signal (&pool->done_cond);
+    }
+
+  return NULL;
+}
+
+void
+WorkStealingPool::work (Worker *W)
+{
+  Job *job;
+
+  while ((job = take (W)) != NULL)
+    job->run (W->index);
+}
+
+/* Next job of the worker W: the last one of its own deque or, if it is
+ * empty, the first one of the deque of another worker. Jobs are not added
+ * during a batch, so the batch is over for W once all deques are found
+ * empty. */
+WorkStealingPool::Job *
+WorkStealingPool::take (Worker *W)
+{
+  Job *result = NULL;
+
+  {
+    MutexLock ml (&W->lock);
+    if (! W->jobs.empty ())
+      {
+	result = W->jobs.back ();
+	W->jobs.pop_back ();
+	return result;
+      }
+  }
+
+  for (size_t i = 1; i < workers.size () && result == NULL; i++)
+    {
+      Worker *victim = workers[(W->index + i) % workers.size ()];
+      MutexLock ml (&victim->lock);
+
+      if (! victim->jobs.empty ())
+	{
+	  result = victim->jobs.front ();
+	  victim->jobs.pop_front ();
+	}
+    }
+
+  return result;
+}
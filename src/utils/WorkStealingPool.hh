@@ -0,0 +1,94 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef UTILS_WORKSTEALINGPOOL_HH
+#define UTILS_WORKSTEALINGPOOL_HH
+
+#include <pthread.h>
+
+#include <deque>
+#include <vector>
+
+/* A fixed set of threads that run batches of jobs. Each worker has its
+ * own deque of jobs: it takes its jobs from the back of its deque and,
+ * once the deque is empty, steals jobs from the front of the deques of
+ * the other workers. Threads are kept between batches. */
+class WorkStealingPool
+{
+public:
+  class Job
+  {
+  public:
+    virtual ~Job () { }
+
+    /* Runs the job on the worker of index 'worker'; the thread that calls
+     * WorkStealingPool::run() is the worker 0. Jobs must not throw. */
+    virtual void run (int worker) = 0;
+  };
+
+  /* Starts 'nb_workers' - 1 threads. If some of them cannot be created,
+   * the pool works with the ones already started. */
+  explicit WorkStealingPool (int nb_workers);
+  ~WorkStealingPool ();
+
+  int get_nb_workers () const;
+
+  /* Runs the 'jobs', which are dealt to the workers in turn, and returns
+   * once all of them are done. Jobs do not belong to the pool. */
+  void run (const std::vector<Job *> &jobs);
+
+private:
+  struct Worker {
+    WorkStealingPool *pool;
+    int index;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    std::deque<Job *> jobs;
+  };
+
+  WorkStealingPool (const WorkStealingPool &);
+  WorkStealingPool &operator= (const WorkStealingPool &);
+
+  static void *run_thread (void *worker);
+  void work (Worker *W);
+  Job *take (Worker *W);
+
+  std::vector<Worker *> workers;
+  pthread_mutex_t lock;
+  pthread_cond_t start_cond;
+  pthread_cond_t done_cond;
+  /* Number of batches started so far */
+  unsigned long nb_batches;
+  /* Number of threads still working on the current batch */
+  int nb_busy;
+  bool terminating;
+};
+
+#endif /* UTILS_WORKSTEALINGPOOL_HH */
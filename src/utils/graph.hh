@@ -207,22 +207,50 @@ public:
   virtual bool contains(Node *n) const;
 
 
+  /* ***************************************************/
+  /**
+   * \brief  return the number of predecessors of a node.
+   * Implementations keep an index of the incoming edges
+   * of each node up to date as edges are added, so that
+   * this is done in constant time.
+   * \param  n the node
+   * \returns number of predecessors of n
+   */
+  /* ***************************************************/
+  virtual int get_nb_predecessors(Node *n) const = 0;
+
+  /* ***************************************************/
+  /**
+   * \brief  return the i-th predecessor of a node in
+   * constant time
+   * \param  n the node
+   * \param  i index of the incoming edge, between 0 and
+   * get_nb_predecessors(n) - 1
+   * \returns  the incoming edge and its source node
+   */
+  /* ***************************************************/
+  virtual std::pair<Edge *, Node *> get_predecessor(Node *n, int i) const = 0;
+
   /* ***************************************************/
   /**
    * \brief  return the first predecessor of a node
    * \param  n the node
-   * \returns  first predecessor (edge) or NULL if none
+   * \returns  first predecessor (edge and source) or NULL
+   * if none
    */
   /* ***************************************************/
   virtual std::pair<Edge *, Node *> get_first_predecessor(Node *n) const;
 
   /* ***************************************************/
   /**
-   * \brief  return another predecessor of a node n
+   * \brief  return another predecessor of a node n. This
+   * looks e up among the incoming edges of n; loops over
+   * all the predecessors should rather keep the index (see
+   * GraphPredecessorCursor).
    * \param  n the node
    * \param  e last enumerated edge
-   * \returns another predecessor (edge) or NULL if no more
-   * edge
+   * \returns another predecessor (edge and source) or NULL
+   * if no more edge
    */
   /* ***************************************************/
   virtual std::pair<Edge *, Node *> get_next_predecessor(Node *n, Edge *e) const ;
@@ -237,15 +265,6 @@ public:
   /* ***************************************************/
   virtual int get_nb_successors(Node *n) const;
 
-  /* ***************************************************/
-  /**
-   * \brief  return the number of predecessors of a node
-   * \param  n the node
-   * \returns number of predecessors of n
-   */
-  /* ***************************************************/
-  virtual int get_nb_predecessors(Node *n) const;
-
   /* ***************************************************/
   /**
    * \brief Performs a depth-first run on the microcode graph
@@ -323,7 +342,10 @@ public:
   /* ***************************************************/
   /**
    * \brief  Get all nodes located on a path starting from
-   * \code start  and ending in \code end.
+   * \code start  and ending in \code end. Paths stop at
+   * the first end node they meet. Nodes are listed once,
+   * in the order they are reached from start. Runs in time
+   * linear in the size of the graph.
    * The caller must delete himself the resulting list
    * \param  start starting node of path
    * \param  end ending node of path
@@ -352,6 +374,47 @@ public:
   virtual void toDot(std::ostream &out) const;
 };
 
+/* ***************************************************/
+/**
+ * \brief  Current predecessor (edge and source) of a loop
+ * over the predecessors of a node, which keeps the index
+ * of the predecessor between the steps.
+ */
+/* ***************************************************/
+template<typename Node, typename Edge, typename NodeStore>
+class GraphPredecessorCursor : public std::pair<Edge *, Node *>
+{
+public:
+  GraphPredecessorCursor(const GraphInterface<Node, Edge, NodeStore> *g,
+                         Node *n)
+    : std::pair<Edge *, Node *>(NULL, NULL), g(g), n(n), index(0),
+      nb(g->get_nb_predecessors(n))
+  {
+    load();
+  }
+
+  void next()
+  {
+    index++;
+    load();
+  }
+
+private:
+  void load()
+  {
+    if (index < nb)
+      static_cast<std::pair<Edge *, Node *> &>(*this) =
+        g->get_predecessor(n, index);
+    else
+      this->first = NULL;
+  }
+
+  const GraphInterface<Node, Edge, NodeStore> *g;
+  Node *n;
+  int index;
+  int nb;
+};
+
 #include "graph.ii"
 
 #endif /* UTILS_GRAPH_HH */
@@ -31,6 +31,8 @@
 #ifndef UTILS_TOOLS_H
 #define UTILS_TOOLS_H
 
+#include <stdint.h>
+
 #include <string>
 
 #define STATIC_ARRAY_COUNT(array) (sizeof (array) / sizeof (array)[0])
@@ -38,4 +40,19 @@
 /** \brief Convert an int to a string (cf. 'itoa()') */
 std::string itos(int i);
 
+/** \brief Scramble the bits of 'x' (finalizer of MurmurHash3). Sums of
+ *  scrambled items give hash values of sets that do not depend on the
+ *  order of the items and can be updated when an item changes. */
+inline uint64_t
+hash_mix (uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+
+  return x;
+}
+
 #endif /* UTILS_TOOLS_H */
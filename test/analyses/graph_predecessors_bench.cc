@@ -0,0 +1,228 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Predecessor access benchmark. A synthetic program of N nodes is built
+ * where each node goes to the next one and to a pseudo-random one. The
+ * benchmark reports the time needed to go through all the predecessors
+ * of all the nodes with the predecessor index and with the iteration
+ * functions of the graph interface, the time of a scan of the whole
+ * graph per node (what the predecessor accessors cost without index),
+ * and the time of get_nodes_between from the entry point to the last
+ * node. The same measures are made on the CFG of the program and on a
+ * frozen snapshot of it, which is also swept through node identifiers.
+ *
+ * USAGE: analyses_graph_predecessors_bench [nb-nodes]
+ *
+ * By default, the program has 100000 nodes.
+ */
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <list>
+
+#include <analyses/CFG.hh>
+#include <kernel/FrozenMicrocode.hh>
+#include <kernel/Microcode.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+#include <benchmarks.hh>
+
+using namespace std;
+
+/* Number of nodes for which the whole graph is scanned */
+static const int NB_SCANNED_NODES = 10;
+
+template<typename Node, typename Edge, typename NodeStore> static void
+s_bench (const char *name, GraphInterface<Node, Edge, NodeStore> *g,
+	 Node *start, Node *end)
+{
+  typedef typename GraphInterface<Node, Edge, NodeStore>::const_node_iterator
+    node_iterator;
+  long nb_nodes = 0;
+  long nb_preds = 0;
+  double start_time = bench_now ();
+
+  for (node_iterator n = g->begin_nodes (); n != g->end_nodes (); n++)
+    {
+      int nb = g->get_nb_predecessors (*n);
+      for (int i = 0; i < nb; i++)
+	if (g->get_predecessor (*n, i).second != NULL)
+	  nb_preds++;
+      nb_nodes++;
+    }
+  double indexed = bench_now () - start_time;
+
+  long nb_iterated = 0;
+  start_time = bench_now ();
+  for (node_iterator n = g->begin_nodes (); n != g->end_nodes (); n++)
+    {
+      for (std::pair<Edge *, Node *> p = g->get_first_predecessor (*n);
+	   p.first != NULL; p = g->get_next_predecessor (*n, p.first))
+	nb_iterated++;
+    }
+  double iterated = bench_now () - start_time;
+
+  long nb_scanned = 0;
+  int nb_scans = 0;
+  start_time = bench_now ();
+  for (node_iterator n = g->begin_nodes ();
+       n != g->end_nodes () && nb_scans < NB_SCANNED_NODES; n++, nb_scans++)
+    {
+      for (node_iterator m = g->begin_nodes (); m != g->end_nodes (); m++)
+	{
+	  for (std::pair<Edge *, Node *> s = g->get_first_successor (*m);
+	       s.first != NULL; s = g->get_next_successor (*m, s.first))
+	    if (s.second == *n)
+	      nb_scanned++;
+	}
+    }
+  double scanned = (bench_now () - start_time) / nb_scans;
+
+  start_time = bench_now ();
+  std::list<Node *> *between = g->get_nodes_between (start, end);
+  double nodes_between = bench_now () - start_time;
+
+  if (nb_iterated != nb_preds)
+    cerr << name << ": " << nb_iterated << " iterated predecessors instead of "
+	 << nb_preds << endl;
+
+  cout << setw (10) << name << setw (10) << nb_nodes << setw (10) << nb_preds
+       << fixed << setprecision (1)
+       << setw (14) << indexed * 1e9 / nb_preds
+       << setw (14) << iterated * 1e9 / nb_preds
+       << setw (14) << scanned * 1e6
+       << setw (10) << between->size ()
+       << setw (14) << nodes_between * 1e3 << endl;
+  delete between;
+}
+
+/* Sweep of the predecessors through the identifiers of the snapshot */
+static void
+s_bench_ids (const FrozenMicrocode *fm)
+{
+  size_t nb_preds = 0;
+  size_t sum = 0;
+  double start_time = bench_now ();
+
+  for (size_t n = 0; n < fm->get_number_of_nodes (); n++)
+    {
+      size_t end = fm->get_predecessors_end (n);
+      for (size_t p = fm->get_predecessors_begin (n); p < end; p++)
+	{
+	  sum += fm->get_predecessor_source (p);
+	  nb_preds++;
+	}
+    }
+  double indexed = bench_now () - start_time;
+
+  cout << setw (10) << "ids" << setw (10) << fm->get_number_of_nodes ()
+       << setw (10) << nb_preds << fixed << setprecision (1)
+       << setw (14) << indexed * 1e9 / nb_preds
+       << setw (14) << "-" << setw (14) << "-" << setw (10) << "-"
+       << setw (14) << "-" << endl;
+  if (sum == 0 && nb_preds > 0)
+    cerr << "no predecessor outside of the entry point" << endl;
+}
+
+int
+main (int argc, char **argv)
+{
+  long nb_nodes = 100000;
+  ConfigTable ct;
+
+  if (argc > 1)
+    nb_nodes = atol (argv[1]);
+
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+  insight::init (ct);
+
+  Microcode *mc = new Microcode ();
+  double start_time = bench_now ();
+  unsigned long r = 1;
+
+  mc->set_entry_point (MicrocodeAddress (0));
+  for (long i = 0; i + 1 < nb_nodes; i++)
+    {
+      r = r * 1103515245 + 12345;
+      mc->add_skip (MicrocodeAddress (i), MicrocodeAddress (i + 1));
+      mc->add_skip (MicrocodeAddress (i),
+		    MicrocodeAddress ((r >> 16) % nb_nodes));
+    }
+  double build = bench_now () - start_time;
+
+  start_time = bench_now ();
+  Microcode *copy = new Microcode (*mc);
+  double build_copy = bench_now () - start_time;
+
+  start_time = bench_now ();
+  FrozenMicrocode *frozen = mc->freeze ();
+  double build_frozen = bench_now () - start_time;
+
+  start_time = bench_now ();
+  CFG *cfg = CFG::createFromMicrocode (mc, MicrocodeAddress (0), false);
+  double build_cfg = bench_now () - start_time;
+
+  cout << "build: microcode " << fixed << setprecision (1) << build * 1e3
+       << " ms, copy " << build_copy * 1e3 << " ms, frozen "
+       << build_frozen * 1e3 << " ms, cfg "
+       << build_cfg * 1e3 << " ms" << endl << endl;
+
+  cout << setw (10) << "graph" << setw (10) << "nodes" << setw (10) << "preds"
+       << setw (14) << "ns/indexed" << setw (14) << "ns/iterated"
+       << setw (14) << "us/scan" << setw (10) << "between"
+       << setw (14) << "ms/between" << endl;
+
+  MicrocodeNode *last = mc->get_node (MicrocodeAddress (nb_nodes - 1));
+  s_bench ("microcode", mc, mc->get_entry_point (), last);
+  s_bench ("copy", copy, copy->get_entry_point (),
+	   copy->get_node (MicrocodeAddress (nb_nodes - 1)));
+  s_bench ("frozen", frozen, frozen->get_entry_point (), last);
+  s_bench_ids (frozen);
+
+  CFG::node_type *cfg_last = NULL;
+  for (CFG::const_node_iterator b = cfg->begin_nodes ();
+       b != cfg->end_nodes (); b++)
+    if ((*b)->get_exit () == last)
+      cfg_last = *b;
+  s_bench ("cfg", cfg, cfg->get_entry_point (), cfg_last);
+
+  delete cfg;
+  delete frozen;
+  delete copy;
+  delete mc;
+
+  insight::terminate ();
+
+  return EXIT_SUCCESS;
+}
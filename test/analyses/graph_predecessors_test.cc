@@ -0,0 +1,342 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <atf-c++.hpp>
+#include <list>
+#include <set>
+
+#include <analyses/CFG.hh>
+#include <io/expressions/expr-parser.hh>
+#include <kernel/Architecture.hh>
+#include <kernel/Expressions.hh>
+#include <kernel/FrozenMicrocode.hh>
+#include <kernel/Microcode.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+using namespace std;
+
+#define SETUP()							\
+  ConfigTable ct;						\
+  ct.set (logs::DEBUG_ENABLED_PROP, false);			\
+  ct.set (logs::STDIO_ENABLED_PROP, true);			\
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);		\
+  insight::init (ct);						\
+  MicrocodeArchitecture ma						\
+    (Architecture::getArchitecture (Architecture::X86_32));	\
+  Microcode *mc = new Microcode ();				\
+  mc->set_entry_point (MicrocodeAddress (1))
+
+#define TEARDOWN()				\
+  delete mc;					\
+  insight::terminate ()
+
+static Expr *
+s_expr (const MicrocodeArchitecture &ma, const char *e)
+{
+  Expr *result = expr_parser (e, &ma);
+  ATF_REQUIRE (result != NULL);
+
+  return result;
+}
+
+static StmtArrow *
+s_skip (Microcode *mc, address_t from, address_t to)
+{
+  return mc->add_skip (MicrocodeAddress (from), MicrocodeAddress (to));
+}
+
+static StmtArrow *
+s_jump (Microcode *mc, const MicrocodeArchitecture &ma, address_t from,
+	const char *target)
+{
+  return mc->add_jump (MicrocodeAddress (from), s_expr (ma, target));
+}
+
+static MicrocodeNode *
+s_node (Microcode *mc, address_t addr)
+{
+  return mc->get_node (MicrocodeAddress (addr));
+}
+
+/* The sources of the predecessors of n, checking that the indexed, the
+ * iterated and the cursor predecessors agree. */
+static set<address_t>
+s_sources (Microcode *mc, MicrocodeNode *n)
+{
+  set<address_t> result;
+  int i = 0;
+
+  for (pair<StmtArrow *, MicrocodeNode *> p = mc->get_first_predecessor (n);
+       p.first != NULL; p = mc->get_next_predecessor (n, p.first), i++)
+    {
+      ATF_REQUIRE (i < mc->get_nb_predecessors (n));
+      ATF_REQUIRE_EQ (mc->get_predecessor (n, i).first, p.first);
+      ATF_REQUIRE_EQ (p.first->get_src (), p.second);
+      ATF_REQUIRE_EQ (mc->get_target (p.first), n);
+      result.insert (p.second->get_loc ().getGlobal ());
+    }
+  ATF_REQUIRE_EQ (i, mc->get_nb_predecessors (n));
+
+  i = 0;
+  for (GraphPredecessorCursor<MicrocodeNode, StmtArrow, NodeStore> p (mc, n);
+       p.first != NULL; p.next (), i++)
+    ATF_REQUIRE_EQ (mc->get_predecessor (n, i).first, p.first);
+  ATF_REQUIRE_EQ (i, mc->get_nb_predecessors (n));
+
+  return result;
+}
+
+static set<address_t>
+s_addresses (address_t a, address_t b = 0, address_t c = 0)
+{
+  set<address_t> result;
+
+  result.insert (a);
+  if (b != 0)
+    result.insert (b);
+  if (c != 0)
+    result.insert (c);
+
+  return result;
+}
+
+ATF_TEST_CASE (static_arrows)
+
+ATF_TEST_CASE_HEAD (static_arrows)
+{
+  set_md_var ("descr", "static arrows are predecessors of their targets");
+}
+
+ATF_TEST_CASE_BODY (static_arrows)
+{
+  SETUP ();
+  s_skip (mc, 1, 2);
+  s_skip (mc, 1, 3);
+  s_skip (mc, 2, 4);
+  s_skip (mc, 3, 4);
+  s_skip (mc, 4, 4);
+  s_jump (mc, ma, 4, "1{0;32}");
+
+  ATF_REQUIRE (s_sources (mc, s_node (mc, 1)) == s_addresses (4));
+  ATF_REQUIRE (mc->get_predecessor (s_node (mc, 1), 0).first->is_dynamic ());
+  ATF_REQUIRE (s_sources (mc, s_node (mc, 2)) == s_addresses (1));
+  ATF_REQUIRE (s_sources (mc, s_node (mc, 4)) == s_addresses (2, 3, 4));
+
+  mc->simplify_and_clean_targets ();
+  ATF_REQUIRE (s_sources (mc, s_node (mc, 1)) == s_addresses (4));
+  ATF_REQUIRE_EQ (mc->get_nb_predecessors (s_node (mc, 1)), 1);
+  ATF_REQUIRE (mc->get_predecessor (s_node (mc, 1), 0).first->is_static ());
+  ATF_REQUIRE_EQ (mc->get_nb_predecessors (s_node (mc, 4)), 3);
+
+  TEARDOWN ();
+}
+
+ATF_TEST_CASE (missing_targets)
+
+ATF_TEST_CASE_HEAD (missing_targets)
+{
+  set_md_var ("descr", "nodes added for missing targets get their "
+	      "predecessors");
+}
+
+ATF_TEST_CASE_BODY (missing_targets)
+{
+  SETUP ();
+  s_skip (mc, 1, 2);
+  s_jump (mc, ma, 2, "9{0;32}");
+  s_jump (mc, ma, 1, "9{0;32}");
+  s_jump (mc, ma, 2, "%eax");
+
+  mc->simplify_and_clean_targets ();
+  ATF_REQUIRE_EQ (mc->get_number_of_nodes (), (size_t) 3);
+  ATF_REQUIRE (s_sources (mc, s_node (mc, 9)) == s_addresses (1, 2));
+  ATF_REQUIRE_EQ (mc->get_nb_successors (s_node (mc, 2)), 2);
+  ATF_REQUIRE (s_node (mc, 2)->get_successors ()->at (0)->is_dynamic ());
+  ATF_REQUIRE (s_node (mc, 2)->get_successors ()->at (1)->is_static ());
+
+  TEARDOWN ();
+}
+
+ATF_TEST_CASE (constant_jumps)
+
+ATF_TEST_CASE_HEAD (constant_jumps)
+{
+  set_md_var ("descr", "jumps to a constant address are predecessors of "
+	      "their target once it exists, as in the frozen program");
+}
+
+ATF_TEST_CASE_BODY (constant_jumps)
+{
+  SETUP ();
+  s_jump (mc, ma, 1, "3{0;32}");
+  s_jump (mc, ma, 1, "%eax");
+  s_skip (mc, 1, 2);
+  ATF_REQUIRE_EQ (mc->get_number_of_nodes (), (size_t) 2);
+  ATF_REQUIRE (mc->get_target (s_node (mc, 1)->get_successors ()->at (0))
+	       == NULL);
+
+  s_skip (mc, 2, 3);
+  ATF_REQUIRE (s_sources (mc, s_node (mc, 3)) == s_addresses (1, 2));
+
+  Microcode *cp = new Microcode (*mc);
+  ATF_REQUIRE (s_sources (cp, s_node (cp, 3)) == s_addresses (1, 2));
+  delete cp;
+
+  FrozenMicrocode *fmc = mc->freeze ();
+  for (address_t a = 1; a <= 3; a++)
+    ATF_REQUIRE_EQ (fmc->get_nb_predecessors (s_node (mc, a)),
+		    mc->get_nb_predecessors (s_node (mc, a)));
+  delete fmc;
+
+  TEARDOWN ();
+}
+
+ATF_TEST_CASE (copy)
+
+ATF_TEST_CASE_HEAD (copy)
+{
+  set_md_var ("descr", "a copy indexes its own arrows");
+}
+
+ATF_TEST_CASE_BODY (copy)
+{
+  SETUP ();
+  s_skip (mc, 1, 2);
+  s_skip (mc, 2, 1);
+  s_skip (mc, 2, 3);
+
+  Microcode *cp = new Microcode (*mc);
+  for (address_t a = 1; a <= 3; a++)
+    {
+      MicrocodeNode *n = s_node (cp, a);
+      ATF_REQUIRE (s_sources (cp, n) == s_sources (mc, s_node (mc, a)));
+      for (int i = 0; i < cp->get_nb_predecessors (n); i++)
+	ATF_REQUIRE_EQ (cp->get_predecessor (n, i).second,
+			s_node (cp, cp->get_predecessor (n, i).second
+				->get_loc ().getGlobal ()));
+    }
+  delete cp;
+
+  TEARDOWN ();
+}
+
+ATF_TEST_CASE (nodes_between)
+
+ATF_TEST_CASE_HEAD (nodes_between)
+{
+  set_md_var ("descr", "nodes between are those on a path to the end, "
+	      "listed once");
+}
+
+ATF_TEST_CASE_BODY (nodes_between)
+{
+  SETUP ();
+  s_skip (mc, 1, 2);
+  s_skip (mc, 1, 5);
+  s_skip (mc, 2, 3);
+  s_skip (mc, 3, 2);
+  s_skip (mc, 3, 4);
+  s_skip (mc, 4, 6);
+  s_skip (mc, 5, 7);
+
+  list<MicrocodeNode *> *between =
+    mc->get_nodes_between (s_node (mc, 1), s_node (mc, 4));
+  set<address_t> found;
+  for (list<MicrocodeNode *>::iterator i = between->begin ();
+       i != between->end (); i++)
+    ATF_REQUIRE (found.insert ((*i)->get_loc ().getGlobal ()).second);
+  ATF_REQUIRE_EQ (between->front (), s_node (mc, 1));
+  ATF_REQUIRE_EQ (found.size (), (size_t) 4);
+  ATF_REQUIRE (found.find (5) == found.end ());
+  ATF_REQUIRE (found.find (6) == found.end ());
+  delete between;
+
+  between = mc->get_nodes_between (s_node (mc, 2), s_node (mc, 1));
+  ATF_REQUIRE (between->empty ());
+  delete between;
+
+  TEARDOWN ();
+}
+
+ATF_TEST_CASE (cfg)
+
+ATF_TEST_CASE_HEAD (cfg)
+{
+  set_md_var ("descr", "basic blocks index their incoming edges");
+}
+
+ATF_TEST_CASE_BODY (cfg)
+{
+  SETUP ();
+  s_skip (mc, 1, 2);
+  s_skip (mc, 2, 3);
+  s_skip (mc, 2, 4);
+  s_skip (mc, 3, 5);
+  s_skip (mc, 4, 5);
+  s_skip (mc, 5, 6);
+  s_skip (mc, 6, 2);
+
+  CFG *cfg = CFG::createFromMicrocode (mc, MicrocodeAddress (1), false);
+  int nb_edges = 0;
+  for (CFG::node_iterator b = cfg->begin_nodes (); b != cfg->end_nodes (); b++)
+    {
+      int nb = cfg->get_nb_predecessors (*b);
+      for (int i = 0; i < nb; i++)
+	{
+	  pair<CFG::edge_type *, CFG::node_type *> p =
+	    cfg->get_predecessor (*b, i);
+	  ATF_REQUIRE_EQ (cfg->get_target (p.first), *b);
+	  ATF_REQUIRE_EQ (cfg->get_source (p.first), p.second);
+	}
+      nb_edges += nb;
+      if ((*b)->get_entry () == s_node (mc, 2) ||
+	  (*b)->get_entry () == s_node (mc, 5))
+	ATF_REQUIRE_EQ (nb, 2);
+      else if (*b == cfg->get_entry_point ())
+	ATF_REQUIRE_EQ (nb, 0);
+      else
+	ATF_REQUIRE_EQ (nb, 1);
+    }
+  ATF_REQUIRE_EQ (nb_edges, 6);
+  delete cfg;
+
+  TEARDOWN ();
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+  ATF_ADD_TEST_CASE(tcs, static_arrows);
+  ATF_ADD_TEST_CASE(tcs, missing_targets);
+  ATF_ADD_TEST_CASE(tcs, constant_jumps);
+  ATF_ADD_TEST_CASE(tcs, copy);
+  ATF_ADD_TEST_CASE(tcs, nodes_between);
+  ATF_ADD_TEST_CASE(tcs, cfg);
+}
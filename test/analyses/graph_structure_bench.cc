@@ -0,0 +1,191 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Graph structure benchmark. Synthetic graphs of N/8, N/4, N/2 and N
+ * vertices are built where each vertex goes to the next one, often to
+ * a close previous one (nested loops) and sometimes to any vertex
+ * (irreducible loops). The benchmark reports the time needed to compute
+ * their dominators, post-dominators, components and loop nesting
+ * forest, per vertex and arc, which should remain about constant as N
+ * grows. The same is done on a program of N/10 nodes built the same
+ * way, through a frozen snapshot (whose construction is included in the
+ * time), through the graph interface of the program and through its
+ * CFG.
+ *
+ * USAGE: analyses_graph_structure_bench [nb-vertices]
+ *
+ * By default, the largest graph has 1000000 vertices.
+ */
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <analyses/CFG.hh>
+#include <analyses/GraphStructure.hh>
+#include <kernel/FrozenMicrocode.hh>
+#include <kernel/Microcode.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+#include <benchmarks.hh>
+
+using namespace std;
+
+/* Targets of the arcs leaving vertex i of a graph of n vertices */
+static void
+s_targets (size_t i, size_t n, unsigned long &r, vector<size_t> &targets)
+{
+  targets.clear ();
+  if (i + 1 < n)
+    targets.push_back (i + 1);
+
+  r = r * 1103515245 + 12345;
+  if ((r >> 16) % 4 == 0)
+    targets.push_back (i - (r >> 20) % 64 % (i + 1));
+  else if ((r >> 16) % 32 == 1)
+    targets.push_back ((r >> 20) % n);
+}
+
+static void
+s_report (const char *name, const GraphStructure *G, size_t nb_arcs,
+	  double elapsed)
+{
+  size_t nb_irreducible = 0;
+
+  for (size_t l = 0; l < G->get_number_of_loops (); l++)
+    if (! G->is_loop_reducible (l))
+      nb_irreducible++;
+
+  cout << setw (10) << name << setw (10) << G->get_number_of_vertices ()
+       << setw (10) << nb_arcs << setw (10) << G->get_number_of_sccs ()
+       << setw (10) << G->get_number_of_loops ()
+       << setw (10) << nb_irreducible
+       << fixed << setprecision (1)
+       << setw (10) << elapsed * 1e3
+       << setw (14) << elapsed * 1e9 / (G->get_number_of_vertices () + nb_arcs)
+       << endl;
+}
+
+int
+main (int argc, char **argv)
+{
+  size_t nb_vertices = 1000000;
+  ConfigTable ct;
+
+  if (argc > 1)
+    nb_vertices = atol (argv[1]);
+
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+  insight::init (ct);
+
+  cout << setw (10) << "graph" << setw (10) << "vertices"
+       << setw (10) << "arcs" << setw (10) << "sccs" << setw (10) << "loops"
+       << setw (10) << "irred." << setw (10) << "ms"
+       << setw (14) << "ns/(v+a)" << endl;
+
+  vector<size_t> targets;
+  for (size_t n = nb_vertices / 8; n <= nb_vertices; n *= 2)
+    {
+      vector<size_t> successors_begin;
+      vector<size_t> successors;
+      unsigned long r = 1;
+
+      for (size_t i = 0; i < n; i++)
+	{
+	  successors_begin.push_back (successors.size ());
+	  s_targets (i, n, r, targets);
+	  successors.insert (successors.end (), targets.begin (),
+			     targets.end ());
+	}
+      successors_begin.push_back (successors.size ());
+
+      double start_time = bench_now ();
+      GraphStructure *G =
+	new GraphStructure (n, 0, successors_begin, successors);
+      s_report ("csr", G, successors.size (), bench_now () - start_time);
+      delete G;
+
+      if (n == 0)
+	break;
+    }
+
+  size_t nb_nodes = nb_vertices / 10;
+  Microcode *mc = new Microcode ();
+  unsigned long r = 1;
+  size_t nb_arrows = 0;
+
+  mc->set_entry_point (MicrocodeAddress (0));
+  for (size_t i = 0; i < nb_nodes; i++)
+    {
+      s_targets (i, nb_nodes, r, targets);
+      for (size_t t = 0; t < targets.size (); t++)
+	mc->add_skip (MicrocodeAddress (i), MicrocodeAddress (targets[t]));
+      nb_arrows += targets.size ();
+    }
+  if (nb_nodes > 0)
+    mc->get_or_create_node (MicrocodeAddress (nb_nodes - 1));
+
+  double start_time = bench_now ();
+  FrozenMicrocode *frozen = mc->freeze ();
+  GraphStructure *G = new GraphStructure (frozen);
+  s_report ("frozen", G, nb_arrows, bench_now () - start_time);
+  delete G;
+  delete frozen;
+
+  start_time = bench_now ();
+  G = GraphStructure::create (mc);
+  s_report ("microcode", G, nb_arrows, bench_now () - start_time);
+  delete G;
+
+  start_time = bench_now ();
+  CFG *cfg = CFG::createFromMicrocode (mc, MicrocodeAddress (0), false);
+  double build_cfg = bench_now () - start_time;
+
+  size_t nb_edges = 0;
+  for (CFG::node_iterator b = cfg->begin_nodes (); b != cfg->end_nodes (); b++)
+    nb_edges += cfg->get_nb_predecessors (*b);
+
+  start_time = bench_now ();
+  G = GraphStructure::create (cfg);
+  s_report ("cfg", G, nb_edges, bench_now () - start_time);
+  cout << endl << "cfg built in " << fixed << setprecision (1)
+       << build_cfg * 1e3 << " ms" << endl;
+  delete G;
+  delete cfg;
+
+  delete mc;
+  insight::terminate ();
+
+  return 0;
+}
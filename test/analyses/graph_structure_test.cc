@@ -0,0 +1,309 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <atf-c++.hpp>
+#include <vector>
+
+#include <analyses/CFG.hh>
+#include <analyses/GraphStructure.hh>
+#include <kernel/FrozenMicrocode.hh>
+#include <kernel/Microcode.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+using namespace std;
+
+static const size_t NONE = GraphStructure::NONE;
+
+/* The graph of the arcs (arcs[2 i], arcs[2 i + 1]) */
+static GraphStructure *
+s_graph (size_t nb_vertices, size_t entry, const size_t *arcs, size_t nb_arcs)
+{
+  vector<size_t> successors_begin (nb_vertices + 1, 0);
+  vector<size_t> successors;
+
+  for (size_t v = 0; v < nb_vertices; v++)
+    {
+      for (size_t a = 0; a < nb_arcs; a++)
+	if (arcs[2 * a] == v)
+	  successors.push_back (arcs[2 * a + 1]);
+      successors_begin[v + 1] = successors.size ();
+    }
+
+  return new GraphStructure (nb_vertices, entry, successors_begin,
+			     successors);
+}
+
+#define NB_ARCS(arcs) (sizeof (arcs) / sizeof (arcs[0]) / 2)
+
+ATF_TEST_CASE (diamond)
+
+ATF_TEST_CASE_HEAD (diamond)
+{
+  set_md_var ("descr", "dominators and post-dominators of a diamond");
+}
+
+ATF_TEST_CASE_BODY (diamond)
+{
+  static const size_t arcs[] = { 0, 1, 0, 2, 1, 3, 2, 3, 3, 4 };
+  GraphStructure *G = s_graph (6, 0, arcs, NB_ARCS (arcs));
+
+  ATF_REQUIRE_EQ (G->get_immediate_dominator (0), NONE);
+  ATF_REQUIRE_EQ (G->get_immediate_dominator (1), 0);
+  ATF_REQUIRE_EQ (G->get_immediate_dominator (2), 0);
+  ATF_REQUIRE_EQ (G->get_immediate_dominator (3), 0);
+  ATF_REQUIRE_EQ (G->get_immediate_dominator (4), 3);
+  ATF_REQUIRE (G->dominates (0, 4));
+  ATF_REQUIRE (G->dominates (3, 3));
+  ATF_REQUIRE (! G->dominates (1, 3));
+
+  /* Vertex 5 is not reachable from the entry */
+  ATF_REQUIRE (! G->is_reachable (5));
+  ATF_REQUIRE_EQ (G->get_immediate_dominator (5), NONE);
+  ATF_REQUIRE (! G->dominates (0, 5));
+  ATF_REQUIRE (! G->dominates (5, 5));
+
+  ATF_REQUIRE_EQ (G->get_immediate_post_dominator (0), 3);
+  ATF_REQUIRE_EQ (G->get_immediate_post_dominator (1), 3);
+  ATF_REQUIRE_EQ (G->get_immediate_post_dominator (3), 4);
+  ATF_REQUIRE_EQ (G->get_immediate_post_dominator (4), NONE);
+  ATF_REQUIRE_EQ (G->get_immediate_post_dominator (5), NONE);
+  ATF_REQUIRE (G->post_dominates (4, 0));
+  ATF_REQUIRE (! G->post_dominates (2, 0));
+
+  ATF_REQUIRE_EQ (G->get_number_of_sccs (), 6);
+  ATF_REQUIRE (G->get_scc (0) > G->get_scc (1));
+  ATF_REQUIRE (G->get_scc (1) > G->get_scc (3));
+  ATF_REQUIRE (G->get_scc (3) > G->get_scc (4));
+  ATF_REQUIRE_EQ (G->get_number_of_loops (), 0);
+  ATF_REQUIRE_EQ (G->get_innermost_loop (3), NONE);
+
+  delete G;
+}
+
+ATF_TEST_CASE (nested_loops)
+
+ATF_TEST_CASE_HEAD (nested_loops)
+{
+  set_md_var ("descr", "a loop and a self-loop nested in an outer loop");
+}
+
+ATF_TEST_CASE_BODY (nested_loops)
+{
+  static const size_t arcs[] = {
+    0, 1, 1, 2, 2, 3, 3, 2, 3, 4, 4, 4, 4, 1, 4, 5
+  };
+  GraphStructure *G = s_graph (6, 0, arcs, NB_ARCS (arcs));
+
+  ATF_REQUIRE_EQ (G->get_number_of_loops (), 3);
+
+  size_t outer = G->get_innermost_loop (1);
+  size_t inner = G->get_innermost_loop (3);
+  size_t self = G->get_innermost_loop (4);
+
+  ATF_REQUIRE_EQ (G->get_loop_header (outer), 1);
+  ATF_REQUIRE_EQ (G->get_loop_header (inner), 2);
+  ATF_REQUIRE_EQ (G->get_loop_header (self), 4);
+  ATF_REQUIRE_EQ (G->get_innermost_loop (2), inner);
+  ATF_REQUIRE_EQ (G->get_innermost_loop (0), NONE);
+  ATF_REQUIRE_EQ (G->get_innermost_loop (5), NONE);
+
+  ATF_REQUIRE_EQ (G->get_loop_parent (outer), NONE);
+  ATF_REQUIRE_EQ (G->get_loop_parent (inner), outer);
+  ATF_REQUIRE_EQ (G->get_loop_parent (self), outer);
+  ATF_REQUIRE (inner < outer && self < outer);
+  ATF_REQUIRE_EQ (G->get_loop_depth (outer), 1);
+  ATF_REQUIRE_EQ (G->get_loop_depth (inner), 2);
+  ATF_REQUIRE (G->is_loop_reducible (outer));
+  ATF_REQUIRE (G->is_loop_reducible (inner));
+
+  ATF_REQUIRE_EQ (G->get_number_of_sccs (), 3);
+  ATF_REQUIRE_EQ (G->get_scc (1), G->get_scc (4));
+  ATF_REQUIRE_EQ (G->get_scc (2), G->get_scc (3));
+  ATF_REQUIRE (G->get_scc (0) > G->get_scc (1));
+  ATF_REQUIRE (G->get_scc (1) > G->get_scc (5));
+
+  ATF_REQUIRE_EQ (G->get_immediate_dominator (4), 3);
+  ATF_REQUIRE_EQ (G->get_immediate_post_dominator (1), 2);
+  ATF_REQUIRE_EQ (G->get_immediate_post_dominator (2), 3);
+  ATF_REQUIRE_EQ (G->get_immediate_post_dominator (3), 4);
+
+  delete G;
+}
+
+ATF_TEST_CASE (irreducible)
+
+ATF_TEST_CASE_HEAD (irreducible)
+{
+  set_md_var ("descr", "a loop with two entries");
+}
+
+ATF_TEST_CASE_BODY (irreducible)
+{
+  static const size_t arcs[] = { 0, 1, 0, 2, 1, 2, 2, 1, 1, 3 };
+  GraphStructure *G = s_graph (4, 0, arcs, NB_ARCS (arcs));
+
+  ATF_REQUIRE_EQ (G->get_number_of_loops (), 1);
+  ATF_REQUIRE_EQ (G->get_loop_header (0), 1);
+  ATF_REQUIRE (! G->is_loop_reducible (0));
+  ATF_REQUIRE_EQ (G->get_innermost_loop (2), 0);
+  ATF_REQUIRE_EQ (G->get_immediate_dominator (1), 0);
+  ATF_REQUIRE_EQ (G->get_immediate_dominator (2), 0);
+
+  delete G;
+}
+
+ATF_TEST_CASE (infinite_loop)
+
+ATF_TEST_CASE_HEAD (infinite_loop)
+{
+  set_md_var ("descr", "post-dominators of a loop without exit");
+}
+
+ATF_TEST_CASE_BODY (infinite_loop)
+{
+  static const size_t arcs[] = { 0, 1, 0, 3, 1, 2, 2, 1 };
+  GraphStructure *G = s_graph (4, 0, arcs, NB_ARCS (arcs));
+
+  ATF_REQUIRE_EQ (G->get_immediate_post_dominator (0), NONE);
+  ATF_REQUIRE_EQ (G->get_immediate_post_dominator (3), NONE);
+  ATF_REQUIRE (G->get_immediate_post_dominator (1) == 2 ||
+	       G->get_immediate_post_dominator (2) == 1);
+  ATF_REQUIRE (G->post_dominates (1, 1));
+  ATF_REQUIRE (! G->post_dominates (1, 0));
+  ATF_REQUIRE (! G->post_dominates (3, 0));
+
+  delete G;
+}
+
+ATF_TEST_CASE (no_entry)
+
+ATF_TEST_CASE_HEAD (no_entry)
+{
+  set_md_var ("descr", "a graph without entry has no dominators");
+}
+
+ATF_TEST_CASE_BODY (no_entry)
+{
+  static const size_t arcs[] = { 0, 1, 1, 0 };
+  GraphStructure *G = s_graph (2, NONE, arcs, NB_ARCS (arcs));
+
+  ATF_REQUIRE (! G->is_reachable (0));
+  ATF_REQUIRE_EQ (G->get_immediate_dominator (1), NONE);
+  ATF_REQUIRE_EQ (G->get_number_of_sccs (), 1);
+  ATF_REQUIRE_EQ (G->get_number_of_loops (), 1);
+  ATF_REQUIRE_EQ (G->get_loop_header (0), 0);
+
+  delete G;
+
+  G = s_graph (0, NONE, arcs, 0);
+  ATF_REQUIRE_EQ (G->get_number_of_sccs (), 0);
+  ATF_REQUIRE_EQ (G->get_number_of_loops (), 0);
+  delete G;
+}
+
+ATF_TEST_CASE (microcode)
+
+ATF_TEST_CASE_HEAD (microcode)
+{
+  set_md_var ("descr", "structure of a program, of its snapshot and "
+	      "of its CFG");
+}
+
+ATF_TEST_CASE_BODY (microcode)
+{
+  ConfigTable ct;
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+  insight::init (ct);
+
+  /* 1 -> 2 -> 3 -> 4 -> 2, 4 -> 5 */
+  Microcode *mc = new Microcode ();
+  mc->set_entry_point (MicrocodeAddress (1));
+  mc->add_skip (MicrocodeAddress (1), MicrocodeAddress (2));
+  mc->add_skip (MicrocodeAddress (2), MicrocodeAddress (3));
+  mc->add_skip (MicrocodeAddress (3), MicrocodeAddress (4));
+  mc->add_skip (MicrocodeAddress (4), MicrocodeAddress (2));
+  mc->add_skip (MicrocodeAddress (4), MicrocodeAddress (5));
+
+  FrozenMicrocode *F = mc->freeze ();
+  GraphStructure *G = new GraphStructure (F);
+  GraphStructure *H = GraphStructure::create (mc);
+  size_t n2 = F->get_id (MicrocodeAddress (2));
+  size_t n4 = F->get_id (MicrocodeAddress (4));
+
+  ATF_REQUIRE_EQ (G->get_number_of_vertices (), 5);
+  ATF_REQUIRE_EQ (G->get_entry (), F->get_entry_id ());
+  ATF_REQUIRE_EQ (G->get_number_of_loops (), 1);
+  ATF_REQUIRE_EQ (G->get_loop_header (0), n2);
+  ATF_REQUIRE_EQ (G->get_innermost_loop (n4), 0);
+  ATF_REQUIRE_EQ (G->get_immediate_post_dominator (n2),
+		  F->get_id (MicrocodeAddress (3)));
+  for (size_t v = 0; v < F->get_number_of_nodes (); v++)
+    {
+      ATF_REQUIRE_EQ (H->get_immediate_dominator (v),
+		      G->get_immediate_dominator (v));
+      ATF_REQUIRE_EQ (H->get_immediate_post_dominator (v),
+		      G->get_immediate_post_dominator (v));
+      ATF_REQUIRE_EQ (H->get_innermost_loop (v), G->get_innermost_loop (v));
+    }
+  delete H;
+  delete G;
+  delete F;
+
+  /* Blocks [1], [2, 3, 4] and [5] */
+  CFG *cfg = CFG::createFromMicrocode (mc, MicrocodeAddress (1), false);
+  vector<CFG::node_type *> blocks (cfg->begin_nodes (), cfg->end_nodes ());
+  G = GraphStructure::create (cfg);
+
+  ATF_REQUIRE_EQ (G->get_number_of_vertices (), 3);
+  ATF_REQUIRE_EQ (blocks[G->get_entry ()], cfg->get_entry_point ());
+  ATF_REQUIRE_EQ (G->get_number_of_loops (), 1);
+
+  CFG::node_type *header = blocks[G->get_loop_header (0)];
+  ATF_REQUIRE_EQ (header->get_entry ()->get_loc ().getGlobal (), 2);
+  ATF_REQUIRE_EQ (G->get_immediate_dominator (G->get_loop_header (0)),
+		  G->get_entry ());
+  delete G;
+  delete cfg;
+
+  delete mc;
+  insight::terminate ();
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+  ATF_ADD_TEST_CASE(tcs, diamond);
+  ATF_ADD_TEST_CASE(tcs, nested_loops);
+  ATF_ADD_TEST_CASE(tcs, irreducible);
+  ATF_ADD_TEST_CASE(tcs, infinite_loop);
+  ATF_ADD_TEST_CASE(tcs, no_entry);
+  ATF_ADD_TEST_CASE(tcs, microcode);
+}
@@ -0,0 +1,365 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <atf-c++.hpp>
+#include <vector>
+
+#include <analyses/MicrocodeSSA.hh>
+#include <io/expressions/expr-parser.hh>
+#include <kernel/Architecture.hh>
+#include <kernel/Expressions.hh>
+#include <kernel/Microcode.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+using namespace std;
+
+#define SETUP()							\
+  ConfigTable ct;						\
+  ct.set (logs::DEBUG_ENABLED_PROP, false);			\
+  ct.set (logs::STDIO_ENABLED_PROP, true);			\
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);		\
+  insight::init (ct);						\
+  MicrocodeArchitecture ma						\
+    (Architecture::getArchitecture (Architecture::X86_32));	\
+  Microcode *mc = new Microcode ();				\
+  mc->set_entry_point (MicrocodeAddress (1))
+
+#define TEARDOWN()				\
+  delete mc;					\
+  insight::terminate ()
+
+static Expr *
+s_expr (const MicrocodeArchitecture &ma, const char *e)
+{
+  Expr *result = expr_parser (e, &ma);
+  ATF_REQUIRE (result != NULL);
+
+  return result;
+}
+
+static StmtArrow *
+s_assign (Microcode *mc, const MicrocodeArchitecture &ma, address_t from,
+	  const char *lv, const char *rv, address_t to)
+{
+  return mc->add_assignment (MicrocodeAddress (from),
+			     (LValue *) s_expr (ma, lv), s_expr (ma, rv),
+			     MicrocodeAddress (to));
+}
+
+static StmtArrow *
+s_skip (Microcode *mc, const MicrocodeArchitecture &ma, address_t from,
+	const char *guard, address_t to)
+{
+  return mc->add_skip (MicrocodeAddress (from), MicrocodeAddress (to),
+		       s_expr (ma, guard));
+}
+
+static MicrocodeNode *
+s_node (Microcode *mc, address_t addr)
+{
+  return mc->get_node (MicrocodeAddress (addr));
+}
+
+/* The definition reaching the use of the variable of lv by arr */
+static size_t
+s_reaching (const MicrocodeSSA &ssa, const MicrocodeArchitecture &ma,
+	    StmtArrow *arr, const char *lv)
+{
+  Expr *e = s_expr (ma, lv);
+  size_t var = ssa.find_variable ((LValue *) e);
+  size_t result = MicrocodeSSA::NONE;
+
+  e->deref ();
+  ATF_REQUIRE (var != MicrocodeSSA::NONE);
+  for (size_t u = 0; u < ssa.get_uses (arr).size (); u++)
+    {
+      size_t use = ssa.get_uses (arr)[u];
+      if (ssa.get_use (use).variable == var)
+	{
+	  ATF_REQUIRE_EQ (result, MicrocodeSSA::NONE);
+	  result = ssa.get_use_def (use);
+	  ATF_REQUIRE_EQ (ssa.get_use (use).arrow, arr);
+	}
+    }
+  ATF_REQUIRE (result != MicrocodeSSA::NONE);
+
+  return result;
+}
+
+static bool
+s_reaches (const MicrocodeSSA &ssa, size_t def, size_t use)
+{
+  const vector<size_t> &uses = ssa.get_def_uses (def);
+
+  for (size_t u = 0; u < uses.size (); u++)
+    if (uses[u] == use)
+      return true;
+  return false;
+}
+
+ATF_TEST_CASE (diamond)
+
+ATF_TEST_CASE_HEAD (diamond)
+{
+  set_md_var ("descr", "definitions of both branches meet in a phi-function");
+}
+
+ATF_TEST_CASE_BODY (diamond)
+{
+  SETUP ();
+  StmtArrow *left = s_skip (mc, ma, 1, "%zf", 2);
+  s_skip (mc, ma, 1, "(NOT %zf)", 3);
+  StmtArrow *a2 = s_assign (mc, ma, 2, "%eax", "1", 4);
+  StmtArrow *a3 = s_assign (mc, ma, 3, "%eax", "2", 4);
+  StmtArrow *a4 = s_assign (mc, ma, 4, "%ebx", "%eax", 5);
+  MicrocodeSSA ssa (mc);
+
+  ATF_REQUIRE_EQ (ssa.get_number_of_variables (), 3U);
+  ATF_REQUIRE_EQ (ssa.get_immediate_dominator (s_node (mc, 1)),
+		  (MicrocodeNode *) NULL);
+  ATF_REQUIRE_EQ (ssa.get_immediate_dominator (s_node (mc, 4)),
+		  s_node (mc, 1));
+  ATF_REQUIRE_EQ (ssa.get_immediate_dominator (s_node (mc, 5)),
+		  s_node (mc, 4));
+  ATF_REQUIRE_EQ (ssa.get_dominance_frontier (s_node (mc, 2)).size (), 1U);
+  ATF_REQUIRE_EQ (ssa.get_dominance_frontier (s_node (mc, 2))[0],
+		  s_node (mc, 4));
+  ATF_REQUIRE (ssa.get_dominance_frontier (s_node (mc, 1)).empty ());
+
+  /* The flag is read before any definition. */
+  size_t zf = s_reaching (ssa, ma, left, "%zf");
+  ATF_REQUIRE_EQ (ssa.get_definition (zf).kind, MicrocodeSSA::ENTRY_DEF);
+
+  /* %eax is merged at node 4, %ebx is never used. */
+  ATF_REQUIRE_EQ (ssa.get_phis (s_node (mc, 4)).size (), 1U);
+  ATF_REQUIRE (ssa.get_phis (s_node (mc, 5)).empty ());
+  size_t phi = ssa.get_phis (s_node (mc, 4))[0];
+  const MicrocodeSSA::Definition &d = ssa.get_definition (phi);
+  ATF_REQUIRE_EQ (d.kind, MicrocodeSSA::PHI_DEF);
+  ATF_REQUIRE_EQ (d.node, s_node (mc, 4));
+  ATF_REQUIRE_EQ (s_reaching (ssa, ma, a4, "%eax"), phi);
+
+  const vector<StmtArrow *> &in = ssa.get_incoming_arrows (s_node (mc, 4));
+  ATF_REQUIRE_EQ (in.size (), 2U);
+  ATF_REQUIRE_EQ (d.operands.size (), 2U);
+  for (size_t o = 0; o < 2; o++)
+    {
+      ATF_REQUIRE (in[o] == a2 || in[o] == a3);
+      ATF_REQUIRE_EQ (d.operands[o], ssa.get_definitions (in[o])[0]);
+      ATF_REQUIRE_EQ (ssa.get_def_uses (d.operands[o]).size (), 1U);
+      const MicrocodeSSA::Use &u =
+	ssa.get_use (ssa.get_def_uses (d.operands[o])[0]);
+      ATF_REQUIRE_EQ (u.phi, phi);
+      ATF_REQUIRE_EQ (u.operand, o);
+      ATF_REQUIRE_EQ (u.arrow, in[o]);
+    }
+  ATF_REQUIRE (ssa.get_def_uses (ssa.get_definitions (a4)[0]).empty ());
+
+  TEARDOWN ();
+}
+
+ATF_TEST_CASE (loop)
+
+ATF_TEST_CASE_HEAD (loop)
+{
+  set_md_var ("descr", "a loop header gets a phi-function for its counter");
+}
+
+ATF_TEST_CASE_BODY (loop)
+{
+  SETUP ();
+  StmtArrow *init = s_assign (mc, ma, 1, "%ecx", "0", 2);
+  StmtArrow *incr = s_assign (mc, ma, 2, "%ecx", "(ADD %ecx 1){0;32}", 3);
+  StmtArrow *back = s_skip (mc, ma, 3, "%zf", 2);
+  s_skip (mc, ma, 3, "(NOT %zf)", 4);
+  MicrocodeSSA ssa (mc);
+
+  ATF_REQUIRE_EQ (ssa.get_immediate_dominator (s_node (mc, 2)),
+		  s_node (mc, 1));
+  ATF_REQUIRE_EQ (ssa.get_immediate_dominator (s_node (mc, 4)),
+		  s_node (mc, 3));
+  ATF_REQUIRE_EQ (ssa.get_dominance_frontier (s_node (mc, 3)).size (), 1U);
+  ATF_REQUIRE_EQ (ssa.get_dominance_frontier (s_node (mc, 3))[0],
+		  s_node (mc, 2));
+  ATF_REQUIRE_EQ (ssa.get_dominance_frontier (s_node (mc, 2))[0],
+		  s_node (mc, 2));
+
+  ATF_REQUIRE_EQ (ssa.get_phis (s_node (mc, 2)).size (), 1U);
+  size_t phi = ssa.get_phis (s_node (mc, 2))[0];
+  const MicrocodeSSA::Definition &d = ssa.get_definition (phi);
+  const vector<StmtArrow *> &in = ssa.get_incoming_arrows (s_node (mc, 2));
+  size_t def_init = ssa.get_definitions (init)[0];
+  size_t def_incr = ssa.get_definitions (incr)[0];
+
+  ATF_REQUIRE_EQ (s_reaching (ssa, ma, incr, "%ecx"), phi);
+  ATF_REQUIRE_EQ (in.size (), 2U);
+  for (size_t o = 0; o < 2; o++)
+    ATF_REQUIRE_EQ (d.operands[o], in[o] == init ? def_init : def_incr);
+  ATF_REQUIRE (in[0] == back || in[1] == back);
+  ATF_REQUIRE_EQ (ssa.get_def_uses (def_incr).size (), 1U);
+  ATF_REQUIRE_EQ (ssa.get_use (ssa.get_def_uses (def_incr)[0]).arrow, back);
+  ATF_REQUIRE_EQ (ssa.get_def_uses (phi).size (), 1U);
+  ATF_REQUIRE_EQ (ssa.get_use (ssa.get_def_uses (phi)[0]).arrow, incr);
+
+  TEARDOWN ();
+}
+
+ATF_TEST_CASE (partial_register)
+
+ATF_TEST_CASE_HEAD (partial_register)
+{
+  set_md_var ("descr", "assigning a sub-register uses the previous version");
+}
+
+ATF_TEST_CASE_BODY (partial_register)
+{
+  SETUP ();
+  StmtArrow *a1 = s_assign (mc, ma, 1, "%eax", "1", 2);
+  StmtArrow *a2 = s_assign (mc, ma, 2, "%al", "2{0;8}", 3);
+  StmtArrow *a3 = s_assign (mc, ma, 3, "%ebx", "%eax", 4);
+  MicrocodeSSA ssa (mc);
+
+  size_t d1 = ssa.get_definitions (a1)[0];
+  size_t d2 = ssa.get_definitions (a2)[0];
+  ATF_REQUIRE (! ssa.get_definition (d1).partial);
+  ATF_REQUIRE (ssa.get_definition (d2).partial);
+  ATF_REQUIRE_EQ (ssa.get_definition (d1).variable,
+		  ssa.get_definition (d2).variable);
+  ATF_REQUIRE_EQ (s_reaching (ssa, ma, a2, "%eax"), d1);
+  ATF_REQUIRE_EQ (s_reaching (ssa, ma, a3, "%eax"), d2);
+  ATF_REQUIRE_EQ (ssa.get_def_uses (d1).size (), 1U);
+  ATF_REQUIRE (s_reaches (ssa, d2, ssa.get_uses (a3)[0]));
+
+  TEARDOWN ();
+}
+
+ATF_TEST_CASE (memory_cells)
+
+ATF_TEST_CASE_HEAD (memory_cells)
+{
+  set_md_var ("descr", "overlapping cells with constant addresses are one "
+	      "variable, other stores may define any of them");
+}
+
+ATF_TEST_CASE_BODY (memory_cells)
+{
+  SETUP ();
+  StmtArrow *a1 = s_assign (mc, ma, 1, "[0x10]", "%eax", 2);
+  StmtArrow *a2 = s_assign (mc, ma, 2, "[0x12]{0;8}", "1{0;8}", 3);
+  StmtArrow *a3 = s_assign (mc, ma, 3, "[0x20]", "[0x10]", 4);
+  StmtArrow *a4 = s_assign (mc, ma, 4, "[%esi]", "0", 5);
+  StmtArrow *a5 = s_assign (mc, ma, 5, "%ebx", "[0x20]", 6);
+  StmtArrow *a6 = s_assign (mc, ma, 6, "%ecx", "[%edi]", 7);
+  MicrocodeSSA ssa (mc);
+
+  /* %eax, %esi, %ebx, %edi, %ecx and two memory variables */
+  ATF_REQUIRE_EQ (ssa.get_number_of_variables (), 7U);
+  Expr *c13 = s_expr (ma, "[0x13]{0;8}");
+  size_t v = ssa.find_variable ((LValue *) c13);
+  c13->deref ();
+  ATF_REQUIRE_EQ (v, ssa.get_definition (ssa.get_definitions (a1)[0]).variable);
+  ATF_REQUIRE_EQ (ssa.get_variable (v).addr, 0x10U);
+  ATF_REQUIRE_EQ (ssa.get_variable (v).nb_bytes, 4U);
+
+  size_t d1 = ssa.get_definitions (a1)[0];
+  size_t d2 = ssa.get_definitions (a2)[0];
+  ATF_REQUIRE (ssa.get_definition (d2).partial);
+  ATF_REQUIRE_EQ (s_reaching (ssa, ma, a2, "[0x10]"), d1);
+  ATF_REQUIRE_EQ (s_reaching (ssa, ma, a3, "[0x10]"), d2);
+
+  /* The store at %esi may change both variables. */
+  ATF_REQUIRE_EQ (ssa.get_definitions (a4).size (), 2U);
+  size_t d4 = MicrocodeSSA::NONE;
+  for (size_t i = 0; i < 2; i++)
+    {
+      const MicrocodeSSA::Definition &d =
+	ssa.get_definition (ssa.get_definitions (a4)[i]);
+      ATF_REQUIRE (d.partial);
+      if (! ssa.get_variable (d.variable).is_register &&
+	  ssa.get_variable (d.variable).addr == 0x20)
+	d4 = ssa.get_definitions (a4)[i];
+    }
+  ATF_REQUIRE (d4 != MicrocodeSSA::NONE);
+  ATF_REQUIRE_EQ (s_reaching (ssa, ma, a4, "[0x20]"),
+		  ssa.get_definitions (a3)[0]);
+  ATF_REQUIRE_EQ (s_reaching (ssa, ma, a5, "[0x20]"), d4);
+
+  /* The load at %edi may read both variables. */
+  ATF_REQUIRE_EQ (ssa.get_uses (a6).size (), 3U);
+
+  TEARDOWN ();
+}
+
+ATF_TEST_CASE (unreachable_cycle)
+
+ATF_TEST_CASE_HEAD (unreachable_cycle)
+{
+  set_md_var ("descr", "a cycle that cannot be reached is entered anyway");
+}
+
+ATF_TEST_CASE_BODY (unreachable_cycle)
+{
+  SETUP ();
+  s_assign (mc, ma, 1, "%eax", "1", 2);
+  StmtArrow *a5 = s_assign (mc, ma, 5, "%eax", "(ADD %eax 1){0;32}", 6);
+  s_skip (mc, ma, 6, "1{0;1}", 5);
+  MicrocodeSSA ssa (mc);
+
+  ATF_REQUIRE_EQ (ssa.get_immediate_dominator (s_node (mc, 5)),
+		  (MicrocodeNode *) NULL);
+  ATF_REQUIRE_EQ (ssa.get_immediate_dominator (s_node (mc, 6)),
+		  s_node (mc, 5));
+  ATF_REQUIRE_EQ (ssa.get_incoming_arrows (s_node (mc, 5)).size (), 2U);
+
+  /* %eax enters the cycle with its initial value. */
+  size_t phi = s_reaching (ssa, ma, a5, "%eax");
+  const MicrocodeSSA::Definition &d = ssa.get_definition (phi);
+  ATF_REQUIRE_EQ (d.kind, MicrocodeSSA::PHI_DEF);
+  for (size_t o = 0; o < 2; o++)
+    {
+      if (ssa.get_incoming_arrows (s_node (mc, 5))[o] == NULL)
+	ATF_REQUIRE_EQ (d.operands[o],
+			ssa.get_entry_definition (d.variable));
+      else
+	ATF_REQUIRE_EQ (d.operands[o], ssa.get_definitions (a5)[0]);
+    }
+
+  TEARDOWN ();
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+  ATF_ADD_TEST_CASE(tcs, diamond);
+  ATF_ADD_TEST_CASE(tcs, loop);
+  ATF_ADD_TEST_CASE(tcs, partial_register);
+  ATF_ADD_TEST_CASE(tcs, memory_cells);
+  ATF_ADD_TEST_CASE(tcs, unreachable_cycle);
+}
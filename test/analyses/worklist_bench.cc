@@ -0,0 +1,173 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Worklist strategies benchmark. Each binary is explored from its entry
+ * point by the recursive traversal, the flood traversal and the concrete
+ * simulator, with each worklist strategy in turn; the size of the state
+ * space, the number of pending arrows processed and the wall time are
+ * reported.
+ *
+ * USAGE: analyses_worklist_bench [max-nb-visits-per-address [binary...]]
+ *
+ * By default, the 'echo' programs of test/test-samples are used and an
+ * address is visited at most 5 times.
+ */
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include <decoders/DecoderFactory.hh>
+#include <analyses/cfgrecovery/AlgorithmFactory.hh>
+#include <io/binary/BinutilsBinaryLoader.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+#include <benchmarks.hh>
+
+using namespace std;
+
+typedef AlgorithmFactory::Algorithm * (AlgorithmFactory::* FactoryMethod) ();
+
+static const struct {
+  const char *name;
+  FactoryMethod build;
+} ALGORITHMS[] = {
+  { "recursive", &AlgorithmFactory::buildRecursiveTraversal },
+  { "flood", &AlgorithmFactory::buildFloodTraversal },
+  { "concrete", &AlgorithmFactory::buildConcreteSimulator },
+  { NULL, NULL }
+};
+
+static void
+s_bench_strategy (const char *filename, FactoryMethod build,
+		  WorklistStrategy strategy, int max_nb_visits)
+{
+  BinaryLoader *loader =
+    new BinutilsBinaryLoader (filename, "", "", Architecture::UnknownEndian);
+  ConcreteMemory *memory = new ConcreteMemory ();
+
+  loader->load_memory (memory);
+
+  const Architecture *A = loader->get_architecture ();
+  MicrocodeArchitecture arch (A);
+  Decoder *decoder = DecoderFactory::get_Decoder (&arch, memory);
+  list<ConcreteAddress> entrypoints (1, loader->get_entrypoint ());
+  Microcode *mc = new Microcode ();
+
+  /* The concrete simulator needs defined registers. */
+  for (RegisterSpecs::const_iterator i = A->get_registers ()->begin ();
+       i != A->get_registers ()->end (); i++)
+    {
+      if (! i->second->is_alias ())
+	memory->put (i->second,
+		     ConcreteValue (i->second->get_register_size (), 0));
+    }
+
+  AlgorithmFactory F;
+
+  F.set_memory (memory);
+  F.set_decoder (decoder);
+  F.set_max_number_of_visits_per_address (max_nb_visits);
+  F.set_worklist_strategy (strategy);
+
+  AlgorithmFactory::Algorithm *algo = (F.* build) ();
+  double start = bench_now ();
+
+  try
+    {
+      algo->compute (entrypoints, mc);
+    }
+  catch (Decoder::Exception &e)
+    {
+      cout << "    (" << e.what () << ")" << endl;
+    }
+
+  double t = bench_now () - start;
+
+  cout << setw (10) << algo->get_number_of_states () << " states "
+       << setw (10) << algo->get_number_of_steps () << " steps "
+       << setw (8) << mc->get_number_of_nodes () << " nodes "
+       << fixed << setprecision (3) << setw (9) << t << " s" << endl;
+
+  delete algo;
+  delete mc;
+  delete decoder;
+  delete memory;
+  delete loader;
+}
+
+static void
+s_bench_binary (const char *filename, int max_nb_visits)
+{
+  cout << filename << endl;
+  for (int a = 0; ALGORITHMS[a].name != NULL; a++)
+    {
+      for (int s = 0; WORKLIST_STRATEGIES[s].name != NULL; s++)
+	{
+	  cout << "  " << left << setw (10) << ALGORITHMS[a].name
+	       << setw (14) << WORKLIST_STRATEGIES[s].name << right;
+	  s_bench_strategy (filename, ALGORITHMS[a].build,
+			    WORKLIST_STRATEGIES[s].strategy, max_nb_visits);
+	}
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  int max_nb_visits = 5;
+  ConfigTable ct;
+
+  if (argc > 1)
+    max_nb_visits = atoi (argv[1]);
+
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+  ct.set (logs::STDIO_ENABLE_WARNINGS_PROP, false);
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+  insight::init (ct);
+
+  if (argc > 2)
+    {
+      for (int i = 2; i < argc; i++)
+	s_bench_binary (argv[i], max_nb_visits);
+    }
+  else
+    {
+      for (int i = 0; BENCH_DEFAULT_BINARIES[i] != NULL; i++)
+	s_bench_binary (BENCH_DEFAULT_BINARIES[i], max_nb_visits);
+    }
+
+  insight::terminate ();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifndef TEST_BENCHMARKS_HH
+# define TEST_BENCHMARKS_HH
+
+/*
+ * Helpers shared by the benchmarks of the test directories.
+ */
+
+# include <cstddef>
+# include <sys/time.h>
+
+# ifndef TEST_SAMPLES_DIR
+#  error TEST_SAMPLES_DIR is not defined
+# endif
+
+/* Binaries of test/test-samples used when none is given on the command
+ * line. The table ends with NULL. */
+static const char * const BENCH_DEFAULT_BINARIES[] = {
+  TEST_SAMPLES_DIR "echo-linux-i386",
+  TEST_SAMPLES_DIR "echo-linux-amd64",
+  TEST_SAMPLES_DIR "echo-freebsd-i386",
+  TEST_SAMPLES_DIR "echo-freebsd-amd64",
+  TEST_SAMPLES_DIR "echo-linux-armel",
+  TEST_SAMPLES_DIR "echo-linux-sparc",
+  NULL
+};
+
+/* Wall-clock time, in seconds. */
+static inline double
+bench_now ()
+{
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+#endif /* ! TEST_BENCHMARKS_HH */
@@ -8,4 +8,12 @@ fi
 TESTNAME="$1"
 REFNAME="${srcdir}/`basename ${TESTNAME}`.result"
 
+# Results of alternative decoders (.dres) and of threaded traversals
+# (.tres) are checked against the reference results of the default
+# run (.res).
+case "${TESTNAME}" in
+    *.dres) REFNAME="${srcdir}/`basename ${TESTNAME} .dres`.res.result" ;;
+    *.tres) REFNAME="${srcdir}/`basename ${TESTNAME} .tres`.res.result" ;;
+esac
+
 exec diff -u "${REFNAME}" "${TESTNAME}"
@@ -0,0 +1,131 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Decoding throughput benchmark. For each binary, instructions are
+ * decoded one after the other from the entry point (decoding errors
+ * are skipped one byte at a time) and the number of instructions
+ * decoded per second is reported, together with the statistics of the
+ * translation cache of the decoder.
+ *
+ * USAGE: decoders_decode_bench [max-nb-instructions [binary...]]
+ *
+ * By default, the 'echo' programs of test/test-samples are used.
+ */
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include <decoders/binutils/BinutilsDecoder.hh>
+#include <io/binary/BinutilsBinaryLoader.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+#include <benchmarks.hh>
+
+using namespace std;
+
+static void
+s_bench_decoder (const char *filename, long max_nb_instructions)
+{
+  BinaryLoader *loader =
+    new BinutilsBinaryLoader (filename, "", "", Architecture::UnknownEndian);
+  ConcreteMemory *memory = new ConcreteMemory ();
+
+  loader->load_memory (memory);
+
+  MicrocodeArchitecture arch (loader->get_architecture ());
+  BinutilsDecoder *decoder = new BinutilsDecoder (&arch, memory);
+  Microcode *mc = new Microcode ();
+  ConcreteAddress addr = loader->get_entrypoint ();
+  long nb_instructions = 0;
+  long nb_errors = 0;
+  double start = bench_now ();
+
+  while (nb_instructions < max_nb_instructions && memory->is_defined (addr))
+    {
+      try
+	{
+	  addr = decoder->decode (mc, addr);
+	  nb_instructions++;
+	}
+      catch (Decoder::Exception &)
+	{
+	  nb_errors++;
+	  addr++;
+	}
+    }
+
+  double t = bench_now () - start;
+
+  cout << filename << endl
+       << "  " << nb_instructions << " instructions (" << nb_errors
+       << " errors) in " << fixed << setprecision (3) << t << " s: "
+       << setprecision (0) << (t > 0 ? nb_instructions / t : 0)
+       << " instructions/s" << endl
+       << "  ";
+  decoder->output_cache_stats (cout);
+
+  delete mc;
+  delete decoder;
+  delete memory;
+  delete loader;
+}
+
+int
+main (int argc, char **argv)
+{
+  long max_nb_instructions = 100000;
+  ConfigTable ct;
+
+  if (argc > 1)
+    max_nb_instructions = atol (argv[1]);
+
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+  insight::init (ct);
+
+  if (argc > 2)
+    {
+      for (int i = 2; i < argc; i++)
+	s_bench_decoder (argv[i], max_nb_instructions);
+    }
+  else
+    {
+      for (int i = 0; BENCH_DEFAULT_BINARIES[i] != NULL; i++)
+	s_bench_decoder (BENCH_DEFAULT_BINARIES[i], max_nb_instructions);
+    }
+
+  insight::terminate ();
+
+  return EXIT_SUCCESS;
+}
@@ -29,10 +29,12 @@
  */
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include <kernel/insight.hh>
 #include <decoders/binutils/BinutilsDecoder.hh>
+#include <decoders/binutils/X86DirectDecoder.hh>
 #include <io/binary/BinutilsBinaryLoader.hh>
 
 using namespace std;
@@ -48,10 +50,20 @@ main (int argc, char **argv)
 
   insight::init (ct);
 
+  /* With -d, instructions are decoded by the direct x86 decoder; its
+   * output must not differ from the one of the binutils decoder. */
+  bool direct = false;
+  if (argc == 4 && strcmp (argv[1], "-d") == 0)
+    {
+      direct = true;
+      argc--;
+      argv++;
+    }
+
   if (argc != 3)
     {
       logs::error << "wrong # of arguments" << endl
-		  << "USAGE: " << argv[0] << " bfd-target binary-filename"
+		  << "USAGE: " << argv[0] << " [-d] bfd-target binary-filename"
 		  << endl;
       result = EXIT_FAILURE;
     }
@@ -65,7 +77,11 @@ main (int argc, char **argv)
       ConcreteMemory *memory = new ConcreteMemory ();
       loader->load_memory (memory);
       MicrocodeArchitecture arch (loader->get_architecture ());
-      BinutilsDecoder *decoder = new BinutilsDecoder (&arch, memory);
+      BinutilsDecoder *decoder;
+      if (direct)
+	decoder = new X86DirectDecoder (&arch, memory);
+      else
+	decoder = new BinutilsDecoder (&arch, memory);
       ConcreteAddress start (loader->get_entrypoint());
 
       while (memory->is_defined (start) && result == EXIT_SUCCESS)
@@ -0,0 +1,129 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <atf-c++.hpp>
+
+#include <sstream>
+#include <string>
+
+#include <kernel/Architecture.hh>
+#include <kernel/insight.hh>
+#include <kernel/Microcode.hh>
+#include <decoders/binutils/BinutilsDecoder.hh>
+#include <utils/logs.hh>
+
+using namespace std;
+
+#define FIRST_COPY 0x1000
+#define SECOND_COPY 0x2000
+
+/* add %ebx,%eax ; mov %eax,%ebx ; jmp <first instruction> */
+static const uint8_t CODE[] = { 0x01, 0xd8, 0x89, 0xc3, 0xeb, 0xfa };
+#define CODE_SIZE (sizeof (CODE) / sizeof (CODE[0]))
+
+static ConcreteMemory *
+s_build_memory ()
+{
+  ConcreteMemory *memory = new ConcreteMemory ();
+
+  for (size_t i = 0; i < CODE_SIZE; i++)
+    {
+      ConcreteValue byte (8, CODE[i]);
+
+      memory->put (ConcreteAddress (FIRST_COPY + i), byte,
+		   Architecture::LittleEndian);
+      memory->put (ConcreteAddress (SECOND_COPY + i), byte,
+		   Architecture::LittleEndian);
+    }
+
+  return memory;
+}
+
+static string
+s_decode_all (BinutilsDecoder *decoder, address_t start)
+{
+  Microcode mc;
+  ConcreteAddress addr (start);
+  ostringstream oss;
+
+  while (addr.get_address () < start + CODE_SIZE)
+    addr = decoder->decode (&mc, addr);
+  mc.sort ();
+  mc.output_text (oss);
+
+  return oss.str ();
+}
+
+ATF_TEST_CASE (translation_cache)
+ATF_TEST_CASE_HEAD (translation_cache)
+{
+  set_md_var ("descr",
+	      "Check that instructions decoded from the translation cache "
+	      "are translated as without cache");
+}
+
+ATF_TEST_CASE_BODY (translation_cache)
+{
+  ConfigTable ct;
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+
+  insight::init (ct);
+
+  ConcreteMemory *memory = s_build_memory ();
+  MicrocodeArchitecture arch (Architecture::getArchitecture
+			      (Architecture::X86_32));
+  BinutilsDecoder *decoder = new BinutilsDecoder (&arch, memory);
+  BinutilsDecoder *reference = new BinutilsDecoder (&arch, memory);
+
+  s_decode_all (decoder, FIRST_COPY);
+  ATF_REQUIRE_EQ (decoder->get_nb_cache_hits (), 0U);
+  ATF_REQUIRE_EQ (decoder->get_nb_cache_misses (), 3U);
+
+  /* 'add' and 'mov' are reused; the relative 'jmp' is not */
+  string cached = s_decode_all (decoder, SECOND_COPY);
+  ATF_REQUIRE_EQ (decoder->get_nb_cache_hits (), 2U);
+  ATF_REQUIRE_EQ (decoder->get_nb_cache_misses (), 4U);
+
+  ATF_REQUIRE_EQ (cached, s_decode_all (reference, SECOND_COPY));
+  ATF_REQUIRE_EQ (reference->get_nb_cache_hits (), 0U);
+
+  delete reference;
+  delete decoder;
+  delete memory;
+
+  insight::terminate ();
+}
+
+ATF_INIT_TEST_CASES (tcs)
+{
+  ATF_ADD_TEST_CASE (tcs, translation_cache);
+}
@@ -30,10 +30,14 @@
 
 #include <atf-c++.hpp>
 
+#include <fstream>
+#include <unistd.h>
+
 #include <domains/concrete/ConcreteMemory.hh>
 #include <kernel/Architecture.hh>
 #include <kernel/insight.hh>
 #include <utils/logs.hh>
+#include <utils/MappedFile.hh>
 
 ATF_TEST_CASE(concretememory_registers)
 ATF_TEST_CASE_HEAD(concretememory_registers)
@@ -124,8 +128,233 @@ ATF_TEST_CASE_BODY(concretememory_memcells)
   insight::terminate ();
 }
 
+ATF_TEST_CASE(concretememory_pages)
+ATF_TEST_CASE_HEAD(concretememory_pages)
+{
+  set_md_var("descr",
+	     "Check memory cells that lie across pages of a ConcreteMemory");
+}
+ATF_TEST_CASE_BODY(concretememory_pages)
+{
+  ConfigTable ct;
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+
+  insight::init (ct);
+
+  ConcreteMemory * memory = new ConcreteMemory();
+  ConcreteAddress addr = ConcreteAddress(ConcreteMemory::PAGE_SIZE - 2);
+  ConcreteValue value = ConcreteValue(32, 0x11223344);
+
+  memory->put(addr, value, Architecture::LittleEndian);
+  ATF_REQUIRE(memory->get(addr, 4, Architecture::LittleEndian).get() ==
+	      0x11223344);
+  ATF_REQUIRE(memory->get(ConcreteAddress(ConcreteMemory::PAGE_SIZE), 2,
+			  Architecture::LittleEndian).get() == 0x1122);
+
+  memory->put(addr, value, Architecture::BigEndian);
+  ATF_REQUIRE(memory->get(addr, 4, Architecture::BigEndian).get() ==
+	      0x11223344);
+
+  /* Partially defined cells are undefined */
+  ATF_REQUIRE_THROW(UndefinedValueException,
+		    memory->get(ConcreteAddress(ConcreteMemory::PAGE_SIZE), 4,
+				Architecture::LittleEndian));
+
+  /* Cells are enumerated by increasing addresses */
+  memory->put(ConcreteAddress(3 * ConcreteMemory::PAGE_SIZE),
+	      ConcreteValue(8, 0x55), Architecture::LittleEndian);
+  memory->put(ConcreteAddress(16), ConcreteValue(8, 0x66),
+	      Architecture::LittleEndian);
+
+  address_t expected[] = { 16, ConcreteMemory::PAGE_SIZE - 2,
+			   ConcreteMemory::PAGE_SIZE - 1,
+			   ConcreteMemory::PAGE_SIZE,
+			   ConcreteMemory::PAGE_SIZE + 1,
+			   3 * ConcreteMemory::PAGE_SIZE };
+  int nb_cells = 0;
+
+  for (ConcreteMemory::const_memcell_iterator i = memory->begin ();
+       i != memory->end (); i++, nb_cells++)
+    ATF_REQUIRE_EQ(i->first, expected[nb_cells]);
+  ATF_REQUIRE_EQ(nb_cells, 6);
+
+  delete memory;
+
+  insight::terminate ();
+}
+
+ATF_TEST_CASE(concretememory_clone)
+ATF_TEST_CASE_HEAD(concretememory_clone)
+{
+  set_md_var("descr",
+	     "Check that clones of a ConcreteMemory do not share writes");
+}
+ATF_TEST_CASE_BODY(concretememory_clone)
+{
+  ConfigTable ct;
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+
+  insight::init (ct);
+
+  ConcreteMemory * memory = new ConcreteMemory();
+  ConcreteAddress addr = ConcreteAddress(1024);
+
+  memory->put(addr, ConcreteValue(32, 6235), Architecture::LittleEndian);
+
+  ConcreteMemory * clone = memory->clone ();
+
+  ATF_REQUIRE(clone->equals (*memory));
+  ATF_REQUIRE_EQ(clone->hashcode (), memory->hashcode ());
+
+  clone->put(addr, ConcreteValue(8, 1), Architecture::LittleEndian);
+  ATF_REQUIRE(memory->get(addr, 4, Architecture::LittleEndian).get() == 6235);
+  ATF_REQUIRE(clone->get(addr, 4, Architecture::LittleEndian).get() == 6145);
+  ATF_REQUIRE(! clone->equals (*memory));
+
+  memory->put(addr, ConcreteValue(8, 1), Architecture::LittleEndian);
+  ATF_REQUIRE(clone->equals (*memory));
+
+  delete memory;
+
+  ATF_REQUIRE(clone->get(addr, 4, Architecture::LittleEndian).get() == 6145);
+
+  delete clone;
+
+  insight::terminate ();
+}
+
+ATF_TEST_CASE(concretememory_hashcode)
+ATF_TEST_CASE_HEAD(concretememory_hashcode)
+{
+  set_md_var("descr",
+	     "Check that the hash value of a ConcreteMemory does not depend "
+	     "on the order of the writes");
+}
+ATF_TEST_CASE_BODY(concretememory_hashcode)
+{
+  ConfigTable ct;
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+
+  insight::init (ct);
+
+  const Architecture * arch_x86 =
+    Architecture::getArchitecture(Architecture::X86_32);
+  const RegisterDesc * eax = arch_x86->get_register("eax");
+  const RegisterDesc * ebx = arch_x86->get_register("ebx");
+  ConcreteMemory * m1 = new ConcreteMemory();
+  ConcreteMemory * m2 = new ConcreteMemory();
+
+  m1->put(ConcreteAddress(1024), ConcreteValue(32, 6235),
+	  Architecture::LittleEndian);
+  m1->put(ConcreteAddress(8192), ConcreteValue(16, 12),
+	  Architecture::LittleEndian);
+  m1->put(eax, ConcreteValue(32, 1));
+  m1->put(ebx, ConcreteValue(32, 2));
+
+  m2->put(ebx, ConcreteValue(32, 7));
+  m2->put(ConcreteAddress(8192), ConcreteValue(16, 12),
+	  Architecture::LittleEndian);
+  m2->put(ConcreteAddress(1024), ConcreteValue(32, 0),
+	  Architecture::LittleEndian);
+  m2->put(eax, ConcreteValue(32, 1));
+  ATF_REQUIRE(! m1->equals (*m2));
+
+  /* Overwritten cells and registers do not count anymore */
+  m2->put(ConcreteAddress(1024), ConcreteValue(32, 6235),
+	  Architecture::LittleEndian);
+  m2->put(ebx, ConcreteValue(32, 2));
+  ATF_REQUIRE_EQ(m1->hashcode (), m2->hashcode ());
+  ATF_REQUIRE(m1->equals (*m2));
+  ATF_REQUIRE(m2->equals (*m1));
+
+  m2->clear(ebx);
+  ATF_REQUIRE(m1->hashcode () != m2->hashcode ());
+
+  delete m1;
+  delete m2;
+
+  insight::terminate ();
+}
+
+ATF_TEST_CASE(concretememory_map)
+ATF_TEST_CASE_HEAD(concretememory_map)
+{
+  set_md_var("descr",
+	     "Check memory cells that refer to a file mapped into memory");
+}
+ATF_TEST_CASE_BODY(concretememory_map)
+{
+  ConfigTable ct;
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+
+  insight::init (ct);
+
+  const char *filename = "concretememory_map.bin";
+  const std::size_t size = 3 * ConcreteMemory::PAGE_SIZE;
+  std::ofstream out (filename, std::ios::binary);
+
+  for (std::size_t i = 0; i < size; i++)
+    out.put ((char) (i % 251));
+  out.close ();
+
+  MappedFile *file = MappedFile::map (filename);
+  ATF_REQUIRE(file != NULL);
+  ATF_REQUIRE_EQ(file->get_size (), size);
+
+  /* Cells from 0x10010 on; the first and the last pages are partial */
+  ConcreteMemory * memory = new ConcreteMemory();
+  address_t start = 0x10010;
+
+  memory->map(ConcreteAddress(start), file->get_data () + 1, size - 1, file);
+  file->deref ();
+
+  ATF_REQUIRE_EQ(memory->is_defined(ConcreteAddress(start - 1)), false);
+  ATF_REQUIRE_EQ(memory->is_defined(ConcreteAddress(start + size - 1)),
+		 false);
+  for (std::size_t i = 0; i < size - 1; i += 97)
+    ATF_REQUIRE((uword_t) memory->get(ConcreteAddress(start + i), 1,
+				      Architecture::LittleEndian).get() ==
+		(uword_t) ((i + 1) % 251));
+
+  /* Writes go to a private copy of the page */
+  ConcreteMemory * clone = memory->clone ();
+  address_t addr = 0x11000;
+
+  clone->put(ConcreteAddress(addr), ConcreteValue(8, 0xff),
+	     Architecture::LittleEndian);
+  ATF_REQUIRE(clone->get(ConcreteAddress(addr), 1,
+			 Architecture::LittleEndian).get() == 0xff);
+  ATF_REQUIRE((uword_t) memory->get(ConcreteAddress(addr), 1,
+				    Architecture::LittleEndian).get() ==
+	      (uword_t) ((addr - start + 1) % 251));
+  ATF_REQUIRE((uword_t) file->get_data ()[addr - start + 1] ==
+	      (uword_t) ((addr - start + 1) % 251));
+
+  /* Mapped cells are hashed as written ones */
+  ConcreteMemory * copy = new ConcreteMemory();
+
+  for (std::size_t i = 0; i < size - 1; i++)
+    copy->put(ConcreteAddress(start + i),
+	      ConcreteValue(8, file->get_data ()[i + 1]),
+	      Architecture::LittleEndian);
+  ATF_REQUIRE_EQ(copy->hashcode (), memory->hashcode ());
+  ATF_REQUIRE(copy->equals (*memory));
+  ATF_REQUIRE(! copy->equals (*clone));
+  delete copy;
+
+  delete memory;
+  delete clone;
+  unlink (filename);
+
+  insight::terminate ();
+}
+
 ATF_INIT_TEST_CASES(tcs)
 {
   ATF_ADD_TEST_CASE(tcs, concretememory_registers);
   ATF_ADD_TEST_CASE(tcs, concretememory_memcells);
+  ATF_ADD_TEST_CASE(tcs, concretememory_pages);
+  ATF_ADD_TEST_CASE(tcs, concretememory_clone);
+  ATF_ADD_TEST_CASE(tcs, concretememory_hashcode);
+  ATF_ADD_TEST_CASE(tcs, concretememory_map);
 }
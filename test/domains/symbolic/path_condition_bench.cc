@@ -0,0 +1,159 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Path condition benchmark. Each long loop is simulated symbolically with
+ * an increasing bound on the number of visits per address, hence on the
+ * length of the paths through the loop and of their path conditions. The
+ * time per step should not depend on the bound.
+ *
+ * USAGE: symbolic_path_condition_bench [max-nb-visits-per-address...]
+ *
+ * By default, the bounds are 64, 128, 256 and 512. The solver is the one
+ * of the configuration file of the tests.
+ */
+
+#ifndef INSIGHT_CONFIG_FILE
+# error INSIGHT_CONFIG_FILE is not defined
+#endif
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <decoders/DecoderFactory.hh>
+#include <analyses/cfgrecovery/AlgorithmFactory.hh>
+#include <io/binary/BinutilsBinaryLoader.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+#include <benchmarks.hh>
+
+#include "simulator_test_cases.hh"
+
+using namespace std;
+
+static const int DEFAULT_BOUNDS[] = { 64, 128, 256, 512, 0 };
+
+static void
+s_bench_bound (const char *filename, const char *target, int max_nb_visits)
+{
+  BinaryLoader *loader =
+    new BinutilsBinaryLoader (filename, target, "",
+			      Architecture::UnknownEndian);
+  ConcreteMemory *memory = new ConcreteMemory ();
+
+  loader->load_memory (memory);
+
+  const Architecture *A = loader->get_architecture ();
+  MicrocodeArchitecture arch (A);
+  Decoder *decoder = DecoderFactory::get_Decoder (&arch, memory);
+  list<ConcreteAddress> entrypoints (1, loader->get_entrypoint ());
+  Microcode *mc = new Microcode ();
+
+  for (RegisterSpecs::const_iterator i = A->get_registers ()->begin ();
+       i != A->get_registers ()->end (); i++)
+    {
+      if (! i->second->is_alias ())
+	memory->put (i->second,
+		     ConcreteValue (i->second->get_register_size (), 0));
+    }
+
+  AlgorithmFactory F;
+
+  F.set_memory (memory);
+  F.set_decoder (decoder);
+  F.set_max_number_of_visits_per_address (max_nb_visits);
+  F.set_warn_on_unsolved_dynamic_jumps (false);
+  F.set_warn_skipped_dynamic_jumps (false);
+
+  AlgorithmFactory::Algorithm *algo = F.buildSymbolicSimulator ();
+  double start = bench_now ();
+
+  algo->compute (entrypoints, mc);
+
+  double t = bench_now () - start;
+  size_t nb_steps = algo->get_number_of_steps ();
+
+  cout << "  " << setw (6) << max_nb_visits << " visits "
+       << setw (10) << algo->get_number_of_states () << " states "
+       << setw (10) << nb_steps << " steps "
+       << fixed << setprecision (3) << setw (9) << t << " s "
+       << setprecision (1) << setw (9)
+       << (nb_steps == 0 ? 0.0 : 1e6 * t / nb_steps) << " us/step" << endl;
+
+  delete algo;
+  delete mc;
+  delete decoder;
+  delete memory;
+  delete loader;
+}
+
+int
+main (int argc, char **argv)
+{
+  ConfigTable ct;
+  fstream config (INSIGHT_CONFIG_FILE, fstream::in);
+
+  if (! config.is_open ())
+    {
+      cerr << "can't open " << INSIGHT_CONFIG_FILE << endl;
+      return EXIT_FAILURE;
+    }
+  ct.load (config);
+  config.close ();
+
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+  ct.set (logs::STDIO_ENABLE_WARNINGS_PROP, false);
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+  insight::init (ct);
+
+#define BINARY_FILE(id, file, target)					\
+  cout << TEST_SAMPLES_DIR file << endl;				\
+  if (argc > 1)								\
+    {									\
+      for (int i = 1; i < argc; i++)					\
+	s_bench_bound (TEST_SAMPLES_DIR file, target, atoi (argv[i]));	\
+    }									\
+  else									\
+    {									\
+      for (int i = 0; DEFAULT_BOUNDS[i] != 0; i++)			\
+	s_bench_bound (TEST_SAMPLES_DIR file, target, DEFAULT_BOUNDS[i]); \
+    }
+
+  BENCHMARKED_BINARIES
+#undef BINARY_FILE
+
+  insight::terminate ();
+
+  return EXIT_SUCCESS;
+}
@@ -124,4 +124,9 @@
   \
   BINARY_FILE (X86_32_GCD, "x86_32-gcd.bin", "elf32-i386")
 
+/* Long loops, too long to be simulated to the end by the tests; see
+ * path_condition_bench.cc. */
+#define BENCHMARKED_BINARIES \
+  BINARY_FILE (X86_32_LONG_LOOP, "x86_32-simulator-long-loop.bin", "elf32-i386")
+
 #endif /* ! SIMULATOR_TEST_CASES_HH */
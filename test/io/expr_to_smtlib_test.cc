@@ -206,6 +206,41 @@ s_check_expr_to_smtlib (const string &, const string &expr,
 ALL_X86_CC
 #undef X86_32_CC
 
+ATF_TEST_CASE(smtlib_shared)
+
+ATF_TEST_CASE_HEAD(smtlib_shared)
+{
+  set_md_var ("descr",
+	      "Check that shared sub-formulas are bound once and that the "
+	      "formula is appended to the buffer");
+}
+
+ATF_TEST_CASE_BODY(smtlib_shared)
+{
+  ConfigTable ct;
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+
+  insight::init (ct);
+  const Architecture *x86_32 =
+    Architecture::getArchitecture (Architecture::X86_32);
+  MicrocodeArchitecture ma (x86_32);
+
+  Expr *e = expr_parser ("(LT_U (ADD %eax %ebx){0;32} "
+			 "(XOR (ADD %eax %ebx){0;32} %ecx){0;32}){0;1}", &ma);
+  ATF_REQUIRE (e != NULL);
+  string buf ("(assert ");
+
+  smtlib_writer (buf, e, "memory", 32, x86_32->get_endian (), true);
+
+  ATF_REQUIRE_EQ (buf, "(assert (let ((_$2 (bvadd eax ebx))) "
+		  "(= (ite (bvult _$2 (bvxor _$2 ecx)) #b1 #b0) #b1))");
+  e->deref ();
+
+  insight::terminate ();
+}
+
 #if 1
 #define X86_32_CC(id, e, expout) \
   ATF_ADD_TEST_CASE(tcs, smtlib_ ## id)
@@ -214,6 +249,7 @@ ALL_X86_CC
 ATF_INIT_TEST_CASES(tcs)
 {
   ALL_X86_CC
+  ATF_ADD_TEST_CASE(tcs, smtlib_shared);
 }
 #else
 
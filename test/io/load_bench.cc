@@ -0,0 +1,132 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Binary loading benchmark. Each binary is loaded into a ConcreteMemory
+ * twice, first with its contents mapped into the address space (see
+ * BinaryLoader::set_mapped_loading) and then copied. For each mode, the
+ * loading time and the growth of the resident memory are reported.
+ *
+ * USAGE: io_load_bench [binary...]
+ *
+ * By default, the 'echo' programs of test/test-samples are used.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <unistd.h>
+
+#include <io/binary/BinutilsBinaryLoader.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+#include <benchmarks.hh>
+
+using namespace std;
+
+/* Current resident memory in KiB, or 0 if /proc is not available. */
+static long
+s_resident_memory ()
+{
+  ifstream statm ("/proc/self/statm");
+  long size = 0;
+  long resident = 0;
+
+  if (! (statm >> size >> resident))
+    return 0;
+
+  return resident * (sysconf (_SC_PAGESIZE) / 1024);
+}
+
+static void
+s_bench_loader (const char *filename, bool mapped)
+{
+  long rss = s_resident_memory ();
+  double start = bench_now ();
+  BinaryLoader *loader =
+    new BinutilsBinaryLoader (filename, "", "", Architecture::UnknownEndian);
+  ConcreteMemory *memory = new ConcreteMemory ();
+
+  loader->set_mapped_loading (mapped);
+  loader->load_memory (memory);
+
+  double t = bench_now () - start;
+  long nb_cells = 0;
+
+  rss = s_resident_memory () - rss;
+  for (ConcreteMemory::const_memcell_iterator i = memory->begin ();
+       i != memory->end (); i++)
+    nb_cells++;
+
+  cout << "  " << (mapped ? "mapped" : "copied") << ": " << nb_cells
+       << " bytes in " << fixed << setprecision (3) << t << " s, "
+       << rss << " KiB of resident memory" << endl;
+
+  delete memory;
+  delete loader;
+}
+
+static void
+s_bench_binary (const char *filename)
+{
+  /* Mapped loading comes first since the heap is not given back to the
+   * system once the copied contents are released. */
+  cout << filename << endl;
+  s_bench_loader (filename, true);
+  s_bench_loader (filename, false);
+}
+
+int
+main (int argc, char **argv)
+{
+  ConfigTable ct;
+
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+  insight::init (ct);
+
+  if (argc > 1)
+    {
+      for (int i = 1; i < argc; i++)
+	s_bench_binary (argv[i]);
+    }
+  else
+    {
+      for (int i = 0; BENCH_DEFAULT_BINARIES[i] != NULL; i++)
+	s_bench_binary (BENCH_DEFAULT_BINARIES[i]);
+    }
+
+  insight::terminate ();
+
+  return EXIT_SUCCESS;
+}
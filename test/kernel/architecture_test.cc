@@ -32,6 +32,7 @@
 
 #include <kernel/Architecture.hh>
 #include <kernel/insight.hh>
+#include <kernel/microcode/MicrocodeArchitecture.hh>
 #include <utils/logs.hh>
 
 ATF_TEST_CASE(architecture_x86_32)
@@ -146,9 +147,54 @@ ATF_TEST_CASE_BODY(architecture_missing)
   insight::terminate ();
 }
 
+ATF_TEST_CASE(decoder_data)
+ATF_TEST_CASE_HEAD(decoder_data)
+{
+  set_md_var("descr",
+	     "Check that decoder data is kept until its last user goes");
+}
+
+static int nb_deleted_data = 0;
+
+class CountedData : public MicrocodeArchitecture::DecoderData
+{
+public:
+  virtual ~CountedData () { nb_deleted_data++; }
+};
+
+ATF_TEST_CASE_BODY(decoder_data)
+{
+  ConfigTable ct;
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+
+  insight::init (ct);
+  MicrocodeArchitecture *ma =
+    new MicrocodeArchitecture (Architecture::getArchitecture
+			       (Architecture::X86_32));
+
+  /* Two decoders share the data of the architecture */
+  ma->ref_decoder_data ();
+  ma->ref_decoder_data ();
+  ma->set_decoder_data (new CountedData ());
+  ma->deref_decoder_data ();
+  ATF_REQUIRE(ma->get_decoder_data () != NULL);
+  ATF_REQUIRE_EQ(nb_deleted_data, 0);
+  ma->deref_decoder_data ();
+  ATF_REQUIRE(ma->get_decoder_data () == NULL);
+  ATF_REQUIRE_EQ(nb_deleted_data, 1);
+
+  /* Otherwise, the data goes with the architecture */
+  ma->set_decoder_data (new CountedData ());
+  delete ma;
+  ATF_REQUIRE_EQ(nb_deleted_data, 2);
+  insight::terminate ();
+}
+
 ATF_INIT_TEST_CASES(tcs)
 {
   ATF_ADD_TEST_CASE(tcs, architecture_x86_32);
   ATF_ADD_TEST_CASE(tcs, architecture_arm);
   ATF_ADD_TEST_CASE(tcs, architecture_missing);
+  ATF_ADD_TEST_CASE(tcs, decoder_data);
 }
@@ -0,0 +1,337 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <atf-c++.hpp>
+#include <set>
+#include <vector>
+
+#include <kernel/Architecture.hh>
+#include <kernel/Expressions.hh>
+#include <kernel/expressions/ExprCachingSolver.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+using namespace std;
+
+/* Solver answering UNSAT for the formulas of 'unsat' (and their
+ * conjunctions) and giving 'nb_models' values to any expression, or
+ * UNKNOWN after 'nb_models' values if 'unknown' is set. It counts the
+ * queries it actually receives. */
+class ScriptedSolver : public ExprSolver
+{
+public:
+  ScriptedSolver (const MicrocodeArchitecture *mca)
+    : ExprSolver (mca), nb_models (3), unknown (false), nb_queries (0) { }
+
+  virtual void add_assertion (const Expr *)
+    throw (UnexpectedResponseException) { }
+
+  virtual Result check_sat (const Expr *e, bool)
+    throw (UnexpectedResponseException) {
+    nb_queries++;
+    if (unknown)
+      return UNKNOWN;
+    return is_unsat (e) ? UNSAT : SAT;
+  }
+
+  virtual Result check_sat ()
+    throw (UnexpectedResponseException) {
+    return SAT;
+  }
+
+  virtual std::vector<constant_t> *
+  evaluate (const Expr *, const Expr *context, int nb_values,
+	    Result *status)
+    throw (UnexpectedResponseException) {
+    std::vector<constant_t> *result = new std::vector<constant_t> ();
+    nb_queries++;
+    for (int i = 0; i < nb_values && i < nb_models && ! is_unsat (context);
+	 i++)
+      result->push_back (i);
+    if (status != NULL)
+      {
+	if (result->size () == (size_t) nb_values)
+	  *status = SAT;
+	else
+	  *status = unknown ? UNKNOWN : UNSAT;
+      }
+    return result;
+  }
+
+  virtual void push () throw (UnexpectedResponseException) { }
+  virtual void pop () throw (UnexpectedResponseException) { }
+  virtual Constant *get_value_of (const Expr *)
+    throw (UnexpectedResponseException) {
+    return NULL;
+  }
+
+  bool is_unsat (const Expr *e) const {
+    const BinaryApp *b = dynamic_cast<const BinaryApp *> (e);
+    if (b != NULL && b->get_op () == BV_OP_AND)
+      return is_unsat (b->get_arg1 ()) || is_unsat (b->get_arg2 ());
+    return unsat.find (e) != unsat.end ();
+  }
+
+  std::set<const Expr *> unsat;
+  int nb_models;
+  bool unknown;
+  int nb_queries;
+};
+
+static Expr *
+s_var (const char *id)
+{
+  return Variable::create (id, 1);
+}
+
+#define SETUP()							\
+  ConfigTable ct;						\
+  ct.set (logs::DEBUG_ENABLED_PROP, false);			\
+  ct.set (logs::STDIO_ENABLED_PROP, true);			\
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);		\
+  insight::init (ct);						\
+  MicrocodeArchitecture ma						\
+    (Architecture::getArchitecture (Architecture::X86_32))
+
+ATF_TEST_CASE (check_sat_cache)
+
+ATF_TEST_CASE_HEAD (check_sat_cache)
+{
+  set_md_var ("descr", "satisfiability queries are answered once");
+}
+
+ATF_TEST_CASE_BODY (check_sat_cache)
+{
+  SETUP ();
+  ScriptedSolver *scripted = new ScriptedSolver (&ma);
+  ExprCachingSolver *s = new ExprCachingSolver (&ma, scripted, 16);
+  Expr *a = s_var ("a");
+  Expr *b = s_var ("b");
+  Expr *ab = Expr::createLAnd (a->ref (), b->ref ());
+
+  scripted->unsat.insert (b);
+  ATF_REQUIRE_EQ (s->check_sat (a, true), ExprSolver::SAT);
+  ATF_REQUIRE_EQ (s->check_sat (a, true), ExprSolver::SAT);
+  ATF_REQUIRE_EQ (scripted->nb_queries, 1);
+
+  /* (AND a b) extends b, which is UNSAT. */
+  ATF_REQUIRE_EQ (s->check_sat (b, true), ExprSolver::UNSAT);
+  ATF_REQUIRE_EQ (s->check_sat (ab, true), ExprSolver::UNSAT);
+  ATF_REQUIRE_EQ (scripted->nb_queries, 2);
+  ATF_REQUIRE_EQ (s->get_nb_lookups (), 4U);
+  ATF_REQUIRE_EQ (s->get_nb_hits (), 2U);
+  ATF_REQUIRE_EQ (s->get_nb_subsumptions (), 1U);
+
+  /* Pushed assertions are part of the query... */
+  Expr *c = s_var ("c");
+  s->push ();
+  ATF_REQUIRE_EQ (s->check_sat (a, true), ExprSolver::SAT);
+  ATF_REQUIRE_EQ (scripted->nb_queries, 2);
+  s->add_assertion (c);
+  ATF_REQUIRE_EQ (s->check_sat (a, true), ExprSolver::SAT);
+  ATF_REQUIRE_EQ (s->check_sat (a, true), ExprSolver::SAT);
+  ATF_REQUIRE_EQ (scripted->nb_queries, 3);
+  s->pop ();
+  ATF_REQUIRE_EQ (s->check_sat (a, true), ExprSolver::SAT);
+  s->push ();
+  s->add_assertion (c);
+  ATF_REQUIRE_EQ (s->check_sat (a, true), ExprSolver::SAT);
+  s->pop ();
+  ATF_REQUIRE_EQ (scripted->nb_queries, 3);
+
+  /* ... and assertions added to the base level invalidate it. */
+  s->add_assertion (b);
+  ATF_REQUIRE_EQ (s->check_sat (a, true), ExprSolver::SAT);
+  ATF_REQUIRE_EQ (scripted->nb_queries, 4);
+
+  ab->deref ();
+  a->deref ();
+  b->deref ();
+  c->deref ();
+  delete s;
+  insight::terminate ();
+}
+
+ATF_TEST_CASE (evaluate_cache)
+
+ATF_TEST_CASE_HEAD (evaluate_cache)
+{
+  set_md_var ("descr", "enumerations are reused when they are long enough");
+}
+
+ATF_TEST_CASE_BODY (evaluate_cache)
+{
+  SETUP ();
+  ScriptedSolver *scripted = new ScriptedSolver (&ma);
+  ExprCachingSolver *s = new ExprCachingSolver (&ma, scripted, 16);
+  Expr *x = Variable::create ("x", 32);
+  Expr *a = s_var ("a");
+  Expr *b = s_var ("b");
+  Expr *ab = Expr::createLAnd (a->ref (), b->ref ());
+  vector<constant_t> *v;
+
+  /* Two values out of three: a request for more has to query again. */
+  v = s->evaluate (x, a, 2);
+  ATF_REQUIRE_EQ (v->size (), 2U);
+  delete v;
+  v = s->evaluate (x, a, 1);
+  ATF_REQUIRE_EQ (v->size (), 1U);
+  delete v;
+  ATF_REQUIRE_EQ (scripted->nb_queries, 1);
+  v = s->evaluate (x, a, 5);
+  ATF_REQUIRE_EQ (v->size (), 3U);
+  delete v;
+  ATF_REQUIRE_EQ (scripted->nb_queries, 2);
+
+  /* All the values are known now. */
+  v = s->evaluate (x, a, 10);
+  ATF_REQUIRE_EQ (v->size (), 3U);
+  delete v;
+  ATF_REQUIRE_EQ (scripted->nb_queries, 2);
+
+  /* No value under b: b is UNSAT, and so are its extensions. */
+  scripted->unsat.insert (b);
+  v = s->evaluate (x, b, 2);
+  ATF_REQUIRE_EQ (v->size (), 0U);
+  delete v;
+  ATF_REQUIRE_EQ (s->check_sat (ab, true), ExprSolver::UNSAT);
+  v = s->evaluate (x, ab, 2);
+  ATF_REQUIRE_EQ (v->size (), 0U);
+  delete v;
+  ATF_REQUIRE_EQ (scripted->nb_queries, 3);
+
+  ab->deref ();
+  a->deref ();
+  b->deref ();
+  x->deref ();
+  delete s;
+  insight::terminate ();
+}
+
+ATF_TEST_CASE (unknown_evaluate)
+
+ATF_TEST_CASE_HEAD (unknown_evaluate)
+{
+  set_md_var ("descr", "enumerations the solver gave up on are not "
+	      "remembered");
+}
+
+ATF_TEST_CASE_BODY (unknown_evaluate)
+{
+  SETUP ();
+  ScriptedSolver *scripted = new ScriptedSolver (&ma);
+  ExprCachingSolver *s = new ExprCachingSolver (&ma, scripted, 16);
+  Expr *x = Variable::create ("x", 32);
+  Expr *a = s_var ("a");
+  Expr *b = s_var ("b");
+  Expr *ab = Expr::createLAnd (a->ref (), b->ref ());
+  ExprSolver::Result status;
+  vector<constant_t> *v;
+
+  /* Neither the two values nor the lack of values under b are complete. */
+  scripted->unknown = true;
+  scripted->nb_models = 2;
+  v = s->evaluate (x, a, 5, &status);
+  ATF_REQUIRE_EQ (v->size (), 2U);
+  ATF_REQUIRE_EQ (status, ExprSolver::UNKNOWN);
+  delete v;
+  scripted->unsat.insert (b);
+  v = s->evaluate (x, b, 2, &status);
+  ATF_REQUIRE_EQ (v->size (), 0U);
+  ATF_REQUIRE_EQ (status, ExprSolver::UNKNOWN);
+  delete v;
+  ATF_REQUIRE_EQ (scripted->nb_queries, 2);
+
+  /* Hence the solver is asked again, and b does not subsume (AND a b). */
+  scripted->unknown = false;
+  v = s->evaluate (x, a, 5, &status);
+  ATF_REQUIRE_EQ (v->size (), 2U);
+  ATF_REQUIRE_EQ (status, ExprSolver::UNSAT);
+  delete v;
+  ATF_REQUIRE_EQ (s->check_sat (ab, true), ExprSolver::UNSAT);
+  ATF_REQUIRE_EQ (scripted->nb_queries, 4);
+  ATF_REQUIRE_EQ (s->get_nb_subsumptions (), 0U);
+
+  /* A complete answer is remembered with its status. */
+  v = s->evaluate (x, a, 5, &status);
+  ATF_REQUIRE_EQ (v->size (), 2U);
+  ATF_REQUIRE_EQ (status, ExprSolver::UNSAT);
+  delete v;
+  ATF_REQUIRE_EQ (scripted->nb_queries, 4);
+
+  ab->deref ();
+  a->deref ();
+  b->deref ();
+  x->deref ();
+  delete s;
+  insight::terminate ();
+}
+
+ATF_TEST_CASE (lru_eviction)
+
+ATF_TEST_CASE_HEAD (lru_eviction)
+{
+  set_md_var ("descr", "the least recently used answers are evicted");
+}
+
+ATF_TEST_CASE_BODY (lru_eviction)
+{
+  SETUP ();
+  ScriptedSolver *scripted = new ScriptedSolver (&ma);
+  ExprCachingSolver *s = new ExprCachingSolver (&ma, scripted, 2);
+  Expr *a = s_var ("a");
+  Expr *b = s_var ("b");
+  Expr *c = s_var ("c");
+
+  s->check_sat (a, true);
+  s->check_sat (b, true);
+  s->check_sat (a, true);
+  s->check_sat (c, true);	/* evicts b */
+  ATF_REQUIRE_EQ (scripted->nb_queries, 3);
+  s->check_sat (a, true);
+  ATF_REQUIRE_EQ (scripted->nb_queries, 3);
+  s->check_sat (b, true);
+  ATF_REQUIRE_EQ (scripted->nb_queries, 4);
+
+  a->deref ();
+  b->deref ();
+  c->deref ();
+  /* The cache still holds references. */
+  delete s;
+  insight::terminate ();
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+  ATF_ADD_TEST_CASE(tcs, check_sat_cache);
+  ATF_ADD_TEST_CASE(tcs, evaluate_cache);
+  ATF_ADD_TEST_CASE(tcs, unknown_evaluate);
+  ATF_ADD_TEST_CASE(tcs, lru_eviction);
+}
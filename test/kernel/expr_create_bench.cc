@@ -0,0 +1,144 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Micro-benchmark for the hash-consing of expressions. For terms of
+ * increasing depth, it measures the time needed to create (and drop)
+ * a new node on top of an existing term. Since the hash value of each
+ * node is cached, this time should not depend on the depth of the
+ * term. It also compares the creation of small (preallocated) and
+ * large constants.
+ *
+ * USAGE: kernel_expr_create_bench [nb-iterations]
+ */
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include <kernel/Expressions.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+#include <benchmarks.hh>
+
+using namespace std;
+
+/* Build (ADD x (ADD x (... (ADD x x)))) with 'depth' nested ADD. */
+static BinaryApp *
+s_build_term (Variable *x, int depth)
+{
+  Expr *result = x->ref ();
+
+  for (int i = 0; i < depth; i++)
+    result = BinaryApp::create (BV_OP_ADD, x->ref (), result);
+
+  return dynamic_cast<BinaryApp *> (result);
+}
+
+static double
+s_bench_create (BinaryApp *term, Variable *x, long nb_iterations)
+{
+  double start = bench_now ();
+
+  for (long i = 0; i < nb_iterations; i++)
+    {
+      /* The new node is not in the store: lookup, insertion and removal */
+      Expr *e = BinaryApp::create (BV_OP_SUB, term->ref (), x->ref ());
+      e->deref ();
+      /* The node already exists: lookup only */
+      e = BinaryApp::create (BV_OP_ADD, term->get_arg1 ()->ref (),
+			     term->get_arg2 ()->ref ());
+      e->deref ();
+    }
+
+  return (bench_now () - start) / (2.0 * nb_iterations);
+}
+
+/* Create constants in [base, base + 200[; small ones are preallocated. */
+static double
+s_bench_constants (constant_t base, long nb_iterations)
+{
+  double start = bench_now ();
+
+  for (long i = 0; i < nb_iterations; i++)
+    {
+      Expr *c = Constant::create (base + i % 200, 0, 32);
+      c->deref ();
+    }
+
+  return (bench_now () - start) / nb_iterations;
+}
+
+int
+main (int argc, char **argv)
+{
+  long nb_iterations = 100000;
+  ConfigTable ct;
+
+  if (argc > 1)
+    nb_iterations = atol (argv[1]);
+
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+  insight::init (ct);
+
+  Variable *x = Variable::create ("x", 32);
+  BinaryApp *term = NULL;
+
+  cout << setw (10) << "depth" << setw (16) << "ns/create" << endl;
+  for (int depth = 1; depth <= 10000; depth *= 10)
+    {
+      if (term != NULL)
+	term->deref ();
+      term = s_build_term (x, depth);
+      double t = s_bench_create (term, x, nb_iterations);
+
+      cout << setw (10) << depth << setw (16) << fixed << setprecision (1)
+	   << t * 1e9 << endl;
+    }
+
+  cout << endl << setw (10) << "constants" << setw (16) << "ns/create"
+       << endl
+       << setw (10) << "small" << setw (16)
+       << s_bench_constants (0, nb_iterations) * 1e9 << endl
+       << setw (10) << "large" << setw (16)
+       << s_bench_constants (100000, nb_iterations) * 1e9 << endl;
+
+  cout << endl;
+  Expr::dump_store_stats (cout);
+  term->deref ();
+  x->deref ();
+
+  insight::terminate ();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,375 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <atf-c++.hpp>
+#include <pthread.h>
+#include <set>
+#include <sstream>
+#include <vector>
+#include <sys/time.h>
+
+#include <kernel/Architecture.hh>
+#include <kernel/Expressions.hh>
+#include <kernel/expressions/ExprCachingSolver.hh>
+#include <kernel/expressions/ExprSolverPool.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+using namespace std;
+
+/* Number of check_sat() calls started, and running at the same time */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static int nb_started = 0;
+static int nb_running = 0;
+static int max_running = 0;
+
+/* Solver answering UNSAT if the formula (or the context) or one of the
+ * assertions belongs to 'unsat'. A call to check_sat() waits (for a
+ * second at most) until 'rendezvous' calls have started. Like the real
+ * solvers, evaluate() builds expressions from the thread it runs in. */
+class ScriptedSolver : public ExprSolver
+{
+public:
+  ScriptedSolver (const MicrocodeArchitecture *mca,
+		  const std::set<const Expr *> *unsat, int rendezvous)
+    : ExprSolver (mca), unsat (unsat), rendezvous (rendezvous),
+      assertions (), levels () { }
+
+  virtual void add_assertion (const Expr *e)
+    throw (UnexpectedResponseException) {
+    assertions.push_back (e);
+  }
+
+  virtual Result check_sat (const Expr *e, bool)
+    throw (UnexpectedResponseException) {
+    struct timeval now;
+    struct timespec deadline;
+
+    gettimeofday (&now, NULL);
+    deadline.tv_sec = now.tv_sec + 1;
+    deadline.tv_nsec = now.tv_usec * 1000;
+
+    pthread_mutex_lock (&lock);
+    nb_started++;
+    nb_running++;
+    if (nb_running > max_running)
+      max_running = nb_running;
+    pthread_cond_broadcast (&cond);
+    while (nb_started < rendezvous &&
+	   pthread_cond_timedwait (&cond, &lock, &deadline) == 0)
+      continue;
+    pthread_mutex_unlock (&lock);
+
+    pthread_mutex_lock (&lock);
+    nb_running--;
+    pthread_mutex_unlock (&lock);
+
+    return is_unsat (e) ? UNSAT : SAT;
+  }
+
+  virtual Result check_sat ()
+    throw (UnexpectedResponseException) {
+    return SAT;
+  }
+
+  virtual std::vector<constant_t> *
+  evaluate (const Expr *e, const Expr *context, int nb_values,
+	    Result *status)
+    throw (UnexpectedResponseException) {
+    std::vector<constant_t> *result = new std::vector<constant_t> ();
+    for (int i = 0; i < nb_values && ! is_unsat (context); i++)
+      {
+	Expr *eq = Expr::createEquality (e->ref (),
+					 Constant::create (i, 0,
+							   e->get_bv_size ()));
+	eq->deref ();
+	result->push_back (i);
+      }
+    if (status != NULL)
+      *status = result->empty () ? UNSAT : SAT;
+    return result;
+  }
+
+  virtual void push () throw (UnexpectedResponseException) {
+    levels.push_back (assertions.size ());
+  }
+
+  virtual void pop () throw (UnexpectedResponseException) {
+    assertions.resize (levels.back ());
+    levels.pop_back ();
+  }
+
+  virtual Constant *get_value_of (const Expr *)
+    throw (UnexpectedResponseException) {
+    return NULL;
+  }
+
+private:
+  bool is_unsat (const Expr *e) const {
+    for (size_t i = 0; i < assertions.size (); i++)
+      if (unsat->find (assertions[i]) != unsat->end ())
+	return true;
+    return unsat->find (e) != unsat->end ();
+  }
+
+  const std::set<const Expr *> *unsat;
+  int rendezvous;
+  std::vector<const Expr *> assertions;
+  std::vector<std::size_t> levels;
+};
+
+static ExprSolverPool *
+s_create_pool (const MicrocodeArchitecture *mca,
+	       const std::set<const Expr *> *unsat, int nb_workers,
+	       int rendezvous)
+{
+  std::vector<ExprSolver *> workers;
+  for (int i = 0; i < nb_workers; i++)
+    workers.push_back (new ScriptedSolver (mca, unsat, rendezvous));
+
+  return new ExprSolverPool (mca, new ScriptedSolver (mca, unsat, 1),
+			     workers);
+}
+
+static Expr *
+s_var (const char *id)
+{
+  return Variable::create (id, 1);
+}
+
+#define SETUP()							\
+  ConfigTable ct;						\
+  ct.set (logs::DEBUG_ENABLED_PROP, false);			\
+  ct.set (logs::STDIO_ENABLED_PROP, true);			\
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);		\
+  ct.set (Expr::CONCURRENT_STORE_PROP, true);			\
+  insight::init (ct);						\
+  MicrocodeArchitecture ma						\
+    (Architecture::getArchitecture (Architecture::X86_32))
+
+ATF_TEST_CASE (concurrent_queries)
+
+ATF_TEST_CASE_HEAD (concurrent_queries)
+{
+  set_md_var ("descr", "submitted queries are answered by all the workers "
+	      "at once");
+}
+
+ATF_TEST_CASE_BODY (concurrent_queries)
+{
+  SETUP ();
+  const int N = 4;
+  std::set<const Expr *> unsat;
+  ExprSolverPool *s = s_create_pool (&ma, &unsat, N, N);
+  Expr *a = s_var ("a");
+  Expr *b = s_var ("b");
+  std::vector<ExprSolver::Query *> queries;
+
+  ATF_REQUIRE_EQ (s->get_nb_workers (), N);
+  unsat.insert (b);
+  nb_started = max_running = 0;
+  for (int i = 0; i < N; i++)
+    queries.push_back (s->submit_check_sat (i % 2 ? b : a));
+  for (int i = 0; i < N; i++)
+    {
+      ATF_REQUIRE_EQ (queries[i]->get_result (),
+		      i % 2 ? ExprSolver::UNSAT : ExprSolver::SAT);
+      delete queries[i];
+    }
+  ATF_REQUIRE_EQ (max_running, N);
+
+  a->deref ();
+  b->deref ();
+  delete s;
+  insight::terminate ();
+}
+
+ATF_TEST_CASE (submitted_assertions)
+
+ATF_TEST_CASE_HEAD (submitted_assertions)
+{
+  set_md_var ("descr", "queries are answered under the assertions made "
+	      "before they were submitted");
+}
+
+ATF_TEST_CASE_BODY (submitted_assertions)
+{
+  SETUP ();
+  std::set<const Expr *> unsat;
+  ExprSolverPool *s = s_create_pool (&ma, &unsat, 2, 1);
+  Expr *a = s_var ("a");
+  Expr *b = s_var ("b");
+  Expr *x = Variable::create ("x", 32);
+
+  unsat.insert (b);
+  s->push ();
+  s->add_assertion (b);
+  ExprSolver::Query *q1 = s->submit_check_sat (a);
+  ExprSolver::Query *q2 = s->submit_evaluate (x, a, 2);
+  s->pop ();
+  ExprSolver::Query *q3 = s->submit_check_sat (a);
+  ExprSolver::Query *q4 = s->submit_evaluate (x, a, 2);
+
+  ATF_REQUIRE_EQ (q1->get_result (), ExprSolver::UNSAT);
+  ATF_REQUIRE_EQ (q3->get_result (), ExprSolver::SAT);
+  vector<constant_t> *v = q2->get_values ();
+  ATF_REQUIRE_EQ (v->size (), 0U);
+  delete v;
+  v = q4->get_values ();
+  ATF_REQUIRE_EQ (v->size (), 2U);
+  delete v;
+  ATF_REQUIRE (q4->get_values () == NULL);
+
+  /* The synchronous requests go to the main solver. */
+  ATF_REQUIRE_EQ (s->check_sat (a, true), ExprSolver::SAT);
+
+  delete q1;
+  delete q2;
+  delete q3;
+  delete q4;
+  x->deref ();
+  a->deref ();
+  b->deref ();
+  delete s;
+  insight::terminate ();
+}
+
+ATF_TEST_CASE (dropped_queries)
+
+ATF_TEST_CASE_HEAD (dropped_queries)
+{
+  set_md_var ("descr", "queries deleted before a worker took them are not "
+	      "answered");
+}
+
+ATF_TEST_CASE_BODY (dropped_queries)
+{
+  SETUP ();
+  std::set<const Expr *> unsat;
+  /* The worker waits for a second query that never starts. */
+  ExprSolverPool *s = s_create_pool (&ma, &unsat, 1, 2);
+  Expr *a = s_var ("a");
+  Expr *b = s_var ("b");
+
+  nb_started = max_running = 0;
+  ExprSolver::Query *q1 = s->submit_check_sat (a);
+  ExprSolver::Query *q2 = s->submit_check_sat (b);
+  delete q2;
+  ATF_REQUIRE_EQ (q1->get_result (), ExprSolver::SAT);
+  delete q1;
+  ATF_REQUIRE_EQ (nb_started, 1);
+
+  a->deref ();
+  b->deref ();
+  delete s;
+  insight::terminate ();
+}
+
+ATF_TEST_CASE (shared_expressions)
+
+ATF_TEST_CASE_HEAD (shared_expressions)
+{
+  set_md_var ("descr", "workers build expressions while the submitter "
+	      "does");
+}
+
+ATF_TEST_CASE_BODY (shared_expressions)
+{
+  SETUP ();
+  const int N = 4;
+  std::set<const Expr *> unsat;
+  std::vector<ExprSolver *> workers;
+  for (int i = 0; i < N; i++)
+    workers.push_back (new ExprCachingSolver
+		       (&ma, new ScriptedSolver (&ma, &unsat, 1), 16));
+  ExprSolverPool *s =
+    new ExprSolverPool (&ma, new ScriptedSolver (&ma, &unsat, 1), workers);
+  Expr *x = Variable::create ("x", 32);
+  std::vector<ExprSolver::Query *> queries;
+
+  ATF_REQUIRE_EQ (s->get_nb_workers (), N);
+  for (int i = 0; i < 64; i++)
+    {
+      std::ostringstream id;
+      id << "c" << (i % 8);
+      Expr *c = s_var (id.str ().c_str ());
+      queries.push_back (s->submit_evaluate (x, c, 1 + i % 3));
+      c->deref ();
+    }
+  for (int i = 0; i < 64; i++)
+    {
+      vector<constant_t> *v = queries[i]->get_values ();
+      ATF_REQUIRE_EQ (v->size (), (size_t) (1 + i % 3));
+      delete v;
+      delete queries[i];
+    }
+
+  x->deref ();
+  delete s;
+  insight::terminate ();
+}
+
+ATF_TEST_CASE (no_worker)
+
+ATF_TEST_CASE_HEAD (no_worker)
+{
+  set_md_var ("descr", "without workers, queries are answered on demand");
+}
+
+ATF_TEST_CASE_BODY (no_worker)
+{
+  SETUP ();
+  std::set<const Expr *> unsat;
+  ExprSolverPool *s = s_create_pool (&ma, &unsat, 0, 1);
+  Expr *a = s_var ("a");
+
+  ATF_REQUIRE_EQ (s->get_nb_workers (), 0);
+  ExprSolver::Query *q = s->submit_check_sat (a);
+  unsat.insert (a);
+  ATF_REQUIRE_EQ (q->get_result (), ExprSolver::UNSAT);
+  delete q;
+
+  /* Queries may also be dropped before being answered. */
+  delete s->submit_check_sat (a);
+
+  a->deref ();
+  delete s;
+  insight::terminate ();
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+  ATF_ADD_TEST_CASE(tcs, concurrent_queries);
+  ATF_ADD_TEST_CASE(tcs, submitted_assertions);
+  ATF_ADD_TEST_CASE(tcs, dropped_queries);
+  ATF_ADD_TEST_CASE(tcs, shared_expressions);
+  ATF_ADD_TEST_CASE(tcs, no_worker);
+}
@@ -34,6 +34,7 @@
 #include <atf-c++.hpp>
 #include <string>
 #include <fstream>
+#include <vector>
 
 #include <config.h>
 #include <utils/logs.hh>
@@ -58,7 +59,12 @@ using namespace std;
 	     "15{0;32}")					    \
   EVAL_TEST (E2, "(MUL_S %eax{0;8} %ebx{0;8}){0;16}", \
     "(AND (EQ %eax{0;32} 0x4{0;32}) (EQ %ebx{0;32} 0xFE{0;32})){0;1}", \
-	     "0xFFF8{0;16}")
+	     "0xFFF8{0;16}")					    \
+  \
+  ENUM_TEST (N1, "X{0;8}", "(LEQ_U X{0;8} 3{0;8})", 10, 4)	    \
+  ENUM_TEST (N2, "X{0;8}", "(LEQ_U X{0;8} 3{0;8})", 2, 2)	    \
+  ENUM_TEST (N3, "(ADD X{0;8} 1{0;8}){0;8}",			    \
+	     "(AND (EQ X{0;8} 1{0;8}) (EQ X{0;8} 2{0;8})){0;1}", 10, 0)
 
 #define SOLVER_TEST(id, e, res)     \
 ATF_TEST_CASE(id)		    \
@@ -88,6 +94,20 @@ ATF_TEST_CASE_BODY(id)			\
   s_check_evaluation (# id, e, cond, res);	\
 }
 
+#define ENUM_TEST(id, e, cond, nb_values, nb_expected)	\
+ATF_TEST_CASE(id)		    \
+\
+ATF_TEST_CASE_HEAD(id)			\
+{ \
+  set_md_var ("descr", \
+	      "Check expression solver against enumeration of " e); \
+} \
+\
+ATF_TEST_CASE_BODY(id)			\
+{ \
+  s_check_enumeration (# id, e, cond, nb_values, nb_expected);	\
+}
+
 static void
 s_check_tautology (const string &, const string &expr,
 		   ExprSolver::Result res)
@@ -169,9 +189,62 @@ s_check_evaluation (const string &, const string &expr, const string &cond,
   insight::terminate ();
 }
 
+static void
+s_check_enumeration (const string &, const string &expr, const string &cond,
+		     int nb_values, size_t nb_expected)
+{
+  ConfigTable cfg;
+
+  fstream config (INSIGHT_CONFIG_FILE, fstream::in);
+  ATF_REQUIRE  (config.is_open ());
+  cfg.load (config);
+  config.close();
+
+
+  cfg.set (logs::DEBUG_ENABLED_PROP, true);
+  cfg.set (logs::STDIO_ENABLED_PROP, true);
+  cfg.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+
+  insight::init (cfg);
+  const Architecture *x86_32 =
+    Architecture::getArchitecture (Architecture::X86_32);
+  MicrocodeArchitecture ma (x86_32);
+
+  Expr *e = expr_parser (expr, &ma);
+  ATF_REQUIRE (e != NULL);
+  Expr *c = expr_parser (cond, &ma);
+  ATF_REQUIRE (c != NULL);
+
+  ExprSolver *s = ExprSolver::create_default_solver (&ma);
+
+  vector<constant_t> *values = s->evaluate (e, c, nb_values);
+  ATF_REQUIRE_EQ (values->size (), nb_expected);
+  for (size_t i = 0; i < values->size (); i++)
+    {
+      Constant *v = Constant::create (values->at (i), 0, e->get_bv_size ());
+      Expr *in = Expr::createLAnd (Expr::createEquality (e->ref (), v),
+				   c->ref ());
+      ATF_REQUIRE_EQ (s->check_sat (in, true), ExprSolver::SAT);
+      in->deref ();
+      for (size_t j = 0; j < i; j++)
+	ATF_REQUIRE (values->at (i) != values->at (j));
+    }
+
+  /* The solver is left usable after an enumeration. */
+  ATF_REQUIRE_EQ (s->check_sat (c, true),
+		  nb_expected > 0 ? ExprSolver::SAT : ExprSolver::UNSAT);
+
+  delete values;
+  e->deref ();
+  c->deref ();
+  delete s;
+  insight::terminate ();
+}
+
 ALL_TESTS
 #undef SOLVER_TEST
 #undef EVAL_TEST
+#undef ENUM_TEST
 
 #define SOLVER_TEST(id, e, expout) \
   ATF_ADD_TEST_CASE(tcs, id);
@@ -179,6 +252,9 @@ ALL_TESTS
 #define EVAL_TEST(id, e, cond, res)	\
   ATF_ADD_TEST_CASE(tcs, id);
 
+#define ENUM_TEST(id, e, cond, nb_values, nb_expected)	\
+  ATF_ADD_TEST_CASE(tcs, id);
+
 ATF_INIT_TEST_CASES(tcs)
 {
   ALL_TESTS
@@ -32,6 +32,7 @@
 #include <string>
 #include <sstream>
 #include <list>
+#include <pthread.h>
 
 #include <kernel/Architecture.hh>
 #include <kernel/Expressions.hh>
@@ -306,6 +307,89 @@ ATF_TEST_CASE_BODY(check_pattern_matching)
 
 
 
+  insight::terminate ();
+}
+
+			/* --------------- */
+
+ATF_TEST_CASE (check_concurrent_store)
+
+ATF_TEST_CASE_HEAD (check_concurrent_store)
+{
+  set_md_var ("descr",
+	      "create and release shared exprs from several threads");
+}
+
+#define NB_THREADS 8
+#define NB_ITERATIONS 50000
+
+struct ConcurrentStoreData {
+  Variable *x;
+  int nb_errors;
+};
+
+static void *
+s_concurrent_store_worker (void *arg)
+{
+  ConcurrentStoreData *data = (ConcurrentStoreData *) arg;
+
+  for (int i = 0; i < NB_ITERATIONS; i++)
+    {
+      /* (MUL_U [(ADD x c)] (ADD x c)) where c is shared between threads */
+      Expr *c = Constant::create (i % 97, 0, 32);
+      Expr *a = BinaryApp::create (BV_OP_ADD, data->x->ref (), c);
+      Expr *m = MemCell::create (a->ref (), 0, 32);
+      Expr *F = BinaryApp::create (BV_OP_MUL_U, m, a);
+
+      c = Constant::create (i % 97, 0, 32);
+      a = BinaryApp::create (BV_OP_ADD, data->x->ref (), c);
+      m = MemCell::create (a->ref (), 0, 32);
+      Expr *G = BinaryApp::create (BV_OP_MUL_U, m, a);
+
+      if (F != G)
+	data->nb_errors++;
+      F->deref ();
+      G->deref ();
+    }
+
+  return NULL;
+}
+
+ATF_TEST_CASE_BODY (check_concurrent_store)
+{
+  ConfigTable ct;
+  ct.set (logs::DEBUG_ENABLED_PROP, false);
+  ct.set (logs::STDIO_ENABLED_PROP, true);
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);
+  ct.set (Expr::CONCURRENT_STORE_PROP, true);
+
+  insight::init (ct);
+
+  pthread_t threads[NB_THREADS];
+  ConcurrentStoreData data[NB_THREADS];
+  Variable *x = Variable::create ("x", 32);
+
+  for (int t = 0; t < NB_THREADS; t++)
+    {
+      data[t].x = x;
+      data[t].nb_errors = 0;
+      ATF_REQUIRE (pthread_create (&threads[t], NULL,
+				   s_concurrent_store_worker,
+				   &data[t]) == 0);
+    }
+
+  for (int t = 0; t < NB_THREADS; t++)
+    {
+      ATF_REQUIRE (pthread_join (threads[t], NULL) == 0);
+      ATF_REQUIRE_EQ (data[t].nb_errors, 0);
+    }
+
+  /* x is the only expression still alive */
+  Expr *y = Variable::create ("x", 32);
+  ATF_REQUIRE_EQ (x, y);
+  y->deref ();
+  x->deref ();
+
   insight::terminate ();
 }
 
@@ -314,4 +398,5 @@ ATF_INIT_TEST_CASES(tcs)
   ATF_ADD_TEST_CASE(tcs, check_tautologies);
   ATF_ADD_TEST_CASE(tcs, check_replacement);
   ATF_ADD_TEST_CASE(tcs, check_pattern_matching);
+  ATF_ADD_TEST_CASE(tcs, check_concurrent_store);
 }
@@ -0,0 +1,224 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <atf-c++.hpp>
+#include <list>
+#include <vector>
+
+#include <io/expressions/expr-parser.hh>
+#include <kernel/Architecture.hh>
+#include <kernel/Expressions.hh>
+#include <kernel/FrozenMicrocode.hh>
+#include <kernel/Microcode.hh>
+#include <kernel/insight.hh>
+#include <utils/logs.hh>
+
+using namespace std;
+
+#define SETUP()							\
+  ConfigTable ct;						\
+  ct.set (logs::DEBUG_ENABLED_PROP, false);			\
+  ct.set (logs::STDIO_ENABLED_PROP, true);			\
+  ct.set (Expr::NON_EMPTY_STORE_ABORT_PROP, true);		\
+  insight::init (ct);						\
+  MicrocodeArchitecture ma						\
+    (Architecture::getArchitecture (Architecture::X86_32));	\
+  Microcode *mc = new Microcode ();				\
+  mc->set_entry_point (MicrocodeAddress (1))
+
+#define TEARDOWN()				\
+  delete mc;					\
+  insight::terminate ()
+
+static StmtArrow *
+s_skip (Microcode *mc, address_t from, address_t to)
+{
+  return mc->add_skip (MicrocodeAddress (from), MicrocodeAddress (to));
+}
+
+static StmtArrow *
+s_jump (Microcode *mc, const MicrocodeArchitecture &ma, address_t from,
+	const char *target)
+{
+  Expr *e = expr_parser (target, &ma);
+  ATF_REQUIRE (e != NULL);
+
+  return mc->add_jump (MicrocodeAddress (from), e);
+}
+
+/* Arrows in the order a visitor is given them */
+class RecordingVisitor : public GraphVisitor<MicrocodeNode, StmtArrow>
+{
+public:
+  vector<StmtArrow *> arrows;
+
+  void process (MicrocodeNode *, StmtArrow *e) { arrows.push_back (e); }
+  bool go_further (MicrocodeNode *, StmtArrow *) { return true; }
+  void back_step_impasse () { }
+  void back_step_loop (StmtArrow *) { }
+  bool continue_run () { return true; }
+  void traversal_over () { }
+};
+
+ATF_TEST_CASE (layout)
+
+ATF_TEST_CASE_HEAD (layout)
+{
+  set_md_var ("descr", "nodes and arrows are numbered in the order of "
+	      "the program");
+}
+
+ATF_TEST_CASE_BODY (layout)
+{
+  SETUP ();
+  StmtArrow *a12 = s_skip (mc, 1, 2);
+  StmtArrow *a13 = s_skip (mc, 1, 3);
+  StmtArrow *a23 = s_skip (mc, 2, 3);
+  StmtArrow *a3x = s_jump (mc, ma, 3, "%eax");
+  StmtArrow *a31 = s_jump (mc, ma, 3, "1{0;32}");
+
+  FrozenMicrocode *fm = mc->freeze ();
+  ATF_REQUIRE_EQ (fm->get_program (), mc);
+  ATF_REQUIRE_EQ (fm->get_number_of_nodes (), (size_t) 3);
+  ATF_REQUIRE_EQ (fm->get_number_of_arrows (), (size_t) 5);
+  for (size_t n = 0; n < fm->get_number_of_nodes (); n++)
+    {
+      ATF_REQUIRE_EQ (fm->get_node (n)->get_loc ().getGlobal (), n + 1);
+      ATF_REQUIRE_EQ (fm->get_id (fm->get_node (n)), n);
+      ATF_REQUIRE_EQ (fm->get_id (MicrocodeAddress (n + 1)), n);
+    }
+  ATF_REQUIRE_EQ (fm->get_id (MicrocodeAddress (4)), FrozenMicrocode::NONE);
+  ATF_REQUIRE_EQ (fm->get_entry_id (), (size_t) 0);
+
+  StmtArrow *arrows[] = { a12, a13, a23, a3x, a31 };
+  size_t sources[] = { 0, 0, 1, 2, 2 };
+  size_t targets[] = { 1, 2, 2, FrozenMicrocode::NONE, 0 };
+  for (size_t a = 0; a < 5; a++)
+    {
+      ATF_REQUIRE_EQ (fm->get_arrow (a), arrows[a]);
+      ATF_REQUIRE_EQ (fm->get_arrow_source (a), sources[a]);
+      ATF_REQUIRE_EQ (fm->get_arrow_target (a), targets[a]);
+      ATF_REQUIRE (fm->get_successors_begin (sources[a]) <= a);
+      ATF_REQUIRE (a < fm->get_successors_end (sources[a]));
+    }
+  ATF_REQUIRE_EQ (fm->get_successors_begin (1), (size_t) 2);
+  ATF_REQUIRE_EQ (fm->get_successors_end (2), (size_t) 5);
+
+  /* Node 2 (address 3) is entered by a13 then a23 */
+  ATF_REQUIRE_EQ (fm->get_predecessors_end (2) -
+		  fm->get_predecessors_begin (2), (size_t) 2);
+  ATF_REQUIRE_EQ (fm->get_predecessor_arrow (fm->get_predecessors_begin (2)),
+		  (size_t) 1);
+  ATF_REQUIRE_EQ (fm->get_predecessor_arrow (fm->get_predecessors_begin (2)
+					     + 1), (size_t) 2);
+  /* The constant jump enters node 0 */
+  ATF_REQUIRE_EQ (fm->get_nb_predecessors (fm->get_node (0)), 1);
+  ATF_REQUIRE_EQ (fm->get_predecessor (fm->get_node (0), 0).first, a31);
+  ATF_REQUIRE_EQ (fm->get_predecessor (fm->get_node (0), 0).second,
+		  fm->get_node (2));
+  delete fm;
+
+  TEARDOWN ();
+}
+
+ATF_TEST_CASE (no_entry_point)
+
+ATF_TEST_CASE_HEAD (no_entry_point)
+{
+  set_md_var ("descr", "an entry point without node has no identifier");
+}
+
+ATF_TEST_CASE_BODY (no_entry_point)
+{
+  SETUP ();
+  mc->set_entry_point (MicrocodeAddress (7));
+  s_skip (mc, 1, 2);
+
+  FrozenMicrocode *fm = mc->freeze ();
+  ATF_REQUIRE_EQ (fm->get_entry_id (), FrozenMicrocode::NONE);
+  ATF_REQUIRE (fm->get_entry_point () == NULL);
+  delete fm;
+
+  TEARDOWN ();
+}
+
+ATF_TEST_CASE (visitors)
+
+ATF_TEST_CASE_HEAD (visitors)
+{
+  set_md_var ("descr", "the generic traversals give the same results on "
+	      "the program and on its snapshot");
+}
+
+ATF_TEST_CASE_BODY (visitors)
+{
+  SETUP ();
+  s_skip (mc, 1, 2);
+  s_skip (mc, 1, 5);
+  s_skip (mc, 2, 3);
+  s_skip (mc, 3, 2);
+  s_skip (mc, 3, 4);
+  s_skip (mc, 4, 6);
+  s_skip (mc, 5, 4);
+  s_jump (mc, ma, 6, "%eax");
+
+  FrozenMicrocode *fm = mc->freeze ();
+  MicrocodeNode *start = mc->get_entry_point ();
+  ATF_REQUIRE_EQ (fm->get_entry_point (), start);
+
+  RecordingVisitor v1, v2;
+  mc->depth_first_traversal (start, v1);
+  fm->depth_first_traversal (start, v2);
+  ATF_REQUIRE_EQ (v1.arrows.size (), (size_t) 7);
+  ATF_REQUIRE (v1.arrows == v2.arrows);
+
+  RecordingVisitor v3, v4;
+  mc->topological_traversal (start, v3);
+  fm->topological_traversal (start, v4);
+  ATF_REQUIRE (v3.arrows == v4.arrows);
+
+  MicrocodeNode *end = mc->get_node (MicrocodeAddress (4));
+  list<MicrocodeNode *> *l1 = mc->get_nodes_between (start, end);
+  list<MicrocodeNode *> *l2 = fm->get_nodes_between (start, end);
+  ATF_REQUIRE_EQ (l1->size (), (size_t) 5);
+  ATF_REQUIRE (*l1 == *l2);
+  delete l1;
+  delete l2;
+  delete fm;
+
+  TEARDOWN ();
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+  ATF_ADD_TEST_CASE(tcs, layout);
+  ATF_ADD_TEST_CASE(tcs, no_entry_point);
+  ATF_ADD_TEST_CASE(tcs, visitors);
+}
@@ -0,0 +1,21 @@
+	.include "x86_32-simulator-header.s"
+
+	# The value at 'input' is never written: each iteration of the loop
+	# compares the counter with an unknown value and extends the path
+	# condition of the states staying in the loop.
+	.set	input, 0x8000
+
+	mov	$0x0, %ecx
+
+loop1:
+	inc	%ecx
+	cmp	%ecx, input
+	je	found
+	cmp	$0x400, %ecx
+	jne	loop1
+
+found:
+	cmp	$0x400, %ecx
+	ja	error
+
+	.include "x86_32-simulator-end.s"
@@ -0,0 +1,179 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <atf-c++.hpp>
+#include <cstdlib>
+#include <map>
+#include <utils/PersistentMap.hh>
+
+using namespace std;
+
+typedef PersistentMap<int, int> IntMap;
+
+static bool
+s_same_contents (const IntMap &m, const map<int, int> &ref)
+{
+  if (m.size () != ref.size ())
+    return false;
+
+  map<int, int>::const_iterator r = ref.begin ();
+  for (IntMap::const_iterator i = m.begin (); i != m.end (); i++, r++)
+    if (i->first != r->first || i->second != r->second)
+      return false;
+
+  return true;
+}
+
+ATF_TEST_CASE(basics)
+ATF_TEST_CASE_HEAD(basics)
+{
+  set_md_var("descr", "Check basic operations of PersistentMap.");
+}
+ATF_TEST_CASE_BODY(basics)
+{
+  IntMap m;
+
+  ATF_REQUIRE (m.empty ());
+  ATF_REQUIRE (m.begin () == m.end ());
+  ATF_REQUIRE (m.lookup (1) == NULL);
+
+  for (int i = 0; i < 100; i++)
+    m.put ((i * 37) % 100, i);
+
+  ATF_REQUIRE_EQ (m.size (), 100U);
+  int expected = 0;
+  for (IntMap::const_iterator i = m.begin (); i != m.end (); i++)
+    ATF_REQUIRE_EQ (i->first, expected++);
+  ATF_REQUIRE_EQ (expected, 100);
+
+  m.put (74, -1);
+  ATF_REQUIRE_EQ (m.size (), 100U);
+  ATF_REQUIRE_EQ (*m.lookup (74), -1);
+  ATF_REQUIRE_EQ (m.find (74)->second, -1);
+
+  IntMap::const_iterator it = m.find (98);
+  ATF_REQUIRE_EQ ((it++)->first, 98);
+  ATF_REQUIRE_EQ (it->first, 99);
+  ATF_REQUIRE (++it == m.end ());
+  ATF_REQUIRE (m.find (100) == m.end ());
+
+  ATF_REQUIRE (m.erase (74));
+  ATF_REQUIRE (! m.erase (74));
+  ATF_REQUIRE (m.lookup (74) == NULL);
+  ATF_REQUIRE_EQ (m.size (), 99U);
+
+  m.clear ();
+  ATF_REQUIRE (m.empty ());
+  ATF_REQUIRE (m.begin () == m.end ());
+}
+
+ATF_TEST_CASE(sharing)
+ATF_TEST_CASE_HEAD(sharing)
+{
+  set_md_var("descr", "Check that copies of a PersistentMap are "
+	     "independent.");
+}
+ATF_TEST_CASE_BODY(sharing)
+{
+  IntMap *m = new IntMap ();
+
+  for (int i = 0; i < 1000; i++)
+    m->put (i, i);
+
+  IntMap copy (*m);
+  ATF_REQUIRE (copy.shares_root (*m));
+
+  copy.put (500, -500);
+  copy.erase (10);
+  m->put (1000, 1000);
+  ATF_REQUIRE (! copy.shares_root (*m));
+
+  ATF_REQUIRE_EQ (*m->lookup (500), 500);
+  ATF_REQUIRE (m->lookup (10) != NULL);
+  ATF_REQUIRE_EQ (m->size (), 1001U);
+  ATF_REQUIRE_EQ (*copy.lookup (500), -500);
+  ATF_REQUIRE (copy.lookup (10) == NULL);
+  ATF_REQUIRE (copy.lookup (1000) == NULL);
+  ATF_REQUIRE_EQ (copy.size (), 999U);
+
+  IntMap other;
+  other = *m;
+  delete m;
+
+  ATF_REQUIRE_EQ (other.size (), 1001U);
+  ATF_REQUIRE_EQ (*other.lookup (500), 500);
+  ATF_REQUIRE_EQ (*copy.lookup (999), 999);
+}
+
+ATF_TEST_CASE(random)
+ATF_TEST_CASE_HEAD(random)
+{
+  set_md_var("descr", "Check PersistentMap and its copies against std::map "
+	     "on random operations.");
+}
+ATF_TEST_CASE_BODY(random)
+{
+  vector<IntMap> maps (1);
+  vector< map<int, int> > refs (1);
+
+  srand (42);
+  for (int step = 0; step < 20000; step++)
+    {
+      int i = rand () % maps.size ();
+      int k = rand () % 512;
+
+      switch (rand () % 8)
+	{
+	case 0:
+	  if (maps.size () < 16)
+	    {
+	      maps.push_back (maps[i]);
+	      refs.push_back (refs[i]);
+	    }
+	  break;
+	case 1: case 2:
+	  ATF_REQUIRE_EQ (maps[i].erase (k), refs[i].erase (k) == 1);
+	  break;
+	default:
+	  maps[i].put (k, step);
+	  refs[i][k] = step;
+	}
+    }
+
+  for (size_t i = 0; i < maps.size (); i++)
+    ATF_REQUIRE (s_same_contents (maps[i], refs[i]));
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+  ATF_ADD_TEST_CASE(tcs, basics);
+  ATF_ADD_TEST_CASE(tcs, sharing);
+  ATF_ADD_TEST_CASE(tcs, random);
+}
@@ -0,0 +1,115 @@
+/*-
+ * Copyright (C) 2010-2014, Centre National de la Recherche Scientifique,
+ *                          Institut Polytechnique de Bordeaux,
+ *                          Universite de Bordeaux.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <atf-c++.hpp>
+#include <vector>
+#include <utils/WorkStealingPool.hh>
+
+using namespace std;
+
+struct CountJob : public WorkStealingPool::Job
+{
+  CountJob () : nb_runs (0), worker (-1), length (0) { }
+
+  virtual void run (int w) {
+    volatile int x = 0;
+
+    for (int i = 0; i < length; i++)
+      x += i;
+    __sync_fetch_and_add (&nb_runs, 1);
+    worker = w;
+  }
+
+  int nb_runs;
+  int worker;
+  int length;
+};
+
+static void
+s_check_pool (int nb_workers, int nb_batches, size_t nb_jobs)
+{
+  WorkStealingPool pool (nb_workers);
+
+  ATF_REQUIRE (pool.get_nb_workers () >= 1);
+  ATF_REQUIRE (pool.get_nb_workers () <= (nb_workers < 1 ? 1 : nb_workers));
+
+  for (int b = 0; b < nb_batches; b++)
+    {
+      vector<CountJob> jobs (nb_jobs);
+      vector<WorkStealingPool::Job *> todo;
+
+      /* Uneven jobs, so that workers run out of their own ones */
+      for (size_t i = 0; i < nb_jobs; i++)
+	{
+	  jobs[i].length = (i % 7 == 0 ? 100000 : 10);
+	  todo.push_back (&jobs[i]);
+	}
+      pool.run (todo);
+
+      for (size_t i = 0; i < nb_jobs; i++)
+	{
+	  ATF_REQUIRE_EQ (jobs[i].nb_runs, 1);
+	  ATF_REQUIRE (jobs[i].worker >= 0);
+	  ATF_REQUIRE (jobs[i].worker < pool.get_nb_workers ());
+	}
+    }
+}
+
+ATF_TEST_CASE(single)
+ATF_TEST_CASE_HEAD(single)
+{
+  set_md_var("descr", "Check that a pool with one worker runs its jobs on "
+	     "the calling thread.");
+}
+ATF_TEST_CASE_BODY(single)
+{
+  s_check_pool (1, 3, 50);
+  s_check_pool (0, 1, 10);
+}
+
+ATF_TEST_CASE(batches)
+ATF_TEST_CASE_HEAD(batches)
+{
+  set_md_var("descr", "Check that every job of every batch is run exactly "
+	     "once.");
+}
+ATF_TEST_CASE_BODY(batches)
+{
+  s_check_pool (4, 200, 37);
+  s_check_pool (8, 20, 1000);
+  s_check_pool (3, 50, 1);
+  s_check_pool (3, 5, 0);
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+  ATF_ADD_TEST_CASE(tcs, single);
+  ATF_ADD_TEST_CASE(tcs, batches);
+}
@@ -43,6 +43,10 @@ static const string SIMULATOR_ZERO_REGISTERS =
   "disas.simulator.zero-registers";
 static const string SIMULATOR_NB_VISITS_PER_ADDRESS =
   "disas.simulator.nb-visits-per-address";
+static const string SIMULATOR_THREADS =
+  "disas.simulator.threads";
+static const string SIMULATOR_WORKLIST =
+  "disas.simulator.worklist";
 static const string SIMULATOR_WARN_UNSOLVED_DYNAMIC_JUMPS =
   "disas.simulator.warn-unsolved-dynamic-jumps";
 static const string SIMULATOR_WARN_SKIPPED_DYNAMIC_JUMPS =
@@ -154,6 +158,16 @@ s_generic_call (const list<ConcreteAddress >&entrypoint,
 		    << "to " << dec << max_nb_visits << " visits."
 		    << endl;
     }
+  int nb_threads = CFGRECOVERY_CONFIG->get_integer (SIMULATOR_THREADS, 1);
+  string worklist = CFGRECOVERY_CONFIG->get (SIMULATOR_WORKLIST, "fifo");
+  int wl;
+
+  for (wl = 0; WORKLIST_STRATEGIES[wl].name != NULL; wl++)
+    if (worklist == WORKLIST_STRATEGIES[wl].name)
+      break;
+  if (WORKLIST_STRATEGIES[wl].name == NULL)
+    logs::warning << "warning: unknown worklist strategy '" << worklist
+		  << "'; pending arrows are taken in FIFO order." << endl;
   int djmpth =
     CFGRECOVERY_CONFIG->get_integer (SYMSIM_DYNAMIC_JUMP_THRESHOLD);
   bool djmp2mem =
@@ -169,6 +183,8 @@ s_generic_call (const list<ConcreteAddress >&entrypoint,
   F.set_map_dynamic_jumps_to_memory (djmp2mem);
   F.set_dynamic_jumps_threshold (djmpth);
   F.set_max_number_of_visits_per_address (max_nb_visits);
+  F.set_number_of_threads (nb_threads);
+  F.set_worklist_strategy (WORKLIST_STRATEGIES[wl].strategy);
 
   running_algorithm = (F.* build) ();
   if (signal (SIGINT, &s_sigint_handler) == SIG_ERR)
@@ -42,7 +42,9 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 
+#include <decoders/SpeculativeDecoder.hh>
 #include <decoders/binutils/BinutilsDecoder.hh>
+#include <decoders/binutils/X86DirectDecoder.hh>
 
 #include <kernel/insight.hh>
 #include <kernel/expressions/ExprSolver.hh>
@@ -103,8 +105,15 @@ static int asm_with_bytes = 0;
 static int asm_with_holes = 0;
 static int asm_with_symbols = 0;
 static int sink_nodes = 0;
+static int direct_decoder = 0;
+static int mapped_loading = 0;
 static bool no_stub = false;
 
+/* Decoding ahead of the traversal (see SpeculativeDecoder); disabled when
+ * the number of threads is 0. */
+static const string PREFETCH_THREADS_PROP = "disas.prefetch.threads";
+static const string PREFETCH_CHUNK_SIZE_PROP = "disas.prefetch.chunk-size";
+
 struct disassembler {
   const char *name;
   const char *desc;
@@ -178,7 +187,11 @@ usage (int status)
 	   << "  --asm-with-holes\t\tdo not skip the empty gaps in memory"  << endl
 	   << "  --asm-with-symbols\t\tdisplay symbols whenever possible" << endl
 	   << "miscellaneous options:" << endl
-	   << "   --sink-nodes\t\t\tlist sink nodes" << endl;
+	   << "   --sink-nodes\t\t\tlist sink nodes" << endl
+	   << "   --direct-decoder\t\tdecode x86 without the disassembler"
+	   << endl
+	   << "   --mmap\t\t\tmap the binary into memory instead of "
+	   << "copying it" << endl;
     }
 
   exit (status);
@@ -381,6 +394,8 @@ main (int argc, char *argv[])
     {"asm-with-holes", no_argument, &asm_with_holes, 1 },
     {"asm-with-symbols", no_argument, &asm_with_symbols, 1 },
     {"sink-nodes", no_argument, &sink_nodes, 1 },
+    {"direct-decoder", no_argument, &direct_decoder, 1 },
+    {"mmap", no_argument, &mapped_loading, 1 },
     {NULL, 0, NULL, 0}
   };
 
@@ -432,6 +447,10 @@ main (int argc, char *argv[])
 
 	  CONFIG.set (string("disas.simulator.init-sp"), string("0xffffff00"));
 	  CONFIG.set (string("disas.simulator.nb-visits-per-address"), 5);
+	  CONFIG.set (string("disas.simulator.threads"), 1);
+
+	  CONFIG.set (PREFETCH_THREADS_PROP, 0);
+	  CONFIG.set (PREFETCH_CHUNK_SIZE_PROP, 65536);
 
 	  CONFIG.set (ExprSolver::DEBUG_TRACES_PROP, false);
 	  if (enable_debug)
@@ -576,6 +595,17 @@ main (int argc, char *argv[])
       f.close();
     }
 
+  /* Workers of the pre-pass, of the traversal and of the solver pools
+   * share the store of expressions. */
+  int prefetch_threads = CONFIG.get_integer (PREFETCH_THREADS_PROP, 0);
+  int traversal_threads =
+    CONFIG.get_integer (string ("disas.simulator.threads"), 1);
+  int solver_pool_size = CONFIG.get_integer (ExprSolver::POOL_SIZE_PROP, 0);
+  if ((prefetch_threads > 1 || traversal_threads > 1 ||
+       solver_pool_size > 0) &&
+      ! CONFIG.has (Expr::CONCURRENT_STORE_PROP))
+    CONFIG.set (Expr::CONCURRENT_STORE_PROP, true);
+
   insight::init (CONFIG);
 
   ConcreteMemory *memory = new ConcreteMemory ();
@@ -583,6 +613,7 @@ main (int argc, char *argv[])
   MicrocodeArchitecture *arch = NULL;
   string execfile_name (argv[optind]);
   StubFactory *stubfactory = NULL;
+  std::list<BinaryLoader::section_t> code_sections;
 
   if (verbosity > 0)
     logs::warning << "loading file " << execfile_name << endl;
@@ -616,6 +647,7 @@ main (int argc, char *argv[])
     if (!no_stub)
       stubfactory = loader->get_StubFactory ();
 
+    loader->set_mapped_loading (mapped_loading);
     if (! loader->load_memory (memory) && verbosity > 0)
       logs::warning << "nothing to load in file " << execfile_name << endl;
     if (! loader->load_symbol_table (symboltable) && verbosity > 0)
@@ -628,6 +660,8 @@ main (int argc, char *argv[])
 			<< loader->get_entrypoint() << endl;
 	entrypoints.push_back (ConcreteAddress(loader->get_entrypoint()));
       }
+    if (prefetch_threads > 0)
+      code_sections = loader->get_code_sections ();
     delete loader;
   } catch (Architecture::UnsupportedArch &e) {
     logs::error << execfile_name << ": " << e.what() << endl;
@@ -682,12 +716,34 @@ main (int argc, char *argv[])
   }
 
   BinutilsDecoder *decoder = NULL;
+  X86DirectDecoder *x86_decoder = NULL;
+  SpeculativeDecoder *prefetcher = NULL;
   Microcode *mc = NULL;
 
   if (dis->process == NULL)
     goto end;
 
-  decoder = new BinutilsDecoder (arch, memory);
+  if (direct_decoder)
+    decoder = x86_decoder = new X86DirectDecoder (arch, memory);
+  else
+    decoder = new BinutilsDecoder (arch, memory);
+
+  if (prefetch_threads > 0)
+    {
+      long chunk_size =
+	CONFIG.get_integer (PREFETCH_CHUNK_SIZE_PROP, 65536);
+
+      if (verbosity > 0)
+	logs::display << "Decoding code sections ahead with "
+		      << prefetch_threads << " thread(s)" << endl;
+      prefetcher =
+	new SpeculativeDecoder (arch, memory, decoder,
+				(direct_decoder
+				 ? DecoderFactory::DIRECT_DECODER
+				 : DecoderFactory::BINUTILS_DECODER));
+      prefetcher->prefetch (code_sections, prefetch_threads,
+			    chunk_size > 0 ? chunk_size : 65536);
+    }
 
   if (verbosity > 0)
     logs::display << "Starting " << dis->desc << " disassembly" << endl;
@@ -720,7 +776,10 @@ main (int argc, char *argv[])
   try
     {
       mc->add_arrow_creation_callback (&CTRL_C_HANDLER);
-      dis->process (entrypoints, memory, decoder, mc);
+      if (prefetcher != NULL)
+	dis->process (entrypoints, memory, prefetcher, mc);
+      else
+	dis->process (entrypoints, memory, decoder, mc);
     }
   catch (Decoder::Exception &e)
     {
@@ -806,7 +865,19 @@ main (int argc, char *argv[])
 	logs::display << "no sink node." << endl;
     }
 
+  if (verbosity > 1)
+    {
+      decoder->output_cache_stats (logs::display);
+      if (x86_decoder != NULL)
+	x86_decoder->output_direct_stats (logs::display);
+      if (prefetcher != NULL)
+	prefetcher->output_prefetch_stats (logs::display);
+      ExprSolver::output_evaluate_stats (logs::display);
+      Expr::dump_store_stats (logs::display);
+    }
+
   delete mc;
+  delete prefetcher;
   delete decoder;
 
  end:
@@ -32,6 +32,7 @@
 #include <io/microcode/asm-writer.hh>
 #include <io/microcode/dot-writer.hh>
 #include <analyses/CFG.hh>
+#include <analyses/GraphStructure.hh>
 #include <analyses/slicing/Slicing.hh>
 
 struct PyMicrocode
@@ -244,17 +245,151 @@ s_PyMicrocode_get_range (PyObject *self, PyObject *)
   return Py_BuildValue ("(k,k)", minaddr, maxaddr);
 }
 
+/* List of the values of get for the vertices of G, None for NONE */
+static PyObject *
+s_structure_list (const GraphStructure *G,
+		  std::size_t (GraphStructure::*get) (std::size_t) const,
+		  std::size_t nb)
+{
+  PyObject *result = PyList_New (nb);
+
+  if (result == NULL)
+    return NULL;
+
+  for (std::size_t i = 0; i < nb; i++)
+    {
+      std::size_t v = (G->*get) (i);
+      PyObject *item;
+
+      if (v == GraphStructure::NONE)
+	item = pynsight::None ();
+      else
+	item = PyInt_FromSize_t (v);
+      if (item == NULL)
+	{
+	  Py_DECREF (result);
+	  return NULL;
+	}
+      PyList_SET_ITEM (result, i, item);
+    }
+
+  return result;
+}
+
+static bool
+s_set_item (PyObject *dict, const char *key, PyObject *value)
+{
+  if (value == NULL)
+    return false;
+
+  int err = PyDict_SetItemString (dict, key, value);
+  Py_DECREF (value);
+
+  return err == 0;
+}
+
+/* Dictionary of the structure of cfg: its dot output (None if it was
+ * written to a file), the addresses of its blocks, then for each block
+ * its immediate dominator and post-dominator, its strongly connected
+ * component and its innermost loop, as indexes of blocks or loops (None
+ * if there is none), and the loops as tuples (header, parent,
+ * reducible). */
+static PyObject *
+s_cfg_structure (CFG *cfg, PyObject *dot)
+{
+  GraphStructure *G = GraphStructure::create (cfg);
+  std::size_t nb_blocks = G->get_number_of_vertices ();
+  std::size_t nb_loops = G->get_number_of_loops ();
+  PyObject *result = PyDict_New ();
+  PyObject *blocks = PyList_New (nb_blocks);
+  PyObject *loops = PyList_New (nb_loops);
+  bool ok = result != NULL && blocks != NULL && loops != NULL;
+  CFG::const_node_iterator b = cfg->begin_nodes ();
+
+  for (std::size_t i = 0; ok && i < nb_blocks; i++, b++)
+    {
+      MicrocodeAddress addr = (*b)->get_entry ()->get_loc ();
+      PyObject *item =
+	Py_BuildValue ("(k,k)", addr.getGlobal (), addr.getLocal ());
+
+      ok = item != NULL;
+      if (ok)
+	PyList_SET_ITEM (blocks, i, item);
+    }
+
+  for (std::size_t l = 0; ok && l < nb_loops; l++)
+    {
+      PyObject *parent;
+
+      if (G->get_loop_parent (l) == GraphStructure::NONE)
+	parent = pynsight::None ();
+      else
+	parent = PyInt_FromSize_t (G->get_loop_parent (l));
+
+      PyObject *item = NULL;
+      if (parent != NULL)
+	{
+	  item = Py_BuildValue ("(nOO)", (Py_ssize_t) G->get_loop_header (l),
+				parent,
+				G->is_loop_reducible (l) ? Py_True : Py_False);
+	  Py_DECREF (parent);
+	}
+
+      ok = item != NULL;
+      if (ok)
+	PyList_SET_ITEM (loops, l, item);
+    }
+
+  /* The lists are given to the dictionary, even on error */
+  if (ok)
+    {
+      Py_INCREF (dot);
+      ok = s_set_item (result, "dot", dot);
+      ok = s_set_item (result, "blocks", blocks) && ok;
+      ok = s_set_item (result, "loops", loops) && ok;
+      blocks = loops = NULL;
+      ok = (ok &&
+	    s_set_item (result, "idom",
+			s_structure_list
+			(G, &GraphStructure::get_immediate_dominator,
+			 nb_blocks)) &&
+	    s_set_item (result, "ipdom",
+			s_structure_list
+			(G, &GraphStructure::get_immediate_post_dominator,
+			 nb_blocks)) &&
+	    s_set_item (result, "scc",
+			s_structure_list (G, &GraphStructure::get_scc,
+					  nb_blocks)) &&
+	    s_set_item (result, "loop",
+			s_structure_list (G, &GraphStructure::get_innermost_loop,
+					  nb_blocks)));
+    }
+  delete G;
+
+  Py_XDECREF (blocks);
+  Py_XDECREF (loops);
+  if (! ok)
+    {
+      Py_XDECREF (result);
+      result = NULL;
+    }
+
+  return result;
+}
+
 static PyObject *
 s_PyMicrocode_cfg (PyObject *self, PyObject *args, PyObject *kwds)
 {
-  static const char *kwlists[] =  { "start", "filename", "trim", NULL };
+  static const char *kwlists[] =
+    { "start", "filename", "trim", "structure", NULL };
   PyMicrocode *M = (PyMicrocode *) self;
   const char *filename = NULL;
   unsigned long addr;
   unsigned char trim = 1;
+  unsigned char structure = 0;
 
-  if (! PyArg_ParseTupleAndKeywords (args, kwds, "k|sb", (char **) kwlists,
-				     &addr, &filename, &trim))
+  if (! PyArg_ParseTupleAndKeywords (args, kwds, "k|sbb", (char **) kwlists,
+				     &addr, &filename, &trim, &structure))
     return NULL;
 
   MicrocodeAddress ma (addr);
@@ -272,6 +407,14 @@ s_PyMicrocode_cfg (PyObject *self, PyObject *args, PyObject *kwds)
       cfg->toDot (oss);
       result = Py_BuildValue ("s", oss.str ().c_str ());
     }
+
+  if (structure && result != NULL)
+    {
+      PyObject *dot = result;
+
+      result = s_cfg_structure (cfg, dot);
+      Py_DECREF (dot);
+    }
   delete cfg;
 
   return result;